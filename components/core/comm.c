@@ -1,15 +1,31 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
 #include "comm.h"
+#include "comm_port.h"
+#include "comm_tdma.h"
+#include "comm_flow.h"
+#include "comm_link.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
 #include "freertos/semphr.h"
-#include "esp_timer.h"
-#include "esp_err.h"
 #include "dataFrame.h"
-#include "hardware.h"
-#include "driver/uart.h"
 #include "mylist.h"
 #include "data_poll.h"
+#include "task_config.h"
+
+// 数据压缩使用LVGL自带的LZ4（需要在menuconfig中开启 LV_USE_LZ4_INTERNAL），其它平台可在编译选项中定义 COMM_USE_LZ4
+#ifndef COMM_USE_LZ4
+#if defined(CONFIG_LV_USE_LZ4_INTERNAL) && CONFIG_LV_USE_LZ4_INTERNAL
+#define COMM_USE_LZ4 1
+#else
+#define COMM_USE_LZ4 0
+#endif
+#endif
+#if COMM_USE_LZ4
+#include "lvgl/src/libs/lz4/lz4.h"
+#endif
 
 typedef struct
 {
@@ -20,6 +36,11 @@ typedef struct
     uint32_t timeout_ms;
     CommPackSend_Cb finished_cb;
     void *user_data;
+    uint8_t is_ack_frame;   // 1：ACK确认帧（时隙模式下ACK也要排队到本端窗口发送）
+    uint32_t ack_id;
+    uint8_t ack_node;       // ACK确认帧的目的节点（COMM_NODE_NONE 时发送不带地址的ACK）
+    uint8_t dst;            // 目的节点掩码，0 表示使用默认目的节点
+    uint32_t pack_id;       // 包ID，0 表示发送时分配新ID（重发沿用原ID，接收端据此去重）
 } DataTransReq_t;
 
 typedef struct
@@ -28,12 +49,24 @@ typedef struct
     void *user_data;
     int id;
     uint8_t cmd;
+    uint8_t src_mask;       // 只接收这些节点发来的包，COMM_NODE_ANY 不过滤
+    QueueHandle_t queue;    // 非NULL：延迟分发，把 CommRxFrame_t* 放入该队列而不是调用 callback
+    TaskHandle_t notify_task;
 } PackDealFunc_t;
 
+// 延迟分发的接收帧：引用计数在应用层看不到的头部
+typedef struct
+{
+    uint8_t refcnt;
+    CommRxFrame_t frame;
+} RxFrameBlock_t;
+
 typedef struct
 {
     SemaphoreHandle_t semphr_handle;
     StaticQueue_t queue_data;
+    uint32_t is_success;
+    uint8_t abandoned;      // 等待方已超时返回，由发送完成回调归还该块
 } StaticSemphrBlock_t;
 
 typedef struct
@@ -42,6 +75,7 @@ typedef struct
     int64_t send_time_ms;
     uint8_t is_using;
     uint32_t pack_id;
+    uint8_t dst;            // 目的节点掩码，只接受这些节点的ACK
     CommPackSend_Cb finished_cb;
     void *user_data;
 
@@ -59,8 +93,28 @@ static uint32_t kCallbackId;
 
 /* -------------------- 协议常量 -------------------- */
 #define PACK_NEED_ACK   (0x80u)
+#define PACK_COMPRESSED (0x40u)  // 数据域为LZ4压缩数据
+#define PACK_ADDRESSED  (0x20u)  // 包ID后带源节点(1)+目的节点掩码(1)
 #define PACK_OVERHEAD   (8u)     // head(1)+len(1)+cmd(1)+id(4)+sum(1)
-#define PACK_MAX_SIZE   (256u)
+#define PACK_ADDR_SIZE  (2u)     // src(1)+dst(1)
+#define PACK_MAX_SIZE   (255u)   // 长度字段只有1字节
+#define ACK_FRAME_SIZE  (5u)     // head(1)+id(4)
+#define ACK_ADDR_FRAME_SIZE (7u) // head(1)+id(4)+src(1)+dst(1)
+
+// 阻塞发送在 超时*(重试+1) 之外额外等待的时间（覆盖超时检查周期与排队时间）
+#define COMM_ACK_WAIT_MARGIN_MS     (50u)
+// 未指定ACK超时的异步发送使用的默认超时
+#define COMM_DEFAULT_ACK_TIMEOUT_MS (100u)
+// 短于该长度的数据域不尝试压缩（LZ4几乎不可能压得更短）
+#define COMM_COMPRESS_MIN_SIZE      (24u)
+// 去重：每个节点记住最近收到的若干个需要ACK的包ID，超过该时间的记录失效（对端重启后包ID从头开始）
+#define COMM_DEDUP_DEPTH            (8u)
+#define COMM_DEDUP_EXPIRE_MS        (2000u)
+
+// 置1时打印每个发出的数据包（调试用，会严重拖慢发送）
+#ifndef COMM_DEBUG_PRINT
+#define COMM_DEBUG_PRINT 0
+#endif
 
 typedef enum
 {
@@ -68,66 +122,133 @@ typedef enum
     COMM_BAD_SUM  = 2,
     COMM_BAD_LEN  = 3,
     COMM_BAD_ACK  = 4,
+    COMM_BAD_COMPRESS = 5,
+    COMM_BAD_ADDR = 6,
 } CommBadType_t;
 
+// 物理链路端口
+static const CommPort_t *kCommPort;
 // 数据包发送请求队列
 static QueueHandle_t send_req_queue_handle;
-// 串口发送互斥锁（用于保护 uart_write_bytes 原子性）
+// 串口发送互斥锁（用于保护端口 write 的原子性）
 static SemaphoreHandle_t uart_tx_mutex;
 // 接收回调链表互斥锁（保护 kRecvCbList 的增删与遍历）
 static SemaphoreHandle_t recv_cb_list_mutex;
 // 数据包ACK确认信号量池
 static DataPoll_t kCommSendAckSemphrPoll;
+// 延迟分发的接收帧池，rx_pool_mutex 保护申请/归还与引用计数
+static DataPoll_t kRxFramePoll;
+static SemaphoreHandle_t rx_pool_mutex;
+// 保护信号量池的申请/归还以及块的 abandoned 标志
+static SemaphoreHandle_t send_block_mutex;
 // 包ID，用于区分不同的数据包
 static uint32_t g_pack_id = 1;
+// 链路统计
+static CommStats_t kCommStats;
 
 /* 发送与接收 buffer */
 static uint8_t send_buffer[PACK_MAX_SIZE];
 static uint8_t recv_buffer[PACK_MAX_SIZE];
 
+// 开启压缩的命令（按 cmd & PACK_CMD_MASK 的位图）
+static uint16_t kCompressMask;
+#if COMM_USE_LZ4
+// LZ4压缩状态（约16KB，第一次开启压缩时申请），只在发送任务中使用
+static void *kLz4State;
+// 解压缓冲：只有接收任务使用，数据在分发回调期间有效
+static uint8_t recv_plain_buffer[PACK_MAX_SIZE];
+#endif
+
 // 挂起的待确认包信息
 static AckWaitBlock_t send_ack_blocks[8];
 static SemaphoreHandle_t send_ack_blocks_mutex;
 
+// 发送队列水位回调
+typedef struct
+{
+    uint8_t high;
+    uint8_t low;
+    uint8_t is_high;
+    CommQueueWatermarkCb_t callback;
+    void *user_data;
+} QueueWatermark_t;
+static QueueWatermark_t kQueueWatermark;
+
+#if COMM_TX_TRACE
+static CommTxTraceCb_t kTxTrace;
+#define TX_TRACE(cmd, stage) do { if (kTxTrace) kTxTrace((cmd), (stage)); } while (0)
+#else
+#define TX_TRACE(cmd, stage) ((void)0)
+#endif
+static CommRxHookCb_t kRxHook;
+static SemaphoreHandle_t queue_watermark_mutex;
+
+// 流控窗口通告内容（零拷贝发送，入队前更新）
+static PackFlowCredit_t kFlowAdvert;
+// 心跳帧内容（零拷贝发送，入队前更新）
+static PackHeartbeat_t kHeartbeat;
+
+// 多机寻址：本端节点号（COMM_NODE_NONE 表示不使用寻址）与默认目的节点掩码
+static uint8_t kNodeId = COMM_NODE_NONE;
+static uint8_t kDefaultDst = COMM_NODE_BROADCAST;
+
+// 每个对端节点的接收状态，最后一个给不带地址的帧使用；只在接收任务中修改
+typedef struct
+{
+    uint32_t ids[COMM_DEDUP_DEPTH];
+    int64_t times[COMM_DEDUP_DEPTH];
+    uint8_t next;
+    CommNodeStats_t stats;
+} CommNodeState_t;
+static CommNodeState_t kNodeState[COMM_NODE_MAX + 1];
+// 正在分发的数据包的源节点（只在接收回调中有效）
+static uint8_t kRecvSrcNode = COMM_NODE_NONE;
+
 /* -------------------- 包头定义 -------------------- */
 
 
 void SendDataPackTask(void *param);
 void ReceiveDataPackTask(void *param);
 void ACKTimeoutCheckTask(void *param);
+static void default_send_cb(void *user_data, uint32_t is_success);
+
+static int port_read(void *dst, uint16_t size, uint32_t timeout_ms)
+{
+    return kCommPort->read(kCommPort->port_data, (uint8_t *)dst, size, timeout_ms);
+}
+
+static void port_write(const uint8_t *src, uint16_t size)
+{
+    xSemaphoreTake(uart_tx_mutex, portMAX_DELAY);
+    kCommPort->write(kCommPort->port_data, src, size);
+    xSemaphoreGive(uart_tx_mutex);
+}
 
 /* -------------------- 模块初始化 -------------------- */
-void RemoteCommInit(BadDataPackCb_t callback)
+void RemoteCommInitWithPort(BadDataPackCb_t callback, const CommPort_t *port)
 {
+    kCommPort = port;
     // 初始化ACK确认包信号量池
     PollInit(&kCommSendAckSemphrPoll, sizeof(StaticSemphrBlock_t), 8);
+    PollInit(&kRxFramePoll, sizeof(RxFrameBlock_t), COMM_RX_POOL_SIZE);
 
     kCallbackId = 0;
     kRecvCbList = ListCreate(sizeof(PackDealFunc_t)); // 创建接收回调链表
 
-    send_req_queue_handle = xQueueCreate(8, sizeof(DataTransReq_t));
+    send_req_queue_handle = xQueueCreate(COMM_SEND_QUEUE_LEN, sizeof(DataTransReq_t));
     uart_tx_mutex = xSemaphoreCreateMutex();
+    send_block_mutex = xSemaphoreCreateMutex();
     recv_cb_list_mutex = xSemaphoreCreateMutex();
     send_ack_blocks_mutex = xSemaphoreCreateMutex();
+    rx_pool_mutex = xSemaphoreCreateMutex();
+    queue_watermark_mutex = xSemaphoreCreateMutex();
+    tdma_init();
+    flow_init();
+    link_init();
 
-    /* UART初始化 */
-    uart_config_t uart_config = {
-        .baud_rate = 115200,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE};
-
-    uart_param_config(UART_NUM_1, &uart_config);
-    uart_set_pin(UART_NUM_1, PIN_NUM_UART_TXD, PIN_NUM_UART_RXD,
-                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
-
-    QueueHandle_t uart_event_queue;
-    uart_driver_install(UART_NUM_1, 256, 256, 4, &uart_event_queue, 0);
-
-    xTaskCreate(SendDataPackTask, "uartSendTask", 2048, NULL, 5, NULL);
-    xTaskCreate(ReceiveDataPackTask, "uartRecvTask", 2048, callback, 5, NULL);
-    xTaskCreate(ACKTimeoutCheckTask, "uartackTask", 2048, NULL, 3, NULL);
+    TASK_CREATE(TASK_COMM_SEND, SendDataPackTask, NULL, NULL);
+    TASK_CREATE(TASK_COMM_RECV, ReceiveDataPackTask, callback, NULL);
+    TASK_CREATE(TASK_COMM_ACK, ACKTimeoutCheckTask, NULL, NULL);
 }
 
 /* -------------------- 求和校验 -------------------- */
@@ -139,98 +260,438 @@ static uint8_t SumCheck(uint16_t size, uint8_t *src)
     return sum;
 }
 
-void SendDataPackTask(void *param)
+static void ReportBadPack(void *param, uint32_t type)
 {
-    DataTransReq_t req;
-    while (1)
+    kCommStats.bad_frames++;
+    if (param)
+        ((BadDataPackCb_t)param)(type);
+}
+
+static uint8_t addressing_enabled(void)
+{
+    return kNodeId != COMM_NODE_NONE;
+}
+
+static uint16_t req_frame_len(const DataTransReq_t *req)
+{
+    if (req->is_ack_frame)
+        return (addressing_enabled() && req->ack_node != COMM_NODE_NONE) ? ACK_ADDR_FRAME_SIZE : ACK_FRAME_SIZE;
+    return (uint16_t)(req->size + PACK_OVERHEAD + (addressing_enabled() ? PACK_ADDR_SIZE : 0));
+}
+
+static uint32_t next_pack_id(void)
+{
+    uint32_t id = g_pack_id++;
+    if (g_pack_id == 0)     // 0 保留表示“未分配”
+        g_pack_id = 1;
+    return id;
+}
+
+static CommNodeState_t *node_state(uint8_t node)
+{
+    return &kNodeState[node < COMM_NODE_MAX ? node : COMM_NODE_MAX];
+}
+
+static RxFrameBlock_t *rx_frame_block(CommRxFrame_t *frame)
+{
+    return (RxFrameBlock_t *)((uint8_t *)frame - offsetof(RxFrameBlock_t, frame));
+}
+
+// 申请一个接收帧并拷贝数据，引用计数为1（属于分发过程）；池空返回NULL
+static CommRxFrame_t *rx_frame_alloc(uint8_t cmd, uint8_t src_node, const uint8_t *data, uint16_t size)
+{
+    xSemaphoreTake(rx_pool_mutex, portMAX_DELAY);
+    RxFrameBlock_t *block = (RxFrameBlock_t *)PollRequireBlock(&kRxFramePoll);
+    if (block)
+        block->refcnt = 1;
+    xSemaphoreGive(rx_pool_mutex);
+    if (!block)
+        return NULL;
+    block->frame.cmd = cmd;
+    block->frame.src_node = src_node;
+    block->frame.size = size;
+    block->frame.recv_ms = comm_get_time_ms();
+    memcpy(block->frame.data, data, size);
+    return &block->frame;
+}
+
+// 需要ACK的包是否是重复收到的（对端没收到ACK而重发），不是则记录下来
+static uint32_t node_check_duplicate(CommNodeState_t *peer, uint32_t pack_id, int64_t now)
+{
+    for (uint32_t i = 0; i < COMM_DEDUP_DEPTH; i++)
     {
-        xQueueReceive(send_req_queue_handle, &req, portMAX_DELAY);
-        printf("执行发送任务\r\n");
-        uint32_t pack_id = g_pack_id++;
+        if (peer->ids[i] == pack_id && now - peer->times[i] <= COMM_DEDUP_EXPIRE_MS)
+            return 1;
+    }
+    peer->ids[peer->next] = pack_id;
+    peer->times[peer->next] = now;
+    peer->next = (uint8_t)((peer->next + 1) % COMM_DEDUP_DEPTH);
+    return 0;
+}
+
+/* -------------------- 发送队列 -------------------- */
+static void queue_watermark_lock(void)
+{
+    xSemaphoreTake(queue_watermark_mutex, portMAX_DELAY);
+}
+
+// 队列深度越过高水位/回落到低水位时通知应用层（带回差，每次跨越只通知一次）
+static void check_queue_watermark(void)
+{
+    if (!kQueueWatermark.callback)
+        return;
+    uint32_t depth = uxQueueMessagesWaiting(send_req_queue_handle);
+    int8_t edge = -1;
+    queue_watermark_lock();
+    CommQueueWatermarkCb_t callback = kQueueWatermark.callback;
+    void *user_data = kQueueWatermark.user_data;
+    if (!kQueueWatermark.is_high && depth >= kQueueWatermark.high)
+        edge = kQueueWatermark.is_high = 1;
+    else if (kQueueWatermark.is_high && depth <= kQueueWatermark.low)
+        edge = kQueueWatermark.is_high = 0;
+    xSemaphoreGive(queue_watermark_mutex);
+    if (edge >= 0 && callback)
+        callback(edge, depth, user_data);
+}
 
-        if (req.size + PACK_OVERHEAD > PACK_MAX_SIZE) {
-            if (req.finished_cb) {
-                req.finished_cb(req.user_data, 0);
+// 请求入队（协议层内部：重发、ACK、链路控制帧），不经过流控
+static uint32_t enqueue_req_raw(const DataTransReq_t *req, TickType_t wait, uint8_t to_front)
+{
+    BaseType_t ret = to_front ? xQueueSendToFront(send_req_queue_handle, req, wait)
+                              : xQueueSend(send_req_queue_handle, req, wait);
+    if (ret != pdPASS)
+        return 0;
+    check_queue_watermark();
+    return 1;
+}
+
+// 用户发送请求入队：批量命令先申请流控额度，额度和队列空位共用 wait_ms 的等待时间
+static uint32_t enqueue_send_req(const DataTransReq_t *req, uint32_t wait_ms)
+{
+    if (!send_req_queue_handle)
+        return 0;
+    TickType_t start = xTaskGetTickCount();
+    TickType_t wait = (wait_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(wait_ms);
+    while (!flow_take_credit(req->cmd))
+    {
+        if (xTaskGetTickCount() - start >= wait)
+        {
+            kCommStats.tx_rejected++;
+            return 0;
+        }
+        vTaskDelay(1);
+    }
+    TickType_t elapsed = xTaskGetTickCount() - start;
+    TickType_t remain = (wait == portMAX_DELAY) ? portMAX_DELAY : (elapsed < wait ? wait - elapsed : 0);
+    TX_TRACE(req->cmd, COMM_TX_TRACE_ENQUEUE);   // 入队之前记录：入队后发送任务可能立即在另一个核上取出
+    if (!enqueue_req_raw(req, remain, 0))
+    {
+        flow_return_credit(req->cmd);
+        kCommStats.tx_rejected++;
+        return 0;
+    }
+    return 1;
+}
+
+// 把数据域写入 dst；开启压缩的命令压缩后更短时写入压缩数据并置压缩标志，返回数据域长度
+static uint16_t pack_payload(uint8_t *cmd, uint8_t *dst, const uint8_t *src, uint16_t size)
+{
+#if COMM_USE_LZ4
+    if (kLz4State && size >= COMM_COMPRESS_MIN_SIZE && ((kCompressMask >> (*cmd & PACK_CMD_MASK)) & 1u))
+    {
+        // 输出上限为 size-1：压缩后不更短时LZ4返回0，按原样发送
+        int n = LZ4_compress_fast_extState(kLz4State, (const char *)src, (char *)dst, size, size - 1, 1);
+        if (n > 0)
+        {
+            *cmd |= PACK_COMPRESSED;
+            kCommStats.tx_compressed++;
+            kCommStats.tx_saved_bytes += size - (uint32_t)n;
+            return (uint16_t)n;
+        }
+    }
+#endif
+    memcpy(dst, src, size);
+    return size;
+}
+
+// 回复ACK；对带地址的包回复带地址的ACK，多个机器人共用信道时各自只处理发给自己的ACK
+static void SendAckFrame(uint32_t ack_id, uint8_t ack_node)
+{
+    uint8_t ack[ACK_ADDR_FRAME_SIZE];
+    uint16_t size = ACK_FRAME_SIZE;
+    ack[0] = ACK_HEAD;
+    memcpy(ack + 1, &ack_id, 4);
+    if (addressing_enabled() && ack_node != COMM_NODE_NONE)
+    {
+        ack[0] = ACK_ADDR_HEAD;
+        ack[5] = kNodeId;
+        ack[6] = ack_node;
+        size = ACK_ADDR_FRAME_SIZE;
+    }
+    port_write(ack, size);
+    kCommStats.tx_acks++;
+    link_on_tx(comm_get_time_ms());
+}
+
+// 封包并发送一个请求，需要ACK的包挂起等待确认
+static void SendDataPack(const DataTransReq_t *p_req)
+{
+    DataTransReq_t req = *p_req;
+    if (req.is_ack_frame) {
+        SendAckFrame(req.ack_id, req.ack_node);
+        return;
+    }
+
+    TX_TRACE(req.cmd, COMM_TX_TRACE_DEQUEUE);
+#if COMM_DEBUG_PRINT
+    printf("执行发送任务\r\n");
+#endif
+    uint32_t pack_id = req.pack_id ? req.pack_id : next_pack_id();
+    uint8_t dst = req.dst ? req.dst : kDefaultDst;
+    uint8_t hdr_len = 7;
+    if (addressing_enabled())
+        hdr_len += PACK_ADDR_SIZE;
+
+    if (req.size + PACK_OVERHEAD + (hdr_len - 7) > PACK_MAX_SIZE) {
+        if (req.finished_cb) {
+            req.finished_cb(req.user_data, 0);
+        }
+        return;
+    }
+
+    // 阻塞发送的等待方超时返回后 src 可能已经失效：拷贝数据时持有锁，等待方放弃后不再发送
+    uint8_t is_blocking = (req.finished_cb == default_send_cb);
+    uint8_t abandoned = 0;
+    if (is_blocking)
+    {
+        xSemaphoreTake(send_block_mutex, portMAX_DELAY);
+        abandoned = ((StaticSemphrBlock_t *)req.user_data)->abandoned;
+    }
+    uint8_t cmd = req.cmd;
+    uint16_t payload_size = 0;
+    if (!abandoned)
+        payload_size = pack_payload(&cmd, &send_buffer[hdr_len], req.data, req.size);
+    if (is_blocking)
+        xSemaphoreGive(send_block_mutex);
+    if (abandoned)
+    {
+        default_send_cb(req.user_data, 0);
+        return;
+    }
+
+    if (hdr_len > 7)
+    {
+        cmd |= PACK_ADDRESSED;
+        send_buffer[7] = kNodeId;
+        send_buffer[8] = dst;
+    }
+    uint16_t frame_len = (uint16_t)(hdr_len + payload_size + 1);
+    send_buffer[0] = PACK_HEAD;
+    send_buffer[1] = (uint8_t)frame_len;
+    send_buffer[2] = cmd;
+    memcpy(&send_buffer[3], &pack_id, 4);
+
+    send_buffer[hdr_len + payload_size] = SumCheck(hdr_len + payload_size, send_buffer);
+
+#if COMM_DEBUG_PRINT
+    for(int i=0;i<frame_len;i++)
+        printf("%x",send_buffer[i]);
+#endif
+    port_write(send_buffer, frame_len);
+    TX_TRACE(req.cmd, COMM_TX_TRACE_WRITTEN);
+    kCommStats.tx_frames++;
+    link_on_tx(comm_get_time_ms());
+
+    if (!(req.cmd & PACK_NEED_ACK)) // 如果该包不需要进行包确认，那么直接执行发送完成回调
+    {
+        if (req.finished_cb)
+            req.finished_cb(req.user_data, 1);
+    }
+    else // 挂起ACK等待，由接收完成函数或超时处理函数执行回调
+    {
+        bool inserted=false;
+        xSemaphoreTake(send_ack_blocks_mutex, portMAX_DELAY);
+        for (int i = 0; i < 8; i++)
+        {
+            if (!send_ack_blocks[i].is_using)
+            {
+                send_ack_blocks[i].is_using = 1;
+                inserted=true;
+
+                send_ack_blocks[i].pack_id = pack_id;
+                send_ack_blocks[i].dst = dst;
+                send_ack_blocks[i].finished_cb = req.finished_cb;
+                send_ack_blocks[i].user_data = req.user_data;
+                send_ack_blocks[i].cmd = req.cmd;
+                send_ack_blocks[i].data = req.data;
+                send_ack_blocks[i].size = req.size;
+                send_ack_blocks[i].retry_cnt = req.max_retry_cnt;
+                send_ack_blocks[i].timeout_ms = req.timeout_ms;
+                send_ack_blocks[i].send_time_ms = comm_get_time_ms();
+                break;
             }
-            continue;
         }
+        xSemaphoreGive(send_ack_blocks_mutex);
+        if(!inserted && req.finished_cb)   //ACK挂起数组已满，不能等待ACK包，直接执行失败回调
+        {
+            req.finished_cb(req.user_data, 0);
+        }
+    }
+}
 
-        send_buffer[0] = PACK_HEAD;
-        send_buffer[1] = (uint8_t)(req.size + PACK_OVERHEAD);
-        send_buffer[2] = req.cmd;
-        memcpy(&send_buffer[3], &pack_id, 4);
-        memcpy(&send_buffer[7], req.data, req.size);
+// 时隙模式：等待本端窗口，在窗口内发送排队的ACK和数据包，放不下的包留到下一个窗口
+static void SendTdmaWindow(void)
+{
+    int64_t win_start, win_end;
+    if (!tdma_wait_window(&win_start, &win_end))
+        return;
 
-        send_buffer[7 + req.size] = SumCheck(req.size + 7, send_buffer);
+    PackTdmaBeacon_t beacon;
+    if (tdma_build_beacon(win_start, &beacon))
+    {
+        DataTransReq_t beacon_req = {
+            .size = sizeof(beacon),
+            .cmd = CMD_LINK_CTRL,
+            .data = (uint8_t *)&beacon,
+            .dst = COMM_NODE_BROADCAST,
+        };
+        SendDataPack(&beacon_req);
+        uint32_t airtime = tdma_airtime_ms(req_frame_len(&beacon_req));
+        if (airtime)
+            vTaskDelay(pdMS_TO_TICKS(airtime));
+    }
 
-        xSemaphoreTake(uart_tx_mutex, portMAX_DELAY);
-        for(int i=0;i<req.size + PACK_OVERHEAD;i++)
-            printf("%x",send_buffer[i]);
-        uart_write_bytes(UART_NUM_1, (char *)send_buffer, req.size + PACK_OVERHEAD);
-        xSemaphoreGive(uart_tx_mutex);
+    DataTransReq_t req;
+    uint8_t sent_any = 0;
+    while (1)
+    {
+        int64_t now = comm_get_time_ms();
+        if (now >= win_end)
+            return;
+        if (xQueuePeek(send_req_queue_handle, &req, pdMS_TO_TICKS((uint32_t)(win_end - now))) != pdPASS)
+            return;
 
-        if (!(req.cmd & PACK_NEED_ACK)) // 如果该包不需要进行包确认，那么直接执行发送完成回调
+        // 剩余窗口放不下这一帧：等到窗口结束
+        // 每个窗口至少发出一帧，窗口配置得比（信标+最长帧）还短时不至于永远发不出去
+        uint32_t airtime = tdma_airtime_ms(req_frame_len(&req));
+        now = comm_get_time_ms();
+        if (now + airtime > win_end && sent_any)
         {
-            if (req.finished_cb)
-                req.finished_cb(req.user_data, 1);
+            if (win_end > now)
+                vTaskDelay(pdMS_TO_TICKS((uint32_t)(win_end - now)));
+            return;
         }
-        else // 挂起ACK等待，由接收完成函数或超时处理函数执行回调
+        xQueueReceive(send_req_queue_handle, &req, 0);
+        check_queue_watermark();
+        SendDataPack(&req);
+        sent_any = 1;
+        if (airtime)
+            vTaskDelay(pdMS_TO_TICKS(airtime));    // 等模块把这一帧发到空中再发下一帧
+    }
+}
+
+void SendDataPackTask(void *param)
+{
+    DataTransReq_t req;
+    while (1)
+    {
+        if (tdma_enabled())
         {
-            bool inserted=false;
-            xSemaphoreTake(send_ack_blocks_mutex, portMAX_DELAY);
-            for (int i = 0; i < 8; i++)
+            SendTdmaWindow();
+            continue;
+        }
+        if (xQueueReceive(send_req_queue_handle, &req, pdMS_TO_TICKS(100)) != pdPASS)
+            continue;   // 周期性醒来，以便运行中切换到时隙模式
+        check_queue_watermark();
+        SendDataPack(&req);
+    }
+}
+
+// 把一个数据包分发给匹配的接收者：同步回调直接执行；延迟分发的注册项共用一份拷贝到池中的帧，各自持有一个引用
+static void dispatch_frame(uint8_t cmd, uint8_t src_node, uint8_t *payload, uint16_t payload_len)
+{
+    ListIterator_t it;
+    CommRxFrame_t *frame = NULL;
+    uint8_t pool_empty = 0;
+    xSemaphoreTake(recv_cb_list_mutex, portMAX_DELAY);
+    InitListIterator(&it, kRecvCbList);
+    kRecvSrcNode = src_node;
+    PackDealFunc_t *obj;
+    while ((obj = IteraterGet(&it)) != NULL)
+    {
+        if (obj->cmd == (cmd & PACK_CMD_MASK) &&
+            (obj->src_mask == COMM_NODE_ANY || (src_node < COMM_NODE_MAX && ((obj->src_mask >> src_node) & 1u))))
+        {
+            if (!obj->queue)
+                obj->callback(payload, payload_len, obj->user_data);
+            else
             {
-                if (!send_ack_blocks[i].is_using)
+                if (!frame && !pool_empty)
                 {
-                    send_ack_blocks[i].is_using = 1;
-                    inserted=true;
-
-                    send_ack_blocks[i].pack_id = pack_id;
-                    send_ack_blocks[i].finished_cb = req.finished_cb;
-                    send_ack_blocks[i].user_data = req.user_data;
-                    send_ack_blocks[i].cmd = req.cmd;
-                    send_ack_blocks[i].data = req.data;
-                    send_ack_blocks[i].size = req.size;
-                    send_ack_blocks[i].retry_cnt = req.max_retry_cnt;
-                    send_ack_blocks[i].timeout_ms = req.timeout_ms;
-                    send_ack_blocks[i].send_time_ms = esp_timer_get_time()/1000;
-                    break;
+                    frame = rx_frame_alloc(cmd & PACK_CMD_MASK, src_node, payload, payload_len);
+                    pool_empty = (frame == NULL);
+                }
+                if (frame)
+                    comm_rx_frame_retain(frame);
+                if (frame && xQueueSend(obj->queue, &frame, 0) == pdPASS)
+                {
+                    if (obj->notify_task)
+                        xTaskNotifyGive(obj->notify_task);
+                }
+                else
+                {
+                    if (frame)
+                        comm_rx_frame_release(frame);
+                    kCommStats.rx_deferred_dropped++;
                 }
-            }
-            xSemaphoreGive(send_ack_blocks_mutex);
-            if(!inserted)   //ACK挂起数组已满，不能等待ACK包，直接执行失败回调
-            {
-                req.finished_cb(req.user_data, 0);
             }
         }
+        IteraterNext(&it);
     }
+    kRecvSrcNode = COMM_NODE_NONE;
+    xSemaphoreGive(recv_cb_list_mutex);
+    if (frame)
+        comm_rx_frame_release(frame);
 }
 
 void ReceiveDataPackTask(void *param)
 {
-    ListIterator_t it;
-    InitListIterator(&it, kRecvCbList);
     while (1)
     {
         uint8_t head;
-        uart_read_bytes(UART_NUM_1, &head, 1, portMAX_DELAY);
+        port_read(&head, 1, portMAX_DELAY);
+        if (kRxHook)
+            kRxHook();
 
         /* ---------- ACK 包 ---------- */
-        if (head == ACK_HEAD)
+        if (head == ACK_HEAD || head == ACK_ADDR_HEAD)
         {
-            uint32_t ack_id = 0;
-            int got = uart_read_bytes(UART_NUM_1, &ack_id, 4, pdMS_TO_TICKS(20));
-            if (got != 4) {
-                if(param)
-                    ((BadDataPackCb_t)param)(COMM_BAD_ACK);
+            uint8_t ack[ACK_ADDR_FRAME_SIZE - 1];
+            uint16_t ack_len = (head == ACK_HEAD) ? ACK_FRAME_SIZE - 1 : ACK_ADDR_FRAME_SIZE - 1;
+            int got = port_read(ack, ack_len, 20);
+            if (got != ack_len) {
+                ReportBadPack(param, COMM_BAD_ACK);
                 continue;
             }
+            uint32_t ack_id;
+            memcpy(&ack_id, ack, 4);
+            // 带地址的ACK：忽略发给其它节点的，只接受发往节点中包含该ACK来源的挂起包
+            uint8_t ack_src = COMM_NODE_NONE;
+            if (head == ACK_ADDR_HEAD)
+            {
+                if (addressing_enabled() && ack[5] != kNodeId)
+                    continue;
+                ack_src = ack[4];
+            }
+            link_on_rx(comm_get_time_ms());
 
             xSemaphoreTake(send_ack_blocks_mutex, portMAX_DELAY);
             for (int i = 0; i < 8; i++)
             {
-                if (send_ack_blocks[i].is_using && send_ack_blocks[i].pack_id == ack_id)
+                if (send_ack_blocks[i].is_using && send_ack_blocks[i].pack_id == ack_id &&
+                    (ack_src >= COMM_NODE_MAX || (send_ack_blocks[i].dst >> ack_src) & 1u))
                 {
+                    kCommStats.rx_acks++;
                     if (send_ack_blocks[i].finished_cb) {
                         send_ack_blocks[i].finished_cb(send_ack_blocks[i].user_data, 1);
                     }
@@ -245,80 +706,129 @@ void ReceiveDataPackTask(void *param)
         /* ---------- 普通数据包 ---------- */
         if (head != PACK_HEAD)
         {
-            if(param)
-                ((BadDataPackCb_t)param)(COMM_BAD_HEAD);
+            ReportBadPack(param, COMM_BAD_HEAD);
             continue;
         }
 
         recv_buffer[0] = head;
 
         /* size */
-        int size_got = uart_read_bytes(UART_NUM_1, &recv_buffer[1], 1, pdMS_TO_TICKS(20));
+        int size_got = port_read(&recv_buffer[1], 1, 20);
         if (size_got != 1) {
-            if(param)
-                ((BadDataPackCb_t)param)(COMM_BAD_LEN);
+            ReportBadPack(param, COMM_BAD_LEN);
             continue;
         }
 
         uint16_t data_len = recv_buffer[1]; // 整包长度（包含 head/len/.../sum）
         if (data_len > PACK_MAX_SIZE || data_len < PACK_OVERHEAD) {
-            if(param)
-                ((BadDataPackCb_t)param)(COMM_BAD_LEN);
+            ReportBadPack(param, COMM_BAD_LEN);
             continue;
         }
 
         /* CMD + ID + DATA（不含 head/len；sum 单独读） */
         uint16_t payload_to_read = (uint16_t)(data_len - 2 - 1);
-        int payload_got = uart_read_bytes(UART_NUM_1, &recv_buffer[2], payload_to_read, pdMS_TO_TICKS(50));
+        int payload_got = port_read(&recv_buffer[2], payload_to_read, 50);
         if (payload_got != (int)payload_to_read) {
-            if(param)
-                ((BadDataPackCb_t)param)(COMM_BAD_LEN);
+            ReportBadPack(param, COMM_BAD_LEN);
             continue;
         }
 
         /* 校验：sum 覆盖 [0..data_len-2]（不含 sum 本身） */
         uint8_t sum = SumCheck((uint16_t)(data_len - 1), recv_buffer);
         uint8_t recv_sum = 0;
-        int sum_got = uart_read_bytes(UART_NUM_1, &recv_sum, 1, pdMS_TO_TICKS(20));
+        int sum_got = port_read(&recv_sum, 1, 20);
         if (sum_got != 1) {
-            if(param)
-                ((BadDataPackCb_t)param)(COMM_BAD_LEN);
+            ReportBadPack(param, COMM_BAD_LEN);
             continue;
         }
 
         if (recv_sum != sum)
         {
-            if(param)
-                ((BadDataPackCb_t)param)(COMM_BAD_SUM);
+            ReportBadPack(param, COMM_BAD_SUM);
             continue;
         }
 
-        // 如果当前数据包需要ACK回复，那么立即回复ACK
+        // 带地址的包：丢弃发给其它节点的（本端未配置节点号时全部接收）
         uint8_t cmd = recv_buffer[2];
-        if (cmd & PACK_NEED_ACK)
+        uint8_t hdr_len = 7;
+        uint8_t src_node = COMM_NODE_NONE;
+        if (cmd & PACK_ADDRESSED)
         {
-            uint8_t ack[5];
-            ack[0]=ACK_HEAD;
-            memcpy(ack+1, recv_buffer + 3, 4);
+            if (data_len < PACK_OVERHEAD + PACK_ADDR_SIZE || recv_buffer[7] >= COMM_NODE_MAX)
+            {
+                ReportBadPack(param, COMM_BAD_ADDR);
+                continue;
+            }
+            src_node = recv_buffer[7];
+            if (addressing_enabled() && !((recv_buffer[8] >> kNodeId) & 1u))
+            {
+                kCommStats.rx_filtered++;
+                continue;
+            }
+            hdr_len += PACK_ADDR_SIZE;
+        }
 
-            xSemaphoreTake(uart_tx_mutex, portMAX_DELAY);
-            uart_write_bytes(UART_NUM_1, ack, sizeof(ack));
-            xSemaphoreGive(uart_tx_mutex);
+        // 压缩的数据域先解压，解压失败按错误帧处理（不回复ACK）
+        uint8_t *payload = recv_buffer + hdr_len;
+        uint16_t payload_len = (uint16_t)(data_len - 1 - hdr_len);
+        if (cmd & PACK_COMPRESSED)
+        {
+            int n = -1;
+#if COMM_USE_LZ4
+            n = LZ4_decompress_safe((const char *)payload, (char *)recv_plain_buffer, payload_len, sizeof(recv_plain_buffer));
+            payload = recv_plain_buffer;
+#endif
+            if (n < 0)
+            {
+                ReportBadPack(param, COMM_BAD_COMPRESS);
+                continue;
+            }
+            payload_len = (uint16_t)n;
         }
 
-        xSemaphoreTake(recv_cb_list_mutex, portMAX_DELAY);
-        ResetListIterator(&it);
-        PackDealFunc_t *obj;
-        while ((obj = IteraterGet(&it)) != NULL)
+        kCommStats.rx_frames++;
+        link_on_rx(comm_get_time_ms());
+
+        // 如果当前数据包需要ACK回复，那么立即回复ACK（时隙模式下插到发送队列最前面，等本端窗口发送）
+        uint32_t pack_id;
+        memcpy(&pack_id, recv_buffer + 3, 4);
+        if (cmd & PACK_NEED_ACK)
         {
-            if (obj->cmd == (cmd & PACK_CMD_MASK))
+            if (tdma_enabled())
             {
-                obj->callback(recv_buffer + 7, (uint16_t)(data_len - PACK_OVERHEAD), obj->user_data);
-                //break;
+                DataTransReq_t ack_req = {.is_ack_frame = 1, .ack_id = pack_id, .ack_node = src_node};
+                enqueue_req_raw(&ack_req, 0, 1);
             }
-            IteraterNext(&it);
+            else
+                SendAckFrame(pack_id, src_node);
         }
-        xSemaphoreGive(recv_cb_list_mutex);
+
+        // 重发的包（上次的ACK丢了）已经回复了ACK，不再重复分发
+        int64_t now = comm_get_time_ms();
+        CommNodeState_t *peer = node_state(src_node);
+        peer->stats.last_rx_ms = now;
+        if ((cmd & PACK_NEED_ACK) && node_check_duplicate(peer, pack_id, now))
+        {
+            peer->stats.rx_duplicates++;
+            kCommStats.rx_duplicates++;
+            continue;
+        }
+        peer->stats.rx_frames++;
+
+        // 链路控制帧由协议层自己处理
+        if ((cmd & PACK_CMD_MASK) == CMD_LINK_CTRL)
+        {
+            if (payload[0] == LINK_CTRL_TDMA_BEACON && payload_len >= sizeof(PackTdmaBeacon_t))
+                tdma_on_beacon((PackTdmaBeacon_t *)payload, comm_get_time_ms(), data_len);
+            else if (payload[0] == LINK_CTRL_FLOW_CREDIT && payload_len >= sizeof(PackFlowCredit_t))
+                flow_on_credit((PackFlowCredit_t *)payload, comm_get_time_ms());
+            else if (payload[0] == LINK_CTRL_HEARTBEAT && payload_len >= sizeof(PackHeartbeat_t))
+                link_on_heartbeat((PackHeartbeat_t *)payload);
+            continue;
+        }
+
+        flow_on_data_received(cmd);
+        dispatch_frame(cmd, src_node, payload, payload_len);
     }
 }
 
@@ -328,7 +838,7 @@ void ACKTimeoutCheckTask(void *param)
     while (1)
     {
         xSemaphoreTake(send_ack_blocks_mutex, portMAX_DELAY);
-        int64_t cut_time=esp_timer_get_time()/ 1000;
+        int64_t cut_time=comm_get_time_ms();
         for (int i = 0; i < 8; i++)
         {
             if (send_ack_blocks[i].is_using)
@@ -337,19 +847,25 @@ void ACKTimeoutCheckTask(void *param)
                 {
                     if (send_ack_blocks[i].retry_cnt) // 如果还有重试次数，那么重新把这个任务放到发送队列中（最大重试次数减一）
                     {
-                        DataTransReq_t req;
+                        DataTransReq_t req = {0};
                         req.cmd = send_ack_blocks[i].cmd;
+                        req.pack_id = send_ack_blocks[i].pack_id;
+                        req.dst = send_ack_blocks[i].dst;
                         req.data = send_ack_blocks[i].data;
                         req.finished_cb = send_ack_blocks[i].finished_cb;
                         req.max_retry_cnt = send_ack_blocks[i].retry_cnt - 1;
                         req.size = send_ack_blocks[i].size;
                         req.timeout_ms = send_ack_blocks[i].timeout_ms;
                         req.user_data = send_ack_blocks[i].user_data;
-                        if(xQueueSend(send_req_queue_handle, &req, 0)==pdPASS)
+                        if(enqueue_req_raw(&req, 0, 0))
+                        {
                             send_ack_blocks[i].is_using = 0; // 声明当前块不再使用
+                            kCommStats.retransmits++;
+                        }
                     }
                     else    //超时并且没有重试次数，通知应用层通信失败
                     {
+                        kCommStats.send_failed++;
                         send_ack_blocks[i].finished_cb(send_ack_blocks[i].user_data, 0);
                         send_ack_blocks[i].is_using = 0;
                     }
@@ -357,7 +873,44 @@ void ACKTimeoutCheckTask(void *param)
             }
         }
         xSemaphoreGive(send_ack_blocks_mutex);
-        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(4));
+
+        // 流控窗口通告：窗口变化时立即发送，之后周期刷新
+        int64_t now = comm_get_time_ms();
+        if (flow_build_advert(now, &kFlowAdvert))
+        {
+            DataTransReq_t req = {0};
+            req.cmd = CMD_LINK_CTRL;
+            req.data = (uint8_t *)&kFlowAdvert;
+            req.size = sizeof(kFlowAdvert);
+            if (enqueue_req_raw(&req, 0, 0))
+                flow_advert_sent(now);
+        }
+
+        // 心跳：本端空闲一个周期才补发；断线时先分发断线保护控制帧再通知应用层
+        if (link_build_heartbeat(now, &kHeartbeat))
+        {
+            DataTransReq_t req = {0};
+            req.cmd = CMD_LINK_CTRL;
+            req.data = (uint8_t *)&kHeartbeat;
+            req.size = sizeof(kHeartbeat);
+            if (enqueue_req_raw(&req, 0, 0))
+            {
+                link_on_tx(now);    // 排队期间不重复生成
+                link_heartbeat_sent();
+            }
+        }
+        int32_t link_state = link_check(now);
+        if (link_state == COMM_LINK_LOST)
+        {
+            uint8_t fs_cmd;
+            uint16_t fs_size;
+            uint8_t fs[COMM_LINK_FAILSAFE_MAX];
+            if (link_get_failsafe(&fs_cmd, fs, &fs_size))
+                dispatch_frame(fs_cmd, COMM_NODE_NONE, fs, fs_size);
+        }
+        if (link_state >= 0)
+            link_notify((uint32_t)link_state);
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(COMM_LINK_CHECK_PERIOD_MS));
     }
 }
 
@@ -373,11 +926,59 @@ static uint32_t recv_list_match_cb(void *user, void *dst)
 // 注册上行数据包接收回调
 uint32_t register_comm_recv_cb(CommPackRecv_Cb callback, uint8_t cmd, void *user_data)
 {
+    return register_comm_recv_cb_from(callback, cmd, COMM_NODE_ANY, user_data);
+}
+
+uint32_t register_comm_recv_cb_from(CommPackRecv_Cb callback, uint8_t cmd, uint8_t src_mask, void *user_data)
+{
+    xSemaphoreTake(recv_cb_list_mutex, portMAX_DELAY);
     kCallbackId = kCallbackId + 1;
+    ListAddElement(kRecvCbList, &(PackDealFunc_t){.callback = callback, .user_data = user_data, .id = kCallbackId,
+                                                    .cmd = cmd, .src_mask = src_mask});
+    uint32_t id = kCallbackId;
+    xSemaphoreGive(recv_cb_list_mutex);
+    return id;
+}
+
+uint32_t register_comm_recv_queue(QueueHandle_t queue, uint8_t cmd, uint8_t src_mask, TaskHandle_t notify_task)
+{
+    if (!queue)
+        return 0;
     xSemaphoreTake(recv_cb_list_mutex, portMAX_DELAY);
-    ListAddElement(kRecvCbList, &(PackDealFunc_t){.callback = callback, .user_data = user_data, .id = kCallbackId, .cmd = cmd});
+    kCallbackId = kCallbackId + 1;
+    ListAddElement(kRecvCbList, &(PackDealFunc_t){.id = kCallbackId, .cmd = cmd, .src_mask = src_mask,
+                                                    .queue = queue, .notify_task = notify_task});
+    uint32_t id = kCallbackId;
     xSemaphoreGive(recv_cb_list_mutex);
-    return kCallbackId;
+    return id;
+}
+
+void comm_rx_frame_retain(CommRxFrame_t *frame)
+{
+    xSemaphoreTake(rx_pool_mutex, portMAX_DELAY);
+    rx_frame_block(frame)->refcnt++;
+    xSemaphoreGive(rx_pool_mutex);
+}
+
+void comm_rx_frame_release(CommRxFrame_t *frame)
+{
+    if (!frame)
+        return;
+    RxFrameBlock_t *block = rx_frame_block(frame);
+    xSemaphoreTake(rx_pool_mutex, portMAX_DELAY);
+    if (block->refcnt && --block->refcnt == 0)
+        PollFreeBlock(&kRxFramePoll, block);
+    xSemaphoreGive(rx_pool_mutex);
+}
+
+uint32_t comm_rx_pool_free(void)
+{
+    if (!rx_pool_mutex)
+        return 0;
+    xSemaphoreTake(rx_pool_mutex, portMAX_DELAY);
+    uint32_t num = PollFreeBlockNum(&kRxFramePoll);
+    xSemaphoreGive(rx_pool_mutex);
+    return num;
 }
 
 // 取消注册上行数据包接收回调函数
@@ -396,56 +997,254 @@ uint32_t unregister_comm_recv_cb(uint32_t cb_id)
 
 static void default_send_cb(void *user_data, uint32_t is_success)
 {
-    xSemaphoreGive(((StaticSemphrBlock_t *)user_data)->semphr_handle);
+    StaticSemphrBlock_t *block = (StaticSemphrBlock_t *)user_data;
+    xSemaphoreTake(send_block_mutex, portMAX_DELAY);
+    if (block->abandoned)   // 等待方已经返回，由这里归还
+        PollFreeBlock(&kCommSendAckSemphrPoll, block);
+    else
+    {
+        block->is_success = is_success;
+        xSemaphoreGive(block->semphr_handle);
+    }
+    xSemaphoreGive(send_block_mutex);
 }
 
 // 下行数据包发送（不确认）
 uint32_t asyn_comm_send_pack_nak(uint8_t *src, uint8_t cmd, uint16_t size)
 {
-    if(!send_req_queue_handle)
+    return asyn_comm_send_pack_nak_timeout(src, cmd, size, 0);
+}
+
+uint32_t asyn_comm_send_pack_nak_timeout(uint8_t *src, uint8_t cmd, uint16_t size, uint32_t wait_ms)
+{
+    DataTransReq_t req = {0};
+    req.cmd = cmd & (~((uint8_t)PACK_NEED_ACK));
+    req.data = src;
+    req.size = size;
+    return enqueue_send_req(&req, wait_ms);
+}
+
+uint32_t asyn_comm_send_pack_nak_to(uint8_t dst_mask, uint8_t *src, uint8_t cmd, uint16_t size)
+{
+    if (!addressing_enabled() || !dst_mask)
         return 0;
-    DataTransReq_t req;
+    DataTransReq_t req = {0};
     req.cmd = cmd & (~((uint8_t)PACK_NEED_ACK));
     req.data = src;
     req.size = size;
-    req.finished_cb = NULL;
-    return xQueueSend(send_req_queue_handle, &req, 0);
+    req.dst = dst_mask;
+    return enqueue_send_req(&req, 0);
 }
 
-// 下行数据包发送（带确认）
+// 下行数据包发送（确认）
 uint32_t comm_send_pack_ack(uint8_t *src, uint8_t cmd, uint16_t size, uint32_t time_out_ms, uint8_t max_retry_num)
 {
     if(!send_req_queue_handle)
         return 0;
-    DataTransReq_t req;
+    DataTransReq_t req = {0};
     req.cmd = cmd | PACK_NEED_ACK;
     req.data = src;
     req.size = size;
     req.max_retry_cnt = max_retry_num;
+    req.timeout_ms = time_out_ms;
     req.finished_cb = default_send_cb;
+
+    xSemaphoreTake(send_block_mutex, portMAX_DELAY);
     StaticSemphrBlock_t *block = (StaticSemphrBlock_t *)PollRequireBlock(&kCommSendAckSemphrPoll);
+    xSemaphoreGive(send_block_mutex);
     if (!block)
         return 0;
     block->semphr_handle = xSemaphoreCreateBinaryStatic(&block->queue_data);
-    xSemaphoreTake(((StaticSemphrBlock_t *)block)->semphr_handle, 0);
+    block->is_success = 0;
+    block->abandoned = 0;
     req.user_data = block;
-    xQueueSend(send_req_queue_handle, &req, 1);
-    BaseType_t ret=xSemaphoreTake(block->semphr_handle, pdMS_TO_TICKS(time_out_ms * max_retry_num));
-    PollFreeBlock(&kCommSendAckSemphrPoll,block);
+
+    // 入队最多等待一个ACK超时
+    if (!enqueue_send_req(&req, time_out_ms))
+    {
+        xSemaphoreTake(send_block_mutex, portMAX_DELAY);
+        PollFreeBlock(&kCommSendAckSemphrPoll, block);
+        xSemaphoreGive(send_block_mutex);
+        return 0;
+    }
+
+    // 首发和每次重发各等待一个超时
+    uint32_t wait_ms = time_out_ms * (max_retry_num + 1u) + COMM_ACK_WAIT_MARGIN_MS;
+    uint32_t done = xSemaphoreTake(block->semphr_handle, pdMS_TO_TICKS(wait_ms)) == pdTRUE;
+
+    xSemaphoreTake(send_block_mutex, portMAX_DELAY);
+    if (!done)  // 回调可能恰好在超时后执行
+        done = xSemaphoreTake(block->semphr_handle, 0) == pdTRUE;
+    uint32_t ret = 0;
+    if (done)
+    {
+        ret = block->is_success;
+        PollFreeBlock(&kCommSendAckSemphrPoll, block);
+    }
+    else    // 请求仍在队列或等待ACK（例如时隙模式迟迟没有窗口）：标记放弃，之后不再发送，完成回调归还该块
+        block->abandoned = 1;
+    xSemaphoreGive(send_block_mutex);
     return ret;
 }
 
 // 异步下行数据包发送（带确认）
 uint32_t asyn_comm_send_pack_ack(uint8_t *src, uint8_t cmd, uint16_t size, CommPackSend_Cb send_cb, void *user_data, uint8_t max_retry_num)
 {
-    if(!send_req_queue_handle)
+    return asyn_comm_send_pack_ack_timeout(src, cmd, size, send_cb, user_data, COMM_DEFAULT_ACK_TIMEOUT_MS, max_retry_num, 0);
+}
+
+uint32_t asyn_comm_send_pack_ack_timeout(uint8_t *src, uint8_t cmd, uint16_t size, CommPackSend_Cb send_cb, void *user_data,
+                                         uint32_t time_out_ms, uint8_t max_retry_num, uint32_t wait_ms)
+{
+    DataTransReq_t req = {0};
+    req.cmd = cmd | PACK_NEED_ACK;
+    req.data = src;
+    req.size = size;
+    req.max_retry_cnt = max_retry_num;
+    req.timeout_ms = time_out_ms;
+    req.finished_cb = send_cb;
+    req.user_data = user_data;
+    return enqueue_send_req(&req, wait_ms);
+}
+
+uint32_t asyn_comm_send_pack_ack_to(uint8_t dst_node, uint8_t *src, uint8_t cmd, uint16_t size, CommPackSend_Cb send_cb,
+                                    void *user_data, uint32_t time_out_ms, uint8_t max_retry_num)
+{
+    if (!addressing_enabled() || dst_node >= COMM_NODE_MAX)
         return 0;
-    DataTransReq_t req;
+    DataTransReq_t req = {0};
     req.cmd = cmd | PACK_NEED_ACK;
     req.data = src;
     req.size = size;
     req.max_retry_cnt = max_retry_num;
+    req.timeout_ms = time_out_ms;
     req.finished_cb = send_cb;
     req.user_data = user_data;
-    return xQueueSend(send_req_queue_handle, &req, 0);
+    req.dst = COMM_NODE_MASK(dst_node);
+    return enqueue_send_req(&req, 0);
+}
+
+uint32_t comm_send_queue_depth(void)
+{
+    if (!send_req_queue_handle)
+        return 0;
+    return uxQueueMessagesWaiting(send_req_queue_handle);
+}
+
+uint32_t comm_send_queue_free(void)
+{
+    if (!send_req_queue_handle)
+        return 0;
+    return uxQueueSpacesAvailable(send_req_queue_handle);
+}
+
+uint32_t comm_ack_pending(void)
+{
+    if (!send_ack_blocks_mutex)
+        return 0;
+    uint32_t n = 0;
+    xSemaphoreTake(send_ack_blocks_mutex, portMAX_DELAY);
+    for (int i = 0; i < 8; i++)
+        n += send_ack_blocks[i].is_using ? 1 : 0;
+    xSemaphoreGive(send_ack_blocks_mutex);
+    return n;
+}
+
+void comm_set_tx_trace(CommTxTraceCb_t callback)
+{
+#if COMM_TX_TRACE
+    kTxTrace = callback;
+#endif
+}
+
+void comm_set_rx_hook(CommRxHookCb_t callback)
+{
+    kRxHook = callback;
+}
+
+uint32_t comm_set_queue_watermark(uint8_t high, uint8_t low, CommQueueWatermarkCb_t callback, void *user_data)
+{
+    if (callback && (high == 0 || high > COMM_SEND_QUEUE_LEN || low >= high))
+        return 0;
+    queue_watermark_lock();
+    kQueueWatermark.high = high;
+    kQueueWatermark.low = low;
+    kQueueWatermark.is_high = 0;
+    kQueueWatermark.callback = callback;
+    kQueueWatermark.user_data = user_data;
+    xSemaphoreGive(queue_watermark_mutex);
+    return 1;
+}
+
+uint32_t comm_set_compress_cmd(uint8_t cmd, uint8_t enable)
+{
+    cmd &= PACK_CMD_MASK;
+    if (cmd == CMD_LINK_CTRL)
+        return 0;
+    if (!enable)
+    {
+        kCompressMask &= (uint16_t)~(1u << cmd);
+        return 1;
+    }
+#if COMM_USE_LZ4
+    if (!kLz4State)
+        kLz4State = malloc(LZ4_sizeofState());
+    if (!kLz4State)
+        return 0;
+    kCompressMask |= (uint16_t)(1u << cmd);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+uint32_t comm_set_node_id(uint8_t node_id)
+{
+    if (node_id >= COMM_NODE_MAX && node_id != COMM_NODE_NONE)
+        return 0;
+    kNodeId = node_id;
+    return 1;
+}
+
+uint8_t comm_get_node_id(void)
+{
+    return kNodeId;
+}
+
+void comm_set_default_dst(uint8_t dst_mask)
+{
+    kDefaultDst = dst_mask ? dst_mask : COMM_NODE_BROADCAST;
+}
+
+uint8_t comm_get_default_dst(void)
+{
+    return kDefaultDst;
+}
+
+uint8_t comm_recv_src_node(void)
+{
+    return kRecvSrcNode;
+}
+
+uint32_t comm_get_node_stats(uint8_t node, CommNodeStats_t *stats)
+{
+    if (node >= COMM_NODE_MAX && node != COMM_NODE_NONE)
+        return 0;
+    *stats = node_state(node)->stats;
+    return 1;
+}
+
+void comm_get_stats(CommStats_t *stats)
+{
+    *stats = kCommStats;
+}
+
+void comm_reset_stats(void)
+{
+    memset(&kCommStats, 0, sizeof(kCommStats));
+    for (int i = 0; i <= COMM_NODE_MAX; i++)
+    {
+        kNodeState[i].stats.rx_frames = 0;
+        kNodeState[i].stats.rx_duplicates = 0;
+    }
 }
@@ -2,6 +2,10 @@
 #define __COMM_H__
 
 #include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "comm_port.h"
 
 typedef void(*BadDataPackCb_t)(uint32_t type);
 
@@ -9,13 +13,89 @@ typedef void(*CommPackRecv_Cb)(uint8_t *src,uint16_t size,void* user_data);
 
 typedef void(*CommPackSend_Cb)(void*user_data,uint32_t is_success);
 
+// 发送队列水位回调：is_high 为1表示队列深度达到高水位，为0表示回落到低水位
+typedef void(*CommQueueWatermarkCb_t)(uint32_t is_high,uint32_t depth,void* user_data);
+
+// 发送请求队列长度
+#define COMM_SEND_QUEUE_LEN     8
+
+// 发送路径跟踪点（用于测量延迟，见 latency_trace.h），定义为0时不编译跟踪点
+#ifndef COMM_TX_TRACE
+#define COMM_TX_TRACE           1
+#endif
+#define COMM_TX_TRACE_ENQUEUE   0       // 用户发送请求即将放入发送队列（在发送者的任务中，入队失败时没有后续跟踪点）
+#define COMM_TX_TRACE_DEQUEUE   1       // 发送任务取出请求，开始封包
+#define COMM_TX_TRACE_WRITTEN   2       // 整帧交给链路端口（串口驱动）写入完成
+
+// 发送路径跟踪回调：cmd 为请求的命令字段，stage 为 COMM_TX_TRACE_*；在入队/发送任务中执行，不能阻塞
+typedef void(*CommTxTraceCb_t)(uint8_t cmd,uint8_t stage);
+
+// 接收回调：接收任务每读到一个帧头字节调用一次（包括之后被判为坏帧的），在接收任务中执行，不能阻塞
+typedef void(*CommRxHookCb_t)(void);
+
+// 多机寻址：节点号 0~COMM_NODE_MAX-1，目的地址和接收过滤都用节点掩码（bit n 对应节点 n）
+// 约定遥控器为节点0，机器人为节点1~7
+#define COMM_NODE_MAX           8
+#define COMM_NODE_NONE          0xFF        // 节点号：未配置（不使用寻址）/ 不带地址的包的来源
+#define COMM_NODE_BROADCAST     0xFF        // 目的掩码：全部节点
+#define COMM_NODE_ANY           0xFF        // 接收过滤掩码：不过滤（包括不带地址的包）
+#define COMM_NODE_MASK(n)       ((uint8_t)(1u << (n)))
+
+// 延迟分发的接收帧池大小，以及单帧数据的最大长度（解压后）
+#define COMM_RX_POOL_SIZE       8
+#define COMM_RX_FRAME_MAX       256
+
+// 延迟分发的接收帧（引用计数、来自接收帧池），处理完后调用 comm_rx_frame_release 归还
+typedef struct
+{
+    uint8_t cmd;            // 命令字段（低4位）
+    uint8_t src_node;       // 源节点，不带地址的包为 COMM_NODE_NONE
+    uint16_t size;          // 数据长度
+    int64_t recv_ms;        // 接收时间（comm_get_time_ms）
+    uint8_t data[COMM_RX_FRAME_MAX];
+} CommRxFrame_t;
+
+// 链路统计（计数从初始化开始累加，可用 comm_reset_stats 清零）
+typedef struct
+{
+    uint32_t tx_frames;     // 发出的数据帧（包含重发）
+    uint32_t tx_acks;       // 发出的ACK确认帧
+    uint32_t rx_frames;     // 接收并校验通过的数据帧
+    uint32_t rx_acks;       // 收到并匹配到挂起包的ACK
+    uint32_t retransmits;   // 超时重发次数
+    uint32_t send_failed;   // 重试耗尽仍未收到ACK的包
+    uint32_t bad_frames;    // 包头/长度/校验错误的帧
+    uint32_t tx_rejected;   // 因发送队列满或流控暂停而未能入队的发送请求
+    uint32_t tx_compressed; // 以压缩形式发出的数据帧
+    uint32_t tx_saved_bytes;// 压缩节省的字节数
+    uint32_t rx_duplicates; // 重复收到的需要ACK的包（对端重发），已回复ACK但不分发
+    uint32_t rx_filtered;   // 发给其它节点而丢弃的包
+    uint32_t rx_deferred_dropped;   // 延迟分发时接收帧池空或处理队列满而没有送达的次数
+} CommStats_t;
+
+// 单个对端节点的接收统计
+typedef struct
+{
+    uint32_t rx_frames;     // 分发给应用层的包
+    uint32_t rx_duplicates; // 重复的包
+    int64_t last_rx_ms;     // 最近一次收到该节点数据包的时间（comm_get_time_ms），0 表示从未收到
+} CommNodeStats_t;
+
 /**
- * @brief 遥控器通信模块初始化
+ * @brief 遥控器通信模块初始化（使用串口/LORA模块作为链路）
  * @param callback 接收到错误数据包时的回调
  * @return void
  */
 void RemoteCommInit(BadDataPackCb_t callback);
 
+/**
+ * @brief 使用指定的链路端口初始化通信模块（回环测试、STM32适配层等）
+ * @param callback 接收到错误数据包时的回调
+ * @param port 链路端口，生命周期须覆盖整个通信过程
+ * @return void
+ */
+void RemoteCommInitWithPort(BadDataPackCb_t callback, const CommPort_t *port);
+
 /**
  * @brief 注册通信模块接收回调
  * @param callback 接收回调
@@ -25,6 +105,45 @@ void RemoteCommInit(BadDataPackCb_t callback);
  */
 uint32_t register_comm_recv_cb(CommPackRecv_Cb callback,uint8_t cmd,void* user_data);
 
+/**
+ * @brief 注册通信模块接收回调，只接收指定节点发来的包
+ * @param callback 接收回调，回调中可用 comm_recv_src_node() 获取源节点
+ * @param cmd 命令字段（匹配时调用回调）
+ * @param src_mask 源节点掩码（COMM_NODE_MASK(n) 的组合）；COMM_NODE_ANY 不过滤，同 register_comm_recv_cb
+ * @param user_data 其它用户数据
+ * @return 注册ID
+ */
+uint32_t register_comm_recv_cb_from(CommPackRecv_Cb callback,uint8_t cmd,uint8_t src_mask,void* user_data);
+
+/**
+ * @brief 以延迟分发方式注册接收：匹配的包拷贝到接收帧池，把 CommRxFrame_t* 放入 queue，由处理任务稍后处理
+ * @param queue 处理队列，元素大小为 sizeof(CommRxFrame_t *)；队列满时丢弃该包（计入 rx_deferred_dropped）
+ * @param cmd 命令字段（匹配时投递）
+ * @param src_mask 源节点掩码，COMM_NODE_ANY 不过滤
+ * @param notify_task 非NULL时每投递一帧对该任务 xTaskNotifyGive，一个任务同时等待多个来源时使用
+ * @return 注册ID（用 unregister_comm_recv_cb 取消）；0 参数错误
+ *
+ * @note 处理较慢的接收者（例如要拿LVGL锁的界面）应使用这种方式，避免阻塞接收任务导致串口缓冲溢出。
+ *       从队列取出的帧处理完后必须调用 comm_rx_frame_release()，否则接收帧池会耗尽。
+ *       多个接收者匹配同一个包时共用一份拷贝，引用计数归零时才归还。
+ */
+uint32_t register_comm_recv_queue(QueueHandle_t queue,uint8_t cmd,uint8_t src_mask,TaskHandle_t notify_task);
+
+/**
+ * @brief 增加接收帧的引用（需要把帧再转交给其它任务时使用）
+ */
+void comm_rx_frame_retain(CommRxFrame_t *frame);
+
+/**
+ * @brief 释放接收帧的引用，引用计数归零时归还接收帧池
+ */
+void comm_rx_frame_release(CommRxFrame_t *frame);
+
+/**
+ * @brief 接收帧池剩余空闲帧数
+ */
+uint32_t comm_rx_pool_free(void);
+
 /**
  * @brief 取消注册通信模块接收回调
  * @param cb_id 注册ID
@@ -43,34 +162,164 @@ uint32_t unregister_comm_recv_cb(uint32_t cb_id);
 uint32_t asyn_comm_send_pack_nak(uint8_t *src,uint8_t cmd,uint16_t size);
 
 /**
- * @brief 阻塞方式发送一个数据包，并且等待接收端应答直到超时或者
+ * @brief 同 asyn_comm_send_pack_nak，但发送队列满或批量命令被流控暂停时最多等待 wait_ms
+ * @param wait_ms 入队最多等待的时间（ms），portMAX_DELAY 表示一直等待
+ * @return 1 已放入发送队列；0 等待超时
+ */
+uint32_t asyn_comm_send_pack_nak_timeout(uint8_t *src,uint8_t cmd,uint16_t size,uint32_t wait_ms);
+
+/**
+ * @brief 同 asyn_comm_send_pack_nak，发送给指定的节点（需要先 comm_set_node_id）
+ * @param dst_mask 目的节点掩码，可包含多个节点：一次发送，多个机器人同时收到
+ * @return 1 已放入发送队列；0 未配置节点号/队列满
+ */
+uint32_t asyn_comm_send_pack_nak_to(uint8_t dst_mask,uint8_t *src,uint8_t cmd,uint16_t size);
+
+/**
+ * @brief 阻塞方式发送一个数据包，并且等待接收端应答直到超时或者重试次数耗尽
  * @param src 要发送的数据包内容
  * @param cmd 数据包命令字段
  * @param size 数据包的内容的长度（不包含命令字段）
- * @param time_out_ms 每次发送等待ACK包的超时时间（ms）
+ * @param time_out_ms 每次发送等待ACK包的超时时间（ms），发送队列满时也最多等待这么久
  * @param max_retry_num 最大的尝试重发次数
  * @return 1发送成功；0发送失败（没有收到应道/发送请求队列满/ACK挂起线程池满）
  *
+ * @note 最长阻塞 time_out_ms*(max_retry_num+1) 再加少量余量。返回0后协议层不会再读取 src。
+ *
  * @note 本实现为零拷贝重传：当 cmd 需要 ACK 且启用超时重发时，src 指针必须在“收到 ACK 或最终失败回调”之前一直保持有效，
  *       并且内容不能被修改，否则重发可能发送错误数据或崩溃。
  */
 uint32_t comm_send_pack_ack(uint8_t *src, uint8_t cmd, uint16_t size, uint32_t time_out_ms, uint8_t max_retry_num);
 
 /**
- *  * @brief 阻塞方式发送一个数据包，并且等待接收端应答直到超时或者
+ * @brief 非阻塞方式发送一个需要应答的数据包，结果通过 send_cb 通知，每次等待ACK的超时为 COMM_DEFAULT_ACK_TIMEOUT_MS(100ms)
  * @param src 要发送的数据包内容
  * @param cmd 数据包命令字段
  * @param size 数据包的内容的长度（不包含命令字段）
  * @param send_cb 发送完成回调（超时或者收到应答包）
  * @param user_data 回调函数其它用户数据
- * @param time_out_ms 每次发送等待ACK包的超时时间（ms）
  * @param max_retry_num 最大的尝试重发次数
- * @return 1发送成功；0发送失败（没有收到应道/发送请求队列满/ACK挂起线程池满）
- */
-/**
+ * @return 1已放入发送队列；0发送队列满（此时不会调用 send_cb）
+ *
  * @note 本实现为零拷贝重传：当 cmd 需要 ACK 且启用超时重发时，src 指针必须在“收到 ACK 或最终失败回调”之前一直保持有效，
  *       并且内容不能被修改，否则重发可能发送错误数据或崩溃。
  */
 uint32_t asyn_comm_send_pack_ack(uint8_t *src,uint8_t cmd,uint16_t size,CommPackSend_Cb send_cb,void* user_data,uint8_t max_retry_num);
 
+/**
+ * @brief 同 asyn_comm_send_pack_ack，可指定ACK超时，发送队列满或批量命令被流控暂停时最多等待 wait_ms
+ * @param time_out_ms 每次发送等待ACK包的超时时间（ms）
+ * @param wait_ms 入队最多等待的时间（ms），portMAX_DELAY 表示一直等待
+ * @return 1已放入发送队列；0等待超时（此时不会调用 send_cb）
+ */
+uint32_t asyn_comm_send_pack_ack_timeout(uint8_t *src,uint8_t cmd,uint16_t size,CommPackSend_Cb send_cb,void* user_data,
+                                         uint32_t time_out_ms,uint8_t max_retry_num,uint32_t wait_ms);
+
+/**
+ * @brief 同 asyn_comm_send_pack_ack_timeout（wait_ms 为0），发送给指定的一个节点，只接受该节点的ACK（需要先 comm_set_node_id）
+ * @param dst_node 目的节点号
+ * @return 1已放入发送队列；0未配置节点号/节点号错误/队列满
+ */
+uint32_t asyn_comm_send_pack_ack_to(uint8_t dst_node,uint8_t *src,uint8_t cmd,uint16_t size,CommPackSend_Cb send_cb,void* user_data,
+                                    uint32_t time_out_ms,uint8_t max_retry_num);
+
+/**
+ * @brief 发送队列中等待发送的请求个数（含协议层排队的ACK和重发）
+ */
+uint32_t comm_send_queue_depth(void);
+
+/**
+ * @brief 发送队列剩余空位
+ */
+uint32_t comm_send_queue_free(void);
+
+/**
+ * @brief 已发出、正在等待ACK（含等待重发）的包个数
+ */
+uint32_t comm_ack_pending(void);
+
+/**
+ * @brief 设置发送队列水位回调，应用层可据此节流批量数据（在 RemoteCommInit 之后调用）
+ * @param high 高水位，队列深度 >= high 时回调 is_high=1
+ * @param low 低水位，之后深度 <= low 时回调 is_high=0
+ * @param callback 回调，NULL 表示取消；在入队/出队的任务中执行，不能阻塞
+ * @param user_data 其它用户数据
+ * @return 1 成功；0 参数错误（需要 0 <= low < high <= COMM_SEND_QUEUE_LEN）
+ */
+uint32_t comm_set_queue_watermark(uint8_t high,uint8_t low,CommQueueWatermarkCb_t callback,void* user_data);
+
+/**
+ * @brief 设置发送路径跟踪回调（COMM_TX_TRACE 为0时无效）
+ * @param callback 回调，NULL 表示取消
+ */
+void comm_set_tx_trace(CommTxTraceCb_t callback);
+
+/**
+ * @brief 设置接收回调，例如电源管理据此在对端发送期间保持唤醒
+ * @param callback 回调，NULL 表示取消
+ */
+void comm_set_rx_hook(CommRxHookCb_t callback);
+
+/**
+ * @brief 开启/关闭某个命令的数据压缩（LZ4）
+ * @param cmd 命令字段（只看低4位）
+ * @param enable 1 开启；0 关闭
+ * @return 1 成功；0 未编译压缩支持（需要开启 LV_USE_LZ4_INTERNAL）或内存不足
+ *
+ * @note 开启后数据域压缩后更短才以压缩形式发送（命令字段置0x40），接收端自动解压，不需要任何配置。
+ *       适合字符串反馈、日志等文本数据；摇杆控制帧这类短小的二进制数据压缩不了，不要开启。
+ *       第一次开启时会申请约16KB的压缩状态内存。
+ */
+uint32_t comm_set_compress_cmd(uint8_t cmd, uint8_t enable);
+
+/**
+ * @brief 设置本端节点号，开启多机寻址
+ * @param node_id 0~COMM_NODE_MAX-1；COMM_NODE_NONE 关闭寻址（默认）
+ * @return 1 成功；0 节点号错误
+ *
+ * @note 开启后发出的包都带源/目的地址（每包多2字节），并丢弃发给其它节点的包；不带地址的包照常接收。
+ *       未开启寻址的一端仍可接收带地址的包（不过滤目的地址）。
+ */
+uint32_t comm_set_node_id(uint8_t node_id);
+
+/**
+ * @brief 本端节点号，COMM_NODE_NONE 表示未开启寻址
+ */
+uint8_t comm_get_node_id(void);
+
+/**
+ * @brief 设置默认目的节点，不指定目的节点的发送接口都发往这里（遥控器切换控制的机器人时调用）
+ * @param dst_mask 目的节点掩码，0 或 COMM_NODE_BROADCAST 表示全部节点
+ */
+void comm_set_default_dst(uint8_t dst_mask);
+
+/**
+ * @brief 当前的默认目的节点掩码
+ */
+uint8_t comm_get_default_dst(void);
+
+/**
+ * @brief 正在分发的数据包的源节点，只在接收回调中有效
+ * @return 节点号；不带地址的包返回 COMM_NODE_NONE
+ */
+uint8_t comm_recv_src_node(void);
+
+/**
+ * @brief 读取某个对端节点的接收统计
+ * @param node 节点号；COMM_NODE_NONE 为不带地址的包的统计
+ * @return 1 成功；0 节点号错误
+ */
+uint32_t comm_get_node_stats(uint8_t node, CommNodeStats_t *stats);
+
+/**
+ * @brief 读取链路统计
+ * @param stats 输出
+ */
+void comm_get_stats(CommStats_t *stats);
+
+/**
+ * @brief 清零链路统计
+ */
+void comm_reset_stats(void);
+
 #endif
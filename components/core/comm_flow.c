@@ -0,0 +1,162 @@
+#include "comm_flow.h"
+#include "comm_port.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+typedef struct
+{
+    uint16_t bulk_mask;         // 批量命令位图（按 cmd & PACK_CMD_MASK）
+
+    // 接收端：向对端通告本端窗口
+    uint8_t rx_enabled;
+    uint8_t rx_dirty;           // 窗口有变化，尽快通告
+    uint16_t rx_window;
+    int64_t rx_advert_ms;       // 最近一次通告入队的时间
+
+    // 发送端：按对端通告限制批量发送
+    uint8_t tx_limited;         // 已收到对端通告且未过期
+    uint16_t tx_credits;
+    int64_t tx_credit_ms;       // 最近一次收到通告的时间
+} FlowState_t;
+
+static FlowState_t kFlow;
+static SemaphoreHandle_t flow_mutex;
+
+static void flow_lock(void)
+{
+    xSemaphoreTake(flow_mutex, portMAX_DELAY);
+}
+
+static void flow_unlock(void)
+{
+    xSemaphoreGive(flow_mutex);
+}
+
+void flow_init(void)
+{
+    flow_mutex = xSemaphoreCreateMutex();
+}
+
+static uint32_t flow_is_bulk(uint8_t cmd)
+{
+    return (kFlow.bulk_mask >> (cmd & PACK_CMD_MASK)) & 1u;
+}
+
+// 通告过期视为对端关闭了流控（调用时已持有锁）
+static void flow_check_expire(int64_t now_ms)
+{
+    if (kFlow.tx_limited && now_ms - kFlow.tx_credit_ms > COMM_FLOW_EXPIRE_MS)
+        kFlow.tx_limited = 0;
+}
+
+uint32_t comm_flow_set_bulk_cmd(uint8_t cmd, uint8_t is_bulk)
+{
+    cmd &= PACK_CMD_MASK;
+    if (cmd == CMD_LINK_CTRL)
+        return 0;
+    flow_lock();
+    if (is_bulk)
+        kFlow.bulk_mask |= (uint16_t)(1u << cmd);
+    else
+        kFlow.bulk_mask &= (uint16_t)~(1u << cmd);
+    flow_unlock();
+    return 1;
+}
+
+void comm_flow_set_rx_window(uint16_t window)
+{
+    flow_lock();
+    if (!kFlow.rx_enabled || kFlow.rx_window != window)
+        kFlow.rx_dirty = 1;
+    kFlow.rx_enabled = 1;
+    kFlow.rx_window = window;
+    flow_unlock();
+}
+
+void comm_flow_stop_rx(void)
+{
+    flow_lock();
+    kFlow.rx_enabled = 0;
+    kFlow.rx_dirty = 0;
+    flow_unlock();
+}
+
+uint32_t comm_flow_tx_credits(void)
+{
+    uint32_t credits = COMM_FLOW_UNLIMITED;
+    flow_lock();
+    flow_check_expire(comm_get_time_ms());
+    if (kFlow.tx_limited)
+        credits = kFlow.tx_credits;
+    flow_unlock();
+    return credits;
+}
+
+uint32_t flow_take_credit(uint8_t cmd)
+{
+    if (!flow_is_bulk(cmd))
+        return 1;
+    uint32_t ok = 1;
+    flow_lock();
+    flow_check_expire(comm_get_time_ms());
+    if (kFlow.tx_limited)
+    {
+        if (kFlow.tx_credits)
+            kFlow.tx_credits--;
+        else
+            ok = 0;
+    }
+    flow_unlock();
+    return ok;
+}
+
+void flow_return_credit(uint8_t cmd)
+{
+    if (!flow_is_bulk(cmd))
+        return;
+    flow_lock();
+    if (kFlow.tx_limited && kFlow.tx_credits < 0xFFFF)
+        kFlow.tx_credits++;
+    flow_unlock();
+}
+
+uint32_t flow_build_advert(int64_t now_ms, PackFlowCredit_t *advert)
+{
+    uint32_t need = 0;
+    flow_lock();
+    if (kFlow.rx_enabled && (kFlow.rx_dirty || now_ms - kFlow.rx_advert_ms >= COMM_FLOW_REFRESH_MS))
+    {
+        advert->type = LINK_CTRL_FLOW_CREDIT;
+        advert->window = kFlow.rx_window;
+        need = 1;
+    }
+    flow_unlock();
+    return need;
+}
+
+void flow_advert_sent(int64_t now_ms)
+{
+    flow_lock();
+    kFlow.rx_dirty = 0;
+    kFlow.rx_advert_ms = now_ms;
+    flow_unlock();
+}
+
+void flow_on_data_received(uint8_t cmd)
+{
+    if (!flow_is_bulk(cmd))
+        return;
+    flow_lock();
+    if (kFlow.rx_enabled && kFlow.rx_window)
+        kFlow.rx_window--;
+    flow_unlock();
+}
+
+void flow_on_credit(const PackFlowCredit_t *credit, int64_t now_ms)
+{
+    flow_lock();
+    kFlow.tx_limited = 1;
+    kFlow.tx_credits = credit->window;
+    kFlow.tx_credit_ms = now_ms;
+    flow_unlock();
+}
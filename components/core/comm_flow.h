@@ -0,0 +1,89 @@
+#ifndef __COMM_FLOW_H__
+#define __COMM_FLOW_H__
+
+#include <stdint.h>
+#include "dataFrame.h"
+
+/*
+ * 批量数据流控（接收窗口信用）：
+ * 接收端（例如消费较慢的机器人）调用 comm_flow_set_rx_window() 声明当前还能接收多少个批量数据包，
+ * 协议层在窗口变化时立即、之后每 COMM_FLOW_REFRESH_MS 把窗口通告给对端（链路控制帧 LINK_CTRL_FLOW_CREDIT）。
+ * 每收到一个批量数据包窗口自动减一，应用层消费掉数据后再调用 comm_flow_set_rx_window() 补充窗口。
+ * 发送端每收到一次通告就把可用额度重置为通告的窗口，每发送一个批量数据包消耗一个额度，额度用完即暂停批量发送：
+ * asyn_comm_send_pack_nak/ack 对批量命令直接返回0，*_timeout 变体最多等待 wait_ms 直到额度恢复。
+ * 只有用 comm_flow_set_bulk_cmd() 标记为批量的命令受流控限制（收发双方都要标记），控制帧等不受影响。
+ *
+ * 对端从未发送过通告（未开启流控）或通告超过 COMM_FLOW_EXPIRE_MS 没有刷新时，发送端不做限制。
+ * 通告生成时已在途的数据包不计入窗口，接收端的窗口应留出少量余量。
+ * 本文件的接口都在 RemoteCommInit 之后调用。
+ */
+
+#define COMM_FLOW_REFRESH_MS    200         // 窗口不变时的通告刷新周期
+#define COMM_FLOW_EXPIRE_MS     1000        // 超过该时间没有收到通告，发送端解除限制
+#define COMM_FLOW_UNLIMITED     0xFFFFFFFFu // comm_flow_tx_credits 的返回值：不受限
+
+/**
+ * @brief 标记/取消标记批量命令
+ * @param cmd 命令字段（只看低4位）
+ * @param is_bulk 1 批量命令，受流控限制；0 不受限制
+ * @return 1 成功；0 参数错误（链路控制命令不能标记）
+ */
+uint32_t comm_flow_set_bulk_cmd(uint8_t cmd, uint8_t is_bulk);
+
+/**
+ * @brief 接收端设置本端还能接收的批量数据包个数，并开始向对端通告（0 表示暂停对端的批量发送）
+ * @param window 接收窗口
+ */
+void comm_flow_set_rx_window(uint16_t window);
+
+/**
+ * @brief 接收端停止通告，对端在 COMM_FLOW_EXPIRE_MS 后解除限制
+ */
+void comm_flow_stop_rx(void);
+
+/**
+ * @brief 发送端当前可用的批量发送额度
+ * @return 额度；对端未开启流控时返回 COMM_FLOW_UNLIMITED
+ */
+uint32_t comm_flow_tx_credits(void);
+
+/* -------------------- 以下接口供 comm.c 内部使用 -------------------- */
+
+/**
+ * @brief 创建互斥锁，由 RemoteCommInitWithPort 在创建通信任务之前调用
+ */
+void flow_init(void);
+
+/**
+ * @brief 发送批量命令前申请一个额度（非批量命令直接成功）
+ * @return 1 获得额度；0 对端窗口已满
+ */
+uint32_t flow_take_credit(uint8_t cmd);
+
+/**
+ * @brief 申请到额度后入队失败，归还额度
+ */
+void flow_return_credit(uint8_t cmd);
+
+/**
+ * @brief 生成窗口通告
+ * @return 1 需要发送（窗口变化或到了刷新周期）；0 不需要
+ */
+uint32_t flow_build_advert(int64_t now_ms, PackFlowCredit_t *advert);
+
+/**
+ * @brief 通告已放入发送队列，记录发送时间（入队失败时不调用，下个周期重试）
+ */
+void flow_advert_sent(int64_t now_ms);
+
+/**
+ * @brief 收到一个数据包，批量命令占用一个接收窗口
+ */
+void flow_on_data_received(uint8_t cmd);
+
+/**
+ * @brief 收到对端窗口通告
+ */
+void flow_on_credit(const PackFlowCredit_t *credit, int64_t now_ms);
+
+#endif
@@ -0,0 +1,207 @@
+#include <string.h>
+#include "comm_link.h"
+#include "comm_port.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+typedef struct
+{
+    uint8_t state;              // CommLinkState_t
+    uint16_t period_ms;
+    uint8_t miss_threshold;
+    uint16_t peer_period_ms;    // 对端心跳周期（收到心跳前按本端周期）
+    int64_t last_rx_ms;
+    int64_t last_tx_ms;
+
+    CommLinkStateCb_t callback;
+    void *user_data;
+
+    uint8_t failsafe_set;
+    uint8_t failsafe_cmd;
+    uint16_t failsafe_size;
+    uint8_t failsafe[COMM_LINK_FAILSAFE_MAX];
+
+    CommLinkStats_t stats;
+} LinkState_t;
+
+static LinkState_t kLink;
+static SemaphoreHandle_t link_mutex;
+
+static void link_lock(void)
+{
+    xSemaphoreTake(link_mutex, portMAX_DELAY);
+}
+
+static void link_unlock(void)
+{
+    xSemaphoreGive(link_mutex);
+}
+
+void link_init(void)
+{
+    link_mutex = xSemaphoreCreateMutex();
+}
+
+// 判定超时按两端周期中较长的一个（调用时已持有锁）
+static uint32_t link_timeout_ms(void)
+{
+    uint16_t period = kLink.peer_period_ms > kLink.period_ms ? kLink.peer_period_ms : kLink.period_ms;
+    return (uint32_t)period * kLink.miss_threshold;
+}
+
+uint32_t comm_link_config(const CommLinkConfig_t *cfg)
+{
+    if (cfg && (cfg->period_ms == 0 || cfg->miss_threshold < 2))
+        return 0;
+    link_lock();
+    if (!cfg)
+        kLink.state = COMM_LINK_OFF;
+    else
+    {
+        kLink.period_ms = cfg->period_ms;
+        kLink.miss_threshold = cfg->miss_threshold;
+        kLink.peer_period_ms = 0;
+        if (kLink.state == COMM_LINK_OFF)
+            kLink.state = COMM_LINK_WAITING;
+    }
+    link_unlock();
+    return 1;
+}
+
+void comm_link_set_state_cb(CommLinkStateCb_t callback, void *user_data)
+{
+    link_lock();
+    kLink.callback = callback;
+    kLink.user_data = user_data;
+    link_unlock();
+}
+
+uint32_t comm_link_set_failsafe(uint8_t cmd, const void *frame, uint16_t size)
+{
+    if (frame && (size == 0 || size > COMM_LINK_FAILSAFE_MAX))
+        return 0;
+    link_lock();
+    kLink.failsafe_set = (frame != NULL);
+    if (frame)
+    {
+        kLink.failsafe_cmd = cmd;
+        kLink.failsafe_size = size;
+        memcpy(kLink.failsafe, frame, size);
+    }
+    link_unlock();
+    return 1;
+}
+
+uint32_t comm_link_state(void)
+{
+    return kLink.state;
+}
+
+void comm_link_get_stats(CommLinkStats_t *stats)
+{
+    link_lock();
+    *stats = kLink.stats;
+    stats->state = kLink.state;
+    stats->timeout_ms = kLink.state == COMM_LINK_OFF ? 0 : link_timeout_ms();
+    stats->detect_bound_ms = kLink.state == COMM_LINK_OFF ? 0 : stats->timeout_ms + COMM_LINK_CHECK_PERIOD_MS;
+    stats->last_rx_ms = kLink.last_rx_ms;
+    link_unlock();
+}
+
+// 64位时间戳在32位MCU上不是一次写完的，读写都要持有锁
+void link_on_rx(int64_t now_ms)
+{
+    link_lock();
+    kLink.last_rx_ms = now_ms;
+    link_unlock();
+}
+
+void link_on_heartbeat(const PackHeartbeat_t *hb)
+{
+    link_lock();
+    kLink.peer_period_ms = hb->period_ms;
+    kLink.stats.hb_rx++;
+    link_unlock();
+}
+
+void link_on_tx(int64_t now_ms)
+{
+    link_lock();
+    kLink.last_tx_ms = now_ms;
+    link_unlock();
+}
+
+uint32_t link_build_heartbeat(int64_t now_ms, PackHeartbeat_t *hb)
+{
+    link_lock();
+    uint32_t due = kLink.state != COMM_LINK_OFF && now_ms - kLink.last_tx_ms >= kLink.period_ms;
+    if (due)
+    {
+        hb->type = LINK_CTRL_HEARTBEAT;
+        hb->period_ms = kLink.period_ms;
+    }
+    link_unlock();
+    return due;
+}
+
+void link_heartbeat_sent(void)
+{
+    link_lock();
+    kLink.stats.hb_tx++;
+    link_unlock();
+}
+
+int32_t link_check(int64_t now_ms)
+{
+    int32_t changed = -1;
+    link_lock();
+    int64_t last_rx = kLink.last_rx_ms;
+    uint8_t alive = last_rx && now_ms - last_rx <= (int64_t)link_timeout_ms();
+    switch (kLink.state)
+    {
+    case COMM_LINK_WAITING:
+    case COMM_LINK_LOST:
+        if (alive)
+            changed = kLink.state = COMM_LINK_UP;
+        break;
+    case COMM_LINK_UP:
+        if (!alive)
+        {
+            changed = kLink.state = COMM_LINK_LOST;
+            uint32_t latency = (uint32_t)(now_ms - last_rx);
+            kLink.stats.last_detect_ms = latency;
+            if (latency > kLink.stats.max_detect_ms)
+                kLink.stats.max_detect_ms = latency;
+            kLink.stats.loss_count++;
+        }
+        break;
+    default:
+        break;
+    }
+    link_unlock();
+    return changed;
+}
+
+void link_notify(uint32_t state)
+{
+    link_lock();
+    CommLinkStateCb_t callback = kLink.callback;
+    void *user_data = kLink.user_data;
+    link_unlock();
+    if (callback)
+        callback(state, user_data);
+}
+
+uint32_t link_get_failsafe(uint8_t *cmd, uint8_t *buf, uint16_t *size)
+{
+    link_lock();
+    uint32_t ok = kLink.failsafe_set;
+    if (ok)
+    {
+        *cmd = kLink.failsafe_cmd;
+        *size = kLink.failsafe_size;
+        memcpy(buf, kLink.failsafe, kLink.failsafe_size);
+    }
+    link_unlock();
+    return ok;
+}
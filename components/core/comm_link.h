@@ -0,0 +1,142 @@
+#ifndef __COMM_LINK_H__
+#define __COMM_LINK_H__
+
+#include <stdint.h>
+#include "dataFrame.h"
+
+/*
+ * 心跳与断线保护：
+ * 收到对端的任何数据包或ACK都算作链路存活；本端超过一个心跳周期没有发送任何帧时才补发心跳帧
+ * （链路控制帧 LINK_CTRL_HEARTBEAT），持续发送控制帧的遥控器实际上不会多发任何帧。
+ * 超过 心跳周期 × 丢失阈值 没有收到对端的帧判定为断线，心跳帧带有发送方的周期，接收方按对端周期判定，
+ * 两端周期配置不同也不会误判。
+ *
+ * 状态在 comm.c 的超时检查任务中每 COMM_LINK_CHECK_PERIOD_MS 判定一次，检测时延上限为
+ * 判定超时 + COMM_LINK_CHECK_PERIOD_MS，实际检测时延记录在 comm_link_get_stats() 中。
+ *
+ * 机器人端可用 comm_link_set_failsafe() 注册一帧“断线保护控制帧”（例如摇杆全0），断线时协议层把它当作收到的
+ * 数据包分发给该命令的接收者，只处理控制帧的代码不需要任何修改就能在断线时停车。
+ *
+ * 多机寻址时任何节点的帧都算作存活，各节点是否在线用 comm_get_node_stats() 的 last_rx_ms 判断。
+ * 本文件的接口都在 RemoteCommInit 之后调用。
+ */
+
+#define COMM_LINK_CHECK_PERIOD_MS   4       // 状态判定周期（超时检查任务周期）
+#define COMM_LINK_FAILSAFE_MAX      32      // 断线保护控制帧最大长度
+
+typedef enum
+{
+    COMM_LINK_OFF = 0,      // 未开启心跳
+    COMM_LINK_WAITING,      // 已开启，尚未收到过对端的帧
+    COMM_LINK_UP,           // 链路正常
+    COMM_LINK_LOST,         // 断线
+} CommLinkState_t;
+
+typedef struct
+{
+    uint16_t period_ms;     // 心跳周期：本端空闲超过该时间补发心跳
+    uint8_t miss_threshold; // 连续丢失多少个周期判定为断线（至少为2）
+} CommLinkConfig_t;
+
+typedef struct
+{
+    uint32_t state;             // CommLinkState_t
+    uint32_t timeout_ms;        // 当前判定超时（对端心跳周期 × 丢失阈值）
+    uint32_t detect_bound_ms;   // 检测时延上限（timeout_ms + COMM_LINK_CHECK_PERIOD_MS）
+    uint32_t last_detect_ms;    // 最近一次断线的实际检测时延（最后一次收到对端帧到判定断线）
+    uint32_t max_detect_ms;     // 实际检测时延的最大值
+    uint32_t loss_count;        // 断线次数
+    uint32_t hb_tx;             // 发出的心跳帧
+    uint32_t hb_rx;             // 收到的心跳帧
+    int64_t last_rx_ms;         // 最近一次收到对端帧的时间
+} CommLinkStats_t;
+
+/**
+ * @brief 链路状态变化回调，在 comm.c 的超时检查任务中执行，不能阻塞
+ * @param state 新状态 CommLinkState_t
+ */
+typedef void (*CommLinkStateCb_t)(uint32_t state, void *user_data);
+
+/**
+ * @brief 开启/关闭心跳，两端都需要开启
+ * @param cfg 配置；NULL 关闭
+ * @return 1 成功；0 参数错误
+ */
+uint32_t comm_link_config(const CommLinkConfig_t *cfg);
+
+/**
+ * @brief 设置链路状态变化回调
+ * @param callback 回调，NULL 取消
+ */
+void comm_link_set_state_cb(CommLinkStateCb_t callback, void *user_data);
+
+/**
+ * @brief 设置断线保护控制帧，断线时按收到该命令的数据包分发一次（源节点为 COMM_NODE_NONE）
+ * @param cmd 命令字段
+ * @param frame 控制帧内容（函数内拷贝）；NULL 取消
+ * @param size 长度，不超过 COMM_LINK_FAILSAFE_MAX
+ * @return 1 成功；0 参数错误
+ */
+uint32_t comm_link_set_failsafe(uint8_t cmd, const void *frame, uint16_t size);
+
+/**
+ * @brief 当前链路状态 CommLinkState_t
+ */
+uint32_t comm_link_state(void);
+
+/**
+ * @brief 读取心跳与断线检测统计
+ */
+void comm_link_get_stats(CommLinkStats_t *stats);
+
+/* -------------------- 以下接口供 comm.c 内部使用 -------------------- */
+
+/**
+ * @brief 创建互斥锁，由 RemoteCommInitWithPort 在创建通信任务之前调用
+ */
+void link_init(void);
+
+/**
+ * @brief 收到对端的数据包或ACK
+ */
+void link_on_rx(int64_t now_ms);
+
+/**
+ * @brief 收到对端心跳（先调用 link_on_rx）
+ */
+void link_on_heartbeat(const PackHeartbeat_t *hb);
+
+/**
+ * @brief 本端发出了一帧
+ */
+void link_on_tx(int64_t now_ms);
+
+/**
+ * @brief 生成心跳帧
+ * @return 1 本端已空闲一个周期，需要发送；0 不需要
+ */
+uint32_t link_build_heartbeat(int64_t now_ms, PackHeartbeat_t *hb);
+
+/**
+ * @brief 心跳已放入发送队列
+ */
+void link_heartbeat_sent(void);
+
+/**
+ * @brief 判定链路状态
+ * @return 状态变化时返回新状态；没有变化返回 -1
+ */
+int32_t link_check(int64_t now_ms);
+
+/**
+ * @brief 执行状态变化回调
+ */
+void link_notify(uint32_t state);
+
+/**
+ * @brief 取断线保护控制帧（拷贝到 buf，buf 至少 COMM_LINK_FAILSAFE_MAX 字节）
+ * @return 1 已设置；0 未设置
+ */
+uint32_t link_get_failsafe(uint8_t *cmd, uint8_t *buf, uint16_t *size);
+
+#endif
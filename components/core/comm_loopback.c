@@ -0,0 +1,102 @@
+#include "comm_loopback.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static int loopback_read(void *port_data, uint8_t *dst, uint16_t size, uint32_t timeout_ms)
+{
+    CommLoopbackEnd_t *e = (CommLoopbackEnd_t *)port_data;
+    StreamBufferHandle_t rx = e->owner->rx[e->end];
+
+    TickType_t start = xTaskGetTickCount();
+    uint16_t got = 0;
+    while (got < size)
+    {
+        TickType_t wait = portMAX_DELAY;
+        if (timeout_ms != portMAX_DELAY)
+        {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= pdMS_TO_TICKS(timeout_ms))
+                break;
+            wait = pdMS_TO_TICKS(timeout_ms) - elapsed;
+        }
+        size_t n = xStreamBufferReceive(rx, dst + got, size - got, wait);
+        if (n == 0 && timeout_ms != portMAX_DELAY)
+            break;
+        got += n;
+    }
+    return got;
+}
+
+static int loopback_write(void *port_data, const uint8_t *src, uint16_t size)
+{
+    CommLoopbackEnd_t *e = (CommLoopbackEnd_t *)port_data;
+    CommLoopback_t *lb = e->owner;
+    uint8_t self = e->end;
+    uint8_t peer = self ^ 1;
+
+    uint32_t air_ms = 0;
+    if (lb->cfg.air_bps)
+        air_ms = ((uint32_t)size * 10u * 1000u + lb->cfg.air_bps - 1) / lb->cfg.air_bps;
+
+    xSemaphoreTake(lb->mutex, portMAX_DELAY);
+    lb->stats.tx_frames[self]++;
+    lb->collided[self] = 0;
+    if (lb->cfg.half_duplex && lb->tx_active[peer]) // 对端正在发送，两帧都损坏
+    {
+        lb->collided[peer] = 1;
+        lb->collided[self] = 1;
+    }
+    lb->tx_active[self] = 1;
+    xSemaphoreGive(lb->mutex);
+
+    if (air_ms)
+        vTaskDelay(pdMS_TO_TICKS(air_ms));
+
+    xSemaphoreTake(lb->mutex, portMAX_DELAY);
+    lb->tx_active[self] = 0;
+    uint8_t collided = lb->collided[self];
+    if (collided)
+        lb->stats.collisions++;
+    xSemaphoreGive(lb->mutex);
+
+    if (!collided)
+        xStreamBufferSend(lb->rx[peer], src, size, portMAX_DELAY);
+    return size;
+}
+
+uint32_t comm_loopback_create(CommLoopback_t *lb, const CommLoopbackConfig_t *cfg)
+{
+    memset(lb, 0, sizeof(*lb));
+    if (cfg)
+        lb->cfg = *cfg;
+
+    lb->mutex = xSemaphoreCreateMutex();
+    lb->rx[0] = xStreamBufferCreate(COMM_LOOPBACK_BUFFER_SIZE, 1);
+    lb->rx[1] = xStreamBufferCreate(COMM_LOOPBACK_BUFFER_SIZE, 1);
+    if (!lb->mutex || !lb->rx[0] || !lb->rx[1])
+        return 0;
+
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        lb->ends[i].owner = lb;
+        lb->ends[i].end = i;
+        lb->ports[i].read = loopback_read;
+        lb->ports[i].write = loopback_write;
+        lb->ports[i].port_data = &lb->ends[i];
+    }
+    return 1;
+}
+
+const CommPort_t *comm_loopback_port(CommLoopback_t *lb, uint8_t end)
+{
+    if (end > 1)
+        return NULL;
+    return &lb->ports[end];
+}
+
+void comm_loopback_get_stats(CommLoopback_t *lb, CommLoopbackStats_t *stats)
+{
+    xSemaphoreTake(lb->mutex, portMAX_DELAY);
+    *stats = lb->stats;
+    xSemaphoreGive(lb->mutex);
+}
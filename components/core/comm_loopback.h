@@ -0,0 +1,69 @@
+#ifndef __COMM_LOOPBACK_H__
+#define __COMM_LOOPBACK_H__
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include "comm_port.h"
+
+/*
+ * 回环链路：两个端口（end 0 / end 1）之间用内存缓冲直连，一端写出的数据从另一端读出。
+ * 可选按空口速率模拟发送耗时，并模拟半双工信道：两端发送时间重叠时两帧都被丢弃（冲突）。
+ * 用于在没有LORA模块的情况下测试协议（包括TDMA时隙模式）。
+ */
+
+#define COMM_LOOPBACK_BUFFER_SIZE   1024
+
+typedef struct
+{
+    uint32_t air_bps;       // 空口速率（bit/s，按每字节10bit计算耗时），0表示不模拟发送耗时
+    uint8_t half_duplex;    // 1：半双工信道，两端同时发送发生冲突
+} CommLoopbackConfig_t;
+
+typedef struct
+{
+    uint32_t tx_frames[2];      // 各端发出的写操作次数
+    uint32_t collisions;        // 因冲突被丢弃的写操作次数
+} CommLoopbackStats_t;
+
+typedef struct CommLoopback_t CommLoopback_t;
+
+typedef struct
+{
+    CommLoopback_t *owner;
+    uint8_t end;
+} CommLoopbackEnd_t;
+
+struct CommLoopback_t
+{
+    CommLoopbackConfig_t cfg;
+    StreamBufferHandle_t rx[2];     // rx[n]：end n 读取的数据
+    SemaphoreHandle_t mutex;        // 保护信道状态
+    uint8_t tx_active[2];
+    uint8_t collided[2];
+    CommLoopbackStats_t stats;
+    CommLoopbackEnd_t ends[2];
+    CommPort_t ports[2];
+};
+
+/**
+ * @brief 创建回环链路
+ * @param lb 回环链路句柄（由调用者提供存储）
+ * @param cfg 信道配置，NULL 表示不限速的全双工直连
+ * @return 1 成功；0 失败
+ */
+uint32_t comm_loopback_create(CommLoopback_t *lb, const CommLoopbackConfig_t *cfg);
+
+/**
+ * @brief 获取回环链路某一端的端口
+ * @param end 0 或 1
+ */
+const CommPort_t *comm_loopback_port(CommLoopback_t *lb, uint8_t end);
+
+/**
+ * @brief 读取回环链路统计信息
+ */
+void comm_loopback_get_stats(CommLoopback_t *lb, CommLoopbackStats_t *stats);
+
+#endif
@@ -0,0 +1,766 @@
+#include <string.h>
+#include "comm_ota.h"
+#include "comm.h"
+#include "task_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "mbedtls/sha256.h"
+
+typedef enum
+{
+    OTA_TX_IDLE = 0,
+    OTA_TX_HASH,        // 计算镜像哈希
+    OTA_TX_BEGIN,       // 等待接收方确认开始（或告知续传位置）
+    OTA_TX_DATA,        // 窗口发送数据块
+    OTA_TX_END,         // 等待接收方校验结果
+} OtaTxPhase_t;
+
+typedef struct
+{
+    uint8_t phase;
+    uint8_t target;
+    CommOtaSource_t source;
+    CommOtaDone_Cb done;
+    void *user_data;
+    uint32_t session;
+    uint32_t image_size;
+    uint8_t sha256[32];
+
+    uint32_t acked;             // 接收方累计确认的偏移
+    uint32_t next;              // 下一个要发送的偏移
+    uint32_t high;              // 发出过的最大偏移，之前的块再发算重发
+    uint32_t window;            // 窗口（块）
+    uint32_t grow;              // 加性增：本窗口内已确认的块数
+    uint32_t rto_ms;
+    int32_t srtt_ms;            // 平滑往返时间，0 表示还没有样本
+    int32_t rttvar_ms;
+    int64_t sent_ms[COMM_OTA_MAX_WINDOW];   // 按块号取模记录首次发送时间，重发的块为0（不取往返时间样本）
+    int64_t timer_ms;           // 重发计时起点
+    int64_t progress_ms;        // 最近一次有进展的时间
+    uint32_t goback_offset;     // 最近一次回退的位置，同一处丢块的重复报告只回退一次
+    int64_t goback_ms;
+
+    CommOtaTxStats_t stats;
+} OtaTx_t;
+
+typedef struct
+{
+    uint8_t state;              // CommOtaState_t
+    uint8_t error;
+    uint8_t target;
+    uint8_t peer;               // 发送方节点号
+    uint32_t session;
+    uint32_t image_size;
+    uint32_t written;
+    uint8_t sha256[32];         // BEGIN 帧带来的镜像哈希
+    mbedtls_sha256_context sha;
+    CommOtaSink_t sink;
+    uint32_t since_ack;         // 上次回复后写入的块数
+    uint8_t gap_reported;       // 已为当前 written 报告过不连续
+    CommOtaRxStats_t stats;
+} OtaRx_t;
+
+// 发送是零拷贝的，全部OTA帧轮流使用这些缓冲；缓冲个数大于发送队列长度，
+// 轮回到同一个缓冲时它对应的帧必然已经被发送任务取走（同 comm_rpc.c）
+#define OTA_TX_RING         (COMM_SEND_QUEUE_LEN + 2)
+#define OTA_FRAME_MAX       (sizeof(PackOtaData_t) + COMM_OTA_CHUNK_SIZE)
+#define OTA_MIN_WINDOW      1
+
+static OtaTx_t kTx;
+static OtaRx_t kRx;
+static uint8_t kOtaTxBuf[OTA_TX_RING][OTA_FRAME_MAX];
+static uint8_t kOtaTxIndex;
+static uint8_t kOtaInited;
+static QueueHandle_t kOtaQueue;
+
+// 以下由 ota_lock 保护，在API与OTA任务之间传递
+static CommOtaSink_t kSinks[COMM_OTA_TARGET_MAX];
+static uint8_t kTxBusy;
+static uint8_t kTxStartReq;
+static uint8_t kTxAbortReq;
+static OtaTx_t kTxReq;
+static CommOtaTxStats_t kTxStats;
+static CommOtaRxStats_t kRxStats;
+static SemaphoreHandle_t ota_mutex;
+
+static void ota_lock(void)
+{
+    xSemaphoreTake(ota_mutex, portMAX_DELAY);
+}
+
+static void ota_unlock(void)
+{
+    xSemaphoreGive(ota_mutex);
+}
+
+static uint32_t ota_crc32(const uint8_t *data, uint16_t size)
+{
+    // 半字节查表，表只有64字节
+    static const uint32_t kTable[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+    };
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint16_t i = 0; i < size; i++)
+    {
+        crc = (crc >> 4) ^ kTable[(crc ^ data[i]) & 0x0F];
+        crc = (crc >> 4) ^ kTable[(crc ^ (data[i] >> 4)) & 0x0F];
+    }
+    return ~crc;
+}
+
+static uint8_t *ota_tx_buf(void)
+{
+    uint8_t *buf = kOtaTxBuf[kOtaTxIndex];
+    kOtaTxIndex = (kOtaTxIndex + 1) % OTA_TX_RING;
+    return buf;
+}
+
+// dst_node 为 COMM_NODE_NONE 时发往默认目的节点
+static uint32_t ota_send(uint8_t *buf, uint16_t size, uint8_t dst_node)
+{
+    if (dst_node < COMM_NODE_MAX && comm_get_node_id() != COMM_NODE_NONE)
+        return asyn_comm_send_pack_nak_to(COMM_NODE_MASK(dst_node), buf, CMD_OTA, size);
+    return asyn_comm_send_pack_nak(buf, CMD_OTA, size);
+}
+
+/* -------------------- 接收方 -------------------- */
+static void ota_rx_status(uint8_t gap)
+{
+    PackOtaStatus_t st = {
+        .type = OTA_TYPE_STATUS,
+        .state = kRx.state,
+        .error = kRx.error,
+        .gap = gap,
+        .session = kRx.session,
+        .offset = kRx.written,
+    };
+    uint8_t *buf = ota_tx_buf();
+    memcpy(buf, &st, sizeof(st));
+    ota_send(buf, sizeof(st), kRx.peer);
+    kRx.since_ack = 0;
+}
+
+static void ota_rx_fail(uint8_t error)
+{
+    if (kRx.state == COMM_OTA_RUNNING && kRx.sink.abort)
+        kRx.sink.abort(kRx.sink.ctx);
+    kRx.state = COMM_OTA_FAILED;
+    kRx.error = error;
+}
+
+static void ota_rx_begin(const PackOtaBegin_t *begin)
+{
+    if (kRx.state != COMM_OTA_IDLE && kRx.session == begin->session && kRx.target == begin->target &&
+        kRx.image_size == begin->image_size && kRx.state != COMM_OTA_FAILED)
+    {
+        // 同一镜像重新开始（链路中断后发送方重启了传输）：从已写入的位置继续
+        if (kRx.state == COMM_OTA_RUNNING)
+            kRx.stats.resumes++;
+        ota_rx_status(0);
+        return;
+    }
+
+    if (kRx.state == COMM_OTA_RUNNING)
+        ota_rx_fail(COMM_OTA_ERR_ABORTED);
+
+    kRx.session = begin->session;
+    kRx.target = begin->target;
+    kRx.image_size = begin->image_size;
+    kRx.written = 0;
+    kRx.since_ack = 0;
+    kRx.gap_reported = 0;
+    kRx.error = COMM_OTA_OK;
+    memcpy(kRx.sha256, begin->sha256, sizeof(kRx.sha256));
+
+    memset(&kRx.sink, 0, sizeof(kRx.sink));
+    if (begin->target < COMM_OTA_TARGET_MAX)
+    {
+        ota_lock();
+        kRx.sink = kSinks[begin->target];
+        ota_unlock();
+    }
+    if (!kRx.sink.write)
+    {
+        kRx.state = COMM_OTA_FAILED;
+        kRx.error = COMM_OTA_ERR_NO_SINK;
+    }
+    else if (kRx.sink.begin && !kRx.sink.begin(kRx.sink.ctx, begin->image_size))
+    {
+        kRx.state = COMM_OTA_FAILED;
+        kRx.error = COMM_OTA_ERR_SINK;
+    }
+    else
+    {
+        mbedtls_sha256_free(&kRx.sha);
+        mbedtls_sha256_init(&kRx.sha);
+        mbedtls_sha256_starts(&kRx.sha, 0);
+        kRx.state = COMM_OTA_RUNNING;
+    }
+    ota_rx_status(0);
+}
+
+static void ota_rx_gap(uint8_t ack_req)
+{
+    // 同一个缺口只报告一次，之后靠发送方的 ACK_REQ 或超时
+    if (!kRx.gap_reported || ack_req)
+        ota_rx_status(1);
+    kRx.gap_reported = 1;
+}
+
+static void ota_rx_data(const PackOtaData_t *hdr, const uint8_t *data, uint16_t size)
+{
+    uint8_t ack_req = (hdr->flags & OTA_DATA_FLAG_ACK_REQ) != 0;
+    if (kRx.state != COMM_OTA_RUNNING || hdr->session != kRx.session)
+    {
+        // 接收方重启过或已结束，让发送方重新开始/取结果
+        if (ack_req)
+            ota_rx_status(0);
+        return;
+    }
+    if (hdr->offset < kRx.written)
+    {
+        // 确认丢失后重发的块，已经写过
+        if (ack_req || ++kRx.since_ack >= COMM_OTA_ACK_EVERY)
+            ota_rx_status(0);
+        return;
+    }
+    if (hdr->offset > kRx.written)
+    {
+        kRx.stats.chunks_out_of_order++;
+        ota_rx_gap(ack_req);
+        return;
+    }
+    if (size == 0 || size > kRx.image_size - kRx.written || ota_crc32(data, size) != hdr->crc32)
+    {
+        kRx.stats.chunks_bad_crc++;
+        ota_rx_gap(ack_req);
+        return;
+    }
+
+    if (!kRx.sink.write(kRx.sink.ctx, kRx.written, data, size))
+    {
+        ota_rx_fail(COMM_OTA_ERR_SINK);
+        ota_rx_status(0);
+        return;
+    }
+    mbedtls_sha256_update(&kRx.sha, data, size);
+    kRx.written += size;
+    kRx.stats.chunks_ok++;
+    kRx.gap_reported = 0;
+    if (ack_req || ++kRx.since_ack >= COMM_OTA_ACK_EVERY || kRx.written == kRx.image_size)
+        ota_rx_status(0);
+}
+
+static void ota_rx_end(const PackOtaCtrl_t *end)
+{
+    if (end->session == kRx.session && kRx.state == COMM_OTA_RUNNING && kRx.written == kRx.image_size)
+    {
+        uint8_t sha256[32];
+        mbedtls_sha256_finish(&kRx.sha, sha256);
+        if (memcmp(sha256, kRx.sha256, sizeof(sha256)) != 0)
+            ota_rx_fail(COMM_OTA_ERR_HASH);
+        else if (kRx.sink.finish && !kRx.sink.finish(kRx.sink.ctx))
+            ota_rx_fail(COMM_OTA_ERR_SINK);
+        else
+            kRx.state = COMM_OTA_DONE;
+    }
+    // 重复的 END（上次的 STATUS 丢失）直接回复结果
+    ota_rx_status(0);
+}
+
+static void ota_rx_abort(const PackOtaCtrl_t *abort)
+{
+    if (abort->session == kRx.session && kRx.state == COMM_OTA_RUNNING)
+        ota_rx_fail(COMM_OTA_ERR_ABORTED);
+    ota_rx_status(0);
+}
+
+/* -------------------- 发送方 -------------------- */
+static void ota_tx_ctrl(uint8_t type)
+{
+    uint8_t *buf = ota_tx_buf();
+    if (type == OTA_TYPE_BEGIN)
+    {
+        PackOtaBegin_t begin = {
+            .type = OTA_TYPE_BEGIN,
+            .target = kTx.target,
+            .session = kTx.session,
+            .image_size = kTx.image_size,
+        };
+        memcpy(begin.sha256, kTx.sha256, sizeof(begin.sha256));
+        memcpy(buf, &begin, sizeof(begin));
+        ota_send(buf, sizeof(begin), COMM_NODE_NONE);
+    }
+    else
+    {
+        PackOtaCtrl_t ctrl = {.type = type, .session = kTx.session};
+        memcpy(buf, &ctrl, sizeof(ctrl));
+        ota_send(buf, sizeof(ctrl), COMM_NODE_NONE);
+    }
+}
+
+static void ota_tx_finish(uint32_t error, int64_t now)
+{
+    kTx.phase = OTA_TX_IDLE;
+    kTx.stats.state = error == COMM_OTA_OK ? COMM_OTA_DONE : COMM_OTA_FAILED;
+    kTx.stats.error = error;
+    kTx.stats.end_ms = now;
+    ota_lock();
+    kTxBusy = 0;
+    ota_unlock();
+    if (kTx.done)
+        kTx.done(error, kTx.user_data);
+}
+
+static uint32_t ota_tx_hash(void)
+{
+    static uint8_t chunk[COMM_OTA_CHUNK_SIZE];
+    mbedtls_sha256_context sha;
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    uint32_t ok = 1;
+    for (uint32_t offset = 0; offset < kTx.image_size && ok; offset += COMM_OTA_CHUNK_SIZE)
+    {
+        uint16_t size = (uint16_t)(kTx.image_size - offset < COMM_OTA_CHUNK_SIZE ? kTx.image_size - offset : COMM_OTA_CHUNK_SIZE);
+        ok = kTx.source.read(kTx.source.ctx, offset, chunk, size);
+        if (ok)
+            mbedtls_sha256_update(&sha, chunk, size);
+    }
+    mbedtls_sha256_finish(&sha, kTx.sha256);
+    mbedtls_sha256_free(&sha);
+
+    uint32_t session;
+    memcpy(&session, kTx.sha256, sizeof(session));
+    kTx.session = session ^ kTx.image_size;
+    return ok;
+}
+
+// 从 next 发出一块，窗口满或是最后一块时要求接收方立即确认
+static uint32_t ota_tx_chunk(int64_t now)
+{
+    uint8_t *buf = ota_tx_buf();
+    uint32_t left = kTx.image_size - kTx.next;
+    uint16_t size = (uint16_t)(left < COMM_OTA_CHUNK_SIZE ? left : COMM_OTA_CHUNK_SIZE);
+    uint8_t *data = buf + sizeof(PackOtaData_t);
+    if (!kTx.source.read(kTx.source.ctx, kTx.next, data, size))
+        return 0;
+
+    uint32_t in_flight = (kTx.next - kTx.acked) / COMM_OTA_CHUNK_SIZE + 1;
+    PackOtaData_t hdr = {
+        .type = OTA_TYPE_DATA,
+        .flags = (in_flight >= kTx.window || kTx.next + size == kTx.image_size) ? OTA_DATA_FLAG_ACK_REQ : 0,
+        .session = kTx.session,
+        .offset = kTx.next,
+        .crc32 = ota_crc32(data, size),
+    };
+    memcpy(buf, &hdr, sizeof(hdr));
+    if (!ota_send(buf, (uint16_t)(sizeof(hdr) + size), COMM_NODE_NONE))
+        return 1;   // 队列被其它发送占满，下次再试
+
+    uint32_t index = (kTx.next / COMM_OTA_CHUNK_SIZE) % COMM_OTA_MAX_WINDOW;
+    if (kTx.next < kTx.high)
+    {
+        kTx.sent_ms[index] = 0;
+        kTx.stats.chunks_resent++;
+    }
+    else
+    {
+        kTx.sent_ms[index] = now;
+        kTx.high = kTx.next + size;
+    }
+    if (kTx.next == kTx.acked)
+        kTx.timer_ms = now;
+    kTx.next += size;
+    kTx.stats.chunks_sent++;
+    return 1;
+}
+
+// 按往返时间样本更新重发超时（同TCP：srtt + 4*rttvar）
+static void ota_tx_rtt_sample(int32_t rtt)
+{
+    if (!kTx.srtt_ms)
+    {
+        kTx.srtt_ms = rtt > 0 ? rtt : 1;
+        kTx.rttvar_ms = rtt / 2;
+    }
+    else
+    {
+        int32_t err = rtt > kTx.srtt_ms ? rtt - kTx.srtt_ms : kTx.srtt_ms - rtt;
+        kTx.rttvar_ms = (3 * kTx.rttvar_ms + err) / 4;
+        kTx.srtt_ms = (7 * kTx.srtt_ms + rtt) / 8;
+    }
+    uint32_t rto = (uint32_t)(kTx.srtt_ms + 4 * kTx.rttvar_ms);
+    kTx.rto_ms = rto < COMM_OTA_RTO_MIN_MS ? COMM_OTA_RTO_MIN_MS : (rto > COMM_OTA_RTO_MAX_MS ? COMM_OTA_RTO_MAX_MS : rto);
+}
+
+static void ota_tx_on_ack(uint32_t offset, int64_t now)
+{
+    uint32_t newly = (offset - kTx.acked + COMM_OTA_CHUNK_SIZE - 1) / COMM_OTA_CHUNK_SIZE;
+    // 往返时间取本次确认的最早一块：接收方攒 COMM_OTA_ACK_EVERY 块才回复，这段等待也要算进重发超时；
+    // 重发过的块没有样本，重发超时保持退避后的值
+    int64_t sent = kTx.sent_ms[(kTx.acked / COMM_OTA_CHUNK_SIZE) % COMM_OTA_MAX_WINDOW];
+    if (sent)
+        ota_tx_rtt_sample((int32_t)(now - sent));
+
+    kTx.acked = offset;
+    if (kTx.next < offset)
+        kTx.next = offset;
+    kTx.timer_ms = now;
+    kTx.progress_ms = now;
+
+    // 加性增：每确认一整个窗口的块，窗口加一
+    kTx.grow += newly;
+    while (kTx.grow >= kTx.window)
+    {
+        kTx.grow -= kTx.window;
+        if (kTx.window < COMM_OTA_MAX_WINDOW)
+            kTx.window++;
+    }
+    if (kTx.window > kTx.stats.max_window)
+        kTx.stats.max_window = kTx.window;
+}
+
+static void ota_tx_on_status(const PackOtaStatus_t *st, int64_t now)
+{
+    if (kTx.phase < OTA_TX_BEGIN)
+        return;
+    if (st->session != kTx.session)
+    {
+        // 接收方不认识本会话（重启过），重新开始
+        if (kTx.phase != OTA_TX_BEGIN && (st->state == COMM_OTA_IDLE || st->state == COMM_OTA_RUNNING))
+        {
+            kTx.phase = OTA_TX_BEGIN;
+            kTx.timer_ms = now;
+            ota_tx_ctrl(OTA_TYPE_BEGIN);
+        }
+        return;
+    }
+    if (st->state == COMM_OTA_FAILED)
+    {
+        ota_tx_finish(st->error, now);
+        return;
+    }
+    if (st->state == COMM_OTA_DONE)
+    {
+        kTx.stats.acked = kTx.image_size;
+        ota_tx_finish(COMM_OTA_OK, now);
+        return;
+    }
+    if (st->state != COMM_OTA_RUNNING || st->offset > kTx.image_size)
+        return;
+
+    if (kTx.phase == OTA_TX_BEGIN)
+    {
+        if (st->offset)
+            kTx.stats.resumes++;
+        if (!kTx.stats.timeouts)
+            ota_tx_rtt_sample((int32_t)(now - kTx.timer_ms));
+        kTx.acked = kTx.next = kTx.high = st->offset;
+        kTx.window = COMM_OTA_INIT_WINDOW;
+        kTx.grow = 0;
+        kTx.timer_ms = now;
+        kTx.progress_ms = now;
+        kTx.phase = OTA_TX_DATA;
+        return;
+    }
+    if (kTx.phase != OTA_TX_DATA)
+        return;
+
+    if (st->offset > kTx.acked)
+        ota_tx_on_ack(st->offset, now);
+    if (st->gap && st->offset < kTx.next &&
+        !(st->offset == kTx.goback_offset && now - kTx.goback_ms < kTx.rto_ms))
+    {
+        // 乘性减：丢块后窗口减半，从缺口处重发
+        kTx.next = st->offset;
+        kTx.window = kTx.window / 2 > OTA_MIN_WINDOW ? kTx.window / 2 : OTA_MIN_WINDOW;
+        kTx.grow = 0;
+        kTx.goback_offset = st->offset;
+        kTx.goback_ms = now;
+        kTx.timer_ms = now;
+        kTx.stats.gaps++;
+    }
+}
+
+static void ota_tx_step(int64_t now)
+{
+    if (kTx.phase == OTA_TX_HASH)
+    {
+        if (!ota_tx_hash())
+        {
+            ota_tx_finish(COMM_OTA_ERR_SOURCE, now);
+            return;
+        }
+        kTx.phase = OTA_TX_BEGIN;
+        kTx.timer_ms = now;
+        kTx.progress_ms = now;
+        ota_tx_ctrl(OTA_TYPE_BEGIN);
+        return;
+    }
+    if (now - kTx.progress_ms >= COMM_OTA_STALL_MS)
+    {
+        // 不通知接收方放弃，之后重新发送同一镜像可以续传
+        ota_tx_finish(COMM_OTA_ERR_STALLED, now);
+        return;
+    }
+
+    uint8_t expired = now - kTx.timer_ms >= kTx.rto_ms;
+    if (kTx.phase == OTA_TX_BEGIN || kTx.phase == OTA_TX_END)
+    {
+        if (expired)
+        {
+            kTx.rto_ms = kTx.rto_ms * 2 < COMM_OTA_RTO_MAX_MS ? kTx.rto_ms * 2 : COMM_OTA_RTO_MAX_MS;
+            kTx.timer_ms = now;
+            kTx.stats.timeouts++;
+            ota_tx_ctrl(kTx.phase == OTA_TX_BEGIN ? OTA_TYPE_BEGIN : OTA_TYPE_END);
+        }
+        return;
+    }
+
+    if (kTx.next > kTx.acked && expired)
+    {
+        // 超时：窗口退回最小，重发超时加倍（链路中断时逐渐拉长探测间隔）
+        kTx.next = kTx.acked;
+        kTx.window = OTA_MIN_WINDOW;
+        kTx.grow = 0;
+        kTx.rto_ms = kTx.rto_ms * 2 < COMM_OTA_RTO_MAX_MS ? kTx.rto_ms * 2 : COMM_OTA_RTO_MAX_MS;
+        kTx.timer_ms = now;
+        kTx.stats.timeouts++;
+    }
+    while (kTx.next < kTx.image_size && (kTx.next - kTx.acked) / COMM_OTA_CHUNK_SIZE < kTx.window &&
+           comm_send_queue_depth() < COMM_OTA_MAX_QUEUED)
+    {
+        uint32_t next = kTx.next;
+        if (!ota_tx_chunk(now))
+        {
+            ota_tx_finish(COMM_OTA_ERR_SOURCE, now);
+            return;
+        }
+        if (kTx.next == next)
+            break;
+    }
+    if (kTx.acked == kTx.image_size)
+    {
+        kTx.phase = OTA_TX_END;
+        kTx.timer_ms = now;
+        ota_tx_ctrl(OTA_TYPE_END);
+    }
+}
+
+// 取出API传来的开始/取消请求
+static void ota_tx_take_request(int64_t now)
+{
+    ota_lock();
+    uint8_t start = kTxStartReq;
+    uint8_t abort = kTxAbortReq;
+    if (start)
+        kTx = kTxReq;
+    kTxStartReq = 0;
+    kTxAbortReq = 0;
+    ota_unlock();
+
+    if (start)
+    {
+        kTx.phase = OTA_TX_HASH;
+        kTx.rto_ms = COMM_OTA_RTO_INIT_MS;
+        kTx.window = COMM_OTA_INIT_WINDOW;
+        kTx.stats.state = COMM_OTA_RUNNING;
+        kTx.stats.image_size = kTx.image_size;
+        kTx.stats.start_ms = now;
+        kTx.progress_ms = now;
+    }
+    if (abort && kTx.phase != OTA_TX_IDLE)
+    {
+        if (kTx.phase != OTA_TX_HASH)
+            ota_tx_ctrl(OTA_TYPE_ABORT);
+        ota_tx_finish(COMM_OTA_ERR_ABORTED, now);
+    }
+}
+
+static void ota_handle_frame(const CommRxFrame_t *frame, int64_t now)
+{
+    if (frame->size < 1)
+        return;
+    switch (frame->data[0])
+    {
+    case OTA_TYPE_BEGIN:
+        if (frame->size >= sizeof(PackOtaBegin_t))
+        {
+            PackOtaBegin_t begin;
+            memcpy(&begin, frame->data, sizeof(begin));
+            kRx.peer = frame->src_node;
+            ota_rx_begin(&begin);
+        }
+        break;
+    case OTA_TYPE_DATA:
+        if (frame->size >= sizeof(PackOtaData_t))
+        {
+            PackOtaData_t hdr;
+            memcpy(&hdr, frame->data, sizeof(hdr));
+            ota_rx_data(&hdr, frame->data + sizeof(hdr), (uint16_t)(frame->size - sizeof(hdr)));
+        }
+        break;
+    case OTA_TYPE_END:
+    case OTA_TYPE_ABORT:
+        if (frame->size >= sizeof(PackOtaCtrl_t))
+        {
+            PackOtaCtrl_t ctrl;
+            memcpy(&ctrl, frame->data, sizeof(ctrl));
+            if (ctrl.type == OTA_TYPE_END)
+                ota_rx_end(&ctrl);
+            else
+                ota_rx_abort(&ctrl);
+        }
+        break;
+    case OTA_TYPE_STATUS:
+        if (frame->size >= sizeof(PackOtaStatus_t))
+        {
+            PackOtaStatus_t st;
+            memcpy(&st, frame->data, sizeof(st));
+            ota_tx_on_status(&st, now);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+static void OtaTask(void *param)
+{
+    while (1)
+    {
+        // 发送中每个tick检查一次重发超时和发送队列空位，否则一直等待收到的帧或API请求
+        CommRxFrame_t *frame = NULL;
+        TickType_t wait = kTx.phase != OTA_TX_IDLE ? 1 : portMAX_DELAY;
+        uint8_t got = xQueueReceive(kOtaQueue, &frame, wait) == pdTRUE;
+        int64_t now = comm_get_time_ms();
+        if (got && frame)
+        {
+            ota_handle_frame(frame, now);
+            comm_rx_frame_release(frame);
+        }
+        ota_tx_take_request(now);
+        if (kTx.phase != OTA_TX_IDLE)
+            ota_tx_step(now);
+
+        if (kTx.phase != OTA_TX_IDLE)
+            kTx.stats.acked = kTx.acked;
+        kTx.stats.window = kTx.window;
+        kTx.stats.rto_ms = kTx.rto_ms;
+        kRx.stats.state = kRx.state;
+        kRx.stats.error = kRx.error;
+        kRx.stats.target = kRx.target;
+        kRx.stats.image_size = kRx.image_size;
+        kRx.stats.written = kRx.written;
+        ota_lock();
+        kTxStats = kTx.stats;
+        kRxStats = kRx.stats;
+        ota_unlock();
+    }
+}
+
+// 调用时已持有锁
+static uint32_t ota_init(void)
+{
+    if (kOtaInited)
+        return 1;
+    kOtaQueue = xQueueCreate(COMM_OTA_RX_QUEUE_LEN, sizeof(CommRxFrame_t *));
+    if (!kOtaQueue)
+        return 0;
+    if (!register_comm_recv_queue(kOtaQueue, CMD_OTA, COMM_NODE_ANY, NULL))
+        return 0;
+    TASK_CREATE(TASK_COMM_OTA, OtaTask, NULL, NULL);
+    kOtaInited = 1;
+    return 1;
+}
+
+// 唤醒OTA任务处理请求（队列满说明任务马上就会醒来）
+static void ota_wake(void)
+{
+    CommRxFrame_t *wake = NULL;
+    xQueueSend(kOtaQueue, &wake, 0);
+}
+
+uint32_t comm_ota_init(void)
+{
+    if (!ota_mutex)
+        ota_mutex = xSemaphoreCreateMutex();
+    return ota_mutex != NULL;
+}
+
+uint32_t comm_ota_register_sink(uint8_t target, const CommOtaSink_t *sink)
+{
+    if (target >= COMM_OTA_TARGET_MAX || (sink && !sink->write))
+        return 0;
+    ota_lock();
+    uint32_t ret = ota_init();
+    if (ret)
+    {
+        if (sink)
+            kSinks[target] = *sink;
+        else
+            memset(&kSinks[target], 0, sizeof(kSinks[target]));
+    }
+    ota_unlock();
+    return ret;
+}
+
+uint32_t comm_ota_send(uint8_t target, const CommOtaSource_t *source, uint32_t image_size, CommOtaDone_Cb done, void *user_data)
+{
+    if (target >= COMM_OTA_TARGET_MAX || !source || !source->read || image_size == 0)
+        return 0;
+    uint32_t ret = 0;
+    ota_lock();
+    if (!kTxBusy && ota_init())
+    {
+        memset(&kTxReq, 0, sizeof(kTxReq));
+        kTxReq.target = target;
+        kTxReq.source = *source;
+        kTxReq.image_size = image_size;
+        kTxReq.done = done;
+        kTxReq.user_data = user_data;
+        kTxStartReq = 1;
+        kTxBusy = 1;
+        ret = 1;
+    }
+    ota_unlock();
+    if (ret)
+        ota_wake();
+    return ret;
+}
+
+void comm_ota_abort(void)
+{
+    ota_lock();
+    uint8_t busy = kTxBusy;
+    if (busy)
+        kTxAbortReq = 1;
+    ota_unlock();
+    if (busy)
+        ota_wake();
+}
+
+void comm_ota_get_tx_stats(CommOtaTxStats_t *stats)
+{
+    ota_lock();
+    *stats = kTxStats;
+    ota_unlock();
+}
+
+void comm_ota_get_rx_stats(CommOtaRxStats_t *stats)
+{
+    ota_lock();
+    *stats = kRxStats;
+    ota_unlock();
+}
+
+uint32_t comm_ota_busy(void)
+{
+    if (!ota_mutex)
+        return 0;
+    ota_lock();
+    uint32_t busy = kTxBusy || kRxStats.state == COMM_OTA_RUNNING;
+    ota_unlock();
+    return busy;
+}
@@ -0,0 +1,163 @@
+#ifndef __COMM_OTA_H__
+#define __COMM_OTA_H__
+
+#include <stdint.h>
+#include "dataFrame.h"
+
+/*
+ * 固件/资源文件传输（OTA），基于 comm.c 的不确认发送，使用 CMD_OTA 命令：
+ * - 镜像按 COMM_OTA_CHUNK_SIZE 分块，每块带偏移和CRC32，接收方只接受偏移连续的块，校验通过后直接交给写入目标
+ *   （写入分区），内存中不暂存镜像；全部写入后用 BEGIN 帧带来的 SHA-256 校验整个镜像，通过才调用写入目标的 finish
+ * - 发送方同时在途（已发出未确认）的块数为窗口，接收方每 COMM_OTA_ACK_EVERY 块或收到带 ACK_REQ 标志的块时回复累计确认；
+ *   发现不连续（丢块/校验错误）立即回复，发送方从确认位置重发（回退N帧）
+ * - 窗口按加性增、乘性减（AIMD）自适应链路：每确认一整个窗口的块窗口加一，丢块减半，超时退回最小窗口并加倍重发超时
+ * - 发送队列中最多同时排 COMM_OTA_MAX_QUEUED 个OTA帧，其余位置留给控制帧；控制帧最多多等串口发送缓冲中的数据
+ *   加上 COMM_OTA_MAX_QUEUED 个OTA帧的发送时间（115200bps 约 40~60ms）。半双工链路应配合时隙模式使用，
+ *   否则接收方的 STATUS 会与数据帧冲突
+ * - 会话号由镜像哈希和长度得出：链路中断后自动探测恢复；超过 COMM_OTA_STALL_MS 放弃后，只要接收方没有重启，
+ *   再次发送同一镜像会从已写入的位置继续
+ *
+ * 接收、写入、重发都在同一个OTA任务中进行（第一次调用 comm_ota_register_sink 或 comm_ota_send 时创建），
+ * 接收到的帧经延迟分发交给该任务，写flash不会阻塞通信接收任务。接收方同一时间只处理一个会话。
+ * 多机寻址时镜像发往默认目的节点，STATUS 发回发送方。
+ */
+
+#define COMM_OTA_CHUNK_SIZE     224     // 每块数据长度，加上帧头和地址后不超过一帧
+#define COMM_OTA_INIT_WINDOW    4       // 初始窗口（块）
+#define COMM_OTA_MAX_WINDOW     32      // 最大窗口（块）
+#define COMM_OTA_MAX_QUEUED     1       // 发送队列中最多同时排队的OTA帧
+#define COMM_OTA_ACK_EVERY      4       // 接收方每写入这么多块回复一次累计确认
+#define COMM_OTA_RTO_INIT_MS    1000    // 还没有往返时间样本时的重发超时
+#define COMM_OTA_RTO_MIN_MS     100     // 重发超时下限
+#define COMM_OTA_RTO_MAX_MS     2000    // 重发超时上限（退避）
+#define COMM_OTA_STALL_MS       30000   // 超过该时间没有任何进展则放弃
+#define COMM_OTA_RX_QUEUE_LEN   4       // 延迟分发队列长度，最多占用接收帧池中这么多帧
+
+typedef enum
+{
+    COMM_OTA_TARGET_APP = 0,        // 应用固件（写入空闲的 ota_0/ota_1 分区）
+    COMM_OTA_TARGET_ASSET = 1,      // 资源文件（例如 storage 分区）
+    COMM_OTA_TARGET_MAX = 4,
+} CommOtaTarget_t;
+
+typedef enum
+{
+    COMM_OTA_IDLE = 0,
+    COMM_OTA_RUNNING,
+    COMM_OTA_DONE,
+    COMM_OTA_FAILED,
+} CommOtaState_t;
+
+typedef enum
+{
+    COMM_OTA_OK = 0,
+    COMM_OTA_ERR_NO_SINK = 1,       // 接收方没有注册该写入目标
+    COMM_OTA_ERR_SINK = 2,          // 写入目标 begin/write/finish 失败（镜像过大、flash错误、固件校验不通过等）
+    COMM_OTA_ERR_HASH = 3,          // 整个镜像的SHA-256不符
+    COMM_OTA_ERR_ABORTED = 4,       // 被发送方取消
+    COMM_OTA_ERR_STALLED = 0x80,    // 本地：超过 COMM_OTA_STALL_MS 没有进展
+    COMM_OTA_ERR_SOURCE = 0x81,     // 本地：读取镜像失败
+} CommOtaError_t;
+
+/**
+ * @brief 接收方写入目标，全部函数在OTA任务中调用，返回1成功、0失败
+ */
+typedef struct
+{
+    uint32_t (*begin)(void *ctx, uint32_t image_size);      // 开始新镜像（检查容量、准备擦除）
+    uint32_t (*write)(void *ctx, uint32_t offset, const uint8_t *data, uint16_t size);  // 按偏移顺序写入
+    uint32_t (*finish)(void *ctx);                          // 全部写入且哈希校验通过（例如设置启动分区）
+    void (*abort)(void *ctx);                               // 放弃当前镜像，可为NULL
+    void *ctx;
+} CommOtaSink_t;
+
+/**
+ * @brief 发送方镜像来源，在OTA任务中调用，可以直接读flash/文件而不必把镜像读入内存
+ * @return 1 成功；0 失败
+ */
+typedef struct
+{
+    uint32_t (*read)(void *ctx, uint32_t offset, uint8_t *buf, uint16_t size);
+    void *ctx;
+} CommOtaSource_t;
+
+/**
+ * @brief 发送结束回调，在OTA任务中执行
+ * @param error CommOtaError_t，COMM_OTA_OK 表示接收方已校验并写入完成
+ */
+typedef void (*CommOtaDone_Cb)(uint32_t error, void *user_data);
+
+typedef struct
+{
+    uint32_t state;             // CommOtaState_t
+    uint32_t error;             // CommOtaError_t
+    uint32_t image_size;
+    uint32_t acked;             // 接收方已确认写入的字节数
+    uint32_t chunks_sent;       // 发出的数据块（含重发）
+    uint32_t chunks_resent;     // 重发的数据块
+    uint32_t gaps;              // 接收方报告不连续的次数（窗口减半）
+    uint32_t timeouts;          // 重发超时次数（窗口退回最小）
+    uint32_t resumes;           // 接收方从非0位置继续的次数
+    uint32_t window;            // 当前窗口（块）
+    uint32_t max_window;        // 达到过的最大窗口
+    uint32_t rto_ms;            // 当前重发超时
+    int64_t start_ms;
+    int64_t end_ms;             // 结束时间，未结束为0
+} CommOtaTxStats_t;
+
+typedef struct
+{
+    uint32_t state;             // CommOtaState_t
+    uint32_t error;             // CommOtaError_t
+    uint32_t target;
+    uint32_t image_size;
+    uint32_t written;           // 已连续写入的字节数
+    uint32_t chunks_ok;         // 写入的数据块
+    uint32_t chunks_bad_crc;    // CRC32错误的数据块
+    uint32_t chunks_out_of_order;   // 偏移不连续（之前有块丢失）而丢弃的数据块
+    uint32_t resumes;           // 同一会话重新开始、从已写入位置继续的次数
+} CommOtaRxStats_t;
+
+/**
+ * @brief 初始化OTA层（在 RemoteCommInit 之后、其它 comm_ota 函数之前调用，重复调用无副作用），
+ *        OTA任务在第一次注册写入目标或发送时创建
+ * @return 1 成功；0 失败
+ */
+uint32_t comm_ota_init(void);
+
+/**
+ * @brief 接收方注册写入目标（在 comm_ota_init 之后调用）
+ * @param target CommOtaTarget_t
+ * @param sink 写入目标（函数内拷贝），NULL 表示取消
+ * @return 1 成功；0 目标号错误/创建OTA任务失败
+ */
+uint32_t comm_ota_register_sink(uint8_t target, const CommOtaSink_t *sink);
+
+/**
+ * @brief 发送一个镜像，立即返回，结果通过 done 通知；开始前会先读一遍镜像计算SHA-256
+ * @param target 接收方写入目标
+ * @param source 镜像来源（函数内拷贝，ctx 须在结束前保持有效）
+ * @param image_size 镜像长度
+ * @param done 结束回调，可为NULL
+ * @param user_data 回调用户数据
+ * @return 1 已开始；0 正在发送其它镜像/参数错误/创建OTA任务失败
+ */
+uint32_t comm_ota_send(uint8_t target, const CommOtaSource_t *source, uint32_t image_size, CommOtaDone_Cb done, void *user_data);
+
+/**
+ * @brief 取消正在进行的发送，并通知接收方放弃（done 回调 COMM_OTA_ERR_ABORTED）
+ */
+void comm_ota_abort(void);
+
+/**
+ * @brief 读取发送方/接收方统计
+ */
+void comm_ota_get_tx_stats(CommOtaTxStats_t *stats);
+void comm_ota_get_rx_stats(CommOtaRxStats_t *stats);
+
+/**
+ * @brief 是否有OTA会话在进行（本端发送中，或作为接收方写入中），可以在任意任务中调用
+ */
+uint32_t comm_ota_busy(void);
+
+#endif
@@ -0,0 +1,115 @@
+#include <stddef.h>
+#include "comm_ota_partition.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_log.h"
+
+static const char *TAG = "comm_ota";
+
+/* -------------------- 应用固件 -------------------- */
+static const esp_partition_t *kAppPart;
+static esp_ota_handle_t kAppHandle;
+
+static uint32_t app_begin(void *ctx, uint32_t image_size)
+{
+    if (kAppHandle)
+    {
+        esp_ota_abort(kAppHandle);
+        kAppHandle = 0;
+    }
+    kAppPart = esp_ota_get_next_update_partition(NULL);
+    if (!kAppPart || image_size > kAppPart->size)
+    {
+        ESP_LOGE(TAG, "no ota partition for %lu bytes", (unsigned long)image_size);
+        return 0;
+    }
+    // 顺序写入模式：写到哪擦到哪，开始时不阻塞整片擦除
+    esp_err_t err = esp_ota_begin(kAppPart, OTA_WITH_SEQUENTIAL_WRITES, &kAppHandle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "esp_ota_begin: %s", esp_err_to_name(err));
+        kAppHandle = 0;
+        return 0;
+    }
+    ESP_LOGI(TAG, "writing %lu bytes to %s", (unsigned long)image_size, kAppPart->label);
+    return 1;
+}
+
+static uint32_t app_write(void *ctx, uint32_t offset, const uint8_t *data, uint16_t size)
+{
+    // comm_ota 保证偏移连续，直接顺序写入
+    return kAppHandle && esp_ota_write(kAppHandle, data, size) == ESP_OK;
+}
+
+static uint32_t app_finish(void *ctx)
+{
+    esp_err_t err = esp_ota_end(kAppHandle);
+    kAppHandle = 0;
+    if (err == ESP_OK)
+        err = esp_ota_set_boot_partition(kAppPart);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "ota finish: %s", esp_err_to_name(err));
+        return 0;
+    }
+    ESP_LOGI(TAG, "%s set as boot partition, restart to apply", kAppPart->label);
+    return 1;
+}
+
+static void app_abort(void *ctx)
+{
+    if (kAppHandle)
+        esp_ota_abort(kAppHandle);
+    kAppHandle = 0;
+}
+
+const CommOtaSink_t *comm_ota_app_sink(void)
+{
+    static const CommOtaSink_t sink = {
+        .begin = app_begin,
+        .write = app_write,
+        .finish = app_finish,
+        .abort = app_abort,
+    };
+    return &sink;
+}
+
+/* -------------------- 数据分区 -------------------- */
+static const esp_partition_t *kAssetPart;
+static uint32_t kAssetErased;   // 已擦除到的位置（扇区对齐）
+
+static uint32_t asset_begin(void *ctx, uint32_t image_size)
+{
+    kAssetPart = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, (const char *)ctx);
+    kAssetErased = 0;
+    if (!kAssetPart || image_size > kAssetPart->size)
+    {
+        ESP_LOGE(TAG, "partition %s can't hold %lu bytes", (const char *)ctx, (unsigned long)image_size);
+        return 0;
+    }
+    return 1;
+}
+
+static uint32_t asset_write(void *ctx, uint32_t offset, const uint8_t *data, uint16_t size)
+{
+    uint32_t sector = kAssetPart->erase_size;
+    while (kAssetErased < offset + size)
+    {
+        if (esp_partition_erase_range(kAssetPart, kAssetErased, sector) != ESP_OK)
+            return 0;
+        kAssetErased += sector;
+    }
+    return esp_partition_write(kAssetPart, offset, data, size) == ESP_OK;
+}
+
+const CommOtaSink_t *comm_ota_asset_sink(const char *label)
+{
+    static CommOtaSink_t sink = {
+        .begin = asset_begin,
+        .write = asset_write,
+    };
+    if (!esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label))
+        return NULL;
+    sink.ctx = (void *)label;
+    return &sink;
+}
@@ -0,0 +1,26 @@
+#ifndef __COMM_OTA_PARTITION_H__
+#define __COMM_OTA_PARTITION_H__
+
+#include "comm_ota.h"
+
+/*
+ * comm_ota 的 flash 分区写入目标（ESP32）：
+ * - 应用固件写入当前未运行的 ota_0/ota_1 分区（esp_ota_*），按写入进度逐个擦除扇区，不在开始时整片擦除；
+ *   finish 时由 esp_ota_end 校验固件镜像并设置为下次启动分区，重启后生效
+ * - 资源文件直接写入指定标签的数据分区（例如 partitions.csv 中的 storage），同样边写边擦除
+ * 擦除和写入都在OTA任务中执行，不影响通信接收任务。
+ */
+
+/**
+ * @brief 应用固件写入目标，注册到 COMM_OTA_TARGET_APP
+ */
+const CommOtaSink_t *comm_ota_app_sink(void);
+
+/**
+ * @brief 数据分区写入目标，注册到 COMM_OTA_TARGET_ASSET
+ * @param label 分区标签（需要在注册期间及之后保持有效，通常为字符串常量）
+ * @return 写入目标；NULL 找不到该分区
+ */
+const CommOtaSink_t *comm_ota_asset_sink(const char *label);
+
+#endif
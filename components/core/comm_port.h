@@ -0,0 +1,43 @@
+#ifndef __COMM_PORT_H__
+#define __COMM_PORT_H__
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/**
+ * @brief 通信链路层端口（字节流收发接口）
+ * comm.c 只通过该结构访问物理链路，ESP32 的串口、STM32 的 HAL 适配层、回环/仿真信道都实现这一组接口
+ */
+typedef struct
+{
+    /**
+     * @brief 读取 size 个字节，直到读满或超时
+     * @return 实际读取的字节数（超时可能小于 size，出错返回 <0）
+     */
+    int (*read)(void *port_data, uint8_t *dst, uint16_t size, uint32_t timeout_ms);
+
+    /**
+     * @brief 写出 size 个字节（可以只放入底层发送缓冲后返回）
+     * @return 实际写出的字节数
+     */
+    int (*write)(void *port_data, const uint8_t *src, uint16_t size);
+
+    void *port_data;
+} CommPort_t;
+
+/**
+ * @brief 通信模块的毫秒时间基准（FreeRTOS tick，ESP32/STM32/Linux 上都可用）
+ */
+static inline int64_t comm_get_time_ms(void)
+{
+    return (int64_t)xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+/**
+ * @brief 获取 ESP32 串口（LORA模块）端口，首次调用时完成串口初始化
+ * @return 串口端口
+ */
+const CommPort_t *comm_uart_port(void);
+
+#endif
@@ -0,0 +1,53 @@
+#include "comm_port.h"
+#include "comm.h"
+#include "freertos/FreeRTOS.h"
+#include "hardware.h"
+#include "driver/uart.h"
+
+static int uart_port_read(void *port_data, uint8_t *dst, uint16_t size, uint32_t timeout_ms)
+{
+    TickType_t ticks = (timeout_ms == portMAX_DELAY) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    return uart_read_bytes((uart_port_t)(intptr_t)port_data, dst, size, ticks);
+}
+
+static int uart_port_write(void *port_data, const uint8_t *src, uint16_t size)
+{
+    return uart_write_bytes((uart_port_t)(intptr_t)port_data, (const char *)src, size);
+}
+
+static CommPort_t kUartPort = {
+    .read = uart_port_read,
+    .write = uart_port_write,
+    .port_data = (void *)(intptr_t)UART_NUM_1,
+};
+static uint8_t kUartPortInited = 0;
+
+const CommPort_t *comm_uart_port(void)
+{
+    if (kUartPortInited)
+        return &kUartPort;
+    kUartPortInited = 1;
+
+    /* UART初始化 */
+    uart_config_t uart_config = {
+        .baud_rate = 115200,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_XTAL};     // 动态调频时APB频率会变化，用XTAL保持波特率（见 power_manager.h）
+
+    uart_param_config(UART_NUM_1, &uart_config);
+    uart_set_pin(UART_NUM_1, PIN_NUM_UART_TXD, PIN_NUM_UART_RXD,
+                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+
+    QueueHandle_t uart_event_queue;
+    uart_driver_install(UART_NUM_1, 256, 256, 4, &uart_event_queue, 0);
+    return &kUartPort;
+}
+
+// 默认使用串口作为通信链路
+void RemoteCommInit(BadDataPackCb_t callback)
+{
+    RemoteCommInitWithPort(callback, comm_uart_port());
+}
@@ -0,0 +1,321 @@
+#include <string.h>
+#include "comm_rpc.h"
+#include "comm.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+typedef enum
+{
+    RPC_SLOT_FREE = 0,
+    RPC_SLOT_WAITING,       // 请求已发出，等待应答
+    RPC_SLOT_DONE,          // 已收到应答或超时，等待 comm_rpc_poll 执行回调
+} RpcSlotState_t;
+
+typedef struct
+{
+    uint8_t state;
+    uint8_t method;
+    uint16_t req_id;
+    uint8_t dst_mask;       // 请求的目的节点掩码，只接受其中节点的应答；0 表示发出时未开启寻址，不检查来源
+    uint8_t status;
+    uint16_t resp_size;
+    int64_t deadline_ms;
+    CommRpcDone_Cb done;
+    void *user_data;
+    uint8_t resp[COMM_RPC_MAX_PAYLOAD];
+} RpcSlot_t;
+
+typedef struct
+{
+    uint8_t method;
+    uint16_t req_size;
+    CommRpcHandler_Cb handler;
+    void *user_data;
+} RpcMethod_t;
+
+// 发送是零拷贝的，请求/应答轮流使用这些缓冲；缓冲个数大于发送队列长度，
+// 轮回到同一个缓冲时它对应的请求必然已经被发送任务取走
+#define RPC_TX_RING         (COMM_SEND_QUEUE_LEN + 2)
+#define RPC_FRAME_MAX       (sizeof(PackRpcHeader_t) + COMM_RPC_MAX_PAYLOAD)
+
+static RpcSlot_t kRpcSlots[COMM_RPC_MAX_IN_FLIGHT];
+static RpcMethod_t kRpcMethods[COMM_RPC_MAX_METHODS];
+static uint8_t kRpcMethodNum;
+static uint8_t kRpcTxBuf[RPC_TX_RING][RPC_FRAME_MAX];
+static uint8_t kRpcTxIndex;
+static uint16_t kRpcReqId;
+static uint8_t kRpcInited;
+static SemaphoreHandle_t rpc_mutex;
+
+static void rpc_lock(void)
+{
+    xSemaphoreTake(rpc_mutex, portMAX_DELAY);
+}
+
+static void rpc_unlock(void)
+{
+    xSemaphoreGive(rpc_mutex);
+}
+
+// 封装一帧并放入发送队列（调用时已持有锁），dst_mask 为0或未开启寻址时按不指定目的节点发送
+static uint32_t rpc_send(const PackRpcHeader_t *hdr, const void *payload, uint16_t size, uint8_t dst_mask)
+{
+    uint8_t *buf = kRpcTxBuf[kRpcTxIndex];
+    kRpcTxIndex = (kRpcTxIndex + 1) % RPC_TX_RING;
+    memcpy(buf, hdr, sizeof(*hdr));
+    if (size)
+        memcpy(buf + sizeof(*hdr), payload, size);
+    if (dst_mask && comm_get_node_id() != COMM_NODE_NONE)
+        return asyn_comm_send_pack_nak_to(dst_mask, buf, CMD_RPC, (uint16_t)(sizeof(*hdr) + size));
+    return asyn_comm_send_pack_nak(buf, CMD_RPC, (uint16_t)(sizeof(*hdr) + size));
+}
+
+// 服务方：执行方法并回复给发起请求的节点
+static void rpc_serve(const PackRpcHeader_t *req, const uint8_t *args, uint16_t size)
+{
+    uint8_t caller = comm_recv_src_node();
+    RpcMethod_t method = {0};
+    rpc_lock();
+    for (uint8_t i = 0; i < kRpcMethodNum; i++)
+    {
+        if (kRpcMethods[i].method == req->method)
+        {
+            method = kRpcMethods[i];
+            break;
+        }
+    }
+    rpc_unlock();
+
+    uint8_t resp[COMM_RPC_MAX_PAYLOAD];
+    uint16_t resp_size = 0;
+    uint32_t status;
+    if (!method.handler)
+        status = COMM_RPC_ERR_NO_METHOD;
+    else if (method.req_size && method.req_size != size)
+        status = COMM_RPC_ERR_BAD_ARGS;
+    else
+        status = method.handler(args, size, resp, &resp_size, method.user_data);
+    if (status != COMM_RPC_OK || resp_size > COMM_RPC_MAX_PAYLOAD)
+        resp_size = 0;
+
+    PackRpcHeader_t hdr = {
+        .type = RPC_TYPE_RESPONSE,
+        .method = req->method,
+        .req_id = req->req_id,
+        .status = (uint8_t)status,
+    };
+    rpc_lock();
+    rpc_send(&hdr, resp, resp_size, caller < COMM_NODE_MAX ? COMM_NODE_MASK(caller) : 0);
+    rpc_unlock();
+}
+
+// 请求发给了哪些节点，应答就只接受来自这些节点的；发给全部节点时也接受不带地址的应答（对端未开启寻址）
+static uint32_t rpc_src_match(uint8_t dst_mask, uint8_t src_node)
+{
+    if (!dst_mask)
+        return 1;
+    if (src_node < COMM_NODE_MAX)
+        return (dst_mask & COMM_NODE_MASK(src_node)) != 0;
+    return dst_mask == COMM_NODE_BROADCAST;
+}
+
+// 调用方：按请求ID、方法和来源节点匹配应答，不同节点用各自的请求ID计数，只比较ID会把别的节点的应答当成自己的
+static void rpc_complete(const PackRpcHeader_t *hdr, const uint8_t *data, uint16_t size)
+{
+    uint8_t src_node = comm_recv_src_node();
+    rpc_lock();
+    for (int i = 0; i < COMM_RPC_MAX_IN_FLIGHT; i++)
+    {
+        RpcSlot_t *slot = &kRpcSlots[i];
+        if (slot->state == RPC_SLOT_WAITING && slot->req_id == hdr->req_id && slot->method == hdr->method &&
+            rpc_src_match(slot->dst_mask, src_node))
+        {
+            if (size > COMM_RPC_MAX_PAYLOAD)
+                size = COMM_RPC_MAX_PAYLOAD;
+            memcpy(slot->resp, data, size);
+            slot->resp_size = size;
+            slot->status = hdr->status;
+            slot->state = RPC_SLOT_DONE;
+            break;
+        }
+    }
+    rpc_unlock();
+}
+
+static void rpc_recv_cb(uint8_t *src, uint16_t size, void *user_data)
+{
+    PackRpcHeader_t hdr;
+    if (size < sizeof(hdr))
+        return;
+    memcpy(&hdr, src, sizeof(hdr));
+    if (hdr.type == RPC_TYPE_REQUEST)
+        rpc_serve(&hdr, src + sizeof(hdr), (uint16_t)(size - sizeof(hdr)));
+    else if (hdr.type == RPC_TYPE_RESPONSE)
+        rpc_complete(&hdr, src + sizeof(hdr), (uint16_t)(size - sizeof(hdr)));
+}
+
+uint32_t comm_rpc_init(void)
+{
+    if (!rpc_mutex)
+        rpc_mutex = xSemaphoreCreateMutex();
+    if (!rpc_mutex)
+        return 0;
+    rpc_lock();
+    if (!kRpcInited)
+        kRpcInited = register_comm_recv_cb(rpc_recv_cb, CMD_RPC, NULL) != 0;
+    uint32_t ret = kRpcInited;
+    rpc_unlock();
+    return ret;
+}
+
+uint32_t comm_rpc_register_method(uint8_t method, uint16_t req_size, CommRpcHandler_Cb handler, void *user_data)
+{
+    uint32_t ret = 0;
+    rpc_lock();
+    RpcMethod_t *slot = NULL;
+    for (uint8_t i = 0; i < kRpcMethodNum; i++)
+    {
+        if (kRpcMethods[i].method == method)
+            slot = &kRpcMethods[i];
+    }
+    if (!slot && kRpcMethodNum < COMM_RPC_MAX_METHODS)
+        slot = &kRpcMethods[kRpcMethodNum++];
+    if (slot)
+    {
+        slot->method = method;
+        slot->req_size = req_size;
+        slot->handler = handler;
+        slot->user_data = user_data;
+        ret = 1;
+    }
+    rpc_unlock();
+    return ret;
+}
+
+uint32_t comm_rpc_call(uint8_t method, const void *args, uint16_t size, uint32_t timeout_ms, CommRpcDone_Cb done, void *user_data)
+{
+    if (size > COMM_RPC_MAX_PAYLOAD || (size && !args))
+        return 0;
+
+    uint32_t call_id = 0;
+    rpc_lock();
+    for (int i = 0; i < COMM_RPC_MAX_IN_FLIGHT; i++)
+    {
+        RpcSlot_t *slot = &kRpcSlots[i];
+        if (slot->state != RPC_SLOT_FREE)
+            continue;
+
+        if (++kRpcReqId == 0)   // 0 保留作无效调用ID
+            kRpcReqId = 1;
+        PackRpcHeader_t hdr = {
+            .type = RPC_TYPE_REQUEST,
+            .method = method,
+            .req_id = kRpcReqId,
+        };
+        // 开启寻址时明确发往当前的默认目的节点，应答按这个掩码检查来源
+        uint8_t dst_mask = comm_get_node_id() != COMM_NODE_NONE ? comm_get_default_dst() : 0;
+        if (!rpc_send(&hdr, args, size, dst_mask))
+            break;
+
+        slot->state = RPC_SLOT_WAITING;
+        slot->method = method;
+        slot->req_id = kRpcReqId;
+        slot->dst_mask = dst_mask;
+        slot->status = COMM_RPC_OK;
+        slot->resp_size = 0;
+        slot->deadline_ms = comm_get_time_ms() + timeout_ms;
+        slot->done = done;
+        slot->user_data = user_data;
+        call_id = kRpcReqId;
+        break;
+    }
+    rpc_unlock();
+    return call_id;
+}
+
+uint32_t comm_rpc_cancel(uint32_t call_id)
+{
+    uint32_t ret = 0;
+    rpc_lock();
+    for (int i = 0; i < COMM_RPC_MAX_IN_FLIGHT; i++)
+    {
+        RpcSlot_t *slot = &kRpcSlots[i];
+        if (slot->state != RPC_SLOT_FREE && slot->req_id == call_id)
+        {
+            slot->state = RPC_SLOT_FREE;
+            ret = 1;
+            break;
+        }
+    }
+    rpc_unlock();
+    return ret;
+}
+
+uint32_t comm_rpc_cancel_by_user(void *user_data)
+{
+    uint32_t num = 0;
+    rpc_lock();
+    for (int i = 0; i < COMM_RPC_MAX_IN_FLIGHT; i++)
+    {
+        RpcSlot_t *slot = &kRpcSlots[i];
+        if (slot->state != RPC_SLOT_FREE && slot->user_data == user_data)
+        {
+            slot->state = RPC_SLOT_FREE;
+            num++;
+        }
+    }
+    rpc_unlock();
+    return num;
+}
+
+uint32_t comm_rpc_poll(void)
+{
+    uint32_t num = 0;
+    int64_t now = comm_get_time_ms();
+    for (int i = 0; i < COMM_RPC_MAX_IN_FLIGHT; i++)
+    {
+        // 逐个取出后释放锁再执行回调，回调中可以继续发起调用
+        CommRpcDone_Cb done = NULL;
+        void *user_data = NULL;
+        uint32_t status = 0;
+        uint16_t size = 0;
+        uint8_t resp[COMM_RPC_MAX_PAYLOAD];
+
+        rpc_lock();
+        RpcSlot_t *slot = &kRpcSlots[i];
+        if (slot->state == RPC_SLOT_WAITING && now >= slot->deadline_ms)
+        {
+            slot->status = COMM_RPC_ERR_TIMEOUT;
+            slot->resp_size = 0;
+            slot->state = RPC_SLOT_DONE;
+        }
+        uint8_t finished = (slot->state == RPC_SLOT_DONE);
+        if (finished)
+        {
+            done = slot->done;
+            user_data = slot->user_data;
+            status = slot->status;
+            size = slot->resp_size;
+            memcpy(resp, slot->resp, size);
+            slot->state = RPC_SLOT_FREE;
+        }
+        rpc_unlock();
+
+        if (finished && done)
+        {
+            done(status, resp, size, user_data);
+            num++;
+        }
+    }
+    return num;
+}
+
+uint32_t comm_rpc_in_flight(void)
+{
+    uint32_t num = 0;
+    rpc_lock();
+    for (int i = 0; i < COMM_RPC_MAX_IN_FLIGHT; i++)
+        num += kRpcSlots[i].state != RPC_SLOT_FREE;
+    rpc_unlock();
+    return num;
+}
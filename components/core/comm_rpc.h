@@ -0,0 +1,104 @@
+#ifndef __COMM_RPC_H__
+#define __COMM_RPC_H__
+
+#include <stdint.h>
+#include "dataFrame.h"
+
+/*
+ * 请求/应答（RPC）层，基于 comm.c 的收发接口，使用 CMD_RPC 命令：
+ * - 调用方 comm_rpc_call() 发出请求后立即返回调用ID，最多 COMM_RPC_MAX_IN_FLIGHT 个请求同时在途，可流水线发出多个读取
+ * - 每个请求带独立的超时，应答按请求ID匹配，超时后才到的应答会被丢弃
+ * - 完成回调（成功/超时/对端错误）统一在 comm_rpc_poll() 中执行，UI 在 lv_timer 回调里调用 comm_rpc_poll()，
+ *   完成回调就运行在 LVGL 线程中，可以直接操作控件
+ * - 服务方用 comm_rpc_register_method() 注册方法处理函数，处理函数在通信接收任务中执行，应尽快返回
+ *
+ * 多机寻址时请求发往默认目的节点（comm_set_default_dst），应答发回发起请求的节点；
+ * 调用方只接受发出请求时默认目的节点中的节点的应答（默认目的为全部节点时也接受不带地址的应答）。
+ *
+ * 请求和应答都不需要链路层ACK，丢失由调用方超时处理，调用方可自行重试（方法应设计为可重复执行）。
+ */
+
+#define COMM_RPC_MAX_IN_FLIGHT      8       // 同时在途的请求数
+#define COMM_RPC_MAX_METHODS        16      // 可注册的方法数
+#define COMM_RPC_MAX_PAYLOAD        64      // 请求参数/应答数据的最大长度
+
+typedef enum
+{
+    COMM_RPC_OK = 0,
+    COMM_RPC_ERR_NO_METHOD = 1,     // 对端没有注册该方法
+    COMM_RPC_ERR_BAD_ARGS = 2,      // 参数长度与方法声明不符
+    COMM_RPC_ERR_FAILED = 3,        // 处理函数执行失败
+    COMM_RPC_ERR_TIMEOUT = 0x80,    // 本地：超时没有收到应答
+} CommRpcStatus_t;
+
+/**
+ * @brief 调用完成回调，在 comm_rpc_poll() 中执行
+ * @param status CommRpcStatus_t
+ * @param resp 应答数据（status 为 COMM_RPC_OK 时有效，回调返回后失效）
+ * @param size 应答数据长度
+ * @param user_data 调用时传入的用户数据
+ */
+typedef void (*CommRpcDone_Cb)(uint32_t status, const uint8_t *resp, uint16_t size, void *user_data);
+
+/**
+ * @brief 方法处理函数，在通信接收任务中执行
+ * @param req 请求参数
+ * @param req_size 请求参数长度
+ * @param resp 应答数据输出，最大 COMM_RPC_MAX_PAYLOAD 字节
+ * @param resp_size 输出应答数据长度（默认0）
+ * @return CommRpcStatus_t，非 COMM_RPC_OK 时只回复状态
+ */
+typedef uint32_t (*CommRpcHandler_Cb)(const uint8_t *req, uint16_t req_size, uint8_t *resp, uint16_t *resp_size, void *user_data);
+
+/**
+ * @brief 初始化RPC层（在 RemoteCommInit 之后、其它RPC函数之前调用，重复调用无副作用）
+ * @return 1 成功；0 失败
+ */
+uint32_t comm_rpc_init(void);
+
+/**
+ * @brief 注册方法处理函数（同一方法重复注册则替换）
+ * @param method 方法号
+ * @param req_size 请求参数长度，不符时直接回复 COMM_RPC_ERR_BAD_ARGS；0 表示不检查（变长参数）
+ * @param handler 处理函数
+ * @param user_data 其它用户数据
+ * @return 1 成功；0 方法表已满
+ */
+uint32_t comm_rpc_register_method(uint8_t method, uint16_t req_size, CommRpcHandler_Cb handler, void *user_data);
+
+/**
+ * @brief 发起一次调用，立即返回
+ * @param method 方法号
+ * @param args 请求参数（函数内拷贝，调用后即可释放）
+ * @param size 请求参数长度，不超过 COMM_RPC_MAX_PAYLOAD
+ * @param timeout_ms 从发起到收到应答的超时时间
+ * @param done 完成回调，可为NULL
+ * @param user_data 回调用户数据
+ * @return 调用ID（非0），可用于 comm_rpc_cancel；0 在途请求已满/参数过长/发送队列满
+ */
+uint32_t comm_rpc_call(uint8_t method, const void *args, uint16_t size, uint32_t timeout_ms, CommRpcDone_Cb done, void *user_data);
+
+/**
+ * @brief 取消一次调用，之后不会再执行它的完成回调
+ * @return 1 成功；0 调用已完成或不存在
+ */
+uint32_t comm_rpc_cancel(uint32_t call_id);
+
+/**
+ * @brief 取消 user_data 相同的全部调用（页面销毁时使用，避免回调访问已删除的控件）
+ * @return 取消的个数
+ */
+uint32_t comm_rpc_cancel_by_user(void *user_data);
+
+/**
+ * @brief 执行已完成调用的回调，并检查超时；超时判断的精度取决于调用周期
+ * @return 本次执行的回调个数
+ */
+uint32_t comm_rpc_poll(void);
+
+/**
+ * @brief 当前在途的调用个数
+ */
+uint32_t comm_rpc_in_flight(void);
+
+#endif
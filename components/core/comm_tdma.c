@@ -0,0 +1,148 @@
+#include "comm_tdma.h"
+#include "comm_port.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+typedef struct
+{
+    CommTdmaConfig_t cfg;
+    int64_t origin_ms;          // 超帧起点（主机：开启时刻；从机：最近一次信标对应的超帧起点）
+    int64_t last_beacon_win;    // 主机最近一次发送信标的窗口起点
+    uint8_t synced;
+} TdmaState_t;
+
+static TdmaState_t kTdma;
+static SemaphoreHandle_t tdma_mutex;
+
+static void tdma_lock(void)
+{
+    xSemaphoreTake(tdma_mutex, portMAX_DELAY);
+}
+
+static void tdma_unlock(void)
+{
+    xSemaphoreGive(tdma_mutex);
+}
+
+void tdma_init(void)
+{
+    tdma_mutex = xSemaphoreCreateMutex();
+}
+
+static uint32_t tdma_period_ms(const CommTdmaConfig_t *cfg)
+{
+    return (uint32_t)cfg->downlink_ms + cfg->uplink_ms + 2u * cfg->guard_ms;
+}
+
+uint32_t comm_tdma_config(const CommTdmaConfig_t *cfg)
+{
+    if (!cfg || cfg->role > COMM_TDMA_SLAVE)
+        return 0;
+    if (cfg->role == COMM_TDMA_MASTER && (cfg->downlink_ms == 0 || cfg->uplink_ms == 0))
+        return 0;
+
+    tdma_lock();
+    kTdma.cfg = *cfg;
+    kTdma.origin_ms = comm_get_time_ms();
+    kTdma.last_beacon_win = -1;
+    kTdma.synced = (cfg->role == COMM_TDMA_MASTER);
+    tdma_unlock();
+    return 1;
+}
+
+uint32_t comm_tdma_is_synced(void)
+{
+    return kTdma.cfg.role != COMM_TDMA_OFF && kTdma.synced;
+}
+
+uint32_t tdma_enabled(void)
+{
+    return kTdma.cfg.role != COMM_TDMA_OFF;
+}
+
+uint8_t tdma_role(void)
+{
+    return kTdma.cfg.role;
+}
+
+uint32_t tdma_airtime_ms(uint16_t bytes)
+{
+    uint32_t bps = kTdma.cfg.air_bps;
+    if (!bps)
+        return 0;
+    return ((uint32_t)bytes * 10u * 1000u + bps - 1) / bps;
+}
+
+uint32_t tdma_wait_window(int64_t *win_start, int64_t *win_end)
+{
+    tdma_lock();
+    TdmaState_t s = kTdma;
+    tdma_unlock();
+
+    uint32_t period = tdma_period_ms(&s.cfg);
+    if (!s.synced || period == 0)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        return 0;
+    }
+
+    uint32_t start = 0, len = s.cfg.downlink_ms;
+    if (s.cfg.role == COMM_TDMA_SLAVE)
+    {
+        start = (uint32_t)s.cfg.downlink_ms + s.cfg.guard_ms;
+        len = s.cfg.uplink_ms;
+    }
+
+    int64_t now = comm_get_time_ms();
+    int64_t phase = (now - s.origin_ms) % period;
+    if (phase < 0)
+        phase += period;
+
+    int64_t begin;
+    if (phase < start) // 窗口还没开始
+        begin = now + (start - phase);
+    else if (phase < start + len) // 已经在窗口内，使用剩余部分
+        begin = now - (phase - start);
+    else // 本超帧的窗口已过，等下一个超帧
+        begin = now + (period - phase) + start;
+
+    if (begin > now)
+        vTaskDelay(pdMS_TO_TICKS((uint32_t)(begin - now)));
+
+    *win_start = begin;
+    *win_end = begin + len;
+    return 1;
+}
+
+uint32_t tdma_build_beacon(int64_t win_start, PackTdmaBeacon_t *beacon)
+{
+    uint32_t need = 0;
+    tdma_lock();
+    if (kTdma.cfg.role == COMM_TDMA_MASTER && kTdma.last_beacon_win != win_start)
+    {
+        kTdma.last_beacon_win = win_start;
+        beacon->type = LINK_CTRL_TDMA_BEACON;
+        beacon->downlink_ms = kTdma.cfg.downlink_ms;
+        beacon->uplink_ms = kTdma.cfg.uplink_ms;
+        beacon->guard_ms = kTdma.cfg.guard_ms;
+        need = 1;
+    }
+    tdma_unlock();
+    return need;
+}
+
+void tdma_on_beacon(const PackTdmaBeacon_t *beacon, int64_t rx_time_ms, uint16_t frame_len)
+{
+    tdma_lock();
+    if (kTdma.cfg.role == COMM_TDMA_SLAVE && beacon->downlink_ms && beacon->uplink_ms)
+    {
+        kTdma.cfg.downlink_ms = beacon->downlink_ms;
+        kTdma.cfg.uplink_ms = beacon->uplink_ms;
+        kTdma.cfg.guard_ms = beacon->guard_ms;
+        // 信标在下行窗口开头发出，扣除其空口耗时即为超帧起点
+        kTdma.origin_ms = rx_time_ms - tdma_airtime_ms(frame_len);
+        kTdma.synced = 1;
+    }
+    tdma_unlock();
+}
@@ -0,0 +1,80 @@
+#ifndef __COMM_TDMA_H__
+#define __COMM_TDMA_H__
+
+#include <stdint.h>
+#include "dataFrame.h"
+
+/*
+ * 半双工时隙（TDMA）模式：
+ * 遥控器作为主机定义超帧 = 下行窗口 + 保护间隔 + 上行窗口 + 保护间隔，并在每个下行窗口开始时发送信标。
+ * 机器人作为从机收到信标后对齐超帧，只在上行窗口发送（反馈帧和ACK都排队到上行窗口）。
+ * 两端都只在自己的窗口内发送，半双工LORA模块上不再发生收发冲突。
+ *
+ * 注意：开启后带ACK的发送，其超时时间应大于一个超帧周期，否则ACK还没轮到上行窗口就会触发重发。
+ */
+
+typedef enum
+{
+    COMM_TDMA_OFF = 0,      // 关闭时隙模式（默认，两端随时发送）
+    COMM_TDMA_MASTER,       // 主机（遥控器），决定超帧参数
+    COMM_TDMA_SLAVE,        // 从机（机器人），跟随主机信标
+} CommTdmaRole_t;
+
+typedef struct
+{
+    uint8_t role;           // CommTdmaRole_t
+    uint16_t downlink_ms;   // 下行窗口长度（仅主机有效，从机从信标获得）
+    uint16_t uplink_ms;     // 上行窗口长度（仅主机有效）
+    uint16_t guard_ms;      // 保护间隔（仅主机有效），覆盖模块收发切换时间
+    uint32_t air_bps;       // 空口速率（bit/s），用于估算每帧占用窗口的时间
+} CommTdmaConfig_t;
+
+/**
+ * @brief 配置时隙模式，在 RemoteCommInit 之后调用，之后可以随时修改
+ * @param cfg 配置，role 为 COMM_TDMA_OFF 时关闭时隙模式
+ * @return 1 成功；0 参数错误
+ */
+uint32_t comm_tdma_config(const CommTdmaConfig_t *cfg);
+
+/**
+ * @brief 从机是否已经与主机信标对齐（主机始终返回1，关闭时返回0）
+ */
+uint32_t comm_tdma_is_synced(void);
+
+/* -------------------- 以下接口供 comm.c 内部使用 -------------------- */
+
+/**
+ * @brief 创建互斥锁，由 RemoteCommInitWithPort 在创建通信任务之前调用
+ */
+void tdma_init(void);
+
+uint32_t tdma_enabled(void);
+uint8_t tdma_role(void);
+
+/**
+ * @brief 估算 bytes 字节在空口上占用的时间（ms）
+ */
+uint32_t tdma_airtime_ms(uint16_t bytes);
+
+/**
+ * @brief 阻塞直到本端发送窗口开始（若当前已在窗口内则立即返回）
+ * @param win_start 输出窗口开始时间（ms）
+ * @param win_end 输出窗口结束时间（ms）
+ * @return 1 获得窗口；0 尚未同步（从机未收到信标），调用者应稍后重试
+ */
+uint32_t tdma_wait_window(int64_t *win_start, int64_t *win_end);
+
+/**
+ * @brief 主机在窗口开始时生成信标内容
+ * @return 1 本窗口需要发送信标；0 本窗口已经发送过
+ */
+uint32_t tdma_build_beacon(int64_t win_start, PackTdmaBeacon_t *beacon);
+
+/**
+ * @brief 从机收到信标时对齐超帧
+ * @param rx_time_ms 信标接收完成的时间
+ * @param frame_len 信标整帧长度（用于扣除空口耗时）
+ */
+void tdma_on_beacon(const PackTdmaBeacon_t *beacon, int64_t rx_time_ms, uint16_t frame_len);
+
+#endif
@@ -1,162 +1,268 @@
+#include <stdatomic.h>
 #include "core.h"
 #include "hardware.h"
 #include "comm.h"
-#include "driver/adc.h"
+#include "input_scanner.h"
+#include "rocker_adc.h"
+#include "stick_filter.h"
+#include "stick_calib.h"
+#include "key_event.h"
+#include "send_scheduler.h"
+#include "remote_state.h"
+#include "latency_trace.h"
+#include "mixer.h"
+#include "virtual_item.h"
+#include "task_config.h"
+#include "task_monitor.h"
+#include "power_manager.h"
+#include "input_record.h"
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+#include "esp_adc/adc_oneshot.h"
+
+#define CORE_BATTERY_PERIOD_MS  100     // 电池电压更新周期
 
-float NormalizationRocker(int adc_value, int dead_zone, int offset);
 float CalcBatteryVoltage();
 void BatteryADCInit();
 
-// 初始化LS165硬件接口
-static void InitButtonsInput(void)
-{
-    // SH/LD + CLK = OUTPUT
-    gpio_config_t cfg_out = {
-        .intr_type = GPIO_INTR_DISABLE,
-        .mode = GPIO_MODE_OUTPUT,
-        .pin_bit_mask = (1ULL << SH_LD_PIN) | (1ULL << CLK_PIN),
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE};
-    gpio_config(&cfg_out);
+// 默认滤波链和参数见 core_config.h
+STICK_FILTER_DEFINE_Q15_CHAIN(core_stick_filter, CORE_STICK_CHAIN)
 
-    // QH = INPUT with pull-up !!!
-    gpio_config_t cfg_in = {
-        .intr_type = GPIO_INTR_DISABLE,
-        .mode = GPIO_MODE_INPUT,
-        .pin_bit_mask = (1ULL << QH_PIN),
-        .pull_up_en = GPIO_PULLUP_ENABLE, // 必须打开
-        .pull_down_en = GPIO_PULLDOWN_DISABLE};
-    gpio_config(&cfg_in);
-
-    // 初始状态
-    gpio_set_level(CLK_PIN, 0);
-    gpio_set_level(SH_LD_PIN, 1); // High = shift mode
-}
-
-// 返回按键状态
-static uint32_t UpdateButtons()
-{
-    uint32_t temp = 0;
-    gpio_set_level(SH_LD_PIN, 0); // 数据锁存
-    esp_rom_delay_us(2);
-    gpio_set_level(SH_LD_PIN, 1); // 数据锁存
-    esp_rom_delay_us(2);
-    for (int i = 0; i < 16; i++)
+static StickFilter_t kStickFilter[4];
+static SendScheduler_t kSendScheduler;     // 只由扫描任务访问
+
+// 发送调度的配置（其它任务 -> 扫描任务）和统计（扫描任务 -> 其它任务）用序号保护（seqlock，同 remote_state.c），
+// 序号为奇数表示正在写入；扫描任务不等待任何锁，读到写了一半的配置时留到下一次扫描再取
+static atomic_uint kScheduleCfgSeq;
+static SendSchedulerConfig_t kScheduleCfg;
+static uint32_t kScheduleCfgApplied;         // 扫描任务已应用的配置序号
+static SemaphoreHandle_t schedule_cfg_mutex; // 只在调用 set_send_schedule 的任务之间互斥
+static atomic_uint kScheduleStatsSeq;
+static SendSchedulerStats_t kScheduleStats;
+static TaskLoopMonitor_t kLoopMonitor;
+
+static void StickFilterReset(void)
+{
+    for (int i = 0; i < 4; i++)
     {
-        gpio_set_level(CLK_PIN, 1);
-        esp_rom_delay_us(2); // 数据稳定时间
-        temp = temp | (gpio_get_level(QH_PIN) << i);
-        gpio_set_level(CLK_PIN, 0);
-        esp_rom_delay_us(2);
+        StickFilterConfig_t cfg = CORE_STICK_FILTER_CONFIG;
+        stick_filter_init(&kStickFilter[i], &cfg);
     }
-    return temp;
 }
 
-void default_remote_state_flush(const int *rockers, const uint16_t key,void* user_data)
+// 发送是零拷贝的，控制包轮流使用这些缓冲；缓冲个数大于发送队列长度，
+// 轮回到同一个缓冲时它对应的帧必然已经被发送任务取走（同 comm_rpc.c），扫描任务不会改写还在队列中的帧
+#define CONTROL_TX_RING     (COMM_SEND_QUEUE_LEN + 2)
+
+typedef union
 {
-    PackControl_t *remoteInfo = (PackControl_t *)user_data;
-    static float rocker_raw_value[4];
+    PackControl_t control;
+    PackChannel_t channel;
+} ControlTxBuf_t;
 
-    rocker_raw_value[0] = NormalizationRocker(rockers[0], 80, -20);
-    rocker_raw_value[1] = NormalizationRocker(rockers[1], 80, -90);
-    rocker_raw_value[2] = NormalizationRocker(rockers[2], 80, 100);
-    rocker_raw_value[3] = NormalizationRocker(rockers[3], 80, -10);
-    for (int i = 0; i < 4; i++)
+static ControlTxBuf_t kControlTxBuf[CONTROL_TX_RING];
+static uint8_t kControlTxIndex;
+static uint8_t kMixerActive;
+static float battery_voltage = 4.0f;
+
+// 发送控制包（由发送调度决定时机），加载了混控模型时发送混控后的通道
+// @return 1 已放入发送队列；0 队列满
+static uint32_t SendControlPack(const RemoteState_t *state)
+{
+    uint32_t ok;
+    ControlTxBuf_t *buf = &kControlTxBuf[kControlTxIndex];
+    kControlTxIndex = (kControlTxIndex + 1) % CONTROL_TX_RING;
+    LATENCY_TRACE_BEGIN(state->seq);
+    if (kMixerActive)
     {
-        rocker_raw_value[i] = 0.21f * rocker_raw_value[i] + (1.0f - 0.21f) * rocker_raw_value[i];
-        remoteInfo->rocker[i] = rocker_raw_value[0];
+        memcpy(buf->channel.channel, state->channel, sizeof(buf->channel.channel));
+        buf->channel.Key = state->keys;
+        ok = asyn_comm_send_pack_nak((uint8_t *)&buf->channel, PACK_CHANNEL_CMD, sizeof(PackChannel_t));
     }
-    remoteInfo->Key = key;
-    asyn_comm_send_pack_nak((uint8_t *)user_data, PACK_CONTROL_CMD, sizeof(PackControl_t));
+    else
+    {
+        for (int i = 0; i < 4; i++)
+            buf->control.rocker[i] = stick_q15_to_float(state->stick[i]);
+        buf->control.Key = state->keys;
+        ok = asyn_comm_send_pack_nak((uint8_t *)&buf->control, PACK_CONTROL_CMD, sizeof(PackControl_t));
+    }
+    if (!ok)
+        LATENCY_TRACE_ABORT();
+    return ok;
 }
 
-static PackControl_t remoteInfo;
-static float battery_voltage = 4.0f;
-static uint16_t buttons_state=0;
-static int rocker_adc_value[4] = {0};     // ADC原始数据
-static RemoteStateFlush_t kRemoteStateFlushFunc = default_remote_state_flush;
-void *kRemoteStateFlushUserData = &remoteInfo;
-void CoreTask(void *param) // 遥控器核心任务
+// 应用 set_send_schedule 设置的新配置（扫描任务）
+static void SendScheduleApplyConfig(void)
 {
-    float battery_alpha = 0.95; // 电池电压低通滤波系数
-    InitButtonsInput();
-    BatteryADCInit();
+    uint32_t seq = atomic_load_explicit(&kScheduleCfgSeq, memory_order_acquire);
+    if (seq == kScheduleCfgApplied || (seq & 1))
+        return;
+    SendSchedulerConfig_t cfg = kScheduleCfg;
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(&kScheduleCfgSeq, memory_order_relaxed) != seq)
+        return;
+    kScheduleCfgApplied = seq;
+    send_scheduler_set_config(&kSendScheduler, &cfg);
+}
 
-    adc1_config_width(ADC_WIDTH_BIT_12);                        // 配置ADC分辨率为12位
-    adc1_config_channel_atten(LEFT_ROCKER_X, ADC_ATTEN_DB_12);  // 配置ADC通道衰减
-    adc1_config_channel_atten(LEFT_ROCKER_Y, ADC_ATTEN_DB_12);  // 配置ADC通道衰减
-    adc1_config_channel_atten(RIGHT_ROCKER_X, ADC_ATTEN_DB_12); // 配置ADC通道衰减
-    adc1_config_channel_atten(RIGHT_ROCKER_Y, ADC_ATTEN_DB_12); // 配置ADC通道衰减
+// 发布发送调度统计供 get_send_schedule_stats 读取（扫描任务）
+static void SendSchedulePublishStats(void)
+{
+    uint32_t seq = atomic_load_explicit(&kScheduleStatsSeq, memory_order_relaxed);
+    atomic_store_explicit(&kScheduleStatsSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    kScheduleStats = kSendScheduler.stats;
+    atomic_store_explicit(&kScheduleStatsSeq, seq + 2, memory_order_release);
+}
 
+void CoreTask(void *param) // 遥控器核心任务
+{
+    float battery_alpha = 0.8; // 电池电压低通滤波系数
+    int64_t battery_update_us = 0;
+    // SPI外设扫描按键，初始化失败时退回软件翻转IO
+    if (!input_scanner_init(input_scanner_spi_backend()))
+        input_scanner_init(input_scanner_gpio_backend());
+    BatteryADCInit();
+    rocker_adc_init();  // 摇杆由ADC连续模式+DMA采样
+    StickFilterReset();     // 校准查找表由 RemoteCoreInit 生成
+    virtual_item_init();    // 接收机器人对虚拟控件的修改
+    send_scheduler_init(&kSendScheduler, NULL);
+#if LATENCY_TRACE_ENABLE
+    comm_set_tx_trace(latency_trace_comm_hook);  // 跟踪控制包经过发送队列和串口的时刻
+#endif
+
+    RemoteState_t state = {0};
+    int16_t calibrated[4];
+    uint32_t pm_state = PM_STATE_ACTIVE;
+    uint32_t period_ms = 1000 / CORE_SCAN_HZ;
+    task_loop_monitor_init(&kLoopMonitor, period_ms * 1000);
     TickType_t last_wake_time = xTaskGetTickCount();
     while (1)
     {
-        rocker_adc_value[0] = adc1_get_raw(LEFT_ROCKER_X);  // 读取ADC值
-        rocker_adc_value[1] = adc1_get_raw(LEFT_ROCKER_Y);  // 读取ADC值
-        rocker_adc_value[2] = adc1_get_raw(RIGHT_ROCKER_X); // 读取ADC值
-        rocker_adc_value[3] = adc1_get_raw(RIGHT_ROCKER_Y); // 读取ADC值
-        buttons_state=UpdateButtons();
-
-        //遥控器状态刷新
-        kRemoteStateFlushFunc(rocker_adc_value,buttons_state,kRemoteStateFlushUserData);
-
-        //电池电量更新
-        battery_voltage = (1.0f - battery_alpha) * CalcBatteryVoltage() + battery_alpha * battery_voltage;
+        task_loop_monitor_wake(&kLoopMonitor, esp_timer_get_time());   // 统计扫描周期的调度抖动
+        if (pm_state == PM_STATE_IDLE)
+        {
+            // 空闲时两次扫描之间ADC暂停，扫描时临时恢复采样
+            rocker_adc_set_running(1);
+            vTaskDelay(pdMS_TO_TICKS(PM_IDLE_ADC_SETTLE_MS));
+        }
+        input_scanner_start();  // 按键移位由SPI外设完成，期间采样摇杆
+        rocker_adc_read(state.raw);  // 取出DMA缓冲中的新样本，输出截尾平均值（没有新样本时保持上一次的值）
+        LATENCY_TRACE_SCAN(LATENCY_STAGE_ADC);
+        stick_calib_feed(state.raw); // 校准页面打开时采集中心/行程
+        input_scanner_read(&state.keys);
+        int64_t now_us = esp_timer_get_time();
+        state.time_us = now_us;
+        //录制硬件输入，或用录制文件中本周期的样本代替
+        uint32_t input_src = input_record_scan(state.raw, &state.keys, now_us);
+        if (input_src == INPUT_SCAN_REPLAY_FIRST)
+        {
+            // 每次回放从相同的初始状态开始
+            SendSchedulerConfig_t cfg = kSendScheduler.cfg;
+            StickFilterReset();
+            send_scheduler_init(&kSendScheduler, &cfg);
+        }
+        if (input_src != INPUT_SCAN_LIVE)
+            power_manager_activity();   // 录制/回放期间扫描周期保持不变
+        key_event_process(state.keys, now_us);    // 消抖并产生按键事件
+
+        //摇杆在每次扫描时滤波，发送时直接使用最新的滤波结果
+        for (int i = 0; i < 4; i++)
+        {
+            calibrated[i] = stick_calib_lookup(stick_calib_lut(i), state.raw[i]);
+            state.stick[i] = core_stick_filter(&kStickFilter[i], calibrated[i]);
+        }
+        kMixerActive = (uint8_t)mixer_run(state.stick, state.keys, state.channel);
+        if (!kMixerActive)
+        {
+            // 混控模型被卸载后，4~7通道不能保留最后一次混控的输出
+            memcpy(state.channel, state.stick, sizeof(state.stick));
+            memset(state.channel + 4, 0, sizeof(state.channel) - sizeof(state.stick));
+        }
+        LATENCY_TRACE_SCAN(LATENCY_STAGE_FILTER);
+
+        //发布到状态总线，调用到期的订阅者
+        remote_state_publish(&state);
+
+        //由发送调度决定是否发送控制包
+        SendScheduleApplyConfig();
+        if (send_scheduler_poll(&kSendScheduler, state.stick, state.keys, now_us) && !SendControlPack(&state))
+            send_scheduler_cancel(&kSendScheduler);     // 入队失败，下一次扫描重新判断
+        SendSchedulePublishStats();
+        virtual_item_poll(now_us);  // 虚拟控件变化时发送增量帧
+
+        //电源管理：长时间无操作时降低扫描频率、暂停ADC，允许浅睡眠
+        uint32_t new_state = power_manager_scan(calibrated, state.keys, now_us);
+        if (new_state != pm_state)
+        {
+            pm_state = new_state;
+            period_ms = pm_state == PM_STATE_IDLE ? PM_IDLE_SCAN_MS : 1000 / CORE_SCAN_HZ;
+            task_loop_monitor_set_period(&kLoopMonitor, period_ms * 1000);
+        }
+        if (pm_state == PM_STATE_IDLE)
+            rocker_adc_set_running(0);
+
+        //电池电量更新，低电量分级处理
+        if (now_us - battery_update_us >= CORE_BATTERY_PERIOD_MS * 1000)
+        {
+            battery_update_us = now_us;
+            battery_voltage = (1.0f - battery_alpha) * CalcBatteryVoltage() + battery_alpha * battery_voltage;
+            power_manager_battery_update(battery_voltage, now_us);
+        }
 
         //板载状态指示灯更新
 
-        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(20));
+        task_loop_monitor_done(&kLoopMonitor, esp_timer_get_time());
+        vTaskDelayUntil(&last_wake_time, pdMS_TO_TICKS(period_ms));
     }
 }
 
-void set_remote_flush_func(RemoteStateFlush_t func,void* user_data)
+void set_send_schedule(const SendSchedulerConfig_t *cfg)
+{
+    SendSchedulerConfig_t new_cfg;
+    if (cfg)
+        new_cfg = *cfg;
+    else
+        send_scheduler_default_config(&new_cfg);
+    xSemaphoreTake(schedule_cfg_mutex, portMAX_DELAY);
+    uint32_t seq = atomic_load_explicit(&kScheduleCfgSeq, memory_order_relaxed);
+    atomic_store_explicit(&kScheduleCfgSeq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    kScheduleCfg = new_cfg;
+    atomic_store_explicit(&kScheduleCfgSeq, seq + 2, memory_order_release);    // 由扫描任务在下一次扫描时应用
+    xSemaphoreGive(schedule_cfg_mutex);
+}
+
+void get_send_schedule_stats(SendSchedulerStats_t *stats)
 {
-    if(func == NULL)
+    while (1)
     {
-        kRemoteStateFlushFunc = default_remote_state_flush;
-        kRemoteStateFlushUserData = &remoteInfo;
-        return;
+        uint32_t seq = atomic_load_explicit(&kScheduleStatsSeq, memory_order_acquire);
+        if (seq & 1)
+            continue;   // 扫描任务正在写入，只需要复制一个结构体的时间
+        *stats = kScheduleStats;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&kScheduleStatsSeq, memory_order_relaxed) == seq)
+            return;
     }
-    kRemoteStateFlushFunc = func;
-    kRemoteStateFlushUserData = user_data;
 }
 
-RemoteStateFlush_t get_remote_flush_func()
+void get_core_loop_stats(TaskLoopStats_t *stats)
 {
-    return kRemoteStateFlushFunc;
+    *stats = kLoopMonitor.stats;
 }
 
-void get_remote_state(int rocker_raw_data[4],uint16_t* key_data)
+void reset_core_loop_stats(void)
 {
-    memcpy(rocker_raw_data, rocker_adc_value, sizeof(rocker_adc_value));
-    *key_data = buttons_state;
+    task_loop_monitor_reset(&kLoopMonitor);
 }
 
-float NormalizationRocker(int adc_value, int dead_zone, int offset)
+void get_remote_state(int rocker_raw_data[4],uint16_t* key_data)
 {
-    int v = adc_value + offset; // 注意这里是 + offset
-    int center = 0x7FF;         // 恒定中心点 2047
-
-    // 死区
-    if (v < center + dead_zone && v > center - dead_zone)
-        return 0.0f;
-
-    // 比例系数，归一化到 -1 ~ 1
-    float k = 1.0f / (0x7FF - 2 * dead_zone);
-
-    float out;
-    if (v > center)
-        out = (v - center - dead_zone) * k;
-    else
-        out = (v - center + dead_zone) * k;
-
-    // 限幅
-    if (out > 1.0f)
-        out = 1.0f;
-    if (out < -1.0f)
-        out = -1.0f;
-
-    return out;
+    RemoteState_t state = {0};
+    remote_state_read(&state);
+    memcpy(rocker_raw_data, state.raw, sizeof(state.raw));
+    *key_data = state.keys;
 }
 
 void sys_setup()
@@ -177,15 +283,30 @@ void sys_shutdown()
     gpio_set_level(PIN_NUM_POWER_ENABLE, 0);
 }
 
+// 摇杆占用ADC1连续模式，电池电压用ADC2单次转换（新版驱动不能与旧版 driver/adc.h 混用）
+static adc_oneshot_unit_handle_t kBatteryAdc;
 void BatteryADCInit()
 {
-    adc2_config_channel_atten(BATTERY_INPUT_CHANNEL, ADC_ATTEN_DB_12); // 测量电池电压
+    adc_oneshot_unit_init_cfg_t unit_cfg = {
+        .unit_id = ADC_UNIT_2,
+    };
+    if (adc_oneshot_new_unit(&unit_cfg, &kBatteryAdc) != ESP_OK)
+    {
+        kBatteryAdc = NULL;
+        return;
+    }
+    adc_oneshot_chan_cfg_t chan_cfg = {
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_12,
+    };
+    adc_oneshot_config_channel(kBatteryAdc, BATTERY_INPUT_CHANNEL, &chan_cfg); // 测量电池电压
 }
 
 float CalcBatteryVoltage()
 {
     int battery_adc_raw_value = 0;
-    adc2_get_raw(BATTERY_INPUT_CHANNEL, ADC_WIDTH_BIT_12, &battery_adc_raw_value);
+    if (!kBatteryAdc || adc_oneshot_read(kBatteryAdc, BATTERY_INPUT_CHANNEL, &battery_adc_raw_value) != ESP_OK)
+        return battery_voltage;     // 读取失败（ADC2被占用）时保持原值
     float voltage = battery_adc_raw_value;
     return 0.0017f * voltage + 0.0946f;
 }
@@ -197,22 +318,8 @@ float get_battery_voltage()
 
 float Get_Battery_level(float Battery_voltage)
 {
-     // 标准化
-    float x_norm = (Battery_voltage - 3.852) / 0.1979;
-
-    // 多项式计算
-    float y = 5.226 * pow(x_norm, 4)
-             - 4.407 * pow(x_norm, 3)
-             - 17.25 * pow(x_norm, 2)
-             + 42.71 * x_norm
-             + 61.18;
-
-    // 判段逻辑
-    if (y > 100.0) {
-        y = 100.0;
-    }
-
-    return y;
+    // 查找表取自原拟合多项式在有效区间内的值，避免浮点幂运算，低端不再回升
+    return power_battery_percent(Battery_voltage > 0.0f ? (uint32_t)(Battery_voltage * 1000.0f + 0.5f) : 0);
 }
 
 static TaskHandle_t buttons_scane_task_handle;
@@ -221,5 +328,13 @@ static TaskHandle_t buttons_scane_task_handle;
  */
 void RemoteCoreInit()
 {
-    xTaskCreate(CoreTask, "CoreTask", 4096, NULL, 5, &buttons_scane_task_handle);
+    // 扫描任务与界面、通信任务共用的模块，在创建扫描任务之前初始化（创建互斥锁）
+    remote_state_init();
+    if (!schedule_cfg_mutex)
+        schedule_cfg_mutex = xSemaphoreCreateMutex();
+    stick_calib_init();
+    latency_trace_init();
+    task_monitor_init();
+    power_manager_init();   // 动态调频、空闲时自动浅睡眠
+    TASK_CREATE(TASK_SCAN, CoreTask, NULL, &buttons_scane_task_handle);    //绑定实时核，见 task_config.h
 }
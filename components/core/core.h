@@ -9,8 +9,10 @@
 #include "freertos/queue.h"
 #include "driver/gpio.h"
 #include "dataFrame.h"
-
-typedef void(*RemoteStateFlush_t)(const int *rockers, const uint16_t key,void* user_data);
+#include "send_scheduler.h"
+#include "remote_state.h"
+#include "task_monitor.h"
+#include "core_config.h"
 
 void RemoteCoreInit();  //遥控器底层驱动组件初始化
 
@@ -21,6 +23,10 @@ void RemoteCoreInit();  //遥控器底层驱动组件初始化
  * @return 电池电压(V)
  */
 float get_battery_voltage();
+/**
+ * @brief 电池电压换算为电量（查找表插值，见 power_manager.h），低电量分级和自动关机见 power_manager_get_status
+ * @return 电量(0~100%)
+ */
 float Get_Battery_level(float Battery_voltage);
 /**
  * @brief 关闭遥控器
@@ -32,26 +38,38 @@ void sys_shutdown();
  */
 void sys_setup();
 
+/*
+ * 按键/摇杆状态由一个FreeRTOS任务以1kHz扫描，每次扫描的结果发布到状态总线（remote_state.h）：
+ * 需要持续处理状态的模块用 remote_state_subscribe 订阅（可以按需降低调用频率），只需要当前值时用 remote_state_read 读取。
+ * 控制包由扫描任务按发送调度发送（默认至少50Hz，摇杆/按键变化时立即发送，最高200Hz，见 set_send_schedule），不受订阅者影响。
+ */
+
+/**
+ * @brief 修改控制包发送调度（周期发送/变化触发、最小发送间隔、摇杆变化阈值），在下一次扫描时生效
+ * @param cfg 新配置，NULL 恢复默认配置
+ */
+void set_send_schedule(const SendSchedulerConfig_t *cfg);
+
+/**
+ * @brief 读取发送调度统计（发送次数及原因）
+ */
+void get_send_schedule_stats(SendSchedulerStats_t *stats);
+
 /**
- * @brief 设置遥控器状态更新函数。按键/摇杆状态在不断更新，因此有一个FreeRTOS任务会不断扫描他们的状态。
- * 该函数会在扫描完成后被调用，频率大约为50Hz，该函数不可以有任何阻塞行为
- * @param func 新的遥控器状态更新函数
- * @param user_data 其它用户数据
- * @note 最好不要在遥控器状态更新函数操作UI，因为在这里操作UI必须等待LVGL渲染的互斥锁释放，可能造成控制指令的延迟
- * @return void
+ * @brief 读取扫描循环统计（调度抖动、漏掉的周期、单次扫描执行时间），核负载见 task_monitor_core_load
  */
-void set_remote_flush_func(RemoteStateFlush_t func,void* user_data);
+void get_core_loop_stats(TaskLoopStats_t *stats);
 
 /**
- * @brief 得到当前的遥控器状态更新函数，通常用来实现在保留原有功能的条件下，实现附加的新功能。
- * @return 遥控器状态更新函数
+ * @brief 清空扫描循环统计，在下一次扫描时生效
  */
-RemoteStateFlush_t get_remote_flush_func();                         //得到当前正在使用的遥控器状态刷新函数
+void reset_core_loop_stats(void);
 
 /**
- * @brief 得到当前遥控器状态，该方法侵入性更小，使用更方便，但是只能读取，不能修改
+ * @brief 得到当前遥控器状态（remote_state_read 的简化版本，摇杆和按键来自同一次扫描）
  * @param rocker_raw_data 摇杆ADC原始数据（理想条件下0~4095）
  * @param key_data 按键数据
+ * @note 需要按下/松开/长按等变化时读取 key_event.h 的按键事件，不要自己比较两次的按键数据
  */
 void get_remote_state(int rocker_raw_data[4],uint16_t* key_data);
 
@@ -0,0 +1,26 @@
+#ifndef __CORE_CONFIG_H__
+#define __CORE_CONFIG_H__
+
+#include "stick_filter.h"
+
+/*
+ * 扫描频率和默认摇杆滤波参数，core.c 和 tools/stick_filter_bench 共用（基准的 default 行与固件一致），
+ * 不依赖FreeRTOS等其它头文件。
+ */
+
+#define CORE_SCAN_HZ            1000    // 按键/摇杆扫描频率，周期需为整数个FreeRTOS tick（1ms）
+
+// 默认滤波链：校准查找表完成归一化和死区，之后经过 One Euro 自适应低通（STICK_FILTER_DEFINE_Q15_CHAIN）
+#define CORE_STICK_CHAIN(S)     S(euro)
+
+// 默认滤波参数，stages 与 CORE_STICK_CHAIN 对应
+#define CORE_STICK_FILTER_CONFIG                                                                        \
+    {                                                                                                   \
+        .stages = STICK_STAGE_EURO,                                                                     \
+        .sample_hz = CORE_SCAN_HZ,                                                                      \
+        .euro_min_hz = 2.0f,                                                                            \
+        .euro_beta = 10.0f,                                                                             \
+        .euro_d_hz = 10.0f,     /* 1kHz扫描时每采样变化量小，速度估计需要更快的低通，否则推杆后截止频率升不起来 */ \
+    }
+
+#endif
@@ -5,6 +5,7 @@
 
 #define PACK_HEAD 0x5A
 #define ACK_HEAD 0xAA
+#define ACK_ADDR_HEAD 0xAB      // 带地址的确认帧（回复带地址的数据包）
 
 #define PACK_TYPE_MASK  0x80
 #define PACK_CMD_MASK   0x0F
@@ -18,6 +19,18 @@
 #define CMD_RECEIVER_MESSAGEBOX             0x03
 #define CMD_RECEIVER_UPDATE_VIRTUAL_ITEM    0x04
 
+//固件/资源文件传输（OTA）帧，由comm_ota.c处理
+#define CMD_OTA                             0x0D
+
+//请求/应答（RPC）帧，由comm_rpc.c处理
+#define CMD_RPC                             0x0E
+
+//协议内部链路控制帧（由comm.c自行处理，不分发给用户接收回调）
+#define CMD_LINK_CTRL                       0x0F
+#define LINK_CTRL_TDMA_BEACON               0x01
+#define LINK_CTRL_FLOW_CREDIT               0x02
+#define LINK_CTRL_HEARTBEAT                 0x03
+
 #define Right_Switch_Up     0x02
 #define Right_Switch_Down   0x04
 #define Right_Key_Up        0x08
@@ -43,6 +56,25 @@ typedef struct
 	uint32_t Key;
 }PackControl_t;
 
+//遥控器下行数据包，混控后的通道（加载了混控模型时代替 PackControl_t 发送，见 mixer.h）
+#define PACK_CHANNEL_CMD    0x05
+#define PACK_CHANNEL_NUM    8
+typedef struct
+{
+    int16_t channel[PACK_CHANNEL_NUM];  // Q15，32767 为 100%
+    uint32_t Key;
+}PackChannel_t;
+
+//虚拟控件（触摸屏上的滑条/开关/按钮，见 virtual_item.h）的值：
+//下行 CMD_REMOTE_UPDATE_VIRTUAL_ITEM 与上行 CMD_RECEIVER_UPDATE_VIRTUAL_ITEM 格式相同，
+//数据域为 uint8_t 项数，后面紧跟该数量的 PackVirtualItem_t，只包含变化了的项
+#define PACK_VIRTUAL_ITEM_MAX   16
+typedef struct
+{
+    uint8_t id;
+    int16_t value;          // Q15，开关/按钮为 0 或 32767
+}PackVirtualItem_t;
+
 //遥控器上行数据包，字符串反馈信息
 #define PACK_STR_FEEDBACK_CMD    0x02
 typedef struct
@@ -51,6 +83,96 @@ typedef struct
     uint8_t size;
     char* str;
 }PackMsg_t;
+
+//链路控制帧：TDMA超帧信标（主机在每个超帧的下行窗口开始时发送）
+typedef struct
+{
+    uint8_t type;           // LINK_CTRL_TDMA_BEACON
+    uint16_t downlink_ms;   // 下行窗口（主机发送）
+    uint16_t uplink_ms;     // 上行窗口（从机发送）
+    uint16_t guard_ms;      // 窗口间保护间隔
+}PackTdmaBeacon_t;
+
+//RPC帧头，后面紧跟请求参数或应答数据
+#define RPC_TYPE_REQUEST    0x00
+#define RPC_TYPE_RESPONSE   0x01
+typedef struct
+{
+    uint8_t type;           // RPC_TYPE_REQUEST / RPC_TYPE_RESPONSE
+    uint8_t method;         // 方法号
+    uint16_t req_id;        // 请求ID，应答原样带回用于匹配
+    uint8_t status;         // 应答状态（CommRpcStatus_t），请求中为0
+}PackRpcHeader_t;
+
+//RPC方法：读取/设置机器人参数
+#define RPC_METHOD_PARAM_GET    0x01    // 参数 PackRpcParamId_t，应答 PackRpcParamValue_t
+#define RPC_METHOD_PARAM_SET    0x02    // 参数 PackRpcParamValue_t，应答 PackRpcParamValue_t（设置后的值）
+#define RPC_METHOD_SENSOR_READ  0x03    // 参数 PackRpcParamId_t（传感器编号），应答 PackRpcParamValue_t
+typedef struct
+{
+    uint16_t id;
+}PackRpcParamId_t;
+
+typedef struct
+{
+    uint16_t id;
+    float value;
+}PackRpcParamValue_t;
+
+//链路控制帧：批量数据流控窗口通告（接收端在窗口变化时及周期性发送）
+typedef struct
+{
+    uint8_t type;           // LINK_CTRL_FLOW_CREDIT
+    uint16_t window;        // 接收端还能接收的批量数据包个数，0表示暂停
+}PackFlowCredit_t;
+
+//链路控制帧：心跳（本端空闲一个心跳周期时发送）
+typedef struct
+{
+    uint8_t type;           // LINK_CTRL_HEARTBEAT
+    uint16_t period_ms;     // 发送方心跳周期，接收方据此判定断线
+}PackHeartbeat_t;
+
+//OTA帧，数据域第一个字节为帧类型；发送方发 BEGIN/DATA/END/ABORT，接收方回复 STATUS
+#define OTA_TYPE_BEGIN      0x00
+#define OTA_TYPE_DATA       0x01
+#define OTA_TYPE_END        0x02
+#define OTA_TYPE_ABORT      0x03
+#define OTA_TYPE_STATUS     0x04
+#define OTA_DATA_FLAG_ACK_REQ   0x01    // 发送方本轮窗口的最后一块，接收方须立即回复 STATUS
+typedef struct
+{
+    uint8_t type;           // OTA_TYPE_BEGIN
+    uint8_t target;         // 写入目标（CommOtaTarget_t）
+    uint32_t session;       // 会话号，由镜像哈希和长度得出，同一镜像重新发送时不变（用于续传）
+    uint32_t image_size;
+    uint8_t sha256[32];     // 整个镜像的SHA-256
+}PackOtaBegin_t;
+
+typedef struct
+{
+    uint8_t type;           // OTA_TYPE_DATA
+    uint8_t flags;          // OTA_DATA_FLAG_*
+    uint32_t session;
+    uint32_t offset;        // 本块在镜像中的偏移
+    uint32_t crc32;         // 本块数据的CRC32
+}PackOtaData_t;             // 后面紧跟块数据
+
+typedef struct
+{
+    uint8_t type;           // OTA_TYPE_END / OTA_TYPE_ABORT
+    uint32_t session;
+}PackOtaCtrl_t;
+
+typedef struct
+{
+    uint8_t type;           // OTA_TYPE_STATUS
+    uint8_t state;          // 接收方状态（CommOtaState_t）
+    uint8_t error;          // 失败原因（CommOtaError_t）
+    uint8_t gap;            // 1：收到的块不连续（丢块/校验错误），发送方应从 offset 重发
+    uint32_t session;       // 接收方当前会话号
+    uint32_t offset;        // 接收方已连续写入的字节数（累计确认）
+}PackOtaStatus_t;
 #pragma pack()
 
 
@@ -0,0 +1,334 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "input_record.h"
+#include "task_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define INPUT_REQ_NONE      0
+#define INPUT_REQ_BUSY      1   // 正在填写请求参数
+#define INPUT_REQ_RECORD    2
+#define INPUT_REQ_PLAY      3
+
+// 录制时扫描任务写入、录制任务读出，回放时方向相反；下标为累计计数，取模后访问
+static InputRecordSample_t kRing[INPUT_RECORD_RING];
+static atomic_uint kHead;
+static atomic_uint kTail;
+static atomic_uint kMode;
+static atomic_uint kEof;                // 回放文件已读完
+static atomic_uint kRequest;
+static atomic_uint kStopReq;
+static char kReqPath[64];
+static uint32_t kReqPeriodUs;
+static TaskHandle_t kTask;
+
+// 扫描任务更新的统计
+static volatile uint32_t kSamples;
+static volatile uint32_t kDropped;
+static volatile uint32_t kUnderruns;
+
+// 扫描任务独占
+static uint32_t kScan;
+static int64_t kStartUs;
+static uint32_t kLastMode;
+static InputRecordSample_t kCurrent;
+
+// 录制任务独占
+static FILE *kFile;
+static uint8_t kFileWriting;
+static InputRecordHeader_t kHeader;
+static uint32_t kWritten;
+static volatile uint8_t kError;
+static volatile uint32_t kTotal;
+
+uint32_t input_record_read_header(FILE *fp, InputRecordHeader_t *header)
+{
+    if (fread(header, sizeof(*header), 1, fp) != 1)
+        return 0;
+    return header->magic == INPUT_RECORD_MAGIC && header->version == INPUT_RECORD_VERSION &&
+           header->sample_size == sizeof(InputRecordSample_t);
+}
+
+uint32_t input_record_read_sample(FILE *fp, InputRecordSample_t *sample)
+{
+    return fread(sample, sizeof(*sample), 1, fp) == 1;
+}
+
+static void input_ring_reset(void)
+{
+    atomic_store(&kHead, 0);
+    atomic_store(&kTail, 0);
+    atomic_store(&kEof, 0);
+    kSamples = 0;
+    kDropped = 0;
+    kUnderruns = 0;
+}
+
+static void input_record_open(void)
+{
+    kFile = fopen(kReqPath, "wb");
+    if (!kFile)
+    {
+        kError = INPUT_RECORD_ERR_OPEN;
+        return;
+    }
+    kFileWriting = 1;
+    setvbuf(kFile, NULL, _IOFBF, 4096);
+    kHeader = (InputRecordHeader_t){
+        .magic = INPUT_RECORD_MAGIC,
+        .version = INPUT_RECORD_VERSION,
+        .sample_size = sizeof(InputRecordSample_t),
+        .period_us = kReqPeriodUs,
+        .count = INPUT_RECORD_COUNT_UNKNOWN,
+    };
+    if (fwrite(&kHeader, sizeof(kHeader), 1, kFile) != 1)
+    {
+        kError = INPUT_RECORD_ERR_WRITE;
+        fclose(kFile);
+        kFile = NULL;
+        return;
+    }
+    kWritten = 0;
+    kError = INPUT_RECORD_OK;
+    input_ring_reset();
+    atomic_store(&kMode, INPUT_RECORD_RECORDING);
+}
+
+static void input_play_open(void)
+{
+    kFile = fopen(kReqPath, "rb");
+    if (!kFile)
+    {
+        kError = INPUT_RECORD_ERR_OPEN;
+        return;
+    }
+    kFileWriting = 0;
+    setvbuf(kFile, NULL, _IOFBF, 4096);
+    if (!input_record_read_header(kFile, &kHeader) || kHeader.period_us != kReqPeriodUs)
+    {
+        kError = INPUT_RECORD_ERR_FORMAT;
+        fclose(kFile);
+        kFile = NULL;
+        return;
+    }
+    kTotal = kHeader.count;
+    kError = INPUT_RECORD_OK;
+    input_ring_reset();
+    atomic_store(&kMode, INPUT_RECORD_PRIMING);
+}
+
+// 把扫描任务放入缓冲的样本写入文件
+static void input_record_flush(void)
+{
+    uint32_t tail = atomic_load_explicit(&kTail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&kHead, memory_order_acquire);
+    while (tail != head)
+    {
+        // 一次写到缓冲末尾或最新样本
+        uint32_t n = head - tail;
+        uint32_t idx = tail % INPUT_RECORD_RING;
+        if (n > INPUT_RECORD_RING - idx)
+            n = INPUT_RECORD_RING - idx;
+        if (fwrite(&kRing[idx], sizeof(InputRecordSample_t), n, kFile) != n)
+        {
+            kError = INPUT_RECORD_ERR_WRITE;
+            atomic_store(&kMode, INPUT_RECORD_OFF);
+            return;
+        }
+        tail += n;
+        kWritten += n;
+        atomic_store_explicit(&kTail, tail, memory_order_release);
+    }
+}
+
+// 预读文件填满缓冲
+static void input_play_fill(void)
+{
+    uint32_t head = atomic_load_explicit(&kHead, memory_order_relaxed);
+    while (!atomic_load(&kEof) && head - atomic_load_explicit(&kTail, memory_order_acquire) < INPUT_RECORD_RING)
+    {
+        if (!input_record_read_sample(kFile, &kRing[head % INPUT_RECORD_RING]))
+        {
+            atomic_store(&kEof, 1);
+            break;
+        }
+        head++;
+        atomic_store_explicit(&kHead, head, memory_order_release);
+    }
+    if (kTotal == INPUT_RECORD_COUNT_UNKNOWN && atomic_load(&kEof))
+        kTotal = head;      // 录制没有正常结束的文件，读完后才知道样本数
+    uint32_t expected = INPUT_RECORD_PRIMING;
+    if (atomic_load(&kEof) || head - atomic_load(&kTail) >= INPUT_RECORD_RING)
+        atomic_compare_exchange_strong(&kMode, &expected, INPUT_RECORD_PLAYING);
+}
+
+static void input_record_close(void)
+{
+    uint32_t mode = atomic_exchange(&kMode, INPUT_RECORD_OFF);
+    if (kFileWriting)
+    {
+        // 扫描任务不再写入，写完剩余的样本后更新文件头
+        if (mode == INPUT_RECORD_RECORDING)
+            input_record_flush();
+        kHeader.count = kWritten;
+        kHeader.dropped = kDropped;
+        if (fseek(kFile, 0, SEEK_SET) != 0 || fwrite(&kHeader, sizeof(kHeader), 1, kFile) != 1)
+            kError = INPUT_RECORD_ERR_WRITE;
+    }
+    if (fclose(kFile) != 0 && kFileWriting)
+        kError = INPUT_RECORD_ERR_WRITE;
+    kFile = NULL;
+}
+
+static void input_record_task(void *param)
+{
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(INPUT_RECORD_IO_PERIOD_MS));
+        // 回放结束（扫描任务置为OFF）、写入出错或请求停止时关闭文件
+        if ((atomic_exchange(&kStopReq, 0) || atomic_load(&kMode) == INPUT_RECORD_OFF) && kFile)
+            input_record_close();
+        // 文件还没有关闭时请求留到下一次处理
+        uint32_t req = atomic_load(&kRequest);
+        if ((req == INPUT_REQ_RECORD || req == INPUT_REQ_PLAY) && !kFile)
+        {
+            if (req == INPUT_REQ_RECORD)
+                input_record_open();
+            else
+                input_play_open();
+            atomic_store(&kRequest, INPUT_REQ_NONE);
+        }
+        if (!kFile)
+            continue;
+
+        uint32_t mode = atomic_load(&kMode);
+        if (mode == INPUT_RECORD_RECORDING)
+            input_record_flush();
+        else if (mode == INPUT_RECORD_PRIMING || mode == INPUT_RECORD_PLAYING)
+            input_play_fill();
+    }
+}
+
+static uint32_t input_request(uint32_t req, const char *path, uint32_t period_us)
+{
+    uint32_t expected = INPUT_REQ_NONE;
+    if (!path || atomic_load(&kMode) != INPUT_RECORD_OFF ||
+        !atomic_compare_exchange_strong(&kRequest, &expected, INPUT_REQ_BUSY))
+        return 0;
+    strncpy(kReqPath, path, sizeof(kReqPath) - 1);
+    kReqPath[sizeof(kReqPath) - 1] = 0;
+    kReqPeriodUs = period_us;
+    atomic_store(&kRequest, req);
+    if (!kTask)
+        TASK_CREATE(TASK_INPUT_RECORD, input_record_task, NULL, &kTask);   //文件读写在界面核
+    else
+        xTaskNotifyGive(kTask);
+    return 1;
+}
+
+uint32_t input_record_start(const char *path, uint32_t period_us)
+{
+    return input_request(INPUT_REQ_RECORD, path, period_us);
+}
+
+uint32_t input_play_start(const char *path, uint32_t period_us)
+{
+    return input_request(INPUT_REQ_PLAY, path, period_us);
+}
+
+void input_record_stop(void)
+{
+    // 还没有开始的请求直接取消
+    uint32_t expected = INPUT_REQ_RECORD;
+    if (!atomic_compare_exchange_strong(&kRequest, &expected, INPUT_REQ_NONE))
+    {
+        expected = INPUT_REQ_PLAY;
+        atomic_compare_exchange_strong(&kRequest, &expected, INPUT_REQ_NONE);
+    }
+    atomic_store(&kStopReq, 1);
+    if (kTask)
+        xTaskNotifyGive(kTask);
+}
+
+void input_record_get_status(InputRecordStatus_t *status)
+{
+    status->mode = (uint8_t)atomic_load(&kMode);
+    status->error = kError;
+    status->samples = kSamples;
+    status->total = kTotal;
+    status->dropped = kDropped;
+    status->underruns = kUnderruns;
+}
+
+uint32_t input_record_scan(int raw[4], uint16_t *keys, int64_t now_us)
+{
+    uint32_t mode = atomic_load_explicit(&kMode, memory_order_acquire);
+    uint32_t first = mode != kLastMode;
+    kLastMode = mode;
+
+    if (mode == INPUT_RECORD_RECORDING)
+    {
+        if (first)
+        {
+            kScan = 0;
+            kStartUs = now_us;
+        }
+        uint32_t head = atomic_load_explicit(&kHead, memory_order_relaxed);
+        if (head - atomic_load_explicit(&kTail, memory_order_acquire) >= INPUT_RECORD_RING)
+        {
+            kDropped++;     // 写入跟不上，扫描序号会不连续
+            kScan++;
+            return INPUT_SCAN_RECORDING;
+        }
+        InputRecordSample_t *s = &kRing[head % INPUT_RECORD_RING];
+        s->scan = kScan++;
+        s->t_us = (uint32_t)(now_us - kStartUs);
+        for (int i = 0; i < 4; i++)
+            s->raw[i] = (uint16_t)raw[i];
+        s->keys = *keys;
+        atomic_store_explicit(&kHead, head + 1, memory_order_release);
+        kSamples++;
+        return INPUT_SCAN_RECORDING;
+    }
+    if (mode != INPUT_RECORD_PLAYING)
+        return INPUT_SCAN_LIVE;
+
+    if (first)
+    {
+        // 文件第一个样本之前沿用硬件输入
+        kScan = 0;
+        for (int i = 0; i < 4; i++)
+            kCurrent.raw[i] = (uint16_t)raw[i];
+        kCurrent.keys = *keys;
+    }
+    // 取出序号不超过本次扫描的样本，最后一个生效；录制时丢失的序号保持上一个样本
+    uint32_t tail = atomic_load_explicit(&kTail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&kHead, memory_order_acquire);
+    uint32_t got = 0;
+    while (tail != head && kRing[tail % INPUT_RECORD_RING].scan <= kScan)
+    {
+        kCurrent = kRing[tail % INPUT_RECORD_RING];
+        tail++;
+        got = 1;
+    }
+    atomic_store_explicit(&kTail, tail, memory_order_release);
+    if (got)
+        kSamples++;
+    if (tail == head)
+    {
+        if (atomic_load(&kEof))
+        {
+            uint32_t expected = INPUT_RECORD_PLAYING;
+            atomic_compare_exchange_strong(&kMode, &expected, INPUT_RECORD_OFF);   // 由录制任务关闭文件
+        }
+        else
+        {
+            kUnderruns++;
+        }
+    }
+    for (int i = 0; i < 4; i++)
+        raw[i] = kCurrent.raw[i];
+    *keys = kCurrent.keys;
+    kScan++;
+    return first ? INPUT_SCAN_REPLAY_FIRST : INPUT_SCAN_REPLAY;
+}
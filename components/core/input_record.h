@@ -0,0 +1,126 @@
+#ifndef __INPUT_RECORD_H__
+#define __INPUT_RECORD_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * 输入录制与回放：
+ * - 录制：扫描任务每次扫描把摇杆ADC原始值和按键（滤波、混控之前的输入）连同扫描序号、时间戳放入环形缓冲，
+ *   由录制任务（界面核，task_config.h）写入SD卡文件。
+ * - 回放：录制任务预读文件填满环形缓冲后开始回放，扫描任务用文件中的样本代替硬件输入，之后的校准、滤波、混控、
+ *   按键事件和发送调度与真实输入完全相同。回放按扫描序号逐周期对齐（序号 n 的样本在回放开始后第 n 次扫描生效，
+ *   录制时丢失的样本保持上一个值），开始回放的那一次扫描重置滤波器和发送调度，相同文件每次回放产生相同的控制包序列，
+ *   延迟/抖动统计可以逐次比较。录制和回放期间电源管理保持活动状态（扫描周期不变）。
+ * - 文件格式与平台无关（小端），tools/comm_sim 用同一组读函数读取录制文件驱动仿真（input=文件）。
+ * 控制函数可以在任意任务中调用，文件操作都在录制任务中执行，结果从 input_record_get_status 读取。
+ */
+
+#define INPUT_RECORD_DEFAULT_PATH   "/sdcard/input.rec"
+#define INPUT_RECORD_MAGIC          0x43455249u     // "IREC"
+#define INPUT_RECORD_VERSION        1
+#define INPUT_RECORD_RING           512             // 环形缓冲样本数，1kHz时约0.5s，容纳SD卡写入的停顿
+#define INPUT_RECORD_IO_PERIOD_MS   20              // 录制任务读写文件的周期
+#define INPUT_RECORD_COUNT_UNKNOWN  0xFFFFFFFFu     // 文件头的样本数，录制没有正常结束
+
+#pragma pack(1)
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t sample_size;       // sizeof(InputRecordSample_t)
+    uint32_t period_us;         // 录制时的扫描周期，回放时必须相同
+    uint32_t count;             // 样本数，录制结束时写入
+    uint32_t dropped;           // 录制时缓冲满丢失的样本数（扫描序号不连续）
+} InputRecordHeader_t;
+
+typedef struct
+{
+    uint32_t scan;              // 从录制开始的扫描序号
+    uint32_t t_us;              // 从录制开始的时间
+    uint16_t raw[4];            // 摇杆ADC原始值，顺序同 rocker_adc_read
+    uint16_t keys;
+} InputRecordSample_t;
+#pragma pack()
+
+typedef enum
+{
+    INPUT_RECORD_OFF = 0,
+    INPUT_RECORD_RECORDING,
+    INPUT_RECORD_PRIMING,       // 回放：正在预读
+    INPUT_RECORD_PLAYING,
+} InputRecordMode_t;
+
+typedef enum
+{
+    INPUT_RECORD_OK = 0,
+    INPUT_RECORD_ERR_OPEN,
+    INPUT_RECORD_ERR_FORMAT,    // 不是录制文件/版本不符/扫描周期不同
+    INPUT_RECORD_ERR_WRITE,
+} InputRecordError_t;
+
+typedef struct
+{
+    uint8_t mode;               // InputRecordMode_t
+    uint8_t error;              // 最近一次录制/回放的错误，InputRecordError_t
+    uint32_t samples;           // 本次录制写入/回放使用的样本数
+    uint32_t total;             // 回放文件的样本数
+    uint32_t dropped;           // 录制时缓冲满丢失的样本
+    uint32_t underruns;         // 回放时缓冲读空（文件读取跟不上）的扫描次数
+} InputRecordStatus_t;
+
+// input_record_scan 的返回值
+#define INPUT_SCAN_LIVE             0   // 使用硬件输入
+#define INPUT_SCAN_RECORDING        1   // 使用硬件输入并录制
+#define INPUT_SCAN_REPLAY           2   // 输入已替换为回放样本
+#define INPUT_SCAN_REPLAY_FIRST     3   // 回放的第一次扫描，调用方需要重置滤波器和发送调度
+
+/**
+ * @brief 开始录制，文件已存在时覆盖
+ * @param period_us 扫描周期，写入文件头
+ * @return 1 已提交；0 正在录制/回放
+ */
+uint32_t input_record_start(const char *path, uint32_t period_us);
+
+/**
+ * @brief 开始回放
+ * @param period_us 当前扫描周期，与文件不同时不回放（ERR_FORMAT）
+ * @return 1 已提交；0 正在录制/回放
+ */
+uint32_t input_play_start(const char *path, uint32_t period_us);
+
+/**
+ * @brief 停止录制/回放，录制时把缓冲中剩余的样本写完并更新文件头
+ */
+void input_record_stop(void);
+
+/**
+ * @brief 读取状态
+ */
+void input_record_get_status(InputRecordStatus_t *status);
+
+/**
+ * @brief 扫描任务读取硬件输入后调用：录制时保存输入，回放时用本周期的样本替换输入
+ * @param raw 摇杆ADC原始值，回放时被替换
+ * @param keys 按键，回放时被替换
+ * @return INPUT_SCAN_*
+ */
+uint32_t input_record_scan(int raw[4], uint16_t *keys, int64_t now_us);
+
+/*
+ * 文件读写（不依赖录制任务，主机工具直接使用）
+ */
+
+/**
+ * @brief 读取并检查文件头
+ * @return 1 成功；0 不是录制文件/版本不符
+ */
+uint32_t input_record_read_header(FILE *fp, InputRecordHeader_t *header);
+
+/**
+ * @brief 读取下一个样本
+ * @return 1 成功；0 文件结束
+ */
+uint32_t input_record_read_sample(FILE *fp, InputRecordSample_t *sample);
+
+#endif
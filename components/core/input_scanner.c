@@ -0,0 +1,62 @@
+#include <stddef.h>
+#include "input_scanner.h"
+
+static const InputScanBackend_t *kBackend;
+static uint16_t kLastKeys;
+static uint8_t kStarted;            // 已调用 start，read 只需取回结果
+static uint8_t kStartFailed;
+static InputScanStats_t kStats;
+
+uint32_t input_scanner_init(const InputScanBackend_t *backend)
+{
+    if (!backend || !backend->read)
+        return 0;
+    kBackend = NULL;
+    kStarted = 0;
+    if (backend->init && !backend->init(backend->backend_data))
+        return 0;
+    kBackend = backend;
+    return 1;
+}
+
+uint32_t input_scanner_start(void)
+{
+    if (!kBackend)
+        return 0;
+    kStarted = 1;
+    kStartFailed = 0;
+    if (kBackend->start && !kBackend->start(kBackend->backend_data))
+        kStartFailed = 1;
+    return !kStartFailed;
+}
+
+uint32_t input_scanner_read(uint16_t *keys)
+{
+    uint32_t ok = 0;
+    if (kBackend)
+    {
+        // 没有调用 start 时由 read 完成整次扫描（后端 start 为NULL时 read 本来就包含整次扫描）
+        if (!kStarted && kBackend->start)
+            kStartFailed = !kBackend->start(kBackend->backend_data);
+        uint16_t value;
+        if (!kStartFailed && kBackend->read(kBackend->backend_data, &value))
+        {
+            kLastKeys = value;
+            ok = 1;
+        }
+    }
+    kStarted = 0;
+    kStartFailed = 0;
+    if (ok)
+        kStats.scans++;
+    else
+        kStats.errors++;
+    *keys = kLastKeys;
+    return ok;
+}
+
+void input_scanner_get_stats(InputScanStats_t *stats)
+{
+    *stats = kStats;
+}
+
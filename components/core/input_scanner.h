@@ -0,0 +1,71 @@
+#ifndef __INPUT_SCANNER_H__
+#define __INPUT_SCANNER_H__
+
+#include <stdint.h>
+
+/*
+ * 按键扫描（两片级联的74LS165，共16个按键）：
+ * core.c 只通过扫描后端读取按键，一次扫描分为 start（锁存并开始移位）和 read（取回16位按键状态）两步，
+ * 后端可以在 start 中启动硬件传输后立即返回，扫描任务在两步之间采样摇杆，read 时再阻塞等待结果，不占用CPU空转。
+ * - SPI后端（默认）：用 SPI2 外设产生移位时钟，SH/LD 接片选（高电平有效），传输完成由中断通知
+ * - GPIO后端：原来的软件翻转IO实现（每次扫描约70us忙等），用于排查硬件问题
+ * 没有硬件的测试/仿真不经过扫描后端，回放录制的输入（input_record.h，tools/comm_sim 的 input 参数）。
+ * 按键位序与原 UpdateButtons 一致：第 i 个时钟上升沿后 QH 的电平为第 i 位。
+ */
+
+#define INPUT_SCANNER_SPI_CLOCK_HZ      1000000     // SPI后端移位时钟，16位约16us
+#define INPUT_SCANNER_TIMEOUT_MS        2           // read 等待硬件传输完成的超时
+
+/**
+ * @brief 扫描后端，函数返回1成功、0失败
+ */
+typedef struct
+{
+    uint32_t (*init)(void *backend_data);                   // 初始化硬件，可为NULL
+    uint32_t (*start)(void *backend_data);                  // 锁存按键并开始移位，可为NULL（全部在 read 中完成）
+    uint32_t (*read)(void *backend_data, uint16_t *keys);   // 取回本次扫描结果
+    void *backend_data;
+} InputScanBackend_t;
+
+typedef struct
+{
+    uint32_t scans;         // 成功的扫描次数
+    uint32_t errors;        // 失败的扫描次数（沿用上一次的按键状态）
+} InputScanStats_t;
+
+/**
+ * @brief 选择扫描后端并初始化（在扫描任务开始前调用）
+ * @param backend 扫描后端（遥控器上由 core.c 传入SPI后端）
+ * @return 1 成功；0 参数错误/后端初始化失败
+ */
+uint32_t input_scanner_init(const InputScanBackend_t *backend);
+
+/**
+ * @brief 开始一次扫描
+ * @return 1 成功；0 后端启动失败（随后的 input_scanner_read 返回上一次的状态）
+ */
+uint32_t input_scanner_start(void);
+
+/**
+ * @brief 取回本次扫描的按键状态，没有先调用 input_scanner_start 时在这里完成整次扫描
+ * @param keys 按键状态，失败时为上一次的状态
+ * @return 1 成功；0 失败
+ */
+uint32_t input_scanner_read(uint16_t *keys);
+
+/**
+ * @brief 读取扫描统计
+ */
+void input_scanner_get_stats(InputScanStats_t *stats);
+
+/**
+ * @brief 74LS165 的SPI后端（SPI2，时钟接 CLK_PIN、MISO接 QH_PIN、片选接 SH_LD_PIN）
+ */
+const InputScanBackend_t *input_scanner_spi_backend(void);
+
+/**
+ * @brief 74LS165 的GPIO后端（软件翻转IO）
+ */
+const InputScanBackend_t *input_scanner_gpio_backend(void);
+
+#endif
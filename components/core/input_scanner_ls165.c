@@ -0,0 +1,143 @@
+#include "input_scanner.h"
+#include "hardware.h"
+#include "driver/gpio.h"
+#include "driver/spi_master.h"
+#include "esp_rom_sys.h"
+#include "esp_log.h"
+
+static const char *TAG = "input_scanner";
+
+/* -------------------- SPI后端 -------------------- */
+static spi_device_handle_t kSpiDev;
+static spi_transaction_t kSpiTrans;
+
+static uint32_t ls165_spi_init(void *backend_data)
+{
+    if (kSpiDev)
+        return 1;
+    spi_bus_config_t bus_cfg = {
+        .mosi_io_num = -1,
+        .miso_io_num = QH_PIN,
+        .sclk_io_num = CLK_PIN,
+        .quadwp_io_num = -1,
+        .quadhd_io_num = -1,
+        .max_transfer_sz = 4,
+    };
+    // 每次只收2字节，放在事务自带的 rx_data 中，不需要DMA
+    esp_err_t err = spi_bus_initialize(SPI2_HOST, &bus_cfg, SPI_DMA_DISABLED);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "spi_bus_initialize: %s", esp_err_to_name(err));
+        return 0;
+    }
+
+    // SH/LD 接片选并设为高电平有效：空闲时为低电平（并行置数），传输期间为高电平（锁存并移位）
+    // 模式1在时钟下降沿采样，即每个上升沿移位之后读取QH，与原来的软件时序一致
+    spi_device_interface_config_t dev_cfg = {
+        .clock_speed_hz = INPUT_SCANNER_SPI_CLOCK_HZ,
+        .mode = 1,
+        .spics_io_num = SH_LD_PIN,
+        .cs_ena_pretrans = 2,       // 片选拉高到第一个时钟之间留出74LS165的建立时间
+        .queue_size = 1,
+        .flags = SPI_DEVICE_POSITIVE_CS | SPI_DEVICE_RXBIT_LSBFIRST,
+    };
+    err = spi_bus_add_device(SPI2_HOST, &dev_cfg, &kSpiDev);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "spi_bus_add_device: %s", esp_err_to_name(err));
+        spi_bus_free(SPI2_HOST);
+        kSpiDev = NULL;
+        return 0;
+    }
+    gpio_pullup_en(QH_PIN);     // QH 必须上拉
+    return 1;
+}
+
+static uint32_t ls165_spi_start(void *backend_data)
+{
+    // 上一次 read 超时没有取回的结果，先取走，否则队列一直是满的
+    spi_transaction_t *stale;
+    while (spi_device_get_trans_result(kSpiDev, &stale, 0) == ESP_OK)
+        ;
+    kSpiTrans = (spi_transaction_t){
+        .flags = SPI_TRANS_USE_RXDATA,
+        .length = 16,
+        .rxlength = 16,
+    };
+    return spi_device_queue_trans(kSpiDev, &kSpiTrans, 0) == ESP_OK;
+}
+
+static uint32_t ls165_spi_read(void *backend_data, uint16_t *keys)
+{
+    spi_transaction_t *done;
+    if (spi_device_get_trans_result(kSpiDev, &done, pdMS_TO_TICKS(INPUT_SCANNER_TIMEOUT_MS)) != ESP_OK)
+        return 0;
+    // 低位先收，第一个字节为前8个时钟的数据
+    *keys = (uint16_t)(done->rx_data[0] | (done->rx_data[1] << 8));
+    return 1;
+}
+
+const InputScanBackend_t *input_scanner_spi_backend(void)
+{
+    static const InputScanBackend_t backend = {
+        .init = ls165_spi_init,
+        .start = ls165_spi_start,
+        .read = ls165_spi_read,
+    };
+    return &backend;
+}
+
+/* -------------------- GPIO后端 -------------------- */
+static uint32_t ls165_gpio_init(void *backend_data)
+{
+    // SH/LD + CLK = OUTPUT
+    gpio_config_t cfg_out = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = GPIO_MODE_OUTPUT,
+        .pin_bit_mask = (1ULL << SH_LD_PIN) | (1ULL << CLK_PIN),
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE};
+    gpio_config(&cfg_out);
+
+    // QH = INPUT with pull-up !!!
+    gpio_config_t cfg_in = {
+        .intr_type = GPIO_INTR_DISABLE,
+        .mode = GPIO_MODE_INPUT,
+        .pin_bit_mask = (1ULL << QH_PIN),
+        .pull_up_en = GPIO_PULLUP_ENABLE, // 必须打开
+        .pull_down_en = GPIO_PULLDOWN_DISABLE};
+    gpio_config(&cfg_in);
+
+    // 初始状态
+    gpio_set_level(CLK_PIN, 0);
+    gpio_set_level(SH_LD_PIN, 1); // High = shift mode
+    return 1;
+}
+
+static uint32_t ls165_gpio_read(void *backend_data, uint16_t *keys)
+{
+    uint32_t temp = 0;
+    gpio_set_level(SH_LD_PIN, 0); // 数据锁存
+    esp_rom_delay_us(2);
+    gpio_set_level(SH_LD_PIN, 1); // 数据锁存
+    esp_rom_delay_us(2);
+    for (int i = 0; i < 16; i++)
+    {
+        gpio_set_level(CLK_PIN, 1);
+        esp_rom_delay_us(2); // 数据稳定时间
+        temp = temp | (gpio_get_level(QH_PIN) << i);
+        gpio_set_level(CLK_PIN, 0);
+        esp_rom_delay_us(2);
+    }
+    *keys = (uint16_t)temp;
+    return 1;
+}
+
+const InputScanBackend_t *input_scanner_gpio_backend(void)
+{
+    static const InputScanBackend_t backend = {
+        .init = ls165_gpio_init,
+        .read = ls165_gpio_read,
+    };
+    return &backend;
+}
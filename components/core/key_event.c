@@ -0,0 +1,134 @@
+#include <stdatomic.h>
+#include "key_event.h"
+
+typedef struct
+{
+    atomic_uint_fast32_t seq;   // 事件序号+1，等于事件序号表示正在写入
+    KeyEvent_t event;
+} KeyEventSlot_t;
+
+typedef struct
+{
+    int64_t change_us;          // 最近一次状态变化的时刻
+    int64_t release_us;         // 最近一次短按松开的时刻，用于双击判断
+    int64_t repeat_us;          // 下一次长按/重复事件的时刻
+    uint16_t repeat_count;
+    uint8_t long_pressed;
+    uint8_t second_click;       // 本次按下是双击的第二次
+} KeyState_t;
+
+static KeyEventSlot_t kRing[KEY_EVENT_QUEUE_SIZE];
+static atomic_uint_fast32_t kHead;      // 已发布的事件数
+static KeyState_t kKeys[KEY_EVENT_KEYS];
+static uint16_t kStable;                // 消抖后的按键状态
+
+static void key_event_publish(uint8_t key, uint8_t type, uint16_t count, int64_t now_us)
+{
+    uint32_t seq = atomic_load_explicit(&kHead, memory_order_relaxed);
+    KeyEventSlot_t *slot = &kRing[seq & (KEY_EVENT_QUEUE_SIZE - 1)];
+    // 写入前先把槽位标记为无效，读者复制期间发现序号变化即放弃这个事件。
+    // 标记用 seq 而不是0：序号回绕时事件 0xFFFFFFFF 的有效标记正好是0，读者会把写了一半的槽位当作有效
+    atomic_store_explicit(&slot->seq, seq, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->event = (KeyEvent_t){
+        .time_us = now_us,
+        .keys = kStable,
+        .key = key,
+        .type = type,
+        .count = count,
+    };
+    atomic_store_explicit(&slot->seq, seq + 1, memory_order_release);
+    atomic_store_explicit(&kHead, seq + 1, memory_order_release);
+}
+
+void key_event_process(uint16_t keys, int64_t now_us)
+{
+    uint16_t changed = keys ^ kStable;
+    for (uint8_t i = 0; i < KEY_EVENT_KEYS; i++)
+    {
+        KeyState_t *k = &kKeys[i];
+        uint16_t bit = (uint16_t)(1u << i);
+        if ((changed & bit) && now_us - k->change_us >= KEY_EVENT_DEBOUNCE_US)
+        {
+            k->change_us = now_us;
+            kStable ^= bit;
+            if (kStable & bit)
+            {
+                uint8_t double_click = k->release_us && now_us - k->release_us <= KEY_EVENT_DOUBLE_CLICK_US;
+                k->repeat_us = now_us + KEY_EVENT_LONG_PRESS_US;
+                k->repeat_count = 0;
+                k->long_pressed = 0;
+                k->second_click = double_click;
+                key_event_publish(i, KEY_EVENT_PRESS, 0, now_us);
+                if (double_click)
+                    key_event_publish(i, KEY_EVENT_DOUBLE_CLICK, 0, now_us);
+            }
+            else
+            {
+                // 长按和双击第二次的松开不作为下一次双击的开始
+                k->release_us = (k->long_pressed || k->second_click) ? 0 : now_us;
+                key_event_publish(i, KEY_EVENT_RELEASE, 0, now_us);
+            }
+        }
+        else if ((kStable & bit) && now_us >= k->repeat_us)
+        {
+            if (!k->long_pressed)
+            {
+                k->long_pressed = 1;
+                key_event_publish(i, KEY_EVENT_LONG_PRESS, 0, now_us);
+            }
+            else
+            {
+                key_event_publish(i, KEY_EVENT_REPEAT, ++k->repeat_count, now_us);
+            }
+            k->repeat_us += KEY_EVENT_REPEAT_US;
+        }
+    }
+}
+
+void key_event_reader_init(KeyEventReader_t *reader)
+{
+    reader->next = atomic_load_explicit(&kHead, memory_order_acquire);
+    reader->lost = 0;
+}
+
+uint32_t key_event_read(KeyEventReader_t *reader, KeyEvent_t *event)
+{
+    while (1)
+    {
+        uint32_t head = atomic_load_explicit(&kHead, memory_order_acquire);
+        if (reader->next == head)
+            return 0;
+        if (head - reader->next > KEY_EVENT_QUEUE_SIZE)
+        {
+            reader->lost += head - reader->next - KEY_EVENT_QUEUE_SIZE;
+            reader->next = head - KEY_EVENT_QUEUE_SIZE;
+        }
+        KeyEventSlot_t *slot = &kRing[reader->next & (KEY_EVENT_QUEUE_SIZE - 1)];
+        uint32_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        if (seq == reader->next + 1)
+        {
+            *event = slot->event;
+            atomic_thread_fence(memory_order_acquire);
+            if (atomic_load_explicit(&slot->seq, memory_order_relaxed) == seq)
+            {
+                reader->next++;
+                return 1;
+            }
+        }
+        // 槽位已被新事件覆盖（或正在覆盖），跳过，不等待写者
+        reader->lost++;
+        reader->next++;
+    }
+}
+
+uint16_t key_event_get_keys(void)
+{
+    return kStable;
+}
+
+const char *key_event_type_name(uint8_t type)
+{
+    static const char *kNames[] = {"press", "release", "long", "repeat", "double"};
+    return type < sizeof(kNames) / sizeof(kNames[0]) ? kNames[type] : "?";
+}
@@ -0,0 +1,76 @@
+#ifndef __KEY_EVENT_H__
+#define __KEY_EVENT_H__
+
+#include <stdint.h>
+
+/*
+ * 按键事件：
+ * 扫描任务每个周期把按键状态送入 key_event_process，逐个按键消抖并产生按下、松开、长按、长按重复、双击事件，
+ * 事件带微秒时间戳（扫描时刻），写入一个广播环形队列。
+ * 队列只有一个写者（扫描任务），读者数量不限，每个读者用自己的 KeyEventReader_t 记录读取位置，读写都不加锁：
+ * 读者不会阻塞扫描任务，读得太慢时最旧的事件被覆盖，key_event_read 跳过它们并计入 lost。
+ *
+ * 消抖采用"先响应后锁定"：状态变化立即产生事件，之后 KEY_EVENT_DEBOUNCE_US 内忽略该键的变化，不增加按下延迟。
+ * 两次扫描之间的按下和松开无法被发现，能分辨的最短按键时间等于扫描周期。
+ */
+
+#define KEY_EVENT_KEYS              16
+#define KEY_EVENT_QUEUE_SIZE        64          // 必须是2的幂
+#define KEY_EVENT_DEBOUNCE_US       10000       // 状态变化后的锁定时间
+#define KEY_EVENT_LONG_PRESS_US     800000      // 按住多久产生长按
+#define KEY_EVENT_REPEAT_US         200000      // 长按后重复事件的间隔
+#define KEY_EVENT_DOUBLE_CLICK_US   300000      // 松开后多久内再次按下算双击
+
+typedef enum
+{
+    KEY_EVENT_PRESS = 0,
+    KEY_EVENT_RELEASE,
+    KEY_EVENT_LONG_PRESS,
+    KEY_EVENT_REPEAT,
+    KEY_EVENT_DOUBLE_CLICK,     // 紧跟在第二次按下的 KEY_EVENT_PRESS 之后
+} KeyEventType_t;
+
+typedef struct
+{
+    int64_t time_us;            // 扫描时刻（esp_timer_get_time）
+    uint16_t keys;              // 事件发生后的全部按键状态（消抖后）
+    uint8_t key;                // 按键序号0~15，对应 dataFrame.h 中按键掩码的位
+    uint8_t type;               // KeyEventType_t
+    uint16_t count;             // KEY_EVENT_REPEAT 的序号（从1开始），其它事件为0
+} KeyEvent_t;
+
+typedef struct
+{
+    uint32_t next;              // 下一个要读取的事件序号
+    uint32_t lost;              // 因读得太慢被覆盖的事件数
+} KeyEventReader_t;
+
+/**
+ * @brief 送入一次扫描得到的按键状态并产生事件，只能由扫描任务调用
+ * @param keys 按键状态（置位为按下）
+ * @param now_us 扫描时刻（微秒）
+ */
+void key_event_process(uint16_t keys, int64_t now_us);
+
+/**
+ * @brief 初始化读者，从当前时刻之后的事件开始读取
+ */
+void key_event_reader_init(KeyEventReader_t *reader);
+
+/**
+ * @brief 读取一个事件，不阻塞
+ * @return 1 读到事件；0 没有新事件
+ */
+uint32_t key_event_read(KeyEventReader_t *reader, KeyEvent_t *event);
+
+/**
+ * @brief 读取消抖后的按键状态
+ */
+uint16_t key_event_get_keys(void);
+
+/**
+ * @brief 事件类型名称（调试显示用）
+ */
+const char *key_event_type_name(uint8_t type);
+
+#endif
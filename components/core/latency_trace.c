@@ -0,0 +1,186 @@
+#include <string.h>
+#include "latency_trace.h"
+#include "dataFrame.h"
+#include "comm.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
+
+static int64_t kScanTime[LATENCY_STAGE_FLUSH];          // 本次扫描的 ADC/FILTER 时刻
+static LatencyRecord_t kPending[LATENCY_TRACE_PENDING]; // 发送路径中的记录，先进先出
+static uint32_t kPendingHead;
+static uint32_t kPendingCount;
+static LatencyRecord_t kRing[LATENCY_TRACE_RING];
+static uint32_t kRingHead;
+static uint32_t kRingCount;
+static LatencyHist_t kHist[LATENCY_STAGE_NUM + 1];
+static LatencyTraceStats_t kStats;
+static SemaphoreHandle_t trace_mutex;
+
+static void trace_lock(void)
+{
+    xSemaphoreTake(trace_mutex, portMAX_DELAY);
+}
+
+static void trace_unlock(void)
+{
+    xSemaphoreGive(trace_mutex);
+}
+
+void latency_trace_init(void)
+{
+    if (!trace_mutex)
+        trace_mutex = xSemaphoreCreateMutex();
+}
+
+static void hist_add(LatencyHist_t *h, int64_t us)
+{
+    if (us < 0)
+        us = 0;
+    uint32_t v = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    uint32_t bin = 0;
+    while (bin < LATENCY_TRACE_BINS - 1 && v >= (32u << bin))
+        bin++;
+    h->bins[bin]++;
+    h->count++;
+    h->sum_us += v;
+    if (v > h->max_us)
+        h->max_us = v;
+}
+
+static void trace_complete(const LatencyRecord_t *r)
+{
+    for (int i = 1; i < LATENCY_STAGE_NUM; i++)
+        hist_add(&kHist[i], r->t[i] - r->t[i - 1]);
+    hist_add(&kHist[LATENCY_HIST_TOTAL], r->t[LATENCY_STAGE_WRITTEN] - r->t[LATENCY_STAGE_ADC]);
+    kRing[kRingHead] = *r;
+    kRingHead = (kRingHead + 1) % LATENCY_TRACE_RING;
+    if (kRingCount < LATENCY_TRACE_RING)
+        kRingCount++;
+    kStats.completed++;
+}
+
+void latency_trace_scan(uint8_t stage)
+{
+    if (stage < LATENCY_STAGE_FLUSH)
+        kScanTime[stage] = esp_timer_get_time();
+}
+
+void latency_trace_begin(uint32_t id)
+{
+    int64_t now = esp_timer_get_time();
+    trace_lock();
+    if (kPendingCount == LATENCY_TRACE_PENDING)
+    {
+        // 最旧的记录一直没有走完发送路径，丢弃
+        kPendingHead = (kPendingHead + 1) % LATENCY_TRACE_PENDING;
+        kPendingCount--;
+        kStats.dropped++;
+    }
+    LatencyRecord_t *r = &kPending[(kPendingHead + kPendingCount) % LATENCY_TRACE_PENDING];
+    memset(r, 0, sizeof(*r));
+    r->id = id;
+    r->t[LATENCY_STAGE_ADC] = kScanTime[LATENCY_STAGE_ADC];
+    r->t[LATENCY_STAGE_FILTER] = kScanTime[LATENCY_STAGE_FILTER];
+    r->t[LATENCY_STAGE_FLUSH] = now;
+    kPendingCount++;
+    trace_unlock();
+}
+
+void latency_trace_abort(void)
+{
+    trace_lock();
+    if (kPendingCount)
+    {
+        kPendingCount--;
+        kStats.aborted++;
+    }
+    trace_unlock();
+}
+
+void latency_trace_comm_hook(uint8_t cmd, uint8_t stage)
+{
+    uint8_t c = cmd & PACK_CMD_MASK;
+    if ((c != PACK_CONTROL_CMD && c != PACK_CHANNEL_CMD) || stage > COMM_TX_TRACE_WRITTEN)
+        return;
+    uint8_t s = (uint8_t)(LATENCY_STAGE_ENQUEUE + stage);
+    int64_t now = esp_timer_get_time();
+    trace_lock();
+    // 控制包按先进先出经过发送路径：这一级时刻落在最旧的、还没有这一级的记录上
+    for (uint32_t i = 0; i < kPendingCount; i++)
+    {
+        LatencyRecord_t *r = &kPending[(kPendingHead + i) % LATENCY_TRACE_PENDING];
+        if (r->t[s])
+            continue;
+        if (!r->t[s - 1])
+            break;      // 上一级还没有记录，这个跟踪点不属于正在跟踪的包
+        r->t[s] = now;
+        if (s == LATENCY_STAGE_WRITTEN)
+        {
+            // 前面还有没走完的记录说明丢失了跟踪点，一并丢弃
+            kStats.dropped += i;
+            trace_complete(r);
+            kPendingHead = (kPendingHead + i + 1) % LATENCY_TRACE_PENDING;
+            kPendingCount -= i + 1;
+        }
+        break;
+    }
+    trace_unlock();
+}
+
+void latency_trace_get_hist(uint8_t index, LatencyHist_t *hist)
+{
+    trace_lock();
+    if (index <= LATENCY_HIST_TOTAL)
+        *hist = kHist[index];
+    else
+        memset(hist, 0, sizeof(*hist));
+    trace_unlock();
+}
+
+uint32_t latency_hist_percentile(const LatencyHist_t *hist, uint32_t percent)
+{
+    if (!hist->count)
+        return 0;
+    uint32_t target = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100);
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < LATENCY_TRACE_BINS - 1; i++)
+    {
+        acc += hist->bins[i];
+        if (acc >= target)
+            return (32u << i) < hist->max_us ? (32u << i) : hist->max_us;
+    }
+    return hist->max_us;
+}
+
+uint32_t latency_trace_read(LatencyRecord_t *records, uint32_t max)
+{
+    trace_lock();
+    uint32_t n = max < kRingCount ? max : kRingCount;
+    for (uint32_t i = 0; i < n; i++)
+        records[i] = kRing[(kRingHead + LATENCY_TRACE_RING - 1 - i) % LATENCY_TRACE_RING];
+    trace_unlock();
+    return n;
+}
+
+void latency_trace_get_stats(LatencyTraceStats_t *stats)
+{
+    trace_lock();
+    *stats = kStats;
+    trace_unlock();
+}
+
+void latency_trace_reset(void)
+{
+    trace_lock();
+    memset(kHist, 0, sizeof(kHist));
+    memset(&kStats, 0, sizeof(kStats));
+    kRingHead = kRingCount = 0;
+    trace_unlock();
+}
+
+const char *latency_stage_name(uint8_t index)
+{
+    static const char *kNames[] = {"adc", "filter", "flush", "enqueue", "dequeue", "written", "total"};
+    return index <= LATENCY_HIST_TOTAL ? kNames[index] : "?";
+}
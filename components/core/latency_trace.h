@@ -0,0 +1,137 @@
+#ifndef __LATENCY_TRACE_H__
+#define __LATENCY_TRACE_H__
+
+#include <stdint.h>
+
+/*
+ * 摇杆到串口的延迟跟踪：
+ * 每个控制包记录6个时刻（esp_timer，微秒）：
+ *   ADC      扫描任务取出ADC样本
+ *   FILTER   摇杆校准/滤波完成
+ *   FLUSH    发送调度决定发送，开始填写控制包
+ *   ENQUEUE  控制包请求放入 comm 发送队列
+ *   DEQUEUE  comm 发送任务取出请求
+ *   WRITTEN  整帧交给串口驱动（uart_write_bytes 返回，数据在驱动发送缓冲中，还要加上帧长*10/波特率才全部离开串口）
+ * ADC/FILTER 每次扫描都记录（只保存最近一次），FLUSH 时开始一条记录，comm 的三个跟踪点按发送队列的先进先出顺序对应到记录上。
+ * 完成的记录放入环形缓冲（latency_trace_read），同时累计每一级（与上一级的时间差）和总延迟（ADC -> WRITTEN）的直方图，
+ * 直方图按2的幂分桶：第 i 桶为 [2^(i+4), 2^(i+5)) 微秒，第0桶包含 32us 以下，最后一桶包含更长的时间。
+ *
+ * 跟踪点用 LATENCY_TRACE_* 宏插入，LATENCY_TRACE_ENABLE 定义为0时宏为空，跟踪点不参与编译。
+ * 控制链路相关的优化（扫描频率、滤波、发送调度、队列、TDMA等）都应该用这里的数据对比优化前后的结果。
+ */
+
+#ifndef LATENCY_TRACE_ENABLE
+#define LATENCY_TRACE_ENABLE    1
+#endif
+
+#define LATENCY_TRACE_RING      64      // 保存最近完成的记录数
+#define LATENCY_TRACE_PENDING   16      // 正在发送路径中的记录数（不少于发送队列长度）
+#define LATENCY_TRACE_BINS      12
+
+typedef enum
+{
+    LATENCY_STAGE_ADC = 0,
+    LATENCY_STAGE_FILTER,
+    LATENCY_STAGE_FLUSH,
+    LATENCY_STAGE_ENQUEUE,
+    LATENCY_STAGE_DEQUEUE,
+    LATENCY_STAGE_WRITTEN,
+    LATENCY_STAGE_NUM,
+} LatencyStage_t;
+
+#define LATENCY_HIST_TOTAL      LATENCY_STAGE_NUM   // 直方图序号：总延迟（其它序号为该级与上一级的时间差，ADC 级为0）
+
+typedef struct
+{
+    uint32_t id;                        // 状态总线的发布序号
+    int64_t t[LATENCY_STAGE_NUM];       // 各级时刻（微秒）
+} LatencyRecord_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t bins[LATENCY_TRACE_BINS];
+    uint32_t max_us;
+    uint64_t sum_us;
+} LatencyHist_t;
+
+typedef struct
+{
+    uint32_t completed;     // 完成的记录数
+    uint32_t aborted;       // 入队失败而放弃的记录数
+    uint32_t dropped;       // 发送路径中记录过多（或丢失了跟踪点）而丢弃的记录数
+} LatencyTraceStats_t;
+
+/**
+ * @brief 创建互斥锁，由 RemoteCoreInit 在创建扫描任务之前调用
+ */
+void latency_trace_init(void);
+
+/**
+ * @brief 记录本次扫描的 ADC/FILTER 时刻，只能由扫描任务调用
+ */
+void latency_trace_scan(uint8_t stage);
+
+/**
+ * @brief 开始一条记录（FLUSH），带上本次扫描的 ADC/FILTER 时刻，只能由扫描任务调用
+ * @param id 状态总线的发布序号
+ */
+void latency_trace_begin(uint32_t id);
+
+/**
+ * @brief 放弃最近开始的记录（控制包没有放入发送队列）
+ */
+void latency_trace_abort(void);
+
+/**
+ * @brief comm 发送路径跟踪回调（comm_set_tx_trace），只跟踪控制包/通道包
+ */
+void latency_trace_comm_hook(uint8_t cmd, uint8_t stage);
+
+/**
+ * @brief 读取直方图
+ * @param index LatencyStage_t（该级与上一级的时间差）或 LATENCY_HIST_TOTAL
+ */
+void latency_trace_get_hist(uint8_t index, LatencyHist_t *hist);
+
+/**
+ * @brief 由直方图估算百分位数（取所在桶的上界）
+ * @param percent 0~100
+ * @return 微秒
+ */
+uint32_t latency_hist_percentile(const LatencyHist_t *hist, uint32_t percent);
+
+/**
+ * @brief 读取最近完成的记录，从新到旧
+ * @param records 输出
+ * @param max 最多读取的条数
+ * @return 实际读取的条数
+ */
+uint32_t latency_trace_read(LatencyRecord_t *records, uint32_t max);
+
+/**
+ * @brief 读取统计
+ */
+void latency_trace_get_stats(LatencyTraceStats_t *stats);
+
+/**
+ * @brief 清空直方图、记录和统计
+ */
+void latency_trace_reset(void);
+
+/**
+ * @brief 级名称（显示用），LATENCY_HIST_TOTAL 为 "total"
+ */
+const char *latency_stage_name(uint8_t index);
+
+#if LATENCY_TRACE_ENABLE
+#define LATENCY_TRACE_SCAN(stage)   latency_trace_scan(stage)
+#define LATENCY_TRACE_BEGIN(id)     latency_trace_begin(id)
+#define LATENCY_TRACE_ABORT()       latency_trace_abort()
+#else
+#define LATENCY_TRACE_SCAN(stage)   ((void)0)
+#define LATENCY_TRACE_BEGIN(id)     ((void)0)
+#define LATENCY_TRACE_ABORT()       ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,660 @@
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "mixer.h"
+#include "virtual_item.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+#include "esp_log.h"
+
+#define MIXER_NVS_KEY           "model"
+#define MIXER_VERSION           1
+#define MIXER_FILE_MAX          4096    // 文本模型文件的最大长度
+#define MIXER_Q15_ONE           32767
+#define MIXER_MAX_TOKENS        24      // 文本模型一行的最多单词数
+
+static const char *TAG = "mixer";
+
+typedef struct
+{
+    uint16_t version;
+    MixerModel_t model;
+} MixerBlob_t;
+
+// 扫描任务与加载者之间交接待生效的程序
+enum
+{
+    PENDING_EMPTY = 0,
+    PENDING_WRITING,        // 加载者正在写入
+    PENDING_READY,          // 等待扫描任务切换
+    PENDING_COPYING,        // 扫描任务正在复制
+};
+
+static MixerProgram_t kProgram;         // 只由扫描任务使用
+static uint8_t kLoaded;
+static MixerProgram_t kPending;
+static uint8_t kPendingLoaded;
+static atomic_uint kPendingState;
+static MixerProgram_t kStaging;         // 编译用，由 mixer_mutex 保护
+static SemaphoreHandle_t mixer_mutex;
+
+static void mixer_lock(void)
+{
+    xSemaphoreTake(mixer_mutex, portMAX_DELAY);
+}
+
+static void mixer_unlock(void)
+{
+    xSemaphoreGive(mixer_mutex);
+}
+
+static inline int32_t q15_clamp(int32_t v)
+{
+    return v > MIXER_Q15_ONE ? MIXER_Q15_ONE : (v < -MIXER_Q15_ONE ? -MIXER_Q15_ONE : v);
+}
+
+static inline int32_t percent_to_q15(int32_t percent)
+{
+    return percent * 32768 / 100;
+}
+
+/* -------------------- 执行 -------------------- */
+
+static inline int32_t curve_eval(const int16_t *t, int32_t x)
+{
+    uint32_t u = (uint32_t)(x + 32768);     // 0~65535
+    uint32_t i = u >> 11;                   // 0~31
+    int32_t frac = (int32_t)(u & 2047);
+    return t[i] + (((t[i + 1] - t[i]) * frac) >> 11);
+}
+
+void mixer_eval(const MixerProgram_t *program, const int16_t sticks[4], uint16_t keys, const volatile int16_t virt[MIXER_VIRT_NUM],
+                int16_t channels[MIXER_CHANNELS])
+{
+    int32_t reg[MIXER_MAX_REGS];
+    int32_t ch[MIXER_CHANNELS] = {0};
+    const MixerOp_t *op = program->ops;
+    const MixerOp_t *end = op + program->n_ops;
+    for (; op < end; op++)
+    {
+        switch (op->code)
+        {
+        case MIXER_OP_SRC:
+            if (op->b < MIXER_SRC_KEY(0))
+                reg[op->a] = q15_clamp(sticks[op->b]);
+            else if (op->b < MIXER_SRC_MAX)
+                reg[op->a] = (keys >> (op->b - MIXER_SRC_KEY(0))) & 1 ? MIXER_Q15_ONE : 0;
+            else if (op->b == MIXER_SRC_MAX)
+                reg[op->a] = MIXER_Q15_ONE;
+            else
+                reg[op->a] = q15_clamp(virt[op->b - MIXER_SRC_VIRT(0)]);
+            break;
+        case MIXER_OP_CH:
+            reg[op->a] = q15_clamp(ch[op->b]);
+            break;
+        case MIXER_OP_CURVE:
+            reg[op->a] = curve_eval(program->curves[op->c], reg[op->b]);
+            break;
+        case MIXER_OP_SKIP:
+            if ((keys & op->k) != op->m)
+                op += op->c;
+            break;
+        case MIXER_OP_MOV:
+            ch[op->a] = reg[op->b];
+            break;
+        case MIXER_OP_ADD:
+            ch[op->a] += reg[op->b];
+            break;
+        case MIXER_OP_MOVW:
+            ch[op->a] = ((reg[op->b] * op->k) >> 15) + op->m;     // |reg| <= 32767，|k| <= 65536，乘积不溢出
+            break;
+        case MIXER_OP_ADDW:
+            ch[op->a] += ((reg[op->b] * op->k) >> 15) + op->m;
+            break;
+        case MIXER_OP_MULW:
+            ch[op->a] = (int32_t)(((int64_t)ch[op->a] * (((reg[op->b] * op->k) >> 15) + op->m)) >> 15);
+            break;
+        case MIXER_OP_OUT:
+        {
+            int32_t v = (int32_t)(((int64_t)ch[op->a] * op->k) >> 15) + op->m;
+            channels[op->a] = (int16_t)(v > op->hi ? op->hi : (v < op->lo ? op->lo : v));
+            break;
+        }
+        }
+    }
+}
+
+/* -------------------- 编译 -------------------- */
+
+// expo：k*x^3 + (1-k)*x；k<0 时关于 (1,1) 镜像，中心更灵敏且保持单调
+static float curve_expo(float x, float k)
+{
+    if (k >= 0)
+        return k * x * x * x + (1 - k) * x;
+    float a = fabsf(x);
+    float u = 1 - a;
+    float y = 1 - (-k * u * u * u + (1 + k) * u);
+    return x < 0 ? -y : y;
+}
+
+static uint32_t curve_build(const MixerCurve_t *c, int16_t table[MIXER_CURVE_TABLE_SIZE])
+{
+    if (c->type == MIXER_CURVE_EXPO)
+    {
+        if (c->expo < -100 || c->expo > 100)
+            return 0;
+    }
+    else if (c->type != MIXER_CURVE_POINTS || c->n_points < 2 || c->n_points > MIXER_CURVE_MAX_POINTS)
+        return 0;
+    for (int i = 0; i < MIXER_CURVE_TABLE_SIZE; i++)
+    {
+        float x = -1.0f + 2.0f * i / (MIXER_CURVE_TABLE_SIZE - 1);
+        float y;
+        if (c->type == MIXER_CURVE_EXPO)
+            y = curve_expo(x, c->expo / 100.0f);
+        else
+        {
+            float pos = (x + 1.0f) * 0.5f * (c->n_points - 1);
+            int j = (int)pos;
+            if (j >= c->n_points - 1)
+                j = c->n_points - 2;
+            float f = pos - j;
+            y = (c->points[j] + (c->points[j + 1] - c->points[j]) * f) / 100.0f;
+        }
+        table[i] = (int16_t)q15_clamp((int32_t)lrintf(y * 32767.0f));
+    }
+    return 1;
+}
+
+static uint32_t line_valid(const MixerLine_t *l)
+{
+    return l->ch < MIXER_CHANNELS && l->src < MIXER_SRC_NUM && l->multiplex <= MIXER_MULTIPLEX_MUL &&
+           (l->curve == MIXER_CURVE_NONE || l->curve < MIXER_MAX_CURVES) &&
+           l->weight >= -MIXER_MAX_WEIGHT && l->weight <= MIXER_MAX_WEIGHT && l->offset >= -100 && l->offset <= 100;
+}
+
+// 永远不会生效或不改变通道的行
+static uint32_t line_dead(const MixerLine_t *l)
+{
+    if (l->when_value & ~l->when_mask)
+        return 1;
+    return l->multiplex == MIXER_MULTIPLEX_ADD && l->weight == 0 && l->offset == 0;
+}
+
+static inline uint32_t src_is_ch(uint8_t src)
+{
+    return src >= MIXER_SRC_CH(0) && src < MIXER_SRC_CH(MIXER_CHANNELS);
+}
+
+static MixerOp_t *emit(MixerProgram_t *p, uint8_t code, uint8_t a, uint8_t b)
+{
+    MixerOp_t *op = &p->ops[p->n_ops++];
+    memset(op, 0, sizeof(*op));
+    op->code = code;
+    op->a = a;
+    op->b = b;
+    return op;
+}
+
+uint32_t mixer_compile(const MixerModel_t *model, MixerProgram_t *p)
+{
+    uint8_t used_curve[MIXER_MAX_CURVES] = {0};
+    uint8_t need_raw[MIXER_SRC_NUM] = {0};                          // 需要不经过曲线的源值
+    uint8_t need_curved[MIXER_SRC_NUM][MIXER_MAX_CURVES] = {0};
+    uint8_t raw_reg[MIXER_SRC_NUM];
+    uint8_t curved_reg[MIXER_SRC_NUM][MIXER_MAX_CURVES];
+
+    if (model->n_lines > MIXER_MAX_LINES)
+        return 0;
+    memset(p, 0, sizeof(*p));
+    for (int i = 0; i < model->n_lines; i++)
+    {
+        const MixerLine_t *l = &model->lines[i];
+        if (!line_valid(l))
+            return 0;
+        if (line_dead(l))
+            continue;
+        if (l->curve != MIXER_CURVE_NONE)
+            used_curve[l->curve] = 1;
+        if (src_is_ch(l->src))
+            continue;
+        if (l->curve == MIXER_CURVE_NONE)
+            need_raw[l->src] = 1;
+        else
+            need_curved[l->src][l->curve] = 1;
+    }
+    for (int c = 0; c < MIXER_MAX_CURVES; c++)
+    {
+        if (used_curve[c] && !curve_build(&model->curves[c], p->curves[c]))
+            return 0;
+    }
+    for (int ch = 0; ch < MIXER_CHANNELS; ch++)
+    {
+        const MixerOutput_t *o = &model->outputs[ch];
+        if (o->trim < -100 || o->trim > 100 || o->min < -100 || o->max > 100 || o->min > o->max)
+            return 0;
+    }
+
+    // 源和曲线与按键条件无关，在程序开头各计算一次；只经过曲线使用的源在原寄存器上做曲线
+    for (int s = 0; s < MIXER_SRC_NUM; s++)
+    {
+        uint32_t curved = 0;
+        for (int c = 0; c < MIXER_MAX_CURVES; c++)
+            curved += need_curved[s][c];
+        if (!need_raw[s] && !curved)
+            continue;
+        uint8_t r = p->n_regs++;
+        raw_reg[s] = r;
+        emit(p, MIXER_OP_SRC, r, (uint8_t)s);
+        for (int c = 0; c < MIXER_MAX_CURVES; c++)
+        {
+            if (!need_curved[s][c])
+                continue;
+            uint8_t cr = (need_raw[s] || curved > 1) ? p->n_regs++ : r;
+            curved_reg[s][c] = cr;
+            emit(p, MIXER_OP_CURVE, cr, r)->c = (uint8_t)c;
+            curved--;
+            if (cr == r)
+                break;
+        }
+    }
+    uint8_t scratch = p->n_regs++;
+
+    // 混控行按顺序执行，条件相同的连续行共用一个 SKIP
+    MixerOp_t *skip = NULL;
+    uint16_t skip_start = 0;
+    for (int i = 0; i < model->n_lines; i++)
+    {
+        const MixerLine_t *l = &model->lines[i];
+        if (line_dead(l))
+            continue;
+        if (skip && (l->when_mask != skip->k || l->when_value != skip->m))
+        {
+            skip->c = (uint8_t)(p->n_ops - skip_start);
+            skip = NULL;
+        }
+        if (!skip && l->when_mask)
+        {
+            skip = emit(p, MIXER_OP_SKIP, 0, 0);
+            skip->k = l->when_mask;
+            skip->m = l->when_value;
+            skip_start = p->n_ops;
+        }
+
+        uint8_t r;
+        if (src_is_ch(l->src))
+        {
+            // 前面通道的值与执行顺序有关，在使用处读取
+            r = scratch;
+            emit(p, MIXER_OP_CH, r, (uint8_t)(l->src - MIXER_SRC_CH(0)));
+            if (l->curve != MIXER_CURVE_NONE)
+                emit(p, MIXER_OP_CURVE, r, r)->c = l->curve;
+        }
+        else
+            r = l->curve == MIXER_CURVE_NONE ? raw_reg[l->src] : curved_reg[l->src][l->curve];
+
+        int32_t k = percent_to_q15(l->weight);
+        int32_t m = percent_to_q15(l->offset);
+        MixerOp_t *op;
+        if (l->multiplex == MIXER_MULTIPLEX_MUL)
+            op = emit(p, MIXER_OP_MULW, l->ch, r);
+        else if (l->weight == 100 && l->offset == 0)
+            op = emit(p, l->multiplex == MIXER_MULTIPLEX_REPLACE ? MIXER_OP_MOV : MIXER_OP_ADD, l->ch, r);
+        else
+            op = emit(p, l->multiplex == MIXER_MULTIPLEX_REPLACE ? MIXER_OP_MOVW : MIXER_OP_ADDW, l->ch, r);
+        op->k = k;
+        op->m = m;
+    }
+    if (skip)
+        skip->c = (uint8_t)(p->n_ops - skip_start);
+
+    for (int ch = 0; ch < MIXER_CHANNELS; ch++)
+    {
+        const MixerOutput_t *o = &model->outputs[ch];
+        MixerOp_t *op = emit(p, MIXER_OP_OUT, (uint8_t)ch, 0);
+        op->k = o->reverse ? -32768 : 32768;
+        op->m = percent_to_q15(o->trim);
+        op->lo = (int16_t)q15_clamp(percent_to_q15(o->min));
+        op->hi = (int16_t)q15_clamp(percent_to_q15(o->max));
+    }
+    return 1;
+}
+
+/* -------------------- 模型 -------------------- */
+
+static void model_clear(MixerModel_t *model)
+{
+    memset(model, 0, sizeof(*model));
+    for (int ch = 0; ch < MIXER_CHANNELS; ch++)
+    {
+        model->outputs[ch].min = -100;
+        model->outputs[ch].max = 100;
+    }
+}
+
+void mixer_default_model(MixerModel_t *model)
+{
+    model_clear(model);
+    for (int i = 0; i < 4; i++)
+    {
+        model->lines[i] = (MixerLine_t){
+            .ch = (uint8_t)i,
+            .src = MIXER_SRC_STICK(i),
+            .curve = MIXER_CURVE_NONE,
+            .weight = 100,
+        };
+    }
+    model->n_lines = 4;
+}
+
+static uint32_t parse_int(const char *tok, long lo, long hi, long *out)
+{
+    if (!tok)
+        return 0;
+    char *end;
+    long v = strtol(tok, &end, 0);
+    if (*end || end == tok || v < lo || v > hi)
+        return 0;
+    *out = v;
+    return 1;
+}
+
+static uint32_t parse_src(const char *tok, uint8_t *src)
+{
+    long n;
+    if (!tok)
+        return 0;
+    if (!strcmp(tok, "max"))
+        *src = MIXER_SRC_MAX;
+    else if (!strncmp(tok, "stick", 5) && parse_int(tok + 5, 0, 3, &n))
+        *src = (uint8_t)MIXER_SRC_STICK(n);
+    else if (!strncmp(tok, "key", 3) && parse_int(tok + 3, 0, 15, &n))
+        *src = (uint8_t)MIXER_SRC_KEY(n);
+    else if (!strncmp(tok, "ch", 2) && parse_int(tok + 2, 0, MIXER_CHANNELS - 1, &n))
+        *src = (uint8_t)MIXER_SRC_CH(n);
+    else if (!strncmp(tok, "virt", 4) && parse_int(tok + 4, 0, MIXER_VIRT_NUM - 1, &n))
+        *src = (uint8_t)MIXER_SRC_VIRT(n);
+    else
+        return 0;
+    return 1;
+}
+
+static uint32_t parse_line(char *line, MixerModel_t *model, uint16_t modes[MIXER_MAX_MODES][2], uint8_t *mode_defined)
+{
+    char *tok[MIXER_MAX_TOKENS + 2] = {0};     // 选项的参数缺失时读到 NULL
+    int n = 0;
+    char *save;
+    char *hash = strchr(line, '#');
+    if (hash)
+        *hash = 0;
+    for (char *t = strtok_r(line, " \t\r", &save); t; t = strtok_r(NULL, " \t\r", &save))
+    {
+        if (n == MIXER_MAX_TOKENS)
+            return 0;
+        tok[n++] = t;
+    }
+    if (n == 0)
+        return 1;
+
+    long v, w, x;
+    if (!strcmp(tok[0], "curve"))
+    {
+        if (!parse_int(tok[1], 0, MIXER_MAX_CURVES - 1, &v) || !tok[2])
+            return 0;
+        MixerCurve_t *c = &model->curves[v];
+        memset(c, 0, sizeof(*c));
+        if (!strcmp(tok[2], "expo"))
+        {
+            c->type = MIXER_CURVE_EXPO;
+            if (n != 4 || !parse_int(tok[3], -100, 100, &w))
+                return 0;
+            c->expo = (int8_t)w;
+            return 1;
+        }
+        if (strcmp(tok[2], "points") || n - 3 < 2 || n - 3 > MIXER_CURVE_MAX_POINTS)
+            return 0;
+        c->type = MIXER_CURVE_POINTS;
+        c->n_points = (uint8_t)(n - 3);
+        for (int i = 3; i < n; i++)
+        {
+            if (!parse_int(tok[i], -100, 100, &w))
+                return 0;
+            c->points[i - 3] = (int8_t)w;
+        }
+        return 1;
+    }
+    if (!strcmp(tok[0], "mode"))
+    {
+        if (n != 4 || !parse_int(tok[1], 0, MIXER_MAX_MODES - 1, &v) ||
+            !parse_int(tok[2], 0, 0xFFFF, &w) || !parse_int(tok[3], 0, 0xFFFF, &x))
+            return 0;
+        modes[v][0] = (uint16_t)w;
+        modes[v][1] = (uint16_t)x;
+        *mode_defined |= 1u << v;
+        return 1;
+    }
+    if (!strcmp(tok[0], "mix"))
+    {
+        if (model->n_lines >= MIXER_MAX_LINES)
+            return 0;
+        MixerLine_t l = {.curve = MIXER_CURVE_NONE};
+        if (!parse_int(tok[1], 0, MIXER_CHANNELS - 1, &v) || !parse_src(tok[2], &l.src) ||
+            !parse_int(tok[3], -MIXER_MAX_WEIGHT, MIXER_MAX_WEIGHT, &w))
+            return 0;
+        l.ch = (uint8_t)v;
+        l.weight = (int16_t)w;
+        for (int i = 4; i < n; i++)
+        {
+            if (!strcmp(tok[i], "offset") && parse_int(tok[i + 1], -100, 100, &v))
+                l.offset = (int16_t)v, i++;
+            else if (!strcmp(tok[i], "curve") && parse_int(tok[i + 1], 0, MIXER_MAX_CURVES - 1, &v))
+                l.curve = (uint8_t)v, i++;
+            else if (!strcmp(tok[i], "mode") && parse_int(tok[i + 1], 0, MIXER_MAX_MODES - 1, &v) && (*mode_defined & (1u << v)))
+                l.when_mask = modes[v][0], l.when_value = modes[v][1], i++;
+            else if (!strcmp(tok[i], "when") && parse_int(tok[i + 1], 0, 0xFFFF, &v) && parse_int(tok[i + 2], 0, 0xFFFF, &w))
+                l.when_mask = (uint16_t)v, l.when_value = (uint16_t)w, i += 2;
+            else if (!strcmp(tok[i], "add"))
+                l.multiplex = MIXER_MULTIPLEX_ADD;
+            else if (!strcmp(tok[i], "replace"))
+                l.multiplex = MIXER_MULTIPLEX_REPLACE;
+            else if (!strcmp(tok[i], "mul"))
+                l.multiplex = MIXER_MULTIPLEX_MUL;
+            else
+                return 0;
+        }
+        model->lines[model->n_lines++] = l;
+        return 1;
+    }
+    if (!strcmp(tok[0], "out"))
+    {
+        if (!parse_int(tok[1], 0, MIXER_CHANNELS - 1, &v))
+            return 0;
+        MixerOutput_t *o = &model->outputs[v];
+        for (int i = 2; i < n; i++)
+        {
+            if (!strcmp(tok[i], "trim") && parse_int(tok[i + 1], -100, 100, &w))
+                o->trim = (int16_t)w, i++;
+            else if (!strcmp(tok[i], "min") && parse_int(tok[i + 1], -100, 100, &w))
+                o->min = (int16_t)w, i++;
+            else if (!strcmp(tok[i], "max") && parse_int(tok[i + 1], -100, 100, &w))
+                o->max = (int16_t)w, i++;
+            else if (!strcmp(tok[i], "reverse"))
+                o->reverse = 1;
+            else
+                return 0;
+        }
+        return o->min <= o->max;
+    }
+    return 0;
+}
+
+uint32_t mixer_parse(const char *text, MixerModel_t *model, int *err_line)
+{
+    uint16_t modes[MIXER_MAX_MODES][2];
+    uint8_t mode_defined = 0;
+    char line[160];
+    int line_no = 0;
+    model_clear(model);
+    while (*text)
+    {
+        const char *eol = strchr(text, '\n');
+        size_t len = eol ? (size_t)(eol - text) : strlen(text);
+        line_no++;
+        if (len >= sizeof(line) || !(memcpy(line, text, len), line[len] = 0, parse_line(line, model, modes, &mode_defined)))
+        {
+            if (err_line)
+                *err_line = line_no;
+            return 0;
+        }
+        text += len + (eol ? 1 : 0);
+    }
+    return 1;
+}
+
+/* -------------------- 加载与切换 -------------------- */
+
+static uint32_t model_save(const MixerModel_t *model)
+{
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(MIXER_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK)
+    {
+        if (model)
+        {
+            MixerBlob_t blob = {.version = MIXER_VERSION, .model = *model};
+            err = nvs_set_blob(nvs, MIXER_NVS_KEY, &blob, sizeof(blob));
+        }
+        else
+        {
+            err = nvs_erase_key(nvs, MIXER_NVS_KEY);
+            if (err == ESP_ERR_NVS_NOT_FOUND)
+                err = ESP_OK;
+        }
+        if (err == ESP_OK)
+            err = nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK)
+        ESP_LOGE(TAG, "save: %s", esp_err_to_name(err));
+    return err == ESP_OK;
+}
+
+// 把编译好的程序（kStaging）交给扫描任务，调用时已持有锁
+static void program_submit(uint32_t loaded)
+{
+    while (1)
+    {
+        // 扫描任务还没有取走上一次的程序时直接覆盖
+        unsigned expected = PENDING_EMPTY;
+        if (atomic_compare_exchange_strong(&kPendingState, &expected, PENDING_WRITING))
+            break;
+        expected = PENDING_READY;
+        if (atomic_compare_exchange_strong(&kPendingState, &expected, PENDING_WRITING))
+            break;
+        vTaskDelay(1);      // 扫描任务正在复制
+    }
+    if (loaded)
+        memcpy(&kPending, &kStaging, sizeof(kPending));
+    kPendingLoaded = (uint8_t)loaded;
+    atomic_store(&kPendingState, PENDING_READY);
+}
+
+// 编译并切换，调用时已持有锁
+static uint32_t load_locked(const MixerModel_t *model, uint32_t save)
+{
+    if (model && !mixer_compile(model, &kStaging))
+    {
+        ESP_LOGW(TAG, "compile failed");
+        return 0;
+    }
+    program_submit(model != NULL);
+    if (model)
+        ESP_LOGI(TAG, "loaded: %u lines -> %u ops", model->n_lines, kStaging.n_ops);
+    if (save)
+        return model_save(model);
+    return 1;
+}
+
+uint32_t mixer_load(const MixerModel_t *model, uint32_t save)
+{
+    mixer_lock();
+    uint32_t ok = load_locked(model, save);
+    mixer_unlock();
+    return ok;
+}
+
+uint32_t mixer_init(void)
+{
+    if (!mixer_mutex)
+        mixer_mutex = xSemaphoreCreateMutex();
+    MixerBlob_t *blob = malloc(sizeof(MixerBlob_t));
+    if (!mixer_mutex || !blob)
+    {
+        free(blob);
+        return 0;
+    }
+    uint32_t ok = 0;
+    // 读取和切换在同一次加锁中完成，不会覆盖其它任务同时加载的模型
+    mixer_lock();
+    nvs_handle_t nvs;
+    if (nvs_open(MIXER_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK)
+    {
+        size_t size = sizeof(*blob);
+        esp_err_t err = nvs_get_blob(nvs, MIXER_NVS_KEY, blob, &size);
+        nvs_close(nvs);
+        if (err == ESP_OK && size == sizeof(*blob) && blob->version == MIXER_VERSION)
+            ok = load_locked(&blob->model, 0);
+    }
+    mixer_unlock();
+    free(blob);
+    if (!ok)
+        ESP_LOGI(TAG, "no model, sending raw sticks");
+    return ok;
+}
+
+uint32_t mixer_load_file(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+        return 0;
+    char *text = malloc(MIXER_FILE_MAX + 1);
+    MixerModel_t *model = malloc(sizeof(MixerModel_t));
+    uint32_t ok = 0;
+    if (text && model)
+    {
+        size_t len = fread(text, 1, MIXER_FILE_MAX + 1, f);
+        text[len <= MIXER_FILE_MAX ? len : MIXER_FILE_MAX] = 0;
+        int err_line = 0;
+        if (len > MIXER_FILE_MAX)
+            ESP_LOGW(TAG, "%s: file too large", path);
+        else if (!mixer_parse(text, model, &err_line))
+            ESP_LOGW(TAG, "%s:%d: syntax error", path, err_line);
+        else
+            ok = mixer_load(model, 1);
+    }
+    fclose(f);
+    free(text);
+    free(model);
+    return ok;
+}
+
+uint32_t mixer_run(const int16_t sticks[4], uint16_t keys, int16_t channels[MIXER_CHANNELS])
+{
+    unsigned expected = PENDING_READY;
+    if (atomic_load_explicit(&kPendingState, memory_order_relaxed) == PENDING_READY &&
+        atomic_compare_exchange_strong(&kPendingState, &expected, PENDING_COPYING))
+    {
+        kLoaded = kPendingLoaded;
+        if (kLoaded)
+            memcpy(&kProgram, &kPending, sizeof(kProgram));
+        atomic_store(&kPendingState, PENDING_EMPTY);
+    }
+    if (!kLoaded)
+        return 0;
+    mixer_eval(&kProgram, sticks, keys, virtual_item_values(), channels);
+    return 1;
+}
@@ -0,0 +1,204 @@
+#ifndef __MIXER_H__
+#define __MIXER_H__
+
+#include <stdint.h>
+#include "dataFrame.h"
+
+/*
+ * 通道混控（航模遥控器式）：
+ * 把4个摇杆和按键映射到 MIXER_CHANNELS 个控制通道，映射关系完全由数据（模型）描述，不同底盘只需要换一份模型：
+ * - 曲线：expo（-100~100，正值中心更柔和，负值中心更灵敏）或 2~MIXER_CURVE_MAX_POINTS 个等间距点（-100%~100%）
+ * - 混控行：通道 += / = / *= 源 经过曲线后 × 权重 + 偏移，可以只在某个按键组合（拨杆位置）下生效，实现多种模式
+ *   源：摇杆（Q15）、按键（按下为100%，松开为0）、常量100%、前面的通道（用于级联）、触摸屏上的虚拟控件
+ * - 通道输出：微调、反向、上下限
+ * 模型在加载时编译成定点操作表（MixerProgram_t）：源和曲线在程序开头各计算一次，曲线预先生成33点查找表，
+ * 条件相同的连续混控行共用一次按键判断，权重100%且偏移为0的行不做乘法，永远不会生效的行直接去掉。
+ * 扫描任务每次扫描执行一次操作表，只有整数加法、乘法和查表，不分配内存、不加锁；
+ * 换模型时新的操作表在扫描任务下一次执行前整体切换，扫描任务不会看到编译到一半的程序。
+ *
+ * 模型保存在NVS中，上电时读出（mixer_init），也可以从SD卡的文本文件加载（mixer_load_file，成功后写入NVS），
+ * 没有模型时扫描任务仍按原来的格式发送控制包（PackControl_t），加载了模型后改为发送通道包（PackChannel_t）。
+ * 解析、编译和执行的正确性用 tools/mixer_bench 检查。
+ *
+ * 文本格式：每行一条，'#' 之后为注释，百分比均为整数
+ *   curve <n> expo <k>                           定义曲线 n（0~MIXER_MAX_CURVES-1）
+ *   curve <n> points <y0> <y1> ...               点曲线，x 从 -100 到 100 等间距
+ *   mode <n> <mask> <value>                      定义模式 n：(按键 & mask) == value 时生效
+ *   mix <ch> <src> <weight> [offset <o>] [curve <n>] [mode <n> | when <mask> <value>] [add | replace | mul]
+ *                                                src：stick0~stick3、key0~key15、max、ch0~ch7、virt0~virt15；默认 add
+ *   out <ch> [trim <t>] [min <lo>] [max <hi>] [reverse]
+ * mask/value 可以写成十六进制（0x...）。例：差速底盘，左摇杆纵向前进、横向转向，左拨杆向上时转向减半：
+ *   mode 0 0x400 0x400
+ *   mode 1 0x400 0
+ *   mix 0 stick1 100
+ *   mix 0 stick0 50 mode 0
+ *   mix 0 stick0 100 mode 1
+ *   mix 1 stick1 100
+ *   mix 1 stick0 -50 mode 0
+ *   mix 1 stick0 -100 mode 1
+ */
+
+#define MIXER_CHANNELS              PACK_CHANNEL_NUM
+#define MIXER_VIRT_NUM              PACK_VIRTUAL_ITEM_MAX
+#define MIXER_MAX_LINES             32
+#define MIXER_MAX_CURVES            8
+#define MIXER_MAX_MODES             8
+#define MIXER_CURVE_MAX_POINTS      9
+#define MIXER_CURVE_TABLE_SIZE      33      // 编译后的曲线查找表（-100%~100%，步长6.25%，线性插值）
+#define MIXER_MAX_REGS              (MIXER_MAX_LINES * 2 + 1)
+#define MIXER_MAX_OPS               (MIXER_MAX_LINES * 4 + MIXER_CHANNELS)
+#define MIXER_MAX_WEIGHT            200     // 权重范围 ±200%
+#define MIXER_NVS_NAMESPACE         "mixer"
+#define MIXER_SD_PATH               "/sdcard/mixer.txt"
+
+// 源编号
+#define MIXER_SRC_STICK(n)          (n)             // 0~3
+#define MIXER_SRC_KEY(n)            (4 + (n))       // 4~19
+#define MIXER_SRC_MAX               20
+#define MIXER_SRC_CH(n)             (21 + (n))      // 21~28
+#define MIXER_SRC_VIRT(n)           (MIXER_SRC_CH(MIXER_CHANNELS) + (n))    // 29~44，虚拟控件（virtual_item.h）
+#define MIXER_SRC_NUM               MIXER_SRC_VIRT(MIXER_VIRT_NUM)
+
+#define MIXER_CURVE_NONE            0xFF
+
+typedef enum
+{
+    MIXER_MULTIPLEX_ADD = 0,        // 通道 += 本行
+    MIXER_MULTIPLEX_REPLACE,        // 通道 = 本行
+    MIXER_MULTIPLEX_MUL,            // 通道 = 通道 × 本行
+} MixerMultiplex_t;
+
+typedef enum
+{
+    MIXER_CURVE_EXPO = 0,
+    MIXER_CURVE_POINTS,
+} MixerCurveType_t;
+
+typedef struct
+{
+    uint8_t type;                               // MixerCurveType_t
+    int8_t expo;                                // -100~100
+    uint8_t n_points;                           // 2~MIXER_CURVE_MAX_POINTS
+    int8_t points[MIXER_CURVE_MAX_POINTS];      // -100~100
+} MixerCurve_t;
+
+typedef struct
+{
+    uint8_t ch;                     // 目的通道
+    uint8_t src;                    // MIXER_SRC_*
+    uint8_t curve;                  // 曲线号，MIXER_CURVE_NONE 不使用曲线
+    uint8_t multiplex;              // MixerMultiplex_t
+    int16_t weight;                 // 百分比，±MIXER_MAX_WEIGHT
+    int16_t offset;                 // 百分比，±100
+    uint16_t when_mask;             // (按键 & when_mask) == when_value 时生效，when_mask 为0时总是生效
+    uint16_t when_value;
+} MixerLine_t;
+
+typedef struct
+{
+    int16_t trim;                   // 百分比，±100
+    int16_t min;                    // 百分比，-100~100
+    int16_t max;
+    uint8_t reverse;
+} MixerOutput_t;
+
+typedef struct
+{
+    uint8_t n_lines;
+    MixerCurve_t curves[MIXER_MAX_CURVES];
+    MixerLine_t lines[MIXER_MAX_LINES];
+    MixerOutput_t outputs[MIXER_CHANNELS];
+} MixerModel_t;
+
+// 编译后的操作码，由 mixer_eval 执行
+enum
+{
+    MIXER_OP_SRC = 0,       // reg[a] = 源 b
+    MIXER_OP_CH,            // reg[a] = 通道 b 当前值（限幅到 ±100%）
+    MIXER_OP_CURVE,         // reg[a] = 曲线 c (reg[b])
+    MIXER_OP_SKIP,          // (按键 & k) != m 时跳过之后的 c 个操作
+    MIXER_OP_MOV,           // ch[a] = reg[b]
+    MIXER_OP_ADD,           // ch[a] += reg[b]
+    MIXER_OP_MOVW,          // ch[a] = reg[b] * k + m
+    MIXER_OP_ADDW,          // ch[a] += reg[b] * k + m
+    MIXER_OP_MULW,          // ch[a] = ch[a] * (reg[b] * k + m)
+    MIXER_OP_OUT,           // out[a] = clamp(ch[a] * k + m, lo, hi)
+};
+
+typedef struct
+{
+    uint8_t code;                   // MIXER_OP_*
+    uint8_t a;                      // 目的寄存器/通道
+    uint8_t b;                      // 源/源寄存器
+    uint8_t c;                      // 曲线号/跳过的操作数
+    int32_t k;                      // 系数（Q15，100% = 32768）/条件掩码
+    int32_t m;                      // 偏移（Q15）/条件值
+    int16_t lo;                     // 输出下限
+    int16_t hi;                     // 输出上限
+} MixerOp_t;
+
+typedef struct
+{
+    uint16_t n_ops;
+    uint8_t n_regs;
+    MixerOp_t ops[MIXER_MAX_OPS];
+    int16_t curves[MIXER_MAX_CURVES][MIXER_CURVE_TABLE_SIZE];
+} MixerProgram_t;
+
+/**
+ * @brief 填写默认模型：通道0~3直接对应摇杆0~3，其余通道为0
+ */
+void mixer_default_model(MixerModel_t *model);
+
+/**
+ * @brief 解析文本格式的模型
+ * @param err_line 失败时填写出错的行号（从1开始），可为NULL
+ * @return 1 成功；0 格式错误
+ */
+uint32_t mixer_parse(const char *text, MixerModel_t *model, int *err_line);
+
+/**
+ * @brief 把模型编译成操作表
+ * @return 1 成功；0 模型中有超出范围的编号/参数
+ */
+uint32_t mixer_compile(const MixerModel_t *model, MixerProgram_t *program);
+
+/**
+ * @brief 执行操作表
+ * @param sticks 校准滤波后的摇杆值（Q15）
+ * @param keys 按键状态
+ * @param virt 虚拟控件的值（Q15）
+ * @param channels 输出（Q15）
+ */
+void mixer_eval(const MixerProgram_t *program, const int16_t sticks[4], uint16_t keys, const volatile int16_t virt[MIXER_VIRT_NUM],
+                int16_t channels[MIXER_CHANNELS]);
+
+/**
+ * @brief 创建互斥锁，从NVS读取模型并编译，需要先调用 nvs_flash_init
+ *        在创建扫描任务（RemoteCoreInit）和调用其它加载函数之前，只在一个任务中调用一次
+ * @return 1 已加载模型；0 NVS中没有模型（按原来的格式发送控制包）
+ */
+uint32_t mixer_init(void);
+
+/**
+ * @brief 编译并切换到新模型，mixer_init 之后可以在任意任务中调用，扫描任务在下一次扫描时切换
+ * @param model 新模型，NULL 卸载模型（恢复原来的控制包）
+ * @param save 1：同时写入NVS（NULL 时删除NVS中的模型）
+ * @return 1 成功；0 编译失败或保存失败（编译失败时不切换）
+ */
+uint32_t mixer_load(const MixerModel_t *model, uint32_t save);
+
+/**
+ * @brief 读取文本文件（例如SD卡上的 MIXER_SD_PATH），解析、编译并写入NVS
+ * @return 1 成功；0 文件不存在或格式错误（当前模型不变）
+ */
+uint32_t mixer_load_file(const char *path);
+
+/**
+ * @brief 扫描任务每次扫描调用，切换待生效的模型并执行（虚拟控件取当前值）
+ * @param channels 输出（Q15），没有模型时不修改
+ * @return 1 已执行模型；0 没有模型
+ */
+uint32_t mixer_run(const int16_t sticks[4], uint16_t keys, int16_t channels[MIXER_CHANNELS]);
+
+#endif
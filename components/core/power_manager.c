@@ -0,0 +1,354 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "power_manager.h"
+#include "core.h"
+#include "hardware.h"
+#include "comm.h"
+#include "comm_link.h"
+#include "comm_rpc.h"
+#include "comm_ota.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#if CONFIG_PM_ENABLE
+#include "esp_pm.h"
+#include "esp_sleep.h"
+#endif
+
+static const char *TAG = "power";
+
+// 电池电压-电量表（单节锂电，遥控器工作负载下测得的放电曲线），表外按两端截断
+typedef struct
+{
+    uint16_t mv;
+    uint8_t percent;
+} BatteryPoint_t;
+
+static const BatteryPoint_t kBatteryTable[] = {
+    {3550, 0}, {3600, 2}, {3650, 10}, {3700, 22}, {3750, 36}, {3800, 49}, {3850, 61},
+    {3900, 70}, {3950, 78}, {4000, 83}, {4050, 88}, {4100, 92}, {4150, 98}, {4200, 100},
+};
+#define BATTERY_TABLE_SIZE (sizeof(kBatteryTable) / sizeof(kBatteryTable[0]))
+
+// 进入各级的电压阈值（NORMAL 没有阈值）
+static const uint16_t kStageThreshold[] = {
+    [PM_BATTERY_LOW] = PM_BATTERY_LOW_MV,
+    [PM_BATTERY_CRITICAL] = PM_BATTERY_CRITICAL_MV,
+    [PM_BATTERY_SHUTDOWN] = PM_BATTERY_CUTOFF_MV,
+};
+
+#if CONFIG_PM_ENABLE
+static esp_pm_lock_handle_t kAwakeLock;     // ESP_PM_NO_LIGHT_SLEEP，活动时持有
+static esp_pm_lock_handle_t kActiveLock;    // ESP_PM_CPU_FREQ_MAX，活动时持有（只持有APB锁时CPU只有80MHz）
+static esp_pm_lock_handle_t kRenderLock;    // ESP_PM_CPU_FREQ_MAX，渲染期间持有
+static esp_pm_lock_handle_t kCommLock;      // ESP_PM_NO_LIGHT_SLEEP，通信有未完成的事务或对端正在发送时持有
+#endif
+
+// 以下由扫描任务独占
+static uint8_t kState = PM_STATE_ACTIVE;
+static uint8_t kScanInited;
+static int16_t kStickRef[4];
+static uint16_t kLastKeys;
+static int64_t kLastActivityUs;
+static uint8_t kStage = PM_BATTERY_NORMAL;
+static int64_t kStageBelowUs;              // 电压低于下一级阈值的起始时刻，0 表示没有
+static int64_t kCriticalUs;                // 进入 CRITICAL 的时刻
+
+static atomic_uint kActivity;              // 其它任务报告的操作
+static atomic_uint kCommHeld;              // 持有 kCommLock，由接收任务置位、扫描任务清除
+static atomic_uint kSleepAllowed;          // 空闲且没有持有 kCommLock，此时可能在浅睡眠
+static atomic_uint kCommWakeups;           // 允许浅睡眠期间收到数据的次数
+static PowerStatus_t kStatus;
+static SemaphoreHandle_t status_mutex;
+
+static void status_lock(void)
+{
+    xSemaphoreTake(status_mutex, portMAX_DELAY);
+}
+
+static void status_unlock(void)
+{
+    xSemaphoreGive(status_mutex);
+}
+
+static void power_set_awake(uint32_t awake)
+{
+#if CONFIG_PM_ENABLE
+    if (!kAwakeLock || !kActiveLock)
+        return;
+    if (awake)
+    {
+        esp_pm_lock_acquire(kAwakeLock);
+        esp_pm_lock_acquire(kActiveLock);
+    }
+    else
+    {
+        esp_pm_lock_release(kActiveLock);
+        esp_pm_lock_release(kAwakeLock);
+    }
+#endif
+}
+
+#if CONFIG_PM_ENABLE
+static atomic_uint kCommRx;                // 接收任务读到了数据，由扫描任务清除
+static int64_t kLastCommRxUs;              // 由扫描任务独占
+
+// 接收任务读到数据时调用：立即禁止浅睡眠，之后的帧不会再丢失开头，由扫描任务在空闲时释放
+static void power_comm_rx(void)
+{
+    atomic_store(&kCommRx, 1);
+    if (!atomic_exchange(&kCommHeld, 1))
+    {
+        esp_pm_lock_acquire(kCommLock);
+        if (atomic_exchange(&kSleepAllowed, 0))
+            atomic_fetch_add(&kCommWakeups, 1);     // 数据是在允许浅睡眠期间到达的
+    }
+}
+
+// 通信是否有未完成的事务：等待ACK或重发、发送队列非空、RPC调用、OTA会话、链路正常（对端在持续发送），
+// 或者 PM_COMM_HOLD_MS 内收到过数据（没有开启心跳时）
+static uint32_t power_comm_busy(int64_t now_us)
+{
+    if (atomic_exchange(&kCommRx, 0))
+        kLastCommRxUs = now_us;
+    if (kLastCommRxUs && now_us - kLastCommRxUs < (int64_t)PM_COMM_HOLD_MS * 1000)
+        return 1;
+    return comm_link_state() == COMM_LINK_UP || comm_ack_pending() || comm_send_queue_depth() ||
+           comm_rpc_in_flight() || comm_ota_busy();
+}
+#endif
+
+// 空闲时每次扫描调用：通信忙时保持禁止浅睡眠，否则释放
+static void power_comm_update(int64_t now_us)
+{
+#if CONFIG_PM_ENABLE
+    if (!kCommLock)
+        return;
+    if (power_comm_busy(now_us))
+    {
+        if (!atomic_exchange(&kCommHeld, 1))
+            esp_pm_lock_acquire(kCommLock);
+    }
+    else if (atomic_exchange(&kCommHeld, 0))
+    {
+        esp_pm_lock_release(kCommLock);
+        // 与接收回调竞争：释放前刚收到的数据由回调置位了 kCommRx，重新持有
+        if (atomic_load(&kCommRx) && !atomic_exchange(&kCommHeld, 1))
+            esp_pm_lock_acquire(kCommLock);
+    }
+    atomic_store(&kSleepAllowed, !atomic_load(&kCommHeld));
+#endif
+}
+
+uint32_t power_manager_init(void)
+{
+    if (!status_mutex)
+        status_mutex = xSemaphoreCreateMutex();
+#if CONFIG_PM_ENABLE
+    if (kAwakeLock)
+        return 1;
+    esp_pm_config_t cfg = {
+        .max_freq_mhz = PM_MAX_CPU_FREQ_MHZ,
+        .min_freq_mhz = PM_MIN_CPU_FREQ_MHZ,
+        .light_sleep_enable = true,
+    };
+    esp_err_t err = esp_pm_configure(&cfg);
+    if (err == ESP_OK)
+        err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "pm_awake", &kAwakeLock);
+    if (err == ESP_OK)
+        err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "pm_active", &kActiveLock);
+    if (err == ESP_OK)
+        err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "pm_render", &kRenderLock);
+    if (err == ESP_OK)
+        err = esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "pm_comm", &kCommLock);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "power management init: %s", esp_err_to_name(err));
+        return 0;
+    }
+    // 浅睡眠时串口时钟停止，用RX引脚的起始位（低电平）唤醒
+    // 唤醒需要时间，唤醒前到达的字节丢失，所以对端在发送时不睡眠（见 power_comm_update）
+    gpio_wakeup_enable(PIN_NUM_UART_RXD, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+    comm_set_rx_hook(power_comm_rx);
+    power_set_awake(1);
+    status_lock();
+    kStatus.sleep_enabled = 1;
+    status_unlock();
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+static uint32_t power_idle_timeout_ms(void)
+{
+    return kStage >= PM_BATTERY_LOW ? PM_IDLE_TIMEOUT_LOW_MS : PM_IDLE_TIMEOUT_MS;
+}
+
+uint32_t power_manager_scan(const int16_t sticks[4], uint16_t keys, int64_t now_us)
+{
+    uint32_t active = atomic_exchange(&kActivity, 0) || !kScanInited || keys != kLastKeys;
+    for (int i = 0; i < 4; i++)
+    {
+        int32_t diff = (int32_t)sticks[i] - kStickRef[i];
+        if (diff > PM_ACTIVITY_STICK_DELTA || diff < -PM_ACTIVITY_STICK_DELTA)
+            active = 1;
+    }
+    kScanInited = 1;
+    kLastKeys = keys;
+    if (active)
+    {
+        // 参考值跟随操作更新，摇杆停在非中心位置不算持续操作
+        memcpy(kStickRef, sticks, sizeof(kStickRef));
+        kLastActivityUs = now_us;
+    }
+
+    uint8_t state = kState;
+    if (active)
+        state = PM_STATE_ACTIVE;
+    else if (now_us - kLastActivityUs >= (int64_t)power_idle_timeout_ms() * 1000)
+        state = PM_STATE_IDLE;
+    if (state == PM_STATE_IDLE)
+        power_comm_update(now_us);
+    uint8_t comm_awake = atomic_load(&kCommHeld);
+    if (state == kState && comm_awake == kStatus.comm_awake)
+        return kState;
+
+    if (state != kState)
+    {
+        kState = state;
+        power_set_awake(state == PM_STATE_ACTIVE);
+        if (state == PM_STATE_ACTIVE)
+            atomic_store(&kSleepAllowed, 0);
+    }
+    status_lock();
+    if (state != kStatus.state && state == PM_STATE_IDLE)
+        kStatus.idle_count++;
+    kStatus.state = state;
+    kStatus.comm_awake = comm_awake;
+    kStatus.comm_wakeups = atomic_load(&kCommWakeups);
+    status_unlock();
+    return kState;
+}
+
+void power_manager_activity(void)
+{
+    atomic_store(&kActivity, 1);
+}
+
+void power_manager_render_begin(void)
+{
+#if CONFIG_PM_ENABLE
+    if (kRenderLock)
+        esp_pm_lock_acquire(kRenderLock);
+#endif
+}
+
+void power_manager_render_end(void)
+{
+#if CONFIG_PM_ENABLE
+    if (kRenderLock)
+        esp_pm_lock_release(kRenderLock);
+#endif
+}
+
+uint8_t power_battery_percent(uint32_t voltage_mv)
+{
+    if (voltage_mv <= kBatteryTable[0].mv)
+        return kBatteryTable[0].percent;
+    for (uint32_t i = 1; i < BATTERY_TABLE_SIZE; i++)
+    {
+        const BatteryPoint_t *a = &kBatteryTable[i - 1];
+        const BatteryPoint_t *b = &kBatteryTable[i];
+        if (voltage_mv < b->mv)
+            return (uint8_t)(a->percent + ((voltage_mv - a->mv) * (b->percent - a->percent) + (b->mv - a->mv) / 2) / (b->mv - a->mv));
+    }
+    return kBatteryTable[BATTERY_TABLE_SIZE - 1].percent;
+}
+
+// 按当前电压应处于的级别，回到上一级需要超过回差
+static uint8_t power_battery_target(uint32_t mv)
+{
+    uint8_t target = PM_BATTERY_NORMAL;
+    for (uint8_t stage = PM_BATTERY_LOW; stage <= PM_BATTERY_SHUTDOWN; stage++)
+    {
+        uint32_t threshold = kStageThreshold[stage];
+        if (stage <= kStage)
+            threshold += PM_BATTERY_HYSTERESIS_MV;
+        if (mv < threshold)
+            target = stage;
+    }
+    return target;
+}
+
+void power_manager_battery_update(float voltage, int64_t now_us)
+{
+    uint32_t mv = voltage > 0.0f ? (uint32_t)(voltage * 1000.0f + 0.5f) : 0;
+    uint8_t stage = kStage;
+    if (stage != PM_BATTERY_SHUTDOWN)
+    {
+        uint8_t target = power_battery_target(mv);
+        if (target > stage)
+        {
+            if (!kStageBelowUs)
+                kStageBelowUs = now_us;
+            if (now_us - kStageBelowUs >= (int64_t)PM_BATTERY_CONFIRM_MS * 1000)
+                stage = target;
+        }
+        else
+        {
+            kStageBelowUs = 0;
+            stage = target;     // 电压回升（例如接上充电器）
+        }
+        if (stage == PM_BATTERY_CRITICAL && kStage != PM_BATTERY_CRITICAL)
+            kCriticalUs = now_us;
+        if (stage == PM_BATTERY_CRITICAL && now_us - kCriticalUs >= (int64_t)PM_BATTERY_SHUTDOWN_DELAY_MS * 1000)
+            stage = PM_BATTERY_SHUTDOWN;
+        if (stage != kStage)
+        {
+            ESP_LOGW(TAG, "battery %s -> %s (%lumV)", power_battery_stage_name(kStage),
+                     power_battery_stage_name(stage), (unsigned long)mv);
+            kStage = stage;
+            kStageBelowUs = 0;
+        }
+    }
+
+    uint32_t shutdown_in_ms = 0;
+    if (stage == PM_BATTERY_CRITICAL)
+        shutdown_in_ms = (uint32_t)(((int64_t)PM_BATTERY_SHUTDOWN_DELAY_MS * 1000 - (now_us - kCriticalUs)) / 1000);
+    status_lock();
+    kStatus.battery_mv = (uint16_t)(mv > UINT16_MAX ? UINT16_MAX : mv);
+    kStatus.battery_percent = power_battery_percent(mv);
+    kStatus.battery_stage = stage;
+    kStatus.shutdown_in_ms = shutdown_in_ms;
+    status_unlock();
+
+    // 切断电源；USB供电时关不掉，保持在 SHUTDOWN
+    if (stage == PM_BATTERY_SHUTDOWN)
+        sys_shutdown();
+}
+
+void power_manager_get_status(PowerStatus_t *status)
+{
+    status_lock();
+    *status = kStatus;
+    status_unlock();
+}
+
+const char *power_battery_stage_name(uint8_t stage)
+{
+    switch (stage)
+    {
+    case PM_BATTERY_NORMAL:
+        return "normal";
+    case PM_BATTERY_LOW:
+        return "low";
+    case PM_BATTERY_CRITICAL:
+        return "critical";
+    case PM_BATTERY_SHUTDOWN:
+        return "shutdown";
+    default:
+        return "?";
+    }
+}
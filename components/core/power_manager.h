@@ -0,0 +1,118 @@
+#ifndef __POWER_MANAGER_H__
+#define __POWER_MANAGER_H__
+
+#include <stdint.h>
+
+/*
+ * 电源管理（需要在menuconfig中开启 PM_ENABLE 和 FREERTOS_USE_TICKLESS_IDLE，否则只有电池状态部分有效）：
+ * - 活动/空闲：摇杆（校准后的值偏离参考超过 PM_ACTIVITY_STICK_DELTA）、按键、触摸在 PM_IDLE_TIMEOUT_MS 内
+ *   都没有变化时进入空闲。活动时持有禁止浅睡眠锁和CPU最高频率锁（PM_MAX_CPU_FREQ_MHZ，扫描和通信路径
+ *   不低于关闭电源管理时的160MHz；APB最高频率锁只能保证80MHz），扫描任务1kHz扫描；
+ *   空闲时释放这两个锁，扫描任务改为每 PM_IDLE_SCAN_MS 扫描一次并在两次扫描之间暂停摇杆ADC，
+ *   所有任务都阻塞时系统自动进入浅睡眠（定时器唤醒；串口RX引脚低电平唤醒）。任何操作在下一次扫描时回到活动状态：
+ *   空闲时第一次操作的响应最多晚 PM_IDLE_SCAN_MS + PM_IDLE_ADC_SETTLE_MS（约22ms，控制包在检测到操作的那次扫描
+ *   中由发送调度立即发出），之后恢复1kHz扫描。
+ * - 通信：浅睡眠时串口时钟停止，从起始位唤醒到串口恢复接收约需0.5~1ms，115200波特率下唤醒前的6~12个字节丢失，
+ *   唤醒的那一帧必然丢失（帧头不完整）。所以空闲时只要通信有未完成的事务（等待ACK/重发、发送队列非空、RPC调用、
+ *   OTA会话）、链路状态为 COMM_LINK_UP（对端在持续发送心跳或数据），或 PM_COMM_HOLD_MS 内收到过数据，
+ *   就另外持有一个禁止浅睡眠锁（不恢复扫描频率和CPU频率）。接收任务读到任何数据时立即持有该锁，
+ *   所以每次被对端唤醒只丢失唤醒的那一帧：需要ACK的帧由重发恢复，心跳丢一帧不会判为断线。
+ *   被对端唤醒的次数记录在 PowerStatus_t.comm_wakeups，在设备上据此统计这部分丢帧。
+ * - 渲染：LVGL任务在 lv_timer_handler 期间持有CPU最高频率锁（PM_MAX_CPU_FREQ_MHZ），空闲时界面刷新也以最高频率完成，渲染结束后降回。
+ * - 电池：电压经查找表插值得到电量百分比；低电压分级处理，低于阈值持续 PM_BATTERY_CONFIRM_MS 才进入下一级
+ *   （负载瞬间的压降不算），电压回升超过 阈值+PM_BATTERY_HYSTERESIS_MV 才回到上一级：
+ *   LOW 界面提示并缩短进入空闲的时间；CRITICAL 界面警告并在 PM_BATTERY_SHUTDOWN_DELAY_MS 后关机；
+ *   低于 PM_BATTERY_CUTOFF_MV 直接关机。
+ * 活动/空闲和电池状态由扫描任务更新，其它任务只通过 power_manager_get_status 读取。
+ */
+
+#define PM_MAX_CPU_FREQ_MHZ             240     // 渲染时
+#define PM_MIN_CPU_FREQ_MHZ             40      // 不持有任何锁时（XTAL）
+#define PM_IDLE_TIMEOUT_MS              10000   // 无操作多久后进入空闲
+#define PM_IDLE_TIMEOUT_LOW_MS          3000    // 低电量时
+#define PM_IDLE_SCAN_MS                 20      // 空闲时的扫描周期，控制包仍按周期发送（50Hz），也是空闲时第一次操作的最大额外延迟
+#define PM_IDLE_ADC_SETTLE_MS           2       // 空闲扫描时恢复ADC后等待新样本的时间
+#define PM_ACTIVITY_STICK_DELTA         1638    // 摇杆变化超过5%（Q15）视为操作
+#define PM_COMM_HOLD_MS                 1000    // 空闲时收到数据后保持唤醒的时间，大于对端的重发超时
+
+#define PM_BATTERY_LOW_MV               3700
+#define PM_BATTERY_CRITICAL_MV          3600
+#define PM_BATTERY_CUTOFF_MV            3450
+#define PM_BATTERY_HYSTERESIS_MV        50
+#define PM_BATTERY_CONFIRM_MS           2000
+#define PM_BATTERY_SHUTDOWN_DELAY_MS    30000
+
+typedef enum
+{
+    PM_STATE_ACTIVE = 0,
+    PM_STATE_IDLE,
+} PowerState_t;
+
+typedef enum
+{
+    PM_BATTERY_NORMAL = 0,
+    PM_BATTERY_LOW,
+    PM_BATTERY_CRITICAL,
+    PM_BATTERY_SHUTDOWN,
+} PowerBatteryStage_t;
+
+typedef struct
+{
+    uint8_t state;                  // PowerState_t
+    uint8_t battery_stage;          // PowerBatteryStage_t
+    uint8_t battery_percent;
+    uint16_t battery_mv;
+    uint32_t shutdown_in_ms;        // CRITICAL 时距离关机的时间，其它为0
+    uint32_t idle_count;            // 进入空闲的次数
+    uint32_t sleep_enabled;         // 1 开启了自动浅睡眠
+    uint8_t comm_awake;             // 1 因通信保持唤醒
+    uint32_t comm_wakeups;          // 允许浅睡眠期间收到数据的次数（每次约丢失一帧）
+} PowerStatus_t;
+
+/**
+ * @brief 创建互斥锁，配置动态调频和自动浅睡眠并进入活动状态，由 RemoteCoreInit 在创建扫描任务之前调用
+ * @return 1 成功；0 没有开启电源管理或配置失败（只有电池状态有效）
+ */
+uint32_t power_manager_init(void);
+
+/**
+ * @brief 扫描任务每次扫描调用，检测操作并切换活动/空闲
+ * @param sticks 校准后未滤波的摇杆值（Q15），空闲时扫描周期长，滤波后的值跟不上
+ * @return PowerState_t，扫描任务按返回值调整扫描周期和ADC
+ */
+uint32_t power_manager_scan(const int16_t sticks[4], uint16_t keys, int64_t now_us);
+
+/**
+ * @brief 报告一次用户操作（例如触摸），可以在任意任务中调用，在下一次扫描时回到活动状态
+ */
+void power_manager_activity(void);
+
+/**
+ * @brief 渲染开始/结束，期间CPU运行在最高频率，只由LVGL任务调用
+ */
+void power_manager_render_begin(void);
+void power_manager_render_end(void);
+
+/**
+ * @brief 扫描任务更新电池电压后调用，执行低电量分级，需要时关机
+ * @param voltage 滤波后的电池电压(V)
+ */
+void power_manager_battery_update(float voltage, int64_t now_us);
+
+/**
+ * @brief 电池电压到电量的查找表插值
+ * @return 0~100
+ */
+uint8_t power_battery_percent(uint32_t voltage_mv);
+
+/**
+ * @brief 读取电源状态
+ */
+void power_manager_get_status(PowerStatus_t *status);
+
+/**
+ * @brief 电池分级的名称（界面显示用）
+ */
+const char *power_battery_stage_name(uint8_t stage);
+
+#endif
@@ -0,0 +1,123 @@
+#include <stdatomic.h>
+#include "remote_state.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+typedef struct
+{
+    atomic_uint_fast32_t seq;   // 缓冲中快照的序号，0 表示正在写入
+    RemoteState_t state;
+} RemoteStateBuffer_t;
+
+typedef struct
+{
+    atomic_uint_fast32_t active;
+    RemoteStateCb_t cb;
+    void *user_data;
+    uint32_t decimation;
+    uint32_t countdown;         // 只由扫描任务修改
+} RemoteStateSubscriber_t;
+
+static RemoteStateBuffer_t kBuffers[REMOTE_STATE_BUFFERS];
+static atomic_uint_fast32_t kLatest;        // 最新快照的序号
+static RemoteStateSubscriber_t kSubscribers[REMOTE_STATE_MAX_SUBSCRIBERS];
+static atomic_uint_fast32_t kDispatching;   // 扫描任务正在调用订阅者
+static TaskHandle_t kPublisherTask;
+static SemaphoreHandle_t state_mutex;       // 只在注册/注销之间互斥，扫描任务不使用
+
+static void state_lock(void)
+{
+    xSemaphoreTake(state_mutex, portMAX_DELAY);
+}
+
+static void state_unlock(void)
+{
+    xSemaphoreGive(state_mutex);
+}
+
+void remote_state_init(void)
+{
+    if (!state_mutex)
+        state_mutex = xSemaphoreCreateMutex();
+}
+
+void remote_state_publish(RemoteState_t *state)
+{
+    kPublisherTask = xTaskGetCurrentTaskHandle();
+    uint32_t seq = atomic_load_explicit(&kLatest, memory_order_relaxed) + 1;
+    state->seq = seq;
+    RemoteStateBuffer_t *buf = &kBuffers[seq & (REMOTE_STATE_BUFFERS - 1)];
+    atomic_store_explicit(&buf->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    buf->state = *state;
+    atomic_store_explicit(&buf->seq, seq, memory_order_release);
+    atomic_store_explicit(&kLatest, seq, memory_order_release);
+
+    atomic_store_explicit(&kDispatching, 1, memory_order_seq_cst);
+    for (int i = 0; i < REMOTE_STATE_MAX_SUBSCRIBERS; i++)
+    {
+        RemoteStateSubscriber_t *sub = &kSubscribers[i];
+        if (!atomic_load_explicit(&sub->active, memory_order_seq_cst))    // 与注销时的 kDispatching 检查配对
+            continue;
+        if (--sub->countdown)
+            continue;
+        sub->countdown = sub->decimation;
+        sub->cb(state, sub->user_data);
+    }
+    atomic_store_explicit(&kDispatching, 0, memory_order_release);
+}
+
+uint32_t remote_state_read(RemoteState_t *state)
+{
+    while (1)
+    {
+        uint32_t seq = atomic_load_explicit(&kLatest, memory_order_acquire);
+        if (!seq)
+            return 0;
+        RemoteStateBuffer_t *buf = &kBuffers[seq & (REMOTE_STATE_BUFFERS - 1)];
+        if (atomic_load_explicit(&buf->seq, memory_order_acquire) != seq)
+            continue;   // 读取期间写者已经绕回这个缓冲，改读最新的一份
+        *state = buf->state;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&buf->seq, memory_order_relaxed) == seq)
+            return 1;
+    }
+}
+
+uint32_t remote_state_subscribe(RemoteStateCb_t cb, void *user_data, uint32_t decimation)
+{
+    if (!cb)
+        return 0;
+    uint32_t handle = 0;
+    state_lock();
+    for (int i = 0; i < REMOTE_STATE_MAX_SUBSCRIBERS; i++)
+    {
+        RemoteStateSubscriber_t *sub = &kSubscribers[i];
+        if (atomic_load_explicit(&sub->active, memory_order_relaxed))
+            continue;
+        sub->cb = cb;
+        sub->user_data = user_data;
+        sub->decimation = decimation ? decimation : 1;
+        sub->countdown = 1;     // 下一次发布时第一次调用
+        atomic_store_explicit(&sub->active, 1, memory_order_release);
+        handle = (uint32_t)i + 1;
+        break;
+    }
+    state_unlock();
+    return handle;
+}
+
+void remote_state_unsubscribe(uint32_t handle)
+{
+    if (handle == 0 || handle > REMOTE_STATE_MAX_SUBSCRIBERS)
+        return;
+    state_lock();
+    atomic_store_explicit(&kSubscribers[handle - 1].active, 0, memory_order_seq_cst);
+    state_unlock();
+    // 在回调中注销时不需要等待；其它任务等扫描任务结束本次分发，之后不会再调用这个回调
+    if (xTaskGetCurrentTaskHandle() == kPublisherTask)
+        return;
+    while (atomic_load_explicit(&kDispatching, memory_order_seq_cst))
+        vTaskDelay(1);
+}
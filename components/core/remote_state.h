@@ -0,0 +1,65 @@
+#ifndef __REMOTE_STATE_H__
+#define __REMOTE_STATE_H__
+
+#include <stdint.h>
+#include "mixer.h"
+
+/*
+ * 遥控器状态总线：
+ * 扫描任务每次扫描后调用 remote_state_publish 发布一份状态快照（摇杆原始值、滤波后的摇杆值、混控通道、按键、时间戳）。
+ * - 读取：remote_state_read 在任意任务中读取最新快照，不加锁。快照轮流写入 REMOTE_STATE_BUFFERS 个缓冲，
+ *   每个缓冲带序号（seqlock），读者复制后检查序号没有变化，复制期间被改写则重新读取最新的一份；
+ *   写者正在写的总是另一个缓冲，所以即使扫描任务在写入中途被抢占，读者也不需要等待。
+ * - 订阅：remote_state_subscribe 注册回调，每 decimation 次发布调用一次（例如1kHz扫描、decimation=20 即50Hz），
+ *   最多 REMOTE_STATE_MAX_SUBSCRIBERS 个。回调在扫描任务中执行，不可以有任何阻塞行为，
+ *   需要操作UI时应在LVGL线程中用 remote_state_read 读取（LVGL定时器），而不是在回调中等待渲染锁。
+ * 扫描任务从不等待读者或订阅者的注册/注销。
+ */
+
+#define REMOTE_STATE_BUFFERS            4       // 必须是2的幂
+#define REMOTE_STATE_MAX_SUBSCRIBERS    8
+
+typedef struct
+{
+    uint32_t seq;               // 发布序号（从1开始）
+    int64_t time_us;            // 扫描时刻
+    int raw[4];                 // 摇杆ADC原始值（0~4095）
+    int16_t stick[4];           // 校准并滤波后的摇杆值（Q15）
+    int16_t channel[MIXER_CHANNELS];    // 混控输出（Q15），没有加载混控模型时通道0~3为摇杆值，其余为0
+    uint16_t keys;              // 按键状态
+} RemoteState_t;
+
+typedef void (*RemoteStateCb_t)(const RemoteState_t *state, void *user_data);
+
+/**
+ * @brief 创建互斥锁，由 RemoteCoreInit 在创建扫描任务和其它任务订阅之前调用
+ */
+void remote_state_init(void);
+
+/**
+ * @brief 发布一份状态并调用到期的订阅者，只能由扫描任务调用
+ * @param state 新状态（seq 由总线填写）
+ */
+void remote_state_publish(RemoteState_t *state);
+
+/**
+ * @brief 读取最新的状态快照，不阻塞扫描任务
+ * @return 1 成功；0 还没有发布过状态
+ */
+uint32_t remote_state_read(RemoteState_t *state);
+
+/**
+ * @brief 注册订阅者
+ * @param cb 回调函数，在扫描任务中执行
+ * @param decimation 每多少次发布调用一次，0 按1处理
+ * @return 订阅句柄（大于0）；0 订阅者已满
+ */
+uint32_t remote_state_subscribe(RemoteStateCb_t cb, void *user_data, uint32_t decimation);
+
+/**
+ * @brief 注销订阅者，返回后回调不会再被调用（其它任务中调用时可能等待扫描任务执行完正在进行的回调，在回调中调用时立即返回）
+ * @param handle remote_state_subscribe 的返回值
+ */
+void remote_state_unsubscribe(uint32_t handle);
+
+#endif
@@ -0,0 +1,175 @@
+#include <string.h>
+#include "rocker_adc.h"
+#include "hardware.h"
+#include "esp_adc/adc_continuous.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+
+static const char *TAG = "rocker_adc";
+
+static const adc_channel_t kChannels[ROCKER_ADC_CHANNELS] = {
+    LEFT_ROCKER_X, LEFT_ROCKER_Y, RIGHT_ROCKER_X, RIGHT_ROCKER_Y};
+
+static adc_continuous_handle_t kAdcHandle;
+static int8_t kChannelIndex[SOC_ADC_MAX_CHANNEL_NUM];   // ADC通道号 -> 摇杆序号，-1 表示不是摇杆通道
+static uint16_t kSamples[ROCKER_ADC_CHANNELS][ROCKER_ADC_WINDOW];
+static uint8_t kSampleHead[ROCKER_ADC_CHANNELS];
+static uint8_t kSampleCount[ROCKER_ADC_CHANNELS];
+static uint8_t kFrameBuf[ROCKER_ADC_FRAME_SIZE];
+static RockerAdcStats_t kStats;
+static volatile uint32_t kOverflows;
+static uint8_t kRunning;
+
+static bool IRAM_ATTR on_pool_ovf(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *user_data)
+{
+    kOverflows++;
+    return false;
+}
+
+uint32_t rocker_adc_init(void)
+{
+    if (kAdcHandle)
+        return 1;
+    memset(kChannelIndex, -1, sizeof(kChannelIndex));
+
+    adc_continuous_handle_cfg_t handle_cfg = {
+        .max_store_buf_size = ROCKER_ADC_POOL_SIZE,
+        .conv_frame_size = ROCKER_ADC_FRAME_SIZE,
+    };
+    esp_err_t err = adc_continuous_new_handle(&handle_cfg, &kAdcHandle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "adc_continuous_new_handle: %s", esp_err_to_name(err));
+        kAdcHandle = NULL;
+        return 0;
+    }
+
+    adc_digi_pattern_config_t pattern[ROCKER_ADC_CHANNELS];
+    for (int i = 0; i < ROCKER_ADC_CHANNELS; i++)
+    {
+        pattern[i] = (adc_digi_pattern_config_t){
+            .atten = ADC_ATTEN_DB_12,
+            .channel = kChannels[i],
+            .unit = ADC_UNIT_1,
+            .bit_width = ADC_BITWIDTH_12,
+        };
+        kChannelIndex[kChannels[i]] = (int8_t)i;
+    }
+    adc_continuous_config_t cfg = {
+        .pattern_num = ROCKER_ADC_CHANNELS,
+        .adc_pattern = pattern,
+        .sample_freq_hz = ROCKER_ADC_SAMPLE_FREQ_HZ,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE2,
+    };
+    adc_continuous_evt_cbs_t cbs = {
+        .on_pool_ovf = on_pool_ovf,
+    };
+    err = adc_continuous_config(kAdcHandle, &cfg);
+    if (err == ESP_OK)
+        err = adc_continuous_register_event_callbacks(kAdcHandle, &cbs, NULL);
+    if (err == ESP_OK)
+        err = adc_continuous_start(kAdcHandle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "adc continuous start: %s", esp_err_to_name(err));
+        adc_continuous_deinit(kAdcHandle);
+        kAdcHandle = NULL;
+        return 0;
+    }
+    kRunning = 1;
+    return 1;
+}
+
+uint32_t rocker_adc_set_running(uint32_t run)
+{
+    if (!kAdcHandle)
+        return 0;
+    run = run ? 1 : 0;
+    if (kRunning == run)
+        return 1;
+    esp_err_t err = run ? adc_continuous_start(kAdcHandle) : adc_continuous_stop(kAdcHandle);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "adc continuous %s: %s", run ? "start" : "stop", esp_err_to_name(err));
+        return 0;
+    }
+    kRunning = (uint8_t)run;
+    return 1;
+}
+
+// 把一帧转换结果放入各通道的环形缓冲
+static void rocker_adc_push_frame(const uint8_t *buf, uint32_t len)
+{
+    for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= len; i += SOC_ADC_DIGI_RESULT_BYTES)
+    {
+        const adc_digi_output_data_t *p = (const adc_digi_output_data_t *)&buf[i];
+        uint32_t channel = p->type2.channel;
+        if (p->type2.unit != 0 || channel >= SOC_ADC_MAX_CHANNEL_NUM || kChannelIndex[channel] < 0)
+        {
+            kStats.invalid++;
+            continue;
+        }
+        int idx = kChannelIndex[channel];
+        kSamples[idx][kSampleHead[idx]] = (uint16_t)p->type2.data;
+        kSampleHead[idx] = (uint8_t)((kSampleHead[idx] + 1) % ROCKER_ADC_WINDOW);
+        if (kSampleCount[idx] < ROCKER_ADC_WINDOW)
+            kSampleCount[idx]++;
+        kStats.samples++;
+    }
+}
+
+// 截尾平均：排序后去掉两端各 trim 个样本（窗口未填满时按比例减少）
+static int rocker_adc_trimmed_mean(const uint16_t *samples, uint32_t count)
+{
+    uint16_t sorted[ROCKER_ADC_WINDOW];
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint16_t v = samples[i];
+        uint32_t j = i;
+        while (j > 0 && sorted[j - 1] > v)
+        {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    uint32_t trim = count * ROCKER_ADC_TRIM / ROCKER_ADC_WINDOW;
+    uint32_t sum = 0;
+    for (uint32_t i = trim; i < count - trim; i++)
+        sum += sorted[i];
+    uint32_t n = count - 2 * trim;
+    return (int)((sum + n / 2) / n);
+}
+
+uint32_t rocker_adc_read(int values[ROCKER_ADC_CHANNELS])
+{
+    if (!kAdcHandle)
+        return 0;
+    kStats.reads++;
+    uint32_t got = 0;
+    uint32_t len = 0;
+    // 不等待，取完驱动缓冲中已有的全部样本；窗口只保留最新的样本
+    while (adc_continuous_read(kAdcHandle, kFrameBuf, sizeof(kFrameBuf), &len, 0) == ESP_OK && len)
+    {
+        rocker_adc_push_frame(kFrameBuf, len);
+        got = 1;
+    }
+    kStats.overflows = kOverflows;
+    if (!got)
+    {
+        kStats.empty_reads++;
+        return 0;
+    }
+    for (int i = 0; i < ROCKER_ADC_CHANNELS; i++)
+    {
+        if (kSampleCount[i])
+            values[i] = rocker_adc_trimmed_mean(kSamples[i], kSampleCount[i]);
+    }
+    return 1;
+}
+
+void rocker_adc_get_stats(RockerAdcStats_t *stats)
+{
+    *stats = kStats;
+}
@@ -0,0 +1,59 @@
+#ifndef __ROCKER_ADC_H__
+#define __ROCKER_ADC_H__
+
+#include <stdint.h>
+
+/*
+ * 摇杆ADC连续采样：
+ * ADC1 连续模式按 ROCKER_ADC_SAMPLE_FREQ_HZ 轮流转换4个摇杆通道，结果由DMA写入驱动的缓冲，采样期间不占用CPU。
+ * 扫描任务每个周期调用 rocker_adc_read()，把缓冲中积累的新样本取出放入各通道最近 ROCKER_ADC_WINDOW 个样本的环形缓冲，
+ * 再对窗口做截尾平均（去掉最大、最小各 ROCKER_ADC_TRIM 个后取平均）作为本周期的输出：
+ * - 一次读数由多个样本平均得到，噪声比单次转换低；截尾能去掉偶发的尖峰
+ * - 窗口只覆盖最近约 ROCKER_ADC_WINDOW * 4 / 采样率（约3ms）的样本，相比扫描周期几乎不增加延迟
+ * - 采样率与扫描/发送周期无关，扫描周期变化时窗口内始终是最新的样本
+ * 输出与原 adc1_get_raw 相同（12位，0~4095，衰减12dB），原有的摇杆归一化参数不需要修改。
+ */
+
+#define ROCKER_ADC_CHANNELS         4
+#define ROCKER_ADC_SAMPLE_FREQ_HZ   20000   // 总转换速率，每个通道 1/4
+#define ROCKER_ADC_FRAME_SIZE       64      // DMA转换帧（字节），每个结果4字节；16个结果约0.8ms，1kHz扫描时每次都有新样本
+#define ROCKER_ADC_POOL_SIZE        4096    // 驱动缓冲（字节），约可存 50ms 的样本
+#define ROCKER_ADC_WINDOW           16      // 每个通道参与平均的最近样本数
+#define ROCKER_ADC_TRIM             4       // 截尾平均两端各去掉的样本数
+
+typedef struct
+{
+    uint32_t samples;       // 取出的有效样本数
+    uint32_t invalid;       // 通道/单元不符的结果
+    uint32_t overflows;     // 驱动缓冲溢出次数（扫描任务长时间没有读取）
+    uint32_t reads;         // rocker_adc_read 调用次数
+    uint32_t empty_reads;   // 没有新样本的读取次数（沿用上一次的输出）
+} RockerAdcStats_t;
+
+/**
+ * @brief 初始化并启动连续采样（通道见 hardware.h）
+ * @return 1 成功；0 失败
+ */
+uint32_t rocker_adc_init(void);
+
+/**
+ * @brief 取出新样本并输出各通道截尾平均值，不阻塞
+ * @param values 输出，顺序为 左X、左Y、右X、右Y，没有任何样本的通道保持原值
+ * @return 1 本次有新样本；0 没有新样本/未初始化
+ */
+uint32_t rocker_adc_read(int values[ROCKER_ADC_CHANNELS]);
+
+/**
+ * @brief 暂停/恢复连续采样。运行中的ADC持有APB频率锁，电源管理在空闲时暂停采样才能进入浅睡眠（power_manager.h）；
+ * 恢复后需要等约一帧（ROCKER_ADC_FRAME_SIZE）才有新样本，窗口中保留暂停前的样本
+ * @param run 1 运行；0 暂停
+ * @return 1 成功；0 失败/未初始化
+ */
+uint32_t rocker_adc_set_running(uint32_t run);
+
+/**
+ * @brief 读取采样统计
+ */
+void rocker_adc_get_stats(RockerAdcStats_t *stats);
+
+#endif
@@ -0,0 +1,96 @@
+#include <string.h>
+#include "send_scheduler.h"
+
+static const SendSchedulerConfig_t kDefaultConfig = {
+    .mode = SEND_SCHED_PERIODIC | SEND_SCHED_ON_CHANGE,
+    .period_us = SEND_SCHED_DEFAULT_PERIOD_US,
+    .min_interval_us = SEND_SCHED_DEFAULT_MIN_INTERVAL_US,
+    .stick_threshold = SEND_SCHED_DEFAULT_STICK_THRESHOLD,
+};
+
+void send_scheduler_init(SendScheduler_t *s, const SendSchedulerConfig_t *cfg)
+{
+    memset(s, 0, sizeof(*s));
+    s->cfg = cfg ? *cfg : kDefaultConfig;
+    s->last_send_us = INT64_MIN / 2;    // 第一次调用立即发送
+}
+
+void send_scheduler_default_config(SendSchedulerConfig_t *cfg)
+{
+    *cfg = kDefaultConfig;
+}
+
+void send_scheduler_set_config(SendScheduler_t *s, const SendSchedulerConfig_t *cfg)
+{
+    s->cfg = cfg ? *cfg : kDefaultConfig;
+}
+
+uint32_t send_scheduler_poll(SendScheduler_t *s, const int16_t sticks[4], uint16_t keys, int64_t now_us)
+{
+    int64_t elapsed = now_us - s->last_send_us;
+    uint32_t reason = 0;
+    s->last_reason = 0;
+    if ((s->cfg.mode & SEND_SCHED_PERIODIC) && elapsed >= s->cfg.period_us)
+        reason |= SEND_REASON_PERIOD;
+    if (s->cfg.mode & SEND_SCHED_ON_CHANGE)
+    {
+        if (keys != s->last_keys)
+            reason |= SEND_REASON_KEY;
+        for (int i = 0; i < 4; i++)
+        {
+            int32_t d = sticks[i] - s->last_sticks[i];
+            if (d > s->cfg.stick_threshold || d < -s->cfg.stick_threshold)
+            {
+                reason |= SEND_REASON_STICK;
+                break;
+            }
+        }
+    }
+    if (!reason)
+        return 0;
+    if (elapsed < s->cfg.min_interval_us)
+    {
+        if (!s->pending)
+            s->stats.deferred++;
+        s->pending = 1;
+        return 0;
+    }
+
+    s->last_reason = reason;
+    s->prev_send_us = s->last_send_us;
+    memcpy(s->prev_sticks, s->last_sticks, sizeof(s->prev_sticks));
+    s->prev_keys = s->last_keys;
+    s->prev_pending = s->pending;
+    s->last_send_us = now_us;
+    memcpy(s->last_sticks, sticks, sizeof(s->last_sticks));
+    s->last_keys = keys;
+    s->pending = 0;
+    s->stats.sent++;
+    if (reason & SEND_REASON_PERIOD)
+        s->stats.by_period++;
+    if (reason & SEND_REASON_STICK)
+        s->stats.by_stick++;
+    if (reason & SEND_REASON_KEY)
+        s->stats.by_key++;
+    return reason;
+}
+
+void send_scheduler_cancel(SendScheduler_t *s)
+{
+    uint32_t reason = s->last_reason;
+    if (!reason)
+        return;
+    s->last_reason = 0;
+    s->last_send_us = s->prev_send_us;
+    memcpy(s->last_sticks, s->prev_sticks, sizeof(s->last_sticks));
+    s->last_keys = s->prev_keys;
+    s->pending = s->prev_pending;
+    s->stats.sent--;
+    if (reason & SEND_REASON_PERIOD)
+        s->stats.by_period--;
+    if (reason & SEND_REASON_STICK)
+        s->stats.by_stick--;
+    if (reason & SEND_REASON_KEY)
+        s->stats.by_key--;
+    s->stats.canceled++;
+}
@@ -0,0 +1,92 @@
+#ifndef __SEND_SCHEDULER_H__
+#define __SEND_SCHEDULER_H__
+
+#include <stdint.h>
+
+/*
+ * 控制包发送调度：
+ * 扫描任务以高频率（core_config.h 中的 CORE_SCAN_HZ）采样和滤波，每次扫描后调用 send_scheduler_poll 决定这一次是否发送控制包：
+ * - SEND_SCHED_PERIODIC：距上次发送超过 period_us 时发送，保证接收端按固定频率收到状态（断线检测、丢包后恢复）
+ * - SEND_SCHED_ON_CHANGE：任一摇杆与上次发送的值相差超过 stick_threshold，或按键状态变化时立即发送
+ * 两者可以同时开启。无论哪种原因，两次发送至少间隔 min_interval_us，限制摇杆连续推动时占用的链路带宽；
+ * 被间隔限制推迟的变化在间隔到达后的第一次扫描发出。
+ * send_scheduler_poll 返回发送后，如果发送请求没有放入发送队列，调用 send_scheduler_cancel 撤销这次发送，
+ * 下一次扫描重新判断（不会因为一次入队失败等满一个周期）。
+ */
+
+#define SEND_SCHED_PERIODIC             (1u << 0)
+#define SEND_SCHED_ON_CHANGE            (1u << 1)
+
+#define SEND_REASON_PERIOD              (1u << 0)
+#define SEND_REASON_STICK               (1u << 1)
+#define SEND_REASON_KEY                 (1u << 2)
+
+#define SEND_SCHED_DEFAULT_PERIOD_US        20000   // 50Hz，与原来的固定发送频率相同
+#define SEND_SCHED_DEFAULT_MIN_INTERVAL_US  5000    // 变化触发时最高200Hz
+#define SEND_SCHED_DEFAULT_STICK_THRESHOLD  328     // 满量程的1%（Q15）
+
+typedef struct
+{
+    uint32_t mode;              // SEND_SCHED_*
+    uint32_t period_us;         // 周期发送间隔
+    uint32_t min_interval_us;   // 两次发送的最小间隔
+    int32_t stick_threshold;    // 摇杆变化阈值（Q15）
+} SendSchedulerConfig_t;
+
+typedef struct
+{
+    uint32_t sent;              // 发送次数
+    uint32_t by_period;         // 其中周期到达的次数
+    uint32_t by_stick;          // 摇杆变化触发的次数
+    uint32_t by_key;            // 按键变化触发的次数
+    uint32_t deferred;          // 变化被最小间隔推迟的次数
+    uint32_t canceled;          // 入队失败被撤销的发送次数（不计入以上各项）
+} SendSchedulerStats_t;
+
+typedef struct
+{
+    SendSchedulerConfig_t cfg;
+    int64_t last_send_us;
+    int16_t last_sticks[4];
+    uint16_t last_keys;
+    uint8_t pending;            // 有被推迟的变化
+    SendSchedulerStats_t stats;
+    // 上一次 send_scheduler_poll 返回发送之前的状态，send_scheduler_cancel 恢复
+    uint32_t last_reason;       // 0 表示没有可以撤销的发送
+    int64_t prev_send_us;
+    int16_t prev_sticks[4];
+    uint16_t prev_keys;
+    uint8_t prev_pending;
+} SendScheduler_t;
+
+/**
+ * @brief 初始化调度器
+ * @param cfg 配置，NULL 使用默认配置（周期+变化触发）
+ */
+void send_scheduler_init(SendScheduler_t *s, const SendSchedulerConfig_t *cfg);
+
+/**
+ * @brief 读取默认配置（周期+变化触发）
+ */
+void send_scheduler_default_config(SendSchedulerConfig_t *cfg);
+
+/**
+ * @brief 修改配置，已发送的状态和统计不变
+ */
+void send_scheduler_set_config(SendScheduler_t *s, const SendSchedulerConfig_t *cfg);
+
+/**
+ * @brief 每次扫描后调用，判断是否需要发送；返回非0时调用者应立即发送，调度器同时记录这次发送的状态
+ * @param sticks 滤波后的摇杆值（Q15）
+ * @param keys 按键状态
+ * @param now_us 当前时间（微秒）
+ * @return 0 不发送；否则为发送原因 SEND_REASON_* 的组合
+ */
+uint32_t send_scheduler_poll(SendScheduler_t *s, const int16_t sticks[4], uint16_t keys, int64_t now_us);
+
+/**
+ * @brief 撤销上一次 send_scheduler_poll 记录的发送（发送请求入队失败时调用），恢复上次发送的状态和统计
+ */
+void send_scheduler_cancel(SendScheduler_t *s);
+
+#endif
@@ -0,0 +1,304 @@
+#include <string.h>
+#include <stdatomic.h>
+#include "stick_calib.h"
+#include "stick_filter.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "nvs.h"
+#include "esp_log.h"
+
+#define STICK_CALIB_NVS_KEY         "axes"
+#define STICK_CALIB_VERSION         1
+
+static const char *TAG = "stick_calib";
+
+typedef struct
+{
+    uint16_t version;
+    StickAxisCalib_t axes[STICK_CALIB_AXES];
+} StickCalibBlob_t;
+
+typedef struct
+{
+    uint32_t phase;
+    uint32_t center_samples;
+    int32_t center_sum[STICK_CALIB_AXES];
+    int16_t center_min[STICK_CALIB_AXES];   // 中心采集期间的波动范围（静止噪声）
+    int16_t center_max[STICK_CALIB_AXES];
+    int16_t center[STICK_CALIB_AXES];
+    int16_t min[STICK_CALIB_AXES];
+    int16_t max[STICK_CALIB_AXES];
+} StickCalibRun_t;
+
+// 默认参数：原 NormalizationRocker 的零点修正和死区，行程按中心±2047计
+static const int16_t kDefaultOffset[STICK_CALIB_AXES] = {-20, -90, 100, -10};
+
+static StickAxisCalib_t kAxes[STICK_CALIB_AXES];
+// 查找表双缓冲：新表生成在另一份中，生成完再切换指针，扫描任务不加锁也不会读到生成了一半的表
+typedef int16_t StickCalibLut_t[STICK_CALIB_AXES][STICK_CALIB_LUT_SIZE];
+static StickCalibLut_t kLutBank[2];
+static _Atomic(StickCalibLut_t *) kLut = &kLutBank[0];
+static StickCalibRun_t kRun;
+static SemaphoreHandle_t calib_mutex;
+
+static void calib_lock(void)
+{
+    xSemaphoreTake(calib_mutex, portMAX_DELAY);
+}
+
+static void calib_unlock(void)
+{
+    xSemaphoreGive(calib_mutex);
+}
+
+static void calib_set_default(void)
+{
+    for (int i = 0; i < STICK_CALIB_AXES; i++)
+    {
+        int16_t center = (int16_t)(STICK_ADC_CENTER - kDefaultOffset[i]);
+        kAxes[i] = (StickAxisCalib_t){
+            .min = (int16_t)(center - STICK_ADC_CENTER),
+            .center = center,
+            .max = (int16_t)(center + STICK_ADC_CENTER),
+            .deadzone = 80,
+            .edge = 80,
+        };
+    }
+}
+
+static uint32_t calib_axis_valid(const StickAxisCalib_t *a)
+{
+    return a->min + a->edge < a->center - a->deadzone && a->center + a->deadzone < a->max - a->edge;
+}
+
+// 生成一个轴的查找表：死区内为0，死区外按该方向的行程拉伸到满量程
+static void calib_build_axis(int16_t *lut, int axis)
+{
+    const StickAxisCalib_t *a = &kAxes[axis];
+    int32_t span_pos = a->max - a->edge - a->center - a->deadzone;
+    int32_t span_neg = a->center - a->deadzone - (a->min + a->edge);
+    for (int32_t raw = 0; raw < STICK_CALIB_LUT_SIZE; raw++)
+    {
+        int32_t d = raw - a->center;
+        int32_t out = 0;
+        if (d > a->deadzone)
+            out = (d - a->deadzone) * STICK_Q15_ONE / span_pos;
+        else if (d < -a->deadzone)
+            out = (d + a->deadzone) * STICK_Q15_ONE / span_neg;
+        lut[raw] = (int16_t)stick_q15_clamp(out);
+    }
+}
+
+// 按 kAxes 在当前没有使用的一份中生成全部查找表后切换过去，调用时持有 calib_mutex
+static void calib_build_lut(void)
+{
+    StickCalibLut_t *cur = atomic_load_explicit(&kLut, memory_order_relaxed);
+    StickCalibLut_t *next = cur == &kLutBank[0] ? &kLutBank[1] : &kLutBank[0];
+    for (int i = 0; i < STICK_CALIB_AXES; i++)
+        calib_build_axis((*next)[i], i);
+    atomic_store_explicit(&kLut, next, memory_order_release);
+}
+
+static uint32_t calib_load(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(STICK_CALIB_NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK)
+        return 0;
+    StickCalibBlob_t blob;
+    size_t size = sizeof(blob);
+    esp_err_t err = nvs_get_blob(nvs, STICK_CALIB_NVS_KEY, &blob, &size);
+    nvs_close(nvs);
+    if (err != ESP_OK || size != sizeof(blob) || blob.version != STICK_CALIB_VERSION)
+        return 0;
+    for (int i = 0; i < STICK_CALIB_AXES; i++)
+    {
+        if (!calib_axis_valid(&blob.axes[i]))
+            return 0;
+    }
+    memcpy(kAxes, blob.axes, sizeof(kAxes));
+    return 1;
+}
+
+static uint32_t calib_save(const StickAxisCalib_t *axes)
+{
+    StickCalibBlob_t blob = {.version = STICK_CALIB_VERSION};
+    memcpy(blob.axes, axes, sizeof(blob.axes));
+    nvs_handle_t nvs;
+    esp_err_t err = nvs_open(STICK_CALIB_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err == ESP_OK)
+    {
+        err = nvs_set_blob(nvs, STICK_CALIB_NVS_KEY, &blob, sizeof(blob));
+        if (err == ESP_OK)
+            err = nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    if (err != ESP_OK)
+        ESP_LOGE(TAG, "save: %s", esp_err_to_name(err));
+    return err == ESP_OK;
+}
+
+uint32_t stick_calib_init(void)
+{
+    if (!calib_mutex)
+        calib_mutex = xSemaphoreCreateMutex();
+    calib_lock();
+    uint32_t loaded = calib_load();
+    if (!loaded)
+        calib_set_default();
+    calib_build_lut();
+    calib_unlock();
+    ESP_LOGI(TAG, "%s", loaded ? "calibration loaded" : "no calibration, using defaults");
+    return loaded;
+}
+
+const int16_t *stick_calib_lut(uint8_t axis)
+{
+    return (*atomic_load_explicit(&kLut, memory_order_acquire))[axis < STICK_CALIB_AXES ? axis : 0];
+}
+
+void stick_calib_begin(void)
+{
+    calib_lock();
+    memset(&kRun, 0, sizeof(kRun));
+    for (int i = 0; i < STICK_CALIB_AXES; i++)
+    {
+        kRun.center_min[i] = INT16_MAX;
+        kRun.center_max[i] = INT16_MIN;
+    }
+    kRun.phase = STICK_CALIB_CENTER;
+    calib_unlock();
+}
+
+void stick_calib_feed(const int raw[STICK_CALIB_AXES])
+{
+    if (kRun.phase == STICK_CALIB_IDLE)
+        return;
+    calib_lock();
+    if (kRun.phase == STICK_CALIB_CENTER)
+    {
+        for (int i = 0; i < STICK_CALIB_AXES; i++)
+        {
+            kRun.center_sum[i] += raw[i];
+            if (raw[i] < kRun.center_min[i])
+                kRun.center_min[i] = (int16_t)raw[i];
+            if (raw[i] > kRun.center_max[i])
+                kRun.center_max[i] = (int16_t)raw[i];
+        }
+        if (++kRun.center_samples >= STICK_CALIB_CENTER_SAMPLES)
+        {
+            for (int i = 0; i < STICK_CALIB_AXES; i++)
+            {
+                kRun.center[i] = (int16_t)((kRun.center_sum[i] + (int32_t)kRun.center_samples / 2) / (int32_t)kRun.center_samples);
+                kRun.min[i] = kRun.max[i] = kRun.center[i];
+            }
+            kRun.phase = STICK_CALIB_RANGE;
+        }
+    }
+    else if (kRun.phase == STICK_CALIB_RANGE)
+    {
+        for (int i = 0; i < STICK_CALIB_AXES; i++)
+        {
+            if (raw[i] < kRun.min[i])
+                kRun.min[i] = (int16_t)raw[i];
+            if (raw[i] > kRun.max[i])
+                kRun.max[i] = (int16_t)raw[i];
+        }
+    }
+    calib_unlock();
+}
+
+uint32_t stick_calib_finish(uint32_t *bad_axes)
+{
+    StickAxisCalib_t axes[STICK_CALIB_AXES];
+    uint32_t bad = 0;
+    calib_lock();
+    if (kRun.phase != STICK_CALIB_RANGE)
+    {
+        calib_unlock();
+        if (bad_axes)
+            *bad_axes = 0;
+        return 0;
+    }
+    for (int i = 0; i < STICK_CALIB_AXES; i++)
+    {
+        int32_t noise = kRun.center_max[i] - kRun.center_min[i];
+        int32_t deadzone = noise * 2 > STICK_CALIB_MIN_DEADZONE ? noise * 2 : STICK_CALIB_MIN_DEADZONE;
+        int32_t travel_pos = kRun.max[i] - kRun.center[i];
+        int32_t travel_neg = kRun.center[i] - kRun.min[i];
+        int32_t travel = travel_pos < travel_neg ? travel_pos : travel_neg;
+        axes[i] = (StickAxisCalib_t){
+            .min = kRun.min[i],
+            .center = kRun.center[i],
+            .max = kRun.max[i],
+            .deadzone = (uint16_t)deadzone,
+            .edge = (uint16_t)(travel * STICK_CALIB_EDGE_PERCENT / 100),
+        };
+        if (travel < STICK_CALIB_MIN_TRAVEL || !calib_axis_valid(&axes[i]))
+            bad |= 1u << i;
+    }
+    if (bad)
+    {
+        calib_unlock();
+        if (bad_axes)
+            *bad_axes = bad;
+        return 0;
+    }
+    kRun.phase = STICK_CALIB_IDLE;  // 停止采集，写NVS期间扫描任务不必等锁
+    calib_unlock();
+
+    if (bad_axes)
+        *bad_axes = 0;
+    if (!calib_save(axes))
+    {
+        calib_lock();
+        kRun.phase = STICK_CALIB_RANGE;     // 保存失败，可以继续采集后重试
+        calib_unlock();
+        return 0;
+    }
+    calib_lock();
+    memcpy(kAxes, axes, sizeof(kAxes));
+    calib_build_lut();
+    calib_unlock();
+    return 1;
+}
+
+void stick_calib_cancel(void)
+{
+    calib_lock();
+    kRun.phase = STICK_CALIB_IDLE;
+    calib_unlock();
+}
+
+void stick_calib_reset_default(void)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(STICK_CALIB_NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK)
+    {
+        nvs_erase_key(nvs, STICK_CALIB_NVS_KEY);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    calib_lock();
+    kRun.phase = STICK_CALIB_IDLE;
+    calib_set_default();
+    calib_build_lut();
+    calib_unlock();
+}
+
+void stick_calib_get_progress(StickCalibProgress_t *progress)
+{
+    calib_lock();
+    progress->phase = kRun.phase;
+    progress->center_samples = kRun.center_samples;
+    memcpy(progress->min, kRun.min, sizeof(progress->min));
+    memcpy(progress->max, kRun.max, sizeof(progress->max));
+    memcpy(progress->center, kRun.center, sizeof(progress->center));
+    calib_unlock();
+}
+
+void stick_calib_get(StickAxisCalib_t axes[STICK_CALIB_AXES])
+{
+    calib_lock();
+    memcpy(axes, kAxes, sizeof(kAxes));
+    calib_unlock();
+}
@@ -0,0 +1,113 @@
+#ifndef __STICK_CALIB_H__
+#define __STICK_CALIB_H__
+
+#include <stdint.h>
+
+/*
+ * 摇杆校准：
+ * 每个轴记录中心、最小、最大值和中心死区，保存在NVS中，上电时读出并生成 4096 项的查找表（ADC原始值 -> Q15），
+ * 之后摇杆归一化只需要一次查表：中心死区内为0，死区外按该方向的实际行程线性拉伸到满量程，
+ * 两端各留出 STICK_CALIB_EDGE_PERCENT 的边缘死区，保证推到底时一定能输出满量程。
+ * NVS中没有校准数据时使用原来的固定参数（零点修正 -20/-90/100/-10、死区80），与校准前的行为一致。
+ *
+ * 校准流程（由校准页面驱动，扫描任务每个周期调用 stick_calib_feed 送入ADC原始值）：
+ * 1. stick_calib_begin：松开摇杆，采集 STICK_CALIB_CENTER_SAMPLES 个样本，得到中心和静止时的噪声，
+ *    死区取噪声峰峰值的两倍（不小于 STICK_CALIB_MIN_DEADZONE）
+ * 2. 中心采集完成后自动进入行程采集：把每个摇杆推到各个方向的极限（转几圈），记录最小/最大值
+ * 3. stick_calib_finish：检查每个方向的行程不少于 STICK_CALIB_MIN_TRAVEL，保存到NVS并重新生成查找表
+ * 查找表有两份，新表在另一份中生成完成后再切换指针，读的一方不需要加锁。
+ */
+
+#define STICK_CALIB_AXES                4
+#define STICK_CALIB_LUT_SIZE            4096    // 12位ADC
+#define STICK_CALIB_CENTER_SAMPLES      1000    // 中心采样数（1kHz扫描约1秒）
+#define STICK_CALIB_MIN_DEADZONE        40      // 最小中心死区（ADC原始值单位）
+#define STICK_CALIB_MIN_TRAVEL          600     // 每个方向的最小行程，不足时校准失败
+#define STICK_CALIB_EDGE_PERCENT        3       // 边缘死区，占该方向行程的百分比
+#define STICK_CALIB_NVS_NAMESPACE       "stick_calib"
+
+typedef struct
+{
+    int16_t min;
+    int16_t center;
+    int16_t max;
+    uint16_t deadzone;      // 中心死区
+    uint16_t edge;          // 边缘死区
+} StickAxisCalib_t;
+
+typedef enum
+{
+    STICK_CALIB_IDLE = 0,
+    STICK_CALIB_CENTER,     // 采集中心，摇杆保持松开
+    STICK_CALIB_RANGE,      // 采集行程，把摇杆推到各个方向的极限
+} StickCalibPhase_t;
+
+typedef struct
+{
+    uint32_t phase;                                 // StickCalibPhase_t
+    uint32_t center_samples;                        // 已采集的中心样本数
+    int16_t min[STICK_CALIB_AXES];                  // 行程采集中到目前为止的最小/最大值
+    int16_t max[STICK_CALIB_AXES];
+    int16_t center[STICK_CALIB_AXES];               // 中心采集完成后的中心值
+} StickCalibProgress_t;
+
+/**
+ * @brief 创建互斥锁，从NVS读取校准数据（没有则使用默认参数）并生成查找表，需要先调用 nvs_flash_init
+ *        由 RemoteCoreInit 在创建扫描任务之前调用
+ * @return 1 使用NVS中的校准数据；0 使用默认参数
+ */
+uint32_t stick_calib_init(void);
+
+/**
+ * @brief 获取某个轴当前的查找表，下标为ADC原始值（0~4095），内容为 Q15
+ *        校准完成/恢复默认后会切换到另一份表，旧表在下一次重新生成时被改写，
+ *        因此不要缓存返回的指针，每次查表前重新获取（扫描任务每个周期获取一次）
+ */
+const int16_t *stick_calib_lut(uint8_t axis);
+
+/**
+ * @brief 查表归一化（超出范围的原始值按端点处理）
+ */
+static inline int16_t stick_calib_lookup(const int16_t *lut, int raw)
+{
+    return lut[(unsigned)raw < STICK_CALIB_LUT_SIZE ? raw : (raw < 0 ? 0 : STICK_CALIB_LUT_SIZE - 1)];
+}
+
+/**
+ * @brief 开始校准（进入中心采集）
+ */
+void stick_calib_begin(void);
+
+/**
+ * @brief 扫描任务送入本周期的ADC原始值，不在校准时直接返回
+ */
+void stick_calib_feed(const int raw[STICK_CALIB_AXES]);
+
+/**
+ * @brief 结束行程采集，检查并保存校准结果
+ * @param bad_axes 校准失败时置位行程不足的轴（bit0~3），可为NULL
+ * @return 1 成功，已保存并生成查找表；0 不在行程采集阶段/行程不足/保存失败（校准数据不变）
+ */
+uint32_t stick_calib_finish(uint32_t *bad_axes);
+
+/**
+ * @brief 放弃本次校准
+ */
+void stick_calib_cancel(void);
+
+/**
+ * @brief 恢复默认参数并删除NVS中的校准数据
+ */
+void stick_calib_reset_default(void);
+
+/**
+ * @brief 读取校准进度（校准页面显示用）
+ */
+void stick_calib_get_progress(StickCalibProgress_t *progress);
+
+/**
+ * @brief 读取当前使用的校准参数
+ */
+void stick_calib_get(StickAxisCalib_t axes[STICK_CALIB_AXES]);
+
+#endif
@@ -0,0 +1,69 @@
+#include <math.h>
+#include "stick_filter.h"
+
+#define STICK_PI    3.14159265f
+
+// 一阶低通 y += alpha(x - y) 在截止频率 fc 下的系数（Q15）
+static int32_t stick_alpha_q15(float fc, float fs)
+{
+    if (fc <= 0 || fs <= 0)
+        return STICK_Q15_ONE;
+    float w = 2 * STICK_PI * fc / fs;
+    return (int32_t)lroundf(w / (1 + w) * STICK_Q15_ONE);
+}
+
+void stick_filter_init(StickFilter_t *f, const StickFilterConfig_t *cfg)
+{
+    float fs = cfg->sample_hz > 0 ? cfg->sample_hz : 50;
+    f->stages = cfg->stages;
+    f->offset = cfg->offset;
+    f->center_gain = (int32_t)lroundf((float)STICK_Q15_ONE / STICK_ADC_CENTER * 4096);
+
+    // 死区换算成 Q15，两端死区合计不超过量程的 15/16（增益不超过16，乘积不溢出）
+    int32_t dz_in = (int32_t)cfg->deadzone * STICK_Q15_ONE / STICK_ADC_CENTER;
+    int32_t dz_out = (int32_t)cfg->outer_deadzone * STICK_Q15_ONE / STICK_ADC_CENTER;
+    if (dz_in + dz_out > STICK_Q15_ONE * 15 / 16)
+    {
+        dz_in = dz_in * (STICK_Q15_ONE * 15 / 16) / (dz_in + dz_out);
+        dz_out = STICK_Q15_ONE * 15 / 16 - dz_in;
+    }
+    f->dz_in = dz_in;
+    f->dz_gain = (int32_t)lroundf((float)STICK_Q15_ONE / (STICK_Q15_ONE - dz_in - dz_out) * 4096);
+
+    float expo = cfg->expo < 0 ? 0 : (cfg->expo > 1 ? 1 : cfg->expo);
+    f->expo = (int32_t)lroundf(expo * STICK_Q15_ONE);
+    f->iir_alpha = stick_alpha_q15(cfg->lowpass_hz, fs);
+    f->euro_w_min = (int32_t)lroundf(2 * STICK_PI * cfg->euro_min_hz / fs * 65536);
+    // 速度按每采样变化量计（满量程/秒 = 每采样变化量 * fs），fc/fs 中的 fs 正好约去
+    f->euro_beta = (int32_t)lroundf(2 * STICK_PI * cfg->euro_beta * 65536);
+    f->euro_d_alpha = stick_alpha_q15(cfg->euro_d_hz, fs);
+    f->rate_step = cfg->rate_limit > 0 ? (int32_t)lroundf(cfg->rate_limit * STICK_Q15_ONE / fs) : 2 * STICK_Q15_ONE;
+    if (f->rate_step < 1)
+        f->rate_step = 1;
+    stick_filter_reset(f);
+}
+
+void stick_filter_reset(StickFilter_t *f)
+{
+    f->iir_acc = 0;
+    f->euro_dx = 0;
+    f->euro_prev = 0;
+    f->euro_acc = 0;
+    f->rate_y = 0;
+}
+
+int16_t stick_filter_run(StickFilter_t *f, int raw)
+{
+    int32_t x = stick_stage_center(f, raw);
+    if (f->stages & STICK_STAGE_DEADZONE)
+        x = stick_stage_deadzone(f, x);
+    if (f->stages & STICK_STAGE_EXPO)
+        x = stick_stage_expo(f, x);
+    if (f->stages & STICK_STAGE_IIR)
+        x = stick_stage_iir(f, x);
+    if (f->stages & STICK_STAGE_EURO)
+        x = stick_stage_euro(f, x);
+    if (f->stages & STICK_STAGE_RATE)
+        x = stick_stage_rate(f, x);
+    return (int16_t)x;
+}
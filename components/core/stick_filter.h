@@ -0,0 +1,185 @@
+#ifndef __STICK_FILTER_H__
+#define __STICK_FILTER_H__
+
+#include <stdint.h>
+
+/*
+ * 摇杆定点滤波链（每个轴一个 StickFilter_t）：
+ * ADC原始值（0~4095）先按零点修正换算成 Q15（-32767~32767 对应 -1~1），再依次经过选中的处理级：
+ * - deadzone：中心死区和边缘死区，死区外重新拉伸到满量程（与原 NormalizationRocker 的效果相同）
+ * - expo：指数曲线 y = x + k(x^3 - x)，k=0 为线性，越大中心附近越细腻
+ * - iir：一阶低通，固定截止频率
+ * - euro：One Euro 自适应低通，静止时截止频率低（去抖），快速推杆时截止频率随速度升高（不拖延）
+ * - rate：变化率限制，每个采样最多变化 rate_limit / sample_hz
+ * 参数只在 stick_filter_init 中用浮点换算一次，处理过程全部是整数运算，不占用FPU。
+ *
+ * 处理级有两种组合方式：
+ * - 编译期：用 STICK_FILTER_DEFINE_CHAIN 定义只包含指定处理级的函数，各级内联展开，没有分支和函数指针，例如
+ *     #define MY_CHAIN(S) S(deadzone) S(expo) S(euro)
+ *     STICK_FILTER_DEFINE_CHAIN(my_stick_chain, MY_CHAIN)
+ *   之后 my_stick_chain(&filter, adc_raw) 返回 Q15 结果
+ * - 运行时：stick_filter_run 按 StickFilterConfig_t.stages 中置位的处理级依次执行（顺序固定为上面列出的顺序），
+ *   便于在设置界面中切换
+ * 两种方式共用 stick_filter_init 换算出的参数和滤波状态。
+ * 遥控器上ADC -> Q15 的换算和死区由校准查找表（stick_calib.h）完成，之后的处理级用 STICK_FILTER_DEFINE_Q15_CHAIN。
+ */
+
+#define STICK_Q15_ONE               32767
+#define STICK_ADC_CENTER            0x7FF       // ADC中心值 2047
+
+#define STICK_STAGE_DEADZONE        (1u << 0)
+#define STICK_STAGE_EXPO            (1u << 1)
+#define STICK_STAGE_IIR             (1u << 2)
+#define STICK_STAGE_EURO            (1u << 3)
+#define STICK_STAGE_RATE            (1u << 4)
+
+typedef struct
+{
+    uint32_t stages;            // stick_filter_run 使用的处理级（STICK_STAGE_*）
+    float sample_hz;            // 采样（调用）频率
+    int16_t offset;             // ADC零点修正，加到原始值上
+    uint16_t deadzone;          // 中心死区（ADC原始值单位）
+    uint16_t outer_deadzone;    // 边缘死区（ADC原始值单位），到达后输出满量程
+    float expo;                 // 指数曲线系数 0~1
+    float lowpass_hz;           // iir 截止频率
+    float euro_min_hz;          // euro 静止时的截止频率
+    float euro_beta;            // euro 截止频率随速度（满量程/秒）增加的系数
+    float euro_d_hz;            // euro 速度估计的低通截止频率
+    float rate_limit;           // rate 最大变化率（满量程/秒）
+} StickFilterConfig_t;
+
+typedef struct
+{
+    uint32_t stages;
+    int32_t offset;
+    int32_t center_gain;        // ADC -> Q15 增益（Q12，乘积不超过32位）
+    int32_t dz_in;              // 中心死区（Q15）
+    int32_t dz_gain;            // 死区外拉伸增益（Q12）
+    int32_t expo;               // Q15
+    int32_t iir_alpha;          // Q15
+    int32_t iir_acc;            // 低通状态（Q23，比输出多8位小数）
+    int32_t euro_w_min;         // 2*pi*fmin/fs（Q16）
+    int32_t euro_beta;          // 2*pi*beta（Q16）
+    int32_t euro_d_alpha;       // 速度低通系数（Q15）
+    int32_t euro_dx;            // 低通后的每采样变化量（Q23，1kHz时每采样变化量只有几十个Q15 LSB）
+    int32_t euro_prev;          // 上一次输入（Q15）
+    int32_t euro_acc;           // 低通状态（Q23）
+    int32_t rate_step;          // 每采样最大变化量（Q15）
+    int32_t rate_y;             // 上一次输出（Q15）
+} StickFilter_t;
+
+/**
+ * @brief 按配置换算定点参数并清零滤波状态（摇杆回中为初始状态）
+ */
+void stick_filter_init(StickFilter_t *f, const StickFilterConfig_t *cfg);
+
+/**
+ * @brief 清零滤波状态，参数不变
+ */
+void stick_filter_reset(StickFilter_t *f);
+
+/**
+ * @brief 运行时组合：执行 cfg.stages 中置位的处理级
+ * @param raw ADC原始值
+ * @return Q15 结果
+ */
+int16_t stick_filter_run(StickFilter_t *f, int raw);
+
+/**
+ * @brief Q15 转换为 -1~1 的浮点数（填写 PackControl_t 时使用）
+ */
+static inline float stick_q15_to_float(int32_t x)
+{
+    return (float)x * (1.0f / STICK_Q15_ONE);
+}
+
+/* -------------------- 处理级（内联，供滤波链展开） -------------------- */
+static inline int32_t stick_q15_clamp(int32_t x)
+{
+    return x > STICK_Q15_ONE ? STICK_Q15_ONE : (x < -STICK_Q15_ONE ? -STICK_Q15_ONE : x);
+}
+
+// ADC原始值 -> Q15
+static inline int32_t stick_stage_center(const StickFilter_t *f, int raw)
+{
+    int32_t v = raw + f->offset - STICK_ADC_CENTER;
+    return stick_q15_clamp((v * f->center_gain) >> 12);
+}
+
+static inline int32_t stick_stage_deadzone(StickFilter_t *f, int32_t x)
+{
+    if (x > f->dz_in)
+        return stick_q15_clamp(((x - f->dz_in) * f->dz_gain) >> 12);
+    if (x < -f->dz_in)
+        return stick_q15_clamp(((x + f->dz_in) * f->dz_gain) >> 12);
+    return 0;
+}
+
+static inline int32_t stick_stage_expo(StickFilter_t *f, int32_t x)
+{
+    int32_t x3 = (((x * x) >> 15) * x) >> 15;
+    return x + (((x3 - x) * f->expo) >> 15);
+}
+
+// acc += alpha * (x - acc)，状态多保留8位小数，截止频率很低时不会卡在离目标几个LSB的地方
+// x可能为负，左移负数是未定义行为，这里用乘法（编译器同样生成移位指令）
+static inline int32_t stick_lowpass_q23(int32_t *acc, int32_t alpha, int32_t x)
+{
+    *acc += (int32_t)(((int64_t)alpha * (x * 256 - *acc)) >> 15);
+    return (*acc + 128) >> 8;
+}
+
+static inline int32_t stick_stage_iir(StickFilter_t *f, int32_t x)
+{
+    return stick_lowpass_q23(&f->iir_acc, f->iir_alpha, x);
+}
+
+static inline int32_t stick_stage_euro(StickFilter_t *f, int32_t x)
+{
+    int32_t d = stick_q15_clamp(x - f->euro_prev);
+    f->euro_prev = x;
+    stick_lowpass_q23(&f->euro_dx, f->euro_d_alpha, d);
+    int32_t speed = f->euro_dx < 0 ? -f->euro_dx : f->euro_dx;
+    // w = 2*pi*fc/fs，alpha = w / (1 + w)
+    int32_t w = f->euro_w_min + (int32_t)(((int64_t)f->euro_beta * speed) >> 23);
+    int32_t alpha = (int32_t)(((int64_t)w << 15) / (65536 + w));
+    return stick_lowpass_q23(&f->euro_acc, alpha, x);
+}
+
+static inline int32_t stick_stage_rate(StickFilter_t *f, int32_t x)
+{
+    int32_t delta = x - f->rate_y;
+    if (delta > f->rate_step)
+        delta = f->rate_step;
+    else if (delta < -f->rate_step)
+        delta = -f->rate_step;
+    f->rate_y += delta;
+    return f->rate_y;
+}
+
+#define STICK_FILTER_APPLY_STAGE(stage) x = stick_stage_##stage(f, x);
+
+/**
+ * @brief 定义编译期滤波链 int16_t name(StickFilter_t *f, int raw)
+ * @param LIST 形如 #define LIST(S) S(deadzone) S(iir) 的处理级列表
+ */
+#define STICK_FILTER_DEFINE_CHAIN(name, LIST)                   \
+    static inline int16_t name(StickFilter_t *f, int raw)       \
+    {                                                           \
+        int32_t x = stick_stage_center(f, raw);                 \
+        LIST(STICK_FILTER_APPLY_STAGE)                          \
+        return (int16_t)x;                                      \
+    }
+
+/**
+ * @brief 定义输入已经是 Q15 的编译期滤波链 int16_t name(StickFilter_t *f, int32_t x)，
+ * 用于归一化已由其它方式完成的情况（例如 stick_calib 的查找表），列表中一般不再包含 deadzone
+ */
+#define STICK_FILTER_DEFINE_Q15_CHAIN(name, LIST)               \
+    static inline int16_t name(StickFilter_t *f, int32_t x)     \
+    {                                                           \
+        LIST(STICK_FILTER_APPLY_STAGE)                          \
+        return (int16_t)x;                                      \
+    }
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef __TASK_CONFIG_H__
+#define __TASK_CONFIG_H__
+
+/*
+ * 任务配置表：所有任务的名称、栈大小、优先级和绑定的核集中在这里，创建任务统一用 TASK_CREATE。
+ * 核分配：
+ *   实时核（1）：按键/摇杆扫描任务和 comm 的收发/ACK任务，扫描任务优先级最高，其它任务不能让1ms扫描周期漂移
+ *   界面核（0）：LVGL刷新任务、OTA任务和输入录制任务，与 main 任务、esp_timer 任务、SD卡等同核
+ * 两个核上的任务互不抢占，LVGL渲染（一次刷新可能持续数毫秒）不再影响扫描和发送。
+ * 优先级只在同核任务之间起作用，这里仍保持界面任务低于实时任务，便于不绑核的平台（模拟器、STM32）使用同一张表。
+ * 运行时用 task_monitor 检查每个核的负载和扫描循环的调度抖动。
+ *
+ * 只有宏定义，不依赖ESP-IDF，comm.c 在模拟器和STM32上编译时也包含这个头文件。
+ */
+
+#define TASK_CORE_REALTIME      1
+#define TASK_CORE_UI            0
+
+// 栈大小单位与 xTaskCreate 相同（ESP-IDF 为字节）
+#define TASK_SCAN_NAME          "CoreTask"
+#define TASK_SCAN_STACK         4096
+#define TASK_SCAN_PRIO          10
+#define TASK_SCAN_CORE          TASK_CORE_REALTIME
+
+#define TASK_COMM_RECV_NAME     "uartRecvTask"
+#define TASK_COMM_RECV_STACK    2048
+#define TASK_COMM_RECV_PRIO     9       // 及时取走串口驱动缓冲中的数据，高于发送
+#define TASK_COMM_RECV_CORE     TASK_CORE_REALTIME
+
+#define TASK_COMM_SEND_NAME     "uartSendTask"
+#define TASK_COMM_SEND_STACK    2048
+#define TASK_COMM_SEND_PRIO     8
+#define TASK_COMM_SEND_CORE     TASK_CORE_REALTIME
+
+#define TASK_COMM_ACK_NAME      "uartackTask"
+#define TASK_COMM_ACK_STACK     2048
+#define TASK_COMM_ACK_PRIO      6
+#define TASK_COMM_ACK_CORE      TASK_CORE_REALTIME
+
+#define TASK_LVGL_NAME          "lvgl_fresh"
+#define TASK_LVGL_STACK         (4096 * 2)
+#define TASK_LVGL_PRIO          4
+#define TASK_LVGL_CORE          TASK_CORE_UI
+
+#define TASK_COMM_OTA_NAME      "commOtaTask"
+#define TASK_COMM_OTA_STACK     4096
+#define TASK_COMM_OTA_PRIO      3       // 批量传输和写flash，不与界面抢时间
+#define TASK_COMM_OTA_CORE      TASK_CORE_UI
+
+#define TASK_INPUT_RECORD_NAME  "inputRecTask"
+#define TASK_INPUT_RECORD_STACK 4096
+#define TASK_INPUT_RECORD_PRIO  2       // 输入录制/回放的SD卡读写，缓冲可容纳约0.5s的停顿
+#define TASK_INPUT_RECORD_CORE  TASK_CORE_UI
+
+/**
+ * @brief 按配置表创建任务，返回值同 xTaskCreate
+ * @param id 配置表中的任务名前缀，如 TASK_SCAN
+ */
+#if defined(ESP_PLATFORM) && !defined(CONFIG_IDF_TARGET_LINUX)
+#define TASK_CREATE(id, fn, param, handle) \
+    xTaskCreatePinnedToCore(fn, id##_NAME, id##_STACK, param, id##_PRIO, handle, id##_CORE)
+#else
+#define TASK_CREATE(id, fn, param, handle) \
+    xTaskCreate(fn, id##_NAME, id##_STACK, param, id##_PRIO, handle)
+#endif
+
+#endif
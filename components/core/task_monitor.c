@@ -0,0 +1,136 @@
+#include <string.h>
+#include "task_monitor.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+void task_loop_monitor_init(TaskLoopMonitor_t *m, uint32_t period_us)
+{
+    memset(m, 0, sizeof(*m));
+    m->period_us = period_us;
+}
+
+void task_loop_monitor_set_period(TaskLoopMonitor_t *m, uint32_t period_us)
+{
+    m->period_us = period_us;
+    m->last_wake_us = 0;
+}
+
+void task_loop_monitor_wake(TaskLoopMonitor_t *m, int64_t now_us)
+{
+    if (m->reset)
+    {
+        m->reset = 0;
+        memset(&m->stats, 0, sizeof(m->stats));
+    }
+    m->wake_us = now_us;
+    int64_t last = m->last_wake_us;
+    m->last_wake_us = now_us;
+    if (!last)
+        return;
+
+    TaskLoopStats_t *s = &m->stats;
+    int64_t interval = now_us - last;
+    if (interval >= 2 * (int64_t)m->period_us)
+    {
+        // 漏掉了周期（vTaskDelayUntil 会立即返回补齐），不计入抖动
+        s->overruns++;
+        return;
+    }
+    int64_t diff = interval - m->period_us;
+    uint32_t jitter = (uint32_t)(diff < 0 ? -diff : diff);
+    uint32_t bin = 0;
+    while (bin < TASK_MONITOR_JITTER_BINS - 1 && jitter >= (4u << bin))
+        bin++;
+    s->bins[bin]++;
+    s->count++;
+    s->jitter_sum_us += jitter;
+    if (jitter > s->jitter_max_us)
+        s->jitter_max_us = jitter;
+}
+
+void task_loop_monitor_done(TaskLoopMonitor_t *m, int64_t now_us)
+{
+    uint32_t busy = (uint32_t)(now_us - m->wake_us);
+    m->stats.busy_sum_us += busy;
+    if (busy > m->stats.busy_max_us)
+        m->stats.busy_max_us = busy;
+}
+
+void task_loop_monitor_reset(TaskLoopMonitor_t *m)
+{
+    m->reset = 1;
+}
+
+uint32_t task_loop_jitter_percentile(const TaskLoopStats_t *stats, uint32_t percent)
+{
+    if (!stats->count)
+        return 0;
+    uint32_t target = (uint32_t)(((uint64_t)stats->count * percent + 99) / 100);
+    uint32_t acc = 0;
+    for (uint32_t i = 0; i < TASK_MONITOR_JITTER_BINS - 1; i++)
+    {
+        acc += stats->bins[i];
+        if (acc >= target)
+            return (4u << i) < stats->jitter_max_us ? (4u << i) : stats->jitter_max_us;
+    }
+    return stats->jitter_max_us;
+}
+
+#if CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+static SemaphoreHandle_t monitor_mutex;
+
+static void monitor_lock(void)
+{
+    xSemaphoreTake(monitor_mutex, portMAX_DELAY);
+}
+
+static void monitor_unlock(void)
+{
+    xSemaphoreGive(monitor_mutex);
+}
+
+void task_monitor_init(void)
+{
+    if (!monitor_mutex)
+        monitor_mutex = xSemaphoreCreateMutex();
+}
+
+uint32_t task_monitor_core_load(uint8_t load[TASK_MONITOR_CORES])
+{
+    static configRUN_TIME_COUNTER_TYPE last_total;
+    static configRUN_TIME_COUNTER_TYPE last_idle[TASK_MONITOR_CORES];
+    static uint8_t started;
+
+    monitor_lock();
+    // 运行时间计数器与各任务的运行时间单位相同（esp_timer 或CPU时钟），只用差值，计数器回绕不影响结果
+    configRUN_TIME_COUNTER_TYPE total = portGET_RUN_TIME_COUNTER_VALUE();
+    configRUN_TIME_COUNTER_TYPE elapsed = total - last_total;
+    uint32_t ok = started && elapsed;
+    for (int core = 0; core < TASK_MONITOR_CORES && core < portNUM_PROCESSORS; core++)
+    {
+        configRUN_TIME_COUNTER_TYPE idle = ulTaskGetIdleRunTimeCounterForCore(core);
+        if (ok)
+        {
+            configRUN_TIME_COUNTER_TYPE idle_elapsed = idle - last_idle[core];
+            if (idle_elapsed > elapsed)
+                idle_elapsed = elapsed;
+            load[core] = (uint8_t)(100 - (uint64_t)idle_elapsed * 100 / elapsed);
+        }
+        last_idle[core] = idle;
+    }
+    last_total = total;
+    started = 1;
+    monitor_unlock();
+    return ok;
+}
+#else
+void task_monitor_init(void)
+{
+}
+
+uint32_t task_monitor_core_load(uint8_t load[TASK_MONITOR_CORES])
+{
+    return 0;
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef __TASK_MONITOR_H__
+#define __TASK_MONITOR_H__
+
+#include <stdint.h>
+
+/*
+ * 运行时检查任务布局（task_config.h）的效果：
+ * - 周期循环监视：周期任务每次被唤醒时调用 task_loop_monitor_wake，循环工作结束时调用 task_loop_monitor_done，
+ *   统计相邻两次唤醒的间隔与周期之差（调度抖动）、漏掉的周期和单次循环的执行时间。
+ *   监视器由所属任务独占修改，其它任务只读取统计（见 core.h 的 get_core_loop_stats）。
+ * - 核负载：由每个核空闲任务的运行时间计算，需要在menuconfig中开启 FREERTOS_GENERATE_RUN_TIME_STATS。
+ */
+
+#define TASK_MONITOR_CORES          2
+#define TASK_MONITOR_JITTER_BINS    8       // 抖动直方图：第 i 桶为 [2^(i+1), 2^(i+2)) 微秒，第0桶包含 4us 以下，最后一桶包含更长的时间
+
+typedef struct
+{
+    uint32_t count;                 // 统计的唤醒次数
+    uint32_t jitter_max_us;         // 唤醒间隔与周期之差的最大绝对值
+    uint64_t jitter_sum_us;
+    uint32_t bins[TASK_MONITOR_JITTER_BINS];
+    uint32_t overruns;              // 唤醒间隔达到2个周期以上的次数（漏掉了周期）
+    uint32_t busy_max_us;           // 单次循环执行时间最大值
+    uint64_t busy_sum_us;
+} TaskLoopStats_t;
+
+typedef struct
+{
+    uint32_t period_us;
+    int64_t last_wake_us;
+    int64_t wake_us;
+    volatile uint8_t reset;         // 其它任务请求清空统计，由所属任务在下一次唤醒时处理
+    TaskLoopStats_t stats;
+} TaskLoopMonitor_t;
+
+/**
+ * @brief 初始化周期循环监视器
+ * @param period_us 循环周期
+ */
+void task_loop_monitor_init(TaskLoopMonitor_t *m, uint32_t period_us);
+
+/**
+ * @brief 修改循环周期（例如电源管理切换扫描频率），切换前后的那一次间隔不计入统计，只能由所属任务调用
+ */
+void task_loop_monitor_set_period(TaskLoopMonitor_t *m, uint32_t period_us);
+
+/**
+ * @brief 任务被唤醒（vTaskDelayUntil 返回）时调用
+ */
+void task_loop_monitor_wake(TaskLoopMonitor_t *m, int64_t now_us);
+
+/**
+ * @brief 循环工作结束、即将阻塞时调用
+ */
+void task_loop_monitor_done(TaskLoopMonitor_t *m, int64_t now_us);
+
+/**
+ * @brief 请求清空统计，可以在任意任务中调用
+ */
+void task_loop_monitor_reset(TaskLoopMonitor_t *m);
+
+/**
+ * @brief 由抖动直方图估算百分位数（取所在桶的上界）
+ * @param percent 0~100
+ * @return 微秒
+ */
+uint32_t task_loop_jitter_percentile(const TaskLoopStats_t *stats, uint32_t percent);
+
+/**
+ * @brief 创建互斥锁，由 RemoteCoreInit 在创建扫描任务之前调用
+ */
+void task_monitor_init(void);
+
+/**
+ * @brief 读取每个核的负载（百分比），为本次调用与上一次调用之间的平均值
+ * @param load 输出，每个核一个
+ * @return 1：成功 0：第一次调用（只记录起点）或没有开启运行时间统计
+ */
+uint32_t task_monitor_core_load(uint8_t load[TASK_MONITOR_CORES]);
+
+#endif
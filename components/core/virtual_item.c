@@ -0,0 +1,110 @@
+#include <stdatomic.h>
+#include <string.h>
+#include "virtual_item.h"
+#include "comm.h"
+
+#pragma pack(1)
+typedef struct
+{
+    uint8_t count;
+    PackVirtualItem_t items[VIRTUAL_ITEM_NUM];
+} VirtualItemFrame_t;
+#pragma pack()
+
+static volatile int16_t kValues[VIRTUAL_ITEM_NUM];
+static atomic_uint kDefined;        // 设置过的项
+static atomic_uint kLocalDirty;     // 需要发送给机器人的项
+static atomic_uint kRemoteChanged;  // 机器人修改过、界面还没有更新的项
+static atomic_uint kInFlight;       // 正在发送的帧包含的项，0 表示没有正在发送的帧
+static VirtualItemFrame_t kFrame;   // 零拷贝发送，收到ACK或最终失败前不能修改
+static int64_t kLastSendUs;
+
+static void virtual_item_recv_cb(uint8_t *src, uint16_t size, void *user_data)
+{
+    if (size < 1 || size < 1 + (uint32_t)src[0] * sizeof(PackVirtualItem_t))
+        return;
+    const PackVirtualItem_t *items = (const PackVirtualItem_t *)(src + 1);
+    uint32_t changed = 0;
+    for (uint32_t i = 0; i < src[0]; i++)
+    {
+        PackVirtualItem_t item;
+        memcpy(&item, &items[i], sizeof(item));
+        if (item.id >= VIRTUAL_ITEM_NUM)
+            continue;
+        kValues[item.id] = item.value;
+        changed |= 1u << item.id;
+    }
+    atomic_fetch_or(&kDefined, changed);
+    atomic_fetch_or(&kRemoteChanged, changed);
+}
+
+// 在 comm 的ACK任务/接收任务中执行
+static void virtual_item_send_cb(void *user_data, uint32_t is_success)
+{
+    uint32_t items = atomic_exchange(&kInFlight, 0);
+    if (!is_success)
+        atomic_fetch_or(&kLocalDirty, items);  // 重新发送这些项的最新值
+}
+
+void virtual_item_init(void)
+{
+    register_comm_recv_cb(virtual_item_recv_cb, CMD_RECEIVER_UPDATE_VIRTUAL_ITEM, NULL);
+}
+
+void virtual_item_set(uint8_t id, int16_t value)
+{
+    if (id >= VIRTUAL_ITEM_NUM)
+        return;
+    uint32_t bit = 1u << id;
+    if (kValues[id] == value && (atomic_load(&kDefined) & bit))
+        return;
+    kValues[id] = value;
+    atomic_fetch_or(&kDefined, bit);
+    atomic_fetch_or(&kLocalDirty, bit);
+}
+
+int16_t virtual_item_get(uint8_t id)
+{
+    return id < VIRTUAL_ITEM_NUM ? kValues[id] : 0;
+}
+
+const volatile int16_t *virtual_item_values(void)
+{
+    return kValues;
+}
+
+uint32_t virtual_item_take_changed(void)
+{
+    return atomic_exchange(&kRemoteChanged, 0);
+}
+
+void virtual_item_resend_all(void)
+{
+    atomic_fetch_or(&kLocalDirty, atomic_load(&kDefined));
+}
+
+void virtual_item_poll(int64_t now_us)
+{
+    if (!atomic_load_explicit(&kLocalDirty, memory_order_relaxed) || atomic_load(&kInFlight) ||
+        now_us - kLastSendUs < VIRTUAL_ITEM_SEND_INTERVAL_US)
+        return;
+    uint32_t items = atomic_exchange(&kLocalDirty, 0);
+    uint8_t n = 0;
+    for (uint8_t id = 0; id < VIRTUAL_ITEM_NUM; id++)
+    {
+        if (!(items & (1u << id)))
+            continue;
+        PackVirtualItem_t item = {.id = id, .value = kValues[id]};
+        memcpy(&kFrame.items[n++], &item, sizeof(item));
+    }
+    kFrame.count = n;
+    atomic_store(&kInFlight, items);
+    kLastSendUs = now_us;
+    if (!asyn_comm_send_pack_ack((uint8_t *)&kFrame, CMD_REMOTE_UPDATE_VIRTUAL_ITEM,
+                                 1 + n * sizeof(PackVirtualItem_t), virtual_item_send_cb, NULL, VIRTUAL_ITEM_ACK_RETRY))
+    {
+        // 发送队列满，下一个间隔再试
+        atomic_store(&kInFlight, 0);
+        atomic_fetch_or(&kLocalDirty, items);
+    }
+}
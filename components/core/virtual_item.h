@@ -0,0 +1,59 @@
+#ifndef __VIRTUAL_ITEM_H__
+#define __VIRTUAL_ITEM_H__
+
+#include <stdint.h>
+#include "dataFrame.h"
+
+/*
+ * 虚拟控件通道：触摸屏上的滑条、开关、按钮作为额外的控制通道（界面绑定见 pages/virtual_widget.h）。
+ * 每项一个 Q15 值（开关/按钮为 0 或 32767），有两种方式到达机器人：
+ * - 增量帧：值变化后由扫描任务（virtual_item_poll）把所有变化了的项打包成一个 CMD_REMOTE_UPDATE_VIRTUAL_ITEM 帧，
+ *   需要ACK；同一时间只有一帧在发送，拖动滑条期间的变化合并，两帧至少间隔 VIRTUAL_ITEM_SEND_INTERVAL_US。
+ *   发送失败时这些项重新标记为变化，下一次发送最新的值。
+ * - 并入控制帧：混控模型中用 virt0~virt15 作为源（mixer.h），值随通道包（PackChannel_t）每次发送。
+ * 机器人发来的 CMD_RECEIVER_UPDATE_VIRTUAL_ITEM 帧直接修改对应项（不会再发回去），并记录在远端变化掩码中，
+ * 界面用 virtual_item_take_changed 取出后只更新绑定的控件。
+ * 读写值不加锁（16位读写是原子的），变化掩码用原子操作。
+ */
+
+#define VIRTUAL_ITEM_NUM                PACK_VIRTUAL_ITEM_MAX
+#define VIRTUAL_ITEM_SEND_INTERVAL_US   20000   // 增量帧最小间隔
+#define VIRTUAL_ITEM_ACK_RETRY          3
+
+/**
+ * @brief 注册机器人更新虚拟控件的接收回调，需要在 RemoteCommInit 之后调用
+ */
+void virtual_item_init(void);
+
+/**
+ * @brief 修改一项的值（界面调用），值变化时在下一次增量帧中发送
+ * @param value Q15
+ */
+void virtual_item_set(uint8_t id, int16_t value);
+
+/**
+ * @brief 读取一项的值
+ */
+int16_t virtual_item_get(uint8_t id);
+
+/**
+ * @brief 所有项的当前值（混控使用，扫描任务只读）
+ */
+const volatile int16_t *virtual_item_values(void);
+
+/**
+ * @brief 取出并清空被机器人修改过的项（bit i 对应第 i 项），由界面绑定（virtual_widget.c）读取，不要在别处调用
+ */
+uint32_t virtual_item_take_changed(void);
+
+/**
+ * @brief 把所有设置过的项标记为变化，在下一次增量帧中全部发送（机器人重新上线时调用，例如在链路状态回调中）
+ */
+void virtual_item_resend_all(void);
+
+/**
+ * @brief 扫描任务每次扫描调用，有变化且没有正在发送的帧时发送增量帧
+ */
+void virtual_item_poll(int64_t now_us);
+
+#endif
@@ -0,0 +1,149 @@
+#include "calibpage.h"
+#include "lvgl.h"
+#include "stick_calib.h"
+
+/*
+ * 摇杆校准页面：在新的屏幕上显示校准步骤和各轴的实时数据，退出时回到进入前的屏幕。
+ * ADC数据由扫描任务送入 stick_calib_feed，本页面只负责开始/结束校准和显示进度。
+ */
+
+void calib_page_create(void *user_data);
+UI_PAGE_REGISTER("calib_page", calib_page_create);
+
+static lv_obj_t *kLastScreen;
+static lv_obj_t *kCalibScreen;
+static lv_obj_t *kStepLabel;
+static lv_obj_t *kDataLabel;
+static lv_obj_t *kStartLabel;
+static lv_timer_t *kShowTimer;
+static char kStepStr[96];
+static char kDataStr[192];
+static const char *kAxisName[STICK_CALIB_AXES] = {"LX", "LY", "RX", "RY"};
+
+static void calib_page_exit(void)
+{
+    stick_calib_cancel();
+    lv_timer_delete(kShowTimer);
+    lv_screen_load(kLastScreen);
+    lv_obj_delete_async(kCalibScreen);
+    kCalibScreen = NULL;
+    page_pop();
+}
+
+static void calib_show_cb(lv_timer_t *timer)
+{
+    StickCalibProgress_t progress;
+    int raw[STICK_CALIB_AXES];
+    uint16_t key;
+    stick_calib_get_progress(&progress);
+    get_remote_state(raw, &key);
+
+    int len = 0;
+    if (progress.phase == STICK_CALIB_CENTER)
+    {
+        snprintf(kStepStr, sizeof(kStepStr), "1. Release sticks... %lu/%d",
+                 (unsigned long)progress.center_samples, STICK_CALIB_CENTER_SAMPLES);
+    }
+    else if (progress.phase == STICK_CALIB_RANGE)
+    {
+        snprintf(kStepStr, sizeof(kStepStr), "2. Rotate sticks to the limits,\nthen press Finish");
+        for (int i = 0; i < STICK_CALIB_AXES; i++)
+            len += snprintf(kDataStr + len, sizeof(kDataStr) - len, "%s %4d  c%4d  %4d~%4d\n",
+                            kAxisName[i], raw[i], progress.center[i], progress.min[i], progress.max[i]);
+    }
+    if (progress.phase != STICK_CALIB_RANGE)
+    {
+        StickAxisCalib_t axes[STICK_CALIB_AXES];
+        stick_calib_get(axes);
+        for (int i = 0; i < STICK_CALIB_AXES; i++)
+            len += snprintf(kDataStr + len, sizeof(kDataStr) - len, "%s %4d  c%4d  %4d~%4d dz%u\n",
+                            kAxisName[i], raw[i], axes[i].center, axes[i].min, axes[i].max, axes[i].deadzone);
+    }
+    if (progress.phase != STICK_CALIB_IDLE)
+        lv_label_set_text_static(kStepLabel, kStepStr);
+    lv_label_set_text_static(kDataLabel, kDataStr);
+    lv_label_set_text(kStartLabel, progress.phase == STICK_CALIB_RANGE ? "Finish" : "Start");
+}
+
+static void calib_start_btn_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED)
+        return;
+    StickCalibProgress_t progress;
+    stick_calib_get_progress(&progress);
+    if (progress.phase == STICK_CALIB_IDLE)
+    {
+        stick_calib_begin();
+        return;
+    }
+    if (progress.phase != STICK_CALIB_RANGE)
+        return;
+    uint32_t bad_axes = 0;
+    if (stick_calib_finish(&bad_axes))
+    {
+        lv_label_set_text(kStepLabel, "Calibration saved");
+        return;
+    }
+    if (!bad_axes)
+    {
+        lv_label_set_text(kStepLabel, "Save failed, press Finish to retry");
+        return;
+    }
+    int len = snprintf(kStepStr, sizeof(kStepStr), "Travel too small:");
+    for (int i = 0; i < STICK_CALIB_AXES; i++)
+    {
+        if (bad_axes & (1u << i))
+            len += snprintf(kStepStr + len, sizeof(kStepStr) - len, " %s", kAxisName[i]);
+    }
+    lv_label_set_text(kStepLabel, kStepStr);
+}
+
+static void calib_default_btn_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED)
+        return;
+    stick_calib_reset_default();
+    lv_label_set_text(kStepLabel, "Default calibration restored");
+}
+
+static void calib_back_btn_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_CLICKED)
+        calib_page_exit();
+}
+
+static lv_obj_t *calib_btn_create(lv_obj_t *parent, const char *text, lv_align_t align, lv_event_cb_t cb)
+{
+    lv_obj_t *btn = lv_btn_create(parent);
+    lv_obj_set_size(btn, 90, 40);
+    lv_obj_align(btn, align, 0, 0);
+    lv_obj_add_event_cb(btn, cb, LV_EVENT_ALL, NULL);
+    lv_obj_t *label = lv_label_create(btn);
+    lv_label_set_text(label, text);
+    lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+    return label;
+}
+
+void calib_page_create(void *user_data)
+{
+    if (kCalibScreen)
+        return;
+    kLastScreen = lv_screen_active();
+    kCalibScreen = lv_obj_create(NULL);
+    kDataStr[0] = '\0';
+
+    kStepLabel = lv_label_create(kCalibScreen);
+    lv_label_set_text(kStepLabel, "Press Start with sticks released");
+    lv_obj_align(kStepLabel, LV_ALIGN_TOP_LEFT, 0, 0);
+
+    kDataLabel = lv_label_create(kCalibScreen);
+    lv_label_set_text_static(kDataLabel, kDataStr);
+    lv_obj_align(kDataLabel, LV_ALIGN_TOP_LEFT, 0, 50);
+
+    kStartLabel = calib_btn_create(kCalibScreen, "Start", LV_ALIGN_BOTTOM_LEFT, calib_start_btn_cb);
+    calib_btn_create(kCalibScreen, "Default", LV_ALIGN_BOTTOM_MID, calib_default_btn_cb);
+    calib_btn_create(kCalibScreen, "Back", LV_ALIGN_BOTTOM_RIGHT, calib_back_btn_cb);
+
+    kShowTimer = lv_timer_create(calib_show_cb, 100, NULL);
+    lv_screen_load(kCalibScreen);
+}
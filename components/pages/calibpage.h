@@ -0,0 +1,6 @@
+#ifndef __CALIBPAGE_H__
+#define __CALIBPAGE_H__
+
+#include "page_manager.h"
+
+#endif
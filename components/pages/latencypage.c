@@ -0,0 +1,188 @@
+#include "latencypage.h"
+#include "lvgl.h"
+#include "latency_trace.h"
+#include "core.h"
+#include "input_record.h"
+
+/*
+ * 延迟跟踪页面：上方列出每一级（与上一级的时间差）和总延迟的 p50/p99/最大值，
+ * 下方柱状图显示选中的一级的直方图（按2的幂分桶，32us以下到32ms以上）。
+ * 之后两行为每个核的负载和扫描循环的调度抖动（p99/最大值）、漏掉的周期数、单次扫描的最长执行时间，
+ * 最后一行为输入录制/回放的状态。Rec 开始/停止录制输入到SD卡，Play 回放录制的输入（开始时清空统计，便于逐次比较）。
+ */
+
+void latency_page_create(void *user_data);
+UI_PAGE_REGISTER("latency_page", latency_page_create);
+
+static lv_obj_t *kLastScreen;
+static lv_obj_t *kLatencyScreen;
+static lv_obj_t *kSummaryLabel;
+static lv_obj_t *kHistLabel;
+static lv_obj_t *kChart;
+static lv_chart_series_t *kSeries;
+static lv_timer_t *kShowTimer;
+static uint8_t kSelected = LATENCY_HIST_TOTAL;
+static char kSummaryStr[512];
+static char kHistStr[48];
+
+static void latency_show_cb(lv_timer_t *timer)
+{
+    LatencyTraceStats_t stats;
+    LatencyHist_t hist;
+    latency_trace_get_stats(&stats);
+    int len = snprintf(kSummaryStr, sizeof(kSummaryStr), "n=%lu drop=%lu abort=%lu  (us)\n%-8s %6s %6s %6s\n",
+                       (unsigned long)stats.completed, (unsigned long)stats.dropped, (unsigned long)stats.aborted,
+                       "stage", "p50", "p99", "max");
+    for (uint8_t i = LATENCY_STAGE_FILTER; i <= LATENCY_HIST_TOTAL; i++)
+    {
+        latency_trace_get_hist(i, &hist);
+        len += snprintf(kSummaryStr + len, sizeof(kSummaryStr) - len, "%c%-7s %6lu %6lu %6lu\n",
+                        i == kSelected ? '>' : ' ', latency_stage_name(i),
+                        (unsigned long)latency_hist_percentile(&hist, 50),
+                        (unsigned long)latency_hist_percentile(&hist, 99),
+                        (unsigned long)hist.max_us);
+    }
+
+    static uint8_t load[TASK_MONITOR_CORES];  // 负载按两次刷新之间计算，第一次刷新时没有数据
+    TaskLoopStats_t loop;
+    get_core_loop_stats(&loop);
+    uint32_t has_load = task_monitor_core_load(load);
+    if (has_load)
+        len += snprintf(kSummaryStr + len, sizeof(kSummaryStr) - len, "cpu0 %u%%  cpu1 %u%%\n", load[0], load[1]);
+    else
+        len += snprintf(kSummaryStr + len, sizeof(kSummaryStr) - len, "cpu load: n/a\n");
+    len += snprintf(kSummaryStr + len, sizeof(kSummaryStr) - len, "loop jit %lu/%lu ovr %lu busy %lu\n",
+                    (unsigned long)task_loop_jitter_percentile(&loop, 99), (unsigned long)loop.jitter_max_us,
+                    (unsigned long)loop.overruns, (unsigned long)loop.busy_max_us);
+
+    static const char *const kErrorName[] = {"ok", "open", "format", "write"};
+    InputRecordStatus_t rec;
+    input_record_get_status(&rec);
+    if (rec.mode == INPUT_RECORD_RECORDING)
+        snprintf(kSummaryStr + len, sizeof(kSummaryStr) - len, "rec %lu drop %lu",
+                 (unsigned long)rec.samples, (unsigned long)rec.dropped);
+    else if (rec.mode != INPUT_RECORD_OFF)
+        snprintf(kSummaryStr + len, sizeof(kSummaryStr) - len, "play %lu/%lu under %lu",
+                 (unsigned long)rec.samples, (unsigned long)rec.total, (unsigned long)rec.underruns);
+    else
+        snprintf(kSummaryStr + len, sizeof(kSummaryStr) - len, "input: live (%s)", kErrorName[rec.error & 3]);
+    lv_label_set_text_static(kSummaryLabel, kSummaryStr);
+
+    latency_trace_get_hist(kSelected, &hist);
+    uint32_t peak = 1;
+    for (int i = 0; i < LATENCY_TRACE_BINS; i++)
+    {
+        if (hist.bins[i] > peak)
+            peak = hist.bins[i];
+    }
+    for (int i = 0; i < LATENCY_TRACE_BINS; i++)
+        lv_chart_set_value_by_id(kChart, kSeries, i, (int32_t)((uint64_t)hist.bins[i] * 100 / peak));
+    lv_chart_refresh(kChart);
+    snprintf(kHistStr, sizeof(kHistStr), "%s: <32us .. >32ms", latency_stage_name(kSelected));
+    lv_label_set_text_static(kHistLabel, kHistStr);
+}
+
+static void latency_next_btn_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED)
+        return;
+    kSelected = kSelected >= LATENCY_HIST_TOTAL ? LATENCY_STAGE_FILTER : kSelected + 1;
+}
+
+static void latency_reset_btn_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED)
+        return;
+    latency_trace_reset();
+    reset_core_loop_stats();
+}
+
+static void latency_rec_btn_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED)
+        return;
+    InputRecordStatus_t rec;
+    input_record_get_status(&rec);
+    if (rec.mode == INPUT_RECORD_OFF)
+        input_record_start(INPUT_RECORD_DEFAULT_PATH, 1000000 / CORE_SCAN_HZ);
+    else
+        input_record_stop();
+}
+
+static void latency_play_btn_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED)
+        return;
+    InputRecordStatus_t rec;
+    input_record_get_status(&rec);
+    if (rec.mode != INPUT_RECORD_OFF)
+    {
+        input_record_stop();
+        return;
+    }
+    if (input_play_start(INPUT_RECORD_DEFAULT_PATH, 1000000 / CORE_SCAN_HZ))
+    {
+        latency_trace_reset();
+        reset_core_loop_stats();
+    }
+}
+
+static void latency_back_btn_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) != LV_EVENT_CLICKED)
+        return;
+    lv_timer_delete(kShowTimer);
+    lv_screen_load(kLastScreen);
+    lv_obj_delete_async(kLatencyScreen);
+    kLatencyScreen = NULL;
+    page_pop();
+}
+
+static void latency_btn_create(lv_obj_t *parent, const char *text, lv_align_t align, int32_t y, lv_event_cb_t cb)
+{
+    lv_obj_t *btn = lv_btn_create(parent);
+    lv_obj_set_size(btn, 80, 32);
+    lv_obj_align(btn, align, 0, y);
+    lv_obj_add_event_cb(btn, cb, LV_EVENT_ALL, NULL);
+    lv_obj_t *label = lv_label_create(btn);
+    lv_label_set_text(label, text);
+    lv_obj_align(label, LV_ALIGN_CENTER, 0, 0);
+}
+
+void latency_page_create(void *user_data)
+{
+    if (kLatencyScreen)
+        return;
+    kLastScreen = lv_screen_active();
+    kLatencyScreen = lv_obj_create(NULL);
+
+    kSummaryLabel = lv_label_create(kLatencyScreen);
+    lv_obj_set_style_text_font(kSummaryLabel, &lv_font_montserrat_12, 0);
+    lv_label_set_text(kSummaryLabel, "");
+    lv_obj_align(kSummaryLabel, LV_ALIGN_TOP_LEFT, 0, 0);
+
+    kChart = lv_chart_create(kLatencyScreen);
+    lv_chart_set_type(kChart, LV_CHART_TYPE_BAR);
+    lv_chart_set_point_count(kChart, LATENCY_TRACE_BINS);
+    lv_chart_set_range(kChart, LV_CHART_AXIS_PRIMARY_Y, 0, 100);
+    lv_chart_set_div_line_count(kChart, 0, 0);
+    lv_obj_set_size(kChart, lv_pct(100), 56);
+    lv_obj_align(kChart, LV_ALIGN_BOTTOM_MID, 0, -36);
+    kSeries = lv_chart_add_series(kChart, lv_palette_main(LV_PALETTE_BLUE), LV_CHART_AXIS_PRIMARY_Y);
+
+    kHistLabel = lv_label_create(kLatencyScreen);
+    lv_obj_set_style_text_font(kHistLabel, &lv_font_montserrat_12, 0);
+    lv_label_set_text(kHistLabel, "");
+    lv_obj_align_to(kHistLabel, kChart, LV_ALIGN_OUT_TOP_LEFT, 0, 0);
+
+    latency_btn_create(kLatencyScreen, "Stage", LV_ALIGN_BOTTOM_LEFT, 0, latency_next_btn_cb);
+    latency_btn_create(kLatencyScreen, "Reset", LV_ALIGN_BOTTOM_MID, 0, latency_reset_btn_cb);
+    latency_btn_create(kLatencyScreen, "Back", LV_ALIGN_BOTTOM_RIGHT, 0, latency_back_btn_cb);
+    // 录制/回放按钮在直方图上方
+    latency_btn_create(kLatencyScreen, "Rec", LV_ALIGN_BOTTOM_LEFT, -114, latency_rec_btn_cb);
+    latency_btn_create(kLatencyScreen, "Play", LV_ALIGN_BOTTOM_RIGHT, -114, latency_play_btn_cb);
+
+    kShowTimer = lv_timer_create(latency_show_cb, 200, NULL);
+    latency_show_cb(kShowTimer);
+    lv_screen_load(kLatencyScreen);
+}
@@ -0,0 +1,6 @@
+#ifndef __LATENCYPAGE_H__
+#define __LATENCYPAGE_H__
+
+#include "page_manager.h"
+
+#endif
@@ -1,10 +1,19 @@
 #include "mainpage.h"
 #include "lvgl/lvgl.h"
+#include "comm_rpc.h"
+#include "comm_link.h"
+#include "comm_ota_partition.h"
+#include "key_event.h"
+#include "virtual_widget.h"
+#include "power_manager.h"
 
 void main_page_create(void *user_data);
 UI_PAGE_REGISTER("main_page", main_page_create);
 static uint8_t main_page_created_flag = 0;
-static char battery_show_str[24];
+static char battery_show_str[48];
+static char key_event_show_str[32];
+static volatile uint8_t link_state = COMM_LINK_WAITING;
+static const char *const link_state_str[] = {"link off", "link waiting", "link up", "link LOST"};
 
 static void btn_event_cb(lv_event_t *e)
 {
@@ -14,30 +23,124 @@ static void btn_event_cb(lv_event_t *e)
         sys_shutdown();
 }
 
+static void calib_btn_event_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_CLICKED)
+        page_switch("calib_page", NULL, NULL);
+}
+
+static void latency_btn_event_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_CLICKED)
+        page_switch("latency_page", NULL, NULL);
+}
+
 static void battery_voltage_show_cb(lv_timer_t *timer)
 {
+    static uint8_t shown_stage = PM_BATTERY_NORMAL;
     lv_obj_t * label=( lv_obj_t *)lv_timer_get_user_data(timer);
-    sprintf(battery_show_str,"Battery voltage:%.2f%%",Get_Battery_level(get_battery_voltage()));
+    //低电量分级和关机由扫描任务处理（power_manager.h），这里只显示
+    PowerStatus_t status;
+    power_manager_get_status(&status);
+    if(status.battery_stage==PM_BATTERY_CRITICAL)
+        sprintf(battery_show_str,"Battery %u%% LOW! power off in %lus",status.battery_percent,
+                (unsigned long)(status.shutdown_in_ms+999)/1000);
+    else
+        sprintf(battery_show_str,"Battery %u%% %u.%02uV %s",status.battery_percent,status.battery_mv/1000,
+                status.battery_mv%1000/10,power_battery_stage_name(status.battery_stage));
     lv_label_set_text_static(label, battery_show_str);
-    if(get_battery_voltage()<3.6f)
-        sys_shutdown();
+    if(status.battery_stage!=shown_stage)
+    {
+        shown_stage=status.battery_stage;
+        if(shown_stage==PM_BATTERY_NORMAL)
+            lv_obj_remove_local_style_prop(label,LV_STYLE_TEXT_COLOR,0);
+        else
+            lv_obj_set_style_text_color(label,lv_palette_main(shown_stage==PM_BATTERY_LOW?LV_PALETTE_ORANGE:LV_PALETTE_RED),0);
+    }
 }
 
-static void main_page_remote_state_flush_func(const int *rocker, const uint16_t key,void* user_data)
+//RPC完成回调在这里执行，运行在LVGL线程中，回调内可以直接操作控件
+static void rpc_poll_cb(lv_timer_t *timer)
 {
-    static uint16_t _key;
-    static int update_cnt=0;
-    if((update_cnt++)%10)
+    comm_rpc_poll();
+}
+
+//按键事件在LVGL线程中读取，扫描任务不需要等待渲染锁
+static void key_event_show_cb(lv_timer_t *timer)
+{
+    static KeyEventReader_t reader;
+    static uint8_t reader_inited = 0;
+    if (!reader_inited)
+    {
+        key_event_reader_init(&reader);
+        reader_inited = 1;
+    }
+    KeyEvent_t event;
+    uint8_t got = 0;
+    while (key_event_read(&reader, &event))
+        got = 1;
+    if (!got)
         return;
-    xSemaphoreTake(get_screen_mutex(),portMAX_DELAY);
-    char out_str[8]={0};
-    sprintf(out_str,"0x%X",key);
-    lv_obj_t *_label=(lv_obj_t *)user_data;
-    lv_label_set_text(_label, out_str);
-    xSemaphoreGive(get_screen_mutex());
-    _key=key;   //使用静态变量防止发送失败
-    asyn_comm_send_pack_nak(&_key,0x66,sizeof(_key));
-    printf("发送\r\n");
+    lv_obj_t *label = (lv_obj_t *)lv_timer_get_user_data(timer);
+    sprintf(key_event_show_str, "key%u %s 0x%X", event.key, key_event_type_name(event.type), event.keys);
+    lv_label_set_text_static(label, key_event_show_str);
+}
+
+//链路状态回调，在通信模块的超时检查任务中执行，不能阻塞，只记录状态由界面定时器显示
+static void main_page_link_state_cb(uint32_t state, void *user_data)
+{
+    link_state = (uint8_t)state;
+    //机器人上线（包括重启后重新连上）时它的虚拟控件可能是默认值，下一次增量帧发送全部当前值
+    if (state == COMM_LINK_UP)
+        virtual_item_resend_all();
+}
+
+static void link_state_show_cb(lv_timer_t *timer)
+{
+    static uint8_t shown_state = 0xFF;
+    uint8_t state = link_state;
+    if (state == shown_state || state > COMM_LINK_LOST)
+        return;
+    shown_state = state;
+    lv_obj_t *label = (lv_obj_t *)lv_timer_get_user_data(timer);
+    lv_label_set_text_static(label, link_state_str[state]);
+    if (state == COMM_LINK_LOST)
+        lv_obj_set_style_text_color(label, lv_palette_main(LV_PALETTE_RED), 0);
+    else
+        lv_obj_remove_local_style_prop(label, LV_STYLE_TEXT_COLOR, 0);
+}
+
+//按键按下/松开时把消抖后的按键状态发送给机器人：读取按键事件而不是轮询按键状态，没有变化时不发送，
+//一次回调中的多个事件只发送最后的状态（控制包本身也带有按键状态，见 send_scheduler.h）
+#define KEY_SEND_RING   (COMM_SEND_QUEUE_LEN + 2)   //发送是零拷贝的，轮流使用的缓冲个数大于发送队列长度（同 core.c）
+static void key_event_send_cb(lv_timer_t *timer)
+{
+    static KeyEventReader_t reader;
+    static uint8_t reader_inited = 0;
+    static uint16_t send_keys[KEY_SEND_RING];
+    static uint8_t send_index = 0;
+    if (!reader_inited)
+    {
+        key_event_reader_init(&reader);
+        reader_inited = 1;
+    }
+    KeyEvent_t event;
+    uint8_t changed = 0;
+    uint16_t keys = 0;
+    while (key_event_read(&reader, &event))
+    {
+        if (event.type == KEY_EVENT_PRESS || event.type == KEY_EVENT_RELEASE)
+        {
+            keys = event.keys;
+            changed = 1;
+        }
+    }
+    if (!changed)
+        return;
+    uint16_t *buf = &send_keys[send_index];
+    send_index = (send_index + 1) % KEY_SEND_RING;
+    *buf = keys;
+    asyn_comm_send_pack_nak((uint8_t *)buf, 0x66, sizeof(*buf));
 }
 
 void main_page_create(void *user_data)
@@ -48,18 +151,44 @@ void main_page_create(void *user_data)
 
     //通信模块初始化
     RemoteCommInit(NULL);
+    //心跳与断线检测，机器人端需要同样开启（见 stm32_port/example_usage.c，断线保护控制帧由机器人端注册）
+    CommLinkConfig_t link = {.period_ms = 50, .miss_threshold = 3};
+    comm_link_config(&link);
+    comm_link_set_state_cb(main_page_link_state_cb, NULL);
+    comm_rpc_init();
+    lv_timer_create(rpc_poll_cb, 10, NULL);
+    //无线升级：固件写入空闲的OTA分区，资源文件写入storage分区
+    comm_ota_init();
+    comm_ota_register_sink(COMM_OTA_TARGET_APP, comm_ota_app_sink());
+    const CommOtaSink_t *asset_sink = comm_ota_asset_sink("storage");
+    if (asset_sink)
+        comm_ota_register_sink(COMM_OTA_TARGET_ASSET, asset_sink);
     //硬件状态更新任务初始化
     RemoteCoreInit();
 
     lv_obj_t *keys_state_label = lv_label_create(lv_screen_active());
     lv_label_set_text(keys_state_label, "key:");
     lv_obj_align(keys_state_label, LV_ALIGN_TOP_MID, 0, 0);
-    set_remote_flush_func(main_page_remote_state_flush_func,keys_state_label);
+    lv_timer_create(key_event_send_cb, 10, NULL);
+    lv_timer_create(key_event_show_cb, 20, keys_state_label);
+
+    lv_obj_t *link_label = lv_label_create(lv_screen_active());
+    lv_obj_align(link_label, LV_ALIGN_TOP_MID, 0, 50);
+    lv_timer_create(link_state_show_cb, 100, link_label);
 
     lv_obj_t *mylabel = lv_label_create(lv_screen_active());
     lv_label_set_text(mylabel, "Main Page Started");
     lv_obj_align(mylabel, LV_ALIGN_TOP_MID, 0, 100);
 
+    //触摸屏上的虚拟控件：滑条为虚拟通道0，开关为虚拟通道1（机器人可以通过 CMD_RECEIVER_UPDATE_VIRTUAL_ITEM 修改）
+    lv_obj_t *virtual_slider = lv_slider_create(lv_screen_active());
+    lv_obj_set_width(virtual_slider, 160);
+    lv_obj_align(virtual_slider, LV_ALIGN_TOP_MID, 0, 150);
+    virtual_widget_bind(virtual_slider, 0);
+    lv_obj_t *virtual_switch = lv_switch_create(lv_screen_active());
+    lv_obj_align(virtual_switch, LV_ALIGN_TOP_MID, 0, 180);
+    virtual_widget_bind(virtual_switch, 1);
+
     lv_obj_t *shutdown_button = lv_btn_create(lv_screen_active());
     lv_obj_set_size(shutdown_button, 80, 40);
     lv_obj_align(shutdown_button, LV_ALIGN_BOTTOM_RIGHT, 0, 0);
@@ -68,6 +197,22 @@ void main_page_create(void *user_data)
     lv_label_set_text(shutdown_button_label, "close");
     lv_obj_align(shutdown_button_label, LV_ALIGN_CENTER, 0, 0);
 
+    lv_obj_t *calib_button = lv_btn_create(lv_screen_active());
+    lv_obj_set_size(calib_button, 80, 40);
+    lv_obj_align(calib_button, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    lv_obj_add_event_cb(calib_button, calib_btn_event_cb, LV_EVENT_ALL, NULL);
+    lv_obj_t *calib_button_label = lv_label_create(calib_button);
+    lv_label_set_text(calib_button_label, "calib");
+    lv_obj_align(calib_button_label, LV_ALIGN_CENTER, 0, 0);
+
+    lv_obj_t *latency_button = lv_btn_create(lv_screen_active());
+    lv_obj_set_size(latency_button, 80, 40);
+    lv_obj_align(latency_button, LV_ALIGN_BOTTOM_MID, 0, 0);
+    lv_obj_add_event_cb(latency_button, latency_btn_event_cb, LV_EVENT_ALL, NULL);
+    lv_obj_t *latency_button_label = lv_label_create(latency_button);
+    lv_label_set_text(latency_button_label, "latency");
+    lv_obj_align(latency_button_label, LV_ALIGN_CENTER, 0, 0);
+
     lv_timer_t *battery_voltage_show_timer=lv_timer_create(battery_voltage_show_cb,200,mylabel);
     lv_timer_enable(battery_voltage_show_timer);
 }
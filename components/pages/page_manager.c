@@ -1,12 +1,11 @@
 #include "page_manager.h"
 
-//最多支持16个页面递归
 typedef struct{
     const PagePort_t *port_addr;
     void* page_create_param;
 }PageCreateInfo_t;
 
-static PageCreateInfo_t page_create_info_stack[16];
+static PageCreateInfo_t page_create_info_stack[PAGE_STACK_DEPTH];
 static uint16_t page_create_info_index=0;
 static const PagePort_t *this_page_port;
 
@@ -40,6 +39,11 @@ QueueHandle_t get_screen_mutex()
 //切换到目标页面，同时将本页面重新创建信息入栈
 uint32_t page_switch(const char* next_page_name,void *next_page_create_param,void* this_page_create_param)
 {
+    if(page_create_info_index>=PAGE_STACK_DEPTH)    //栈满，不再跳转
+    {
+        printf("page stack full, switch to %s refused\r\n",next_page_name);
+        return 0;
+    }
     int page_num=get_pages_num();
     for(int i=0;i<page_num;i++)
     {
@@ -62,8 +66,18 @@ uint32_t return_last_page()
 {
     if(!page_create_info_index)
         return 0;
+    page_create_info_index--;
     this_page_port=page_create_info_stack[page_create_info_index].port_addr;
     this_page_port->create(page_create_info_stack[page_create_info_index].page_create_param);   //执行创建上一个页面
+    return 1;
+}
+
+//回到上一个页面但不重新创建，上一个页面的屏幕由调用者恢复
+uint32_t page_pop()
+{
+    if(!page_create_info_index)
+        return 0;
     page_create_info_index--;
+    this_page_port=page_create_info_stack[page_create_info_index].port_addr;
     return 1;
 }
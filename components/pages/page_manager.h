@@ -14,6 +14,8 @@
 #include "mylist.h"
 #include "dataFrame.h"
 
+#define PAGE_STACK_DEPTH 16     //最多支持16个页面递归
+
 typedef struct PagePort_t;
 
 typedef void(*PageCreateCb)(void* user_data);
@@ -81,6 +83,16 @@ QueueHandle_t get_screen_mutex();
  */
 uint32_t page_switch(const char* next_page_name,void *next_page_create_param,void* this_page_create_param);
 
+/**
+ * @brief 返回上一个页面，重新执行上一个页面的创建函数
+ * @return 成功返回1;已经在第一个页面返回0
+ */
 uint32_t return_last_page();
 
+/**
+ * @brief 返回上一个页面但不重新创建（页面在新屏幕上创建，退出时自己恢复了进入前的屏幕）
+ * @return 成功返回1;已经在第一个页面返回0
+ */
+uint32_t page_pop();
+
 #endif
\ No newline at end of file
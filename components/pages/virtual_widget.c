@@ -0,0 +1,138 @@
+#include "virtual_widget.h"
+
+typedef enum
+{
+    VIRTUAL_WIDGET_SLIDER = 0,
+    VIRTUAL_WIDGET_TOGGLE,      // 开关/可勾选的按钮
+    VIRTUAL_WIDGET_BUTTON,      // 按住有效
+} VirtualWidgetType_t;
+
+typedef struct
+{
+    lv_obj_t *obj;
+    uint8_t id;
+    uint8_t type;
+} VirtualWidget_t;
+
+static VirtualWidget_t kWidgets[VIRTUAL_WIDGET_MAX];
+static lv_timer_t *kPollTimer;
+
+static int32_t slider_span(lv_obj_t *obj)
+{
+    int32_t lo = lv_slider_get_min_value(obj);
+    int32_t hi = lv_slider_get_max_value(obj);
+    lo = lo < 0 ? -lo : lo;
+    hi = hi < 0 ? -hi : hi;
+    return hi > lo ? hi : (lo ? lo : 1);
+}
+
+// 控件当前的值（Q15）
+static int16_t widget_value(const VirtualWidget_t *w)
+{
+    switch (w->type)
+    {
+    case VIRTUAL_WIDGET_SLIDER:
+        return (int16_t)(lv_slider_get_value(w->obj) * 32767 / slider_span(w->obj));
+    case VIRTUAL_WIDGET_TOGGLE:
+        return lv_obj_has_state(w->obj, LV_STATE_CHECKED) ? 32767 : 0;
+    default:
+        return lv_obj_has_state(w->obj, LV_STATE_PRESSED) ? 32767 : 0;
+    }
+}
+
+// 按机器人修改的值更新控件，不发送值变化事件
+static void widget_show(const VirtualWidget_t *w, int16_t value)
+{
+    switch (w->type)
+    {
+    case VIRTUAL_WIDGET_SLIDER:
+    {
+        int32_t span = slider_span(w->obj);
+        lv_slider_set_value(w->obj, (value * span + (value < 0 ? -16383 : 16383)) / 32767, LV_ANIM_OFF);
+        break;
+    }
+    case VIRTUAL_WIDGET_TOGGLE:
+        lv_obj_set_state(w->obj, LV_STATE_CHECKED, value > 16383);
+        break;
+    default:
+        break;  // 按住有效的按钮只由用户操作
+    }
+}
+
+static VirtualWidget_t *widget_find(lv_obj_t *obj)
+{
+    for (int i = 0; i < VIRTUAL_WIDGET_MAX; i++)
+    {
+        if (kWidgets[i].obj == obj)
+            return &kWidgets[i];
+    }
+    return NULL;
+}
+
+static void virtual_widget_event_cb(lv_event_t *e)
+{
+    VirtualWidget_t *w = widget_find(lv_event_get_target(e));
+    if (!w)
+        return;
+    switch (lv_event_get_code(e))
+    {
+    case LV_EVENT_VALUE_CHANGED:
+    case LV_EVENT_PRESSED:
+    case LV_EVENT_RELEASED:
+    case LV_EVENT_PRESS_LOST:
+        virtual_item_set(w->id, widget_value(w));
+        break;
+    case LV_EVENT_DELETE:
+        w->obj = NULL;
+        break;
+    default:
+        break;
+    }
+}
+
+static void virtual_widget_poll_cb(lv_timer_t *timer)
+{
+    uint32_t changed = virtual_item_take_changed();
+    if (!changed)
+        return;
+    for (int i = 0; i < VIRTUAL_WIDGET_MAX; i++)
+    {
+        VirtualWidget_t *w = &kWidgets[i];
+        if (w->obj && (changed & (1u << w->id)))
+            widget_show(w, virtual_item_get(w->id));
+    }
+}
+
+uint32_t virtual_widget_bind(lv_obj_t *obj, uint8_t id)
+{
+    if (!obj || id >= VIRTUAL_ITEM_NUM || widget_find(obj))
+        return 0;
+    uint8_t type;
+    if (lv_obj_check_type(obj, &lv_slider_class))
+        type = VIRTUAL_WIDGET_SLIDER;
+    else if (lv_obj_check_type(obj, &lv_switch_class) ||
+             (lv_obj_check_type(obj, &lv_button_class) && lv_obj_has_flag(obj, LV_OBJ_FLAG_CHECKABLE)))
+        type = VIRTUAL_WIDGET_TOGGLE;
+    else if (lv_obj_check_type(obj, &lv_button_class))
+        type = VIRTUAL_WIDGET_BUTTON;
+    else
+        return 0;
+    VirtualWidget_t *w = widget_find(NULL);
+    if (!w)
+        return 0;
+    *w = (VirtualWidget_t){.obj = obj, .id = id, .type = type};
+    lv_obj_add_event_cb(obj, virtual_widget_event_cb, LV_EVENT_ALL, NULL);
+    virtual_item_set(id, widget_value(w));
+    if (!kPollTimer)
+        kPollTimer = lv_timer_create(virtual_widget_poll_cb, VIRTUAL_WIDGET_POLL_MS, NULL);
+    return 1;
+}
+
+void virtual_widget_unbind(lv_obj_t *obj)
+{
+    VirtualWidget_t *w = widget_find(obj);
+    if (!w)
+        return;
+    lv_obj_remove_event_cb(obj, virtual_widget_event_cb);
+    w->obj = NULL;
+}
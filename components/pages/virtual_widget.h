@@ -0,0 +1,32 @@
+#ifndef __VIRTUAL_WIDGET_H__
+#define __VIRTUAL_WIDGET_H__
+
+#include "lvgl.h"
+#include "virtual_item.h"
+
+/*
+ * 把LVGL控件绑定到虚拟控件通道（virtual_item.h），只能在LVGL线程中调用：
+ * - 滑条：值按 max(|最小值|, |最大值|) 缩放到 Q15（0~100 的滑条对应 0~100%，-100~100 对应 -100%~100%）
+ * - 开关、可勾选的按钮：选中为 32767，否则为 0
+ * - 普通按钮：按住为 32767，松开为 0
+ * 用户操作控件时修改通道的值；机器人修改通道时由一个LVGL定时器只更新绑定的控件（不触发控件的值变化事件，不会发回机器人）。
+ * 控件删除时自动解除绑定，一个通道可以绑定多个控件。
+ */
+
+#define VIRTUAL_WIDGET_MAX          32
+#define VIRTUAL_WIDGET_POLL_MS      20      // 检查机器人修改的周期
+
+/**
+ * @brief 绑定控件，绑定时用控件当前的值设置通道
+ * @param obj 滑条/开关/按钮
+ * @param id 通道号（0~VIRTUAL_ITEM_NUM-1）
+ * @return 1 成功；0 控件类型不支持/通道号错误/绑定已满
+ */
+uint32_t virtual_widget_bind(lv_obj_t *obj, uint8_t id);
+
+/**
+ * @brief 解除绑定（控件删除时会自动解除）
+ */
+void virtual_widget_unbind(lv_obj_t *obj);
+
+#endif
@@ -5,6 +5,7 @@
 
 #include "esp_err.h"
 #include "esp_log.h"
+#include "esp_attr.h"
 #include "freertos/projdefs.h"
 #include "data_poll.h"
 
@@ -12,14 +13,38 @@
 
 static spi_device_handle_t spi_handle;
 static DataPoll_t kSpiTransReqPoll;
+static ILI9341DoneCb_t kDoneCb;     // 当前刷新的完成回调，上一次刷新完成前不会修改
+static void *kDoneUserData;
 
-static uint16_t screen_buffer[TFT_HEIGHT*TFT_WIDTH/6] __attribute__((aligned(4))) DRAM_ATTR;
+// 回收驱动返回的已完成传输（只在任务中执行，SPI中断中不访问数据池），wait 为1时至少等到一个传输完成
+static void ili9341_reap_trans(uint8_t wait)
+{
+    spi_transaction_t *trans;
+    TickType_t timeout=wait ? portMAX_DELAY : 0;
+    while(spi_device_get_trans_result(spi_handle,&trans,timeout)==ESP_OK)
+    {
+        PollFreeBlock(&kSpiTransReqPoll,trans);
+        timeout=0;
+    }
+}
+
+static spi_transaction_t *ili9341_require_trans(void)
+{
+    ili9341_reap_trans(0);
+    spi_transaction_t *p_buffer=(spi_transaction_t*)PollRequireBlock(&kSpiTransReqPoll);
+    if(!p_buffer)
+    {
+        ili9341_reap_trans(1);     // 全部在队列中，等最早的一个完成
+        p_buffer=(spi_transaction_t*)PollRequireBlock(&kSpiTransReqPoll);
+    }
+    return p_buffer;
+}
 
 uint8_t ili9341_send_small(uint8_t *data,uint32_t size,uint8_t pack_type)
 {
     if(size>4)
         return 0;
-    spi_transaction_t *p_buffer=(spi_transaction_t*)PollRequireBlock(&kSpiTransReqPoll);
+    spi_transaction_t *p_buffer=ili9341_require_trans();
     if(!p_buffer)
         return 0;
     memset(p_buffer,0,sizeof(spi_transaction_t));
@@ -32,11 +57,12 @@ uint8_t ili9341_send_small(uint8_t *data,uint32_t size,uint8_t pack_type)
     return 1;
 }
 
-uint8_t ili9341_send_large(uint8_t *data,uint32_t size,uint8_t pack_type)
+// last 为1时该传输完成后调用刷新完成回调
+uint8_t ili9341_send_large(const uint8_t *data,uint32_t size,uint8_t pack_type,uint8_t last)
 {
     if(size>SPI_MAX_DMA_LEN)
         return 0;
-    spi_transaction_t *p_buffer=(spi_transaction_t*)PollRequireBlock(&kSpiTransReqPoll);
+    spi_transaction_t *p_buffer=ili9341_require_trans();
     if(!p_buffer)
         return 0;
     
@@ -45,18 +71,25 @@ uint8_t ili9341_send_large(uint8_t *data,uint32_t size,uint8_t pack_type)
     p_buffer->cmd=pack_type;
     p_buffer->flags=SPI_TRANS_DMA_BUFFER_ALIGN_MANUAL;
     p_buffer->tx_buffer=data;
+    p_buffer->user=last ? (void*)1 : NULL;
     spi_device_queue_trans(spi_handle,p_buffer,portMAX_DELAY);
     return 1;
 }
 
-static void lil9341_spi_trans_pre_cb(spi_transaction_t *trans)
+/*
+ * 以下两个回调在SPI中断中执行。sdkconfig 开启了 SPI_MASTER_ISR_IN_IRAM，中断可能在flash缓存关闭时（OTA写入、NVS提交）执行，
+ * 回调及其调用的函数都要在IRAM中（gpio_set_level 由 GPIO_CTRL_FUNC_IN_IRAM 放入IRAM），只访问DRAM中的数据。
+ */
+static void IRAM_ATTR lil9341_spi_trans_pre_cb(spi_transaction_t *trans)
 {
     gpio_set_level(LCD_RS, (uint32_t)(trans->cmd));
 }
 
-static void lil9341_spi_trans_finished_cb(spi_transaction_t *trans)
+//传输块由发送者在任务中回收（ili9341_reap_trans），这里只通知刷新完成
+static void IRAM_ATTR lil9341_spi_trans_finished_cb(spi_transaction_t *trans)
 {
-    PollFreeBlock(&kSpiTransReqPoll,trans);
+    if(trans->user && kDoneCb)
+        kDoneCb(kDoneUserData);
 }
 
 //SPI初始化
@@ -125,7 +158,7 @@ void ILI9341_Init()
     buf[1] = 0x83;
     buf[2] = 0x30;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 3, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 3, PACK_TYPE_DATA, 0);
 
     cmd = 0xED;
     buf[0] = 0x64;
@@ -133,14 +166,14 @@ void ILI9341_Init()
     buf[2] = 0x12;
     buf[3] = 0x81;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 4, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 4, PACK_TYPE_DATA, 0);
 
     cmd = 0xE8;
     buf[0] = 0x85;
     buf[1] = 0x01;
     buf[2] = 0x79;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 3, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 3, PACK_TYPE_DATA, 0);
 
     cmd = 0xCB;
     buf[0] = 0x39;
@@ -149,61 +182,61 @@ void ILI9341_Init()
     buf[3] = 0x34;
     buf[4] = 0x02;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 5, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 5, PACK_TYPE_DATA, 0);
 
     cmd = 0xF7;
     buf[0] = 0x20;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 1, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 1, PACK_TYPE_DATA, 0);
 
     cmd = 0xEA;
     buf[0] = 0x00;
     buf[1] = 0x00;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 2, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 2, PACK_TYPE_DATA, 0);
 
     cmd = 0xC1;
     buf[0] = 0x02;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 1, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 1, PACK_TYPE_DATA, 0);
 
     cmd = 0xC5;
     buf[0] = 0x3E;
     buf[1] = 0x28;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 2, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 2, PACK_TYPE_DATA, 0);
 
     cmd = 0xC7;
     buf[0] = 0x86;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 1, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 1, PACK_TYPE_DATA, 0);
 
     cmd = 0x36;
     buf[0] = 0x48;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 1, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 1, PACK_TYPE_DATA, 0);
 
     cmd = 0x3A;
     buf[0] = 0x55;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 1, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 1, PACK_TYPE_DATA, 0);
 
     cmd = 0xB1;
     buf[0] = 0x00;
     buf[1] = 0x18;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 2, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 2, PACK_TYPE_DATA, 0);
 
     cmd = 0xB6;
     buf[0] = 0x0A;
     buf[1] = 0x82;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 2, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 2, PACK_TYPE_DATA, 0);
 
     cmd = 0x26;
     buf[0] = 0x01;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 1, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 1, PACK_TYPE_DATA, 0);
 
     cmd = 0xE0;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
@@ -212,7 +245,7 @@ void ILI9341_Init()
         0x08, 0x4E, 0xF1, 0x37, 0x07,
         0x10, 0x03, 0x0E, 0x09, 0x00
     };
-    ili9341_send_large(gamma_p, 15, PACK_TYPE_DATA);
+    ili9341_send_large(gamma_p, 15, PACK_TYPE_DATA, 0);
 
     cmd = 0xE1;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
@@ -221,7 +254,7 @@ void ILI9341_Init()
         0x07, 0x31, 0xC1, 0x48, 0x08,
         0x0F, 0x0C, 0x31, 0x36, 0x0F
     };
-    ili9341_send_large(gamma_n, 15, PACK_TYPE_DATA);
+    ili9341_send_large(gamma_n, 15, PACK_TYPE_DATA, 0);
 
     /* 列地址设置 */
     cmd = 0x2A;
@@ -230,7 +263,7 @@ void ILI9341_Init()
     buf[2] = 0x00;
     buf[3] = 0xEF;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 4, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 4, PACK_TYPE_DATA, 0);
 
       /* 行地址设置 */
     cmd = 0x2B;
@@ -239,7 +272,7 @@ void ILI9341_Init()
     buf[2] = 0x01;
     buf[3] = 0x3F;
     ili9341_send_small(&cmd, 1, PACK_TYPE_CMD);
-    ili9341_send_large(buf, 4, PACK_TYPE_DATA);
+    ili9341_send_large(buf, 4, PACK_TYPE_DATA, 0);
 
     /* 开启显示 */
     cmd = 0x29;
@@ -250,33 +283,15 @@ void ILI9341_Init()
 
 uint8_t wait_spi_trans_finished()
 {
-    while(1)
-    {
-        if(PollFreeBlockNum(&kSpiTransReqPoll)==32)
-            return 0;
-        PollWaitEvent(&kSpiTransReqPoll,10);
-    }
+    while(PollFreeBlockNum(&kSpiTransReqPoll)!=32)
+        ili9341_reap_trans(1);
     return 0;
 }
 
-void color_data_conversion(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2,uint16_t *pixel_data_src)
-{
-    uint32_t cnt=0;
-    uint16_t temp;
-    for(uint16_t i=y1;i<=y2;i++)
-    {
-        for(uint16_t j=x1;j<=x2;j++)
-        {
-            temp=*(pixel_data_src+cnt);
-            *(screen_buffer+cnt)=(temp>>8)|(temp<<8);
-            cnt++;
-        }
-    }
-}
-
-void ILI9341_FreshScreen(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2)
+void ILI9341_FreshScreen(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2,const uint16_t *pixels,
+                         ILI9341DoneCb_t done_cb,void *user_data)
 {
-    uint8_t *pixel_data=(uint8_t*)screen_buffer;
+    const uint8_t *pixel_data=(const uint8_t*)pixels;
     uint32_t pixel_data_size=(x2-x1+1)*(y2-y1+1)*sizeof(uint16_t);
     uint8_t cmd;
     uint8_t data[4];
@@ -298,12 +313,15 @@ void ILI9341_FreshScreen(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2)
 
     cmd=0x2C;
     ili9341_send_small(&cmd,1,PACK_TYPE_CMD);
+    kDoneCb=done_cb;
+    kDoneUserData=user_data;
+    //像素直接从调用者的缓冲DMA发送，分成多个传输，最后一个完成时调用 done_cb
     uint16_t current_pack_size;
     while(pixel_data_size)
     {
         current_pack_size=pixel_data_size>SPI_MAX_DMA_LEN ? SPI_MAX_DMA_LEN : pixel_data_size;
         pixel_data_size=pixel_data_size-current_pack_size;
-        ili9341_send_large(pixel_data,current_pack_size,PACK_TYPE_DATA);
+        ili9341_send_large(pixel_data,current_pack_size,PACK_TYPE_DATA,pixel_data_size==0);
         pixel_data=pixel_data+current_pack_size;
     }
 }
@@ -20,9 +20,20 @@
 #define LCD_CS  45          //液晶屏片选控制信号，低电平有效
 
 
+typedef void (*ILI9341DoneCb_t)(void *user_data);
+
 void ILI9341_Init();
-void color_data_conversion(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2,uint16_t *pixel_data_src);
-void ILI9341_FreshScreen(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2);
+/**
+ * @brief 异步刷新一个区域：发送窗口命令后把像素直接交给SPI DMA，不等待传输完成
+ * @param pixels 高字节在前的RGB565像素，必须位于可DMA的内部RAM并4字节对齐，done_cb 被调用前不能修改
+ * @param done_cb 最后一个像素传输完成时在SPI中断中调用，可以为NULL；必须是 IRAM_ATTR 函数，只能使用中断安全的接口、
+ *                访问DRAM中的数据（中断可能在flash缓存关闭时执行）；同一时间只能有一次刷新，下一次调用前需要等到 done_cb
+ */
+void ILI9341_FreshScreen(uint16_t x1,uint16_t y1,uint16_t x2,uint16_t y2,const uint16_t *pixels,
+                         ILI9341DoneCb_t done_cb,void *user_data);
+/**
+ * @brief 等待所有已提交的SPI传输完成
+ */
 uint8_t wait_spi_trans_finished();
 
 #endif
@@ -3,10 +3,15 @@
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_heap_caps.h"
+#include "esp_attr.h"
 #include "ILI9341.h"
 #include "FT6336.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "task_config.h"
+#include "power_manager.h"
+#include "rgb565_swap.h"
 
 #include "lvgl.h"
 
@@ -18,18 +23,44 @@ TaskHandle_t lvgl_fresh_task_handler;
 lv_display_t *display_screen;
 lv_indev_t * indev_touch;
 
-static uint16_t screen_buffer1[TFT_WIDTH*TFT_HEIGHT/6];
-static uint16_t screen_buffer2[TFT_WIDTH*TFT_HEIGHT/6];
+/*
+ * 两个渲染缓冲轮流使用：刷新时在缓冲内就地转换字节序后直接由SPI DMA发送，发送期间LVGL渲染到另一个缓冲。
+ * 最后一个传输完成时SPI中断只清除标志并释放信号量，LVGL需要该缓冲时在 flush_wait_cb 中（LVGL任务）等待并调用
+ * lv_display_flush_ready：中断可能在flash缓存关闭时执行，不能调用flash中的LVGL函数。
+ * 缓冲需要在可DMA的内部RAM中，按 RGB565_SWAP_ALIGN 对齐使字节序转换不需要逐像素处理头部。
+ */
+static uint16_t screen_buffer1[TFT_WIDTH*TFT_HEIGHT/6] __attribute__((aligned(RGB565_SWAP_ALIGN)));
+static uint16_t screen_buffer2[TFT_WIDTH*TFT_HEIGHT/6] __attribute__((aligned(RGB565_SWAP_ALIGN)));
+static SemaphoreHandle_t flush_done_sem;
+static volatile uint8_t flush_busy;
 
-/* 刷新函数 */
+/* 最后一个像素传输完成，在SPI中断中执行 */
+static void IRAM_ATTR sceenflush_done_cb(void *user_data)
+{
+    BaseType_t woken=pdFALSE;
+    flush_busy=0;
+    xSemaphoreGiveFromISR(flush_done_sem,&woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+/* 刷新函数，不等待传输完成 */
 void sceenflush_cb(lv_display_t * disp, const lv_area_t * area, uint8_t * px_map)
 {
-    if(disp==display_screen)
+    if(disp!=display_screen)
     {
-        wait_spi_trans_finished();
-        color_data_conversion(area->x1,area->y1,area->x2,area->y2,(uint16_t*)px_map);       //进行高低字节转换，然后放到发送缓冲区
-        ILI9341_FreshScreen(area->x1,area->y1,area->x2,area->y2);
+        lv_display_flush_ready(disp);
+        return;
     }
+    rgb565_swap(px_map,lv_area_get_size(area));     //屏幕要求高字节在前，就地转换
+    flush_busy=1;
+    ILI9341_FreshScreen(area->x1,area->y1,area->x2,area->y2,(const uint16_t*)px_map,sceenflush_done_cb,disp);
+}
+
+/* LVGL需要使用正在发送的缓冲时调用，阻塞等待传输完成而不是忙等 */
+static void sceenflush_wait_cb(lv_display_t * disp)
+{
+    while(flush_busy)
+        xSemaphoreTake(flush_done_sem,pdMS_TO_TICKS(10));   //信号量可能是之前的刷新留下的，以标志为准
     lv_display_flush_ready(disp);
 }
 
@@ -52,7 +83,9 @@ void lvgl_screen_fresh_task(void *param)
     {
         xSemaphoreTake(lv_update_mutex,portMAX_DELAY);
         int64_t start_time=esp_timer_get_time();
+        power_manager_render_begin();   //渲染期间CPU运行在最高频率
         lv_timer_handler();
+        power_manager_render_end();
         xSemaphoreGive(lv_update_mutex);
         //printf("%.2f%%\n",((float)((esp_timer_get_time()-start_time)))/(SCREEN_FRESH_PERIOD_MS*1000)*100.0f);  //统计CPU使用率
         vTaskDelayUntil(&last_wake_time,pdMS_TO_TICKS(SCREEN_FRESH_PERIOD_MS));
@@ -68,6 +101,7 @@ void lvgl_indev_update_cb(lv_indev_t *indev, lv_indev_data_t *data)
         data->state = LV_INDEV_STATE_REL;
     }else {
         data->state = LV_INDEV_STATE_PR;
+        power_manager_activity();   //触摸算作操作，退出空闲
         data->point.x = touch_info.x1;
         data->point.y = touch_info.y1;
     }
@@ -84,12 +118,14 @@ QueueHandle_t mylvgl_port_init()
     display_screen=lv_display_create(TFT_WIDTH, TFT_HEIGHT);   //创建显示器
 
     lv_display_set_buffers(display_screen,screen_buffer1,screen_buffer2,TFT_HEIGHT*TFT_WIDTH*2/6,LV_DISPLAY_RENDER_MODE_PARTIAL);   //为显示器注册缓冲区
+    flush_done_sem=xSemaphoreCreateBinary();
     lv_display_set_flush_cb(display_screen,sceenflush_cb);   //设置显示器输出回调函数
+    lv_display_set_flush_wait_cb(display_screen,sceenflush_wait_cb);
 
     indev_touch = lv_indev_create();
     lv_indev_set_type(indev_touch, LV_INDEV_TYPE_POINTER);
     lv_indev_set_read_cb(indev_touch,lvgl_indev_update_cb);
 
-    xTaskCreate(lvgl_screen_fresh_task,"lvgl_fresh",4096*2,lv_update_mutex,20,&lvgl_fresh_task_handler);  //创建显示器刷新任务
+    TASK_CREATE(TASK_LVGL,lvgl_screen_fresh_task,lv_update_mutex,&lvgl_fresh_task_handler);  //创建显示器刷新任务（绑定界面核）
     return lv_update_mutex;
 }
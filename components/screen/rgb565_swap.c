@@ -0,0 +1,74 @@
+#include "rgb565_swap.h"
+
+// 通过字类型访问像素缓冲，不受严格别名规则限制
+typedef uint32_t __attribute__((may_alias)) word32_t;
+typedef uint64_t __attribute__((may_alias)) word64_t;
+
+#define SWAP16(v)   ((uint16_t)(((v) >> 8) | ((v) << 8)))
+#define SWAP32(v)   ((((v) & 0xff00ff00u) >> 8) | (((v) & 0x00ff00ffu) << 8))
+#define SWAP64(v)   ((((v) & 0xff00ff00ff00ff00ull) >> 8) | (((v) & 0x00ff00ff00ff00ffull) << 8))
+
+void rgb565_swap_ref(void *buf, uint32_t px)
+{
+    uint16_t *p = buf;
+    for (uint32_t i = 0; i < px; i++)
+        p[i] = SWAP16(p[i]);
+}
+
+// 逐像素处理到地址按 align 对齐，返回剩余像素数
+static uint32_t swap_head(uint16_t **p, uint32_t px, uintptr_t align)
+{
+    while (px && ((uintptr_t)*p & (align - 1)))
+    {
+        **p = SWAP16(**p);
+        (*p)++;
+        px--;
+    }
+    return px;
+}
+
+void rgb565_swap_swar32(void *buf, uint32_t px)
+{
+    uint16_t *p = buf;
+    px = swap_head(&p, px, 4);
+    word32_t *w = (word32_t *)p;
+    uint32_t n = px / 2;
+    for (; n >= 4; n -= 4, w += 4)
+    {
+        w[0] = SWAP32(w[0]);
+        w[1] = SWAP32(w[1]);
+        w[2] = SWAP32(w[2]);
+        w[3] = SWAP32(w[3]);
+    }
+    for (; n; n--, w++)
+        *w = SWAP32(*w);
+    if (px & 1)
+        rgb565_swap_ref(w, 1);
+}
+
+void rgb565_swap_swar64(void *buf, uint32_t px)
+{
+    uint16_t *p = buf;
+    px = swap_head(&p, px, 8);
+    word64_t *w = (word64_t *)p;
+    uint32_t n = px / 4;
+    for (; n >= 4; n -= 4, w += 4)
+    {
+        w[0] = SWAP64(w[0]);
+        w[1] = SWAP64(w[1]);
+        w[2] = SWAP64(w[2]);
+        w[3] = SWAP64(w[3]);
+    }
+    for (; n; n--, w++)
+        *w = SWAP64(*w);
+    rgb565_swap_swar32(w, px & 3);
+}
+
+void rgb565_swap(void *buf, uint32_t px)
+{
+#if UINTPTR_MAX > 0xffffffffu
+    rgb565_swap_swar64(buf, px);
+#else
+    rgb565_swap_swar32(buf, px);    // 32位CPU上64位运算由两个32位运算组成，没有收益
+#endif
+}
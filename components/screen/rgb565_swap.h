@@ -0,0 +1,29 @@
+#ifndef __RGB565_SWAP_H__
+#define __RGB565_SWAP_H__
+
+#include <stdint.h>
+
+/*
+ * RGB565 像素字节序转换（ILI9341 要求高字节在前，LVGL 按小端渲染）：
+ * - rgb565_swap_ref   逐像素，作为其它实现的参考
+ * - rgb565_swap_swar32 / rgb565_swap_swar64  一次处理2/4个像素（寄存器内按字节掩码移位），不依赖平台
+ * rgb565_swap 选择当前平台最快的实现。所有实现都就地转换，缓冲只要求2字节对齐，不足一个字的头尾逐像素处理。
+ * sdkconfig 中 LV_USE_DRAW_SW_ASM 为 CUSTOM 时 LVGL 的 lv_draw_sw_rgb565_swap 也使用 rgb565_swap（rgb565_swap_lvgl.h）。
+ * 转换仍是刷新前单独的一遍：LVGL 9.2 没有高字节在前的RGB565输出格式，合并到混合（blend）中需要修改LVGL源码。
+ * 各实现的正确性和吞吐量用 tools/rgb565_bench 检查。
+ */
+
+#define RGB565_SWAP_ALIGN       8       // 渲染缓冲按此对齐可以省去头部的逐像素处理（swar64 按8字节访问）
+
+/**
+ * @brief 就地交换每个像素的高低字节
+ * @param buf 2字节对齐
+ * @param px 像素数
+ */
+void rgb565_swap(void *buf, uint32_t px);
+
+void rgb565_swap_ref(void *buf, uint32_t px);
+void rgb565_swap_swar32(void *buf, uint32_t px);
+void rgb565_swap_swar64(void *buf, uint32_t px);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef __RGB565_SWAP_LVGL_H__
+#define __RGB565_SWAP_LVGL_H__
+
+/*
+ * LVGL 软件渲染的自定义加速头文件（sdkconfig: LV_DRAW_SW_ASM_CUSTOM，LV_DRAW_SW_ASM_CUSTOM_INCLUDE="rgb565_swap_lvgl.h"），
+ * 被 LVGL 的 draw/sw 源文件包含，只替换 lv_draw_sw_rgb565_swap，其余混合函数仍使用 LVGL 的实现。
+ * 头文件所在目录由 screen 组件的 CMakeLists.txt 加到 lvgl 组件的包含路径。
+ */
+
+#include "rgb565_swap.h"
+
+#define LV_DRAW_SW_RGB565_SWAP(buf, buf_size_px)    (rgb565_swap((buf), (buf_size_px)), LV_RESULT_OK)
+
+#endif
@@ -12,6 +12,7 @@
 #include "core.h"
 #include "lvgl_port_disp.h"
 #include "page_manager.h"
+#include "mixer.h"
 
 #include "lvgl/lvgl.h"//lvgl库
 #include "lvgl.h"
@@ -21,12 +22,22 @@
 #include "sdmmc_cmd.h"
 #include "esp_vfs_fat.h"
 
+#include "nvs_flash.h"//参数存储（摇杆校准等）
+
 void SDInit();
 void FatFsInit();
 
 void app_main(void)
 {
     sys_setup();
+    //NVS初始化，分区版本不兼容时擦除重建
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND)
+    {
+        nvs_flash_erase();
+        nvs_flash_init();
+    }
+    mixer_init();       //NVS中保存的混控模型，在扫描任务创建和SD卡加载之前完成
     //屏幕显示初始化
     ILI9341_Init();
     FT6636_init();
@@ -35,6 +46,7 @@ void app_main(void)
     page_manager_init("main_page",screen_mutex);
     
     SDInit();
+    mixer_load_file(MIXER_SD_PATH);     //SD卡上有混控模型时加载并写入NVS，之后不插卡也使用这个模型
     while (1)
     {
         printf("running...\r\n");
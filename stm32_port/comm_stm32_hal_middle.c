@@ -12,6 +12,8 @@ static void Comm_TxTask(void *pvParameters);
 static inline void Comm_RingPushFromISR(CommHandle_t* h, const uint8_t* src, uint16_t size);
 static inline uint16_t Comm_RingPop(CommHandle_t* h, uint8_t* dst, uint16_t size);
 static inline uint8_t Comm_ReadByte(CommHandle_t* h);
+static int Comm_PortRead(void *port_data, uint8_t *dst, uint16_t size, uint32_t timeout_ms);
+static int Comm_PortWrite(void *port_data, const uint8_t *src, uint16_t size);
 
 static inline void Comm_RingPushFromISR(CommHandle_t* h, const uint8_t* src, uint16_t size)
 {
@@ -111,6 +113,9 @@ CommHandle_t* Comm_Init(UART_HandleTypeDef *huart)
     // 初始化通信句柄
     memset(&comm_instance, 0, sizeof(comm_instance));
     comm_instance.huart = huart;
+    comm_instance.port.read = Comm_PortRead;
+    comm_instance.port.write = Comm_PortWrite;
+    comm_instance.port.port_data = &comm_instance;
 
     // 创建FreeRTOS信号量和队列
     comm_instance.rx_semaphore = xSemaphoreCreateBinary();
@@ -285,7 +290,7 @@ int Comm_Read_Timeout(CommHandle_t* comm_handle, uint8_t *buffer, uint16_t size,
 }
 
 /**
- * @brief 发送数据（使用队列提交方式，立即返回）
+ * @brief 发送数据（使用队列提交方式，放入发送队列后返回）
  * @param comm_handle 通信句柄
  * @param data 要发送的数据
  * @param size 数据长度
@@ -306,9 +311,10 @@ void Comm_Write(CommHandle_t* comm_handle, const uint8_t *data, uint16_t size)
     memcpy(tx_request.data, data, size);
     tx_request.size = size;
     
-    // 将发送请求放入队列，如果队列满了则丢弃（非阻塞）
+    // 将发送请求放入队列，队列满时等待（与 ESP32 的 uart_write_bytes 一致）：
+    // 串口发送慢于 comm.c 产生数据时，背压传回 comm.c 的发送队列，而不是在这里悄悄丢帧
     if (comm_handle->tx_queue != NULL) {
-        xQueueSend(comm_handle->tx_queue, &tx_request, 0);
+        xQueueSend(comm_handle->tx_queue, &tx_request, portMAX_DELAY);
     }
 }
 
@@ -339,6 +345,30 @@ void Comm_UART_TxCplt_IRQ_Handle(CommHandle_t* comm_handle, UART_HandleTypeDef *
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
+static int Comm_PortRead(void *port_data, uint8_t *dst, uint16_t size, uint32_t timeout_ms)
+{
+    return Comm_Read_Timeout((CommHandle_t*)port_data, dst, size, timeout_ms);
+}
+
+static int Comm_PortWrite(void *port_data, const uint8_t *src, uint16_t size)
+{
+    Comm_Write((CommHandle_t*)port_data, src, size);
+    return size;
+}
+
+/**
+ * @brief 获取 comm.c 使用的链路端口
+ * @param comm_handle 通信句柄
+ * @return 链路端口
+ */
+const CommPort_t* Comm_GetPort(CommHandle_t* comm_handle)
+{
+    if (comm_handle == NULL) {
+        return NULL;
+    }
+    return &comm_handle->port;
+}
+
 /**
  * @brief 获取系统时间（毫秒）
  * @return 系统时间（毫秒）
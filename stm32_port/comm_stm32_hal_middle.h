@@ -21,6 +21,7 @@
 #include "queue.h"
 #include <string.h>
 #include <stdint.h>
+#include "comm_port.h"
 
 // 环形缓冲区大小
 #define COMM_RING_BUFFER_SIZE 1024
@@ -48,6 +49,7 @@ typedef struct {
     SemaphoreHandle_t rx_semaphore;                    // 接收信号量（有新数据到达时 give）
     TaskHandle_t tx_wait_task;                         // 当前等待发送完成通知的任务（用于 task notify）
     volatile uint8_t tx_busy;                          // 发送忙标志（与 tx_wait_task 配合）
+    CommPort_t port;                                   // comm.c 使用的链路端口
 } CommHandle_t;
 
 /*
@@ -71,6 +73,12 @@ void Comm_Write(CommHandle_t* comm_handle, const uint8_t *data, uint16_t size);
 // 工具函数
 uint32_t Comm_GetTickMS(void);
 
+/**
+ * 获取 comm.c 使用的链路端口，用法：RemoteCommInitWithPort(callback, Comm_GetPort(handle));
+ * （STM32 工程不编译 comm_port_uart.c，也就没有 RemoteCommInit）
+ */
+const CommPort_t* Comm_GetPort(CommHandle_t* comm_handle);
+
 // 兼容ESP32的函数映射宏
 #define uart_read_bytes(port, buffer, size, timeout_ms) Comm_Read_Timeout(g_comm_handle, buffer, size, timeout_ms)
 #define uart_write_bytes(port, data, size) Comm_Write(g_comm_handle, data, size)
@@ -8,6 +8,7 @@
 #include "comm_stm32_hal_middle.h"
 #include "comm.h"  // 原有的通信模块
 #include "dataFrame.h"
+#include "comm_link.h"
 
 // 外部UART句柄（由STM32 CubeMX生成）
 extern UART_HandleTypeDef huart1;
@@ -135,7 +136,7 @@ int comm_system_init(void)
     }
     
     // 2. 初始化原有通信模块
-    RemoteCommInit(comm_error_callback);
+    RemoteCommInitWithPort(comm_error_callback, Comm_GetPort(g_comm_handle));
     
     // 3. 注册接收回调
     uint32_t cb_id = register_comm_recv_cb(rocker_data_recv_callback, 
@@ -146,6 +147,12 @@ int comm_system_init(void)
         return -1;
     }
     
+    // 4. 开启心跳，断线时按收到一帧摇杆全0、无按键的控制帧处理（遥控器端也要开启心跳）
+    static const PackControl_t failsafe = {0};
+    CommLinkConfig_t link = {.period_ms = 50, .miss_threshold = 3};
+    comm_link_config(&link);
+    comm_link_set_failsafe(CMD_REMOTE_UPDATE_ROCKER, &failsafe, sizeof(failsafe));
+
     printf("通信系统初始化成功，回调ID: %lu\r\n", cb_id);
     return 0;
 }
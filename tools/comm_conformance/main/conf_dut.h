@@ -0,0 +1,25 @@
+#ifndef __CONF_DUT_H__
+#define __CONF_DUT_H__
+
+#include "sim_stack.h"
+
+/*
+ * 四份独立的协议栈（comm.c 各编译一遍，做法同 comm_sim，见 sim_stack_rename.h）：
+ * 每种构建配置一对，参考端直接接连线，被测端经该配置自己的链路端口实现收发。
+ */
+extern const SimStack_t conf_ref_esp32;     // 连线0 参考端
+extern const SimStack_t conf_dut_esp32;     // 连线0 被测端：RemoteCommInit() -> comm_port_uart.c -> 串口驱动替身
+extern const SimStack_t conf_ref_stm32;     // 连线1 参考端
+extern const SimStack_t conf_dut_stm32;     // 连线1 被测端：comm_stm32_hal_middle.c -> HAL 替身
+
+/**
+ * @brief 初始化 HAL 替身与 STM32 适配层（Comm_Init），返回适配层的链路端口
+ */
+const CommPort_t *conf_stm32_port(void);
+
+/**
+ * @brief HAL 替身在接收未启动期间丢失的字节数
+ */
+uint32_t conf_stm32_rx_overrun(void);
+
+#endif
@@ -0,0 +1,104 @@
+#include <string.h>
+#include "stm32xxxx_hal.h"
+#include "FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+#include "conf_wire.h"
+
+#define CONF_HAL_RX_LINE_SIZE   1024    // 线路上尚未被“DMA”取走的字节（替身内部缓冲，不对应硬件）
+#define CONF_HAL_IDLE_MS        2       // 超过该时间没有新字节视为线路空闲
+
+typedef struct
+{
+    uint16_t size;
+    uint8_t data[CONF_WIRE_MAX_FRAME];
+} HalTxJob_t;
+
+static UART_HandleTypeDef *kHuart;
+static QueueHandle_t kTxJobs;
+static StreamBufferHandle_t kRxLine;
+
+static void HalTxDmaTask(void *param)
+{
+    static HalTxJob_t job;
+    while (1)
+    {
+        xQueueReceive(kTxJobs, &job, portMAX_DELAY);
+        conf_wire_write(kHuart->link, CONF_DIR_TO_REF, job.data, job.size);
+        vTaskDelay(pdMS_TO_TICKS(conf_wire_airtime_ms(kHuart->link, job.size)));
+        kHuart->tx_busy = 0;
+        HAL_UART_TxCpltCallback(kHuart);
+    }
+}
+
+// 模拟 DMA + 空闲中断：收满登记的缓冲或线路空闲时产生一次接收事件
+static void HalRxDmaTask(void *param)
+{
+    static uint8_t chunk[CONF_WIRE_MAX_FRAME];
+    while (1)
+    {
+        size_t got = xStreamBufferReceive(kRxLine, chunk, 1, portMAX_DELAY);
+        uint16_t want = kHuart->rx_buf ? kHuart->rx_size : 1;
+        while (got < want)
+        {
+            size_t n = xStreamBufferReceive(kRxLine, chunk + got, want - got, pdMS_TO_TICKS(CONF_HAL_IDLE_MS));
+            if (n == 0)
+                break;
+            got += n;
+        }
+
+        uint8_t *buf = kHuart->rx_buf;
+        if (!buf)
+        {
+            kHuart->rx_overrun += got;
+            continue;
+        }
+        memcpy(buf, chunk, got);
+        kHuart->rx_buf = NULL;  // 普通模式DMA：一次事件后需要重新启动接收
+        HAL_UARTEx_RxEventCallback(kHuart, (uint16_t)got);
+    }
+}
+
+void conf_hal_uart_init(UART_HandleTypeDef *huart, uint8_t link)
+{
+    static DMA_HandleTypeDef hdmarx;
+    memset(huart, 0, sizeof(*huart));
+    huart->hdmarx = &hdmarx;
+    huart->link = link;
+    kHuart = huart;
+    kTxJobs = xQueueCreate(1, sizeof(HalTxJob_t));
+    kRxLine = xStreamBufferCreate(CONF_HAL_RX_LINE_SIZE, 1);
+    conf_wire_set_sink(link, CONF_DIR_TO_DUT, conf_wire_stream_sink, kRxLine);
+    xTaskCreate(HalTxDmaTask, "halTxDma", 4096, NULL, 12, NULL);
+    xTaskCreate(HalRxDmaTask, "halRxDma", 4096, NULL, 12, NULL);
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+    if (huart != kHuart || !pData || Size == 0 || Size > CONF_WIRE_MAX_FRAME)
+        return HAL_ERROR;
+    if (huart->tx_busy)
+        return HAL_BUSY;
+    huart->tx_busy = 1;
+
+    HalTxJob_t job;
+    job.size = Size;
+    memcpy(job.data, pData, Size);
+    xQueueSend(kTxJobs, &job, portMAX_DELAY);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+    if (huart != kHuart || !pData || Size == 0 || Size > CONF_WIRE_MAX_FRAME)
+        return HAL_ERROR;
+    if (huart->rx_buf)
+        return HAL_BUSY;
+    huart->rx_size = Size;
+    huart->rx_buf = pData;
+    return HAL_OK;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    vTaskDelay(pdMS_TO_TICKS(Delay));
+}
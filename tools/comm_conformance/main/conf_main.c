@@ -0,0 +1,689 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "conf_dut.h"
+#include "conf_wire.h"
+
+/*
+ * 协议一致性测试：comm.c 的两种构建（ESP32：comm_port_uart.c + 串口驱动；STM32：comm_stm32_hal_middle.c + HAL）
+ * 分别作为被测端，与一份参考协议栈通过连线模型对接，逐项检查：
+ * 帧格式、ACK、超时重发与去重、错误长度、和校验错误、回调顺序，最后测两个方向的吞吐。
+ * 被测端只经各自的链路端口收发，参考端和测试代码按协议说明独立构帧、检查发出的字节。
+ *
+ * 参数以 key=value 形式在命令行给出，例如：
+ *   ./build/comm_conformance.elf bps=115200 tput_s=2 stm32=0
+ * 全部通过时返回0，否则返回1。
+ */
+
+#define CONF_CMD_DATA           0x05
+#define CONF_CMD_ORDER          0x06
+#define CONF_CMD_TPUT           0x07
+#define CONF_NEED_ACK           0x80
+#define CONF_FRAME_OVERHEAD     8       // head(1)+len(1)+cmd(1)+id(4)+sum(1)
+#define CONF_MAX_PAYLOAD        (255 - CONF_FRAME_OVERHEAD)    // 长度字段只有1字节
+#define CONF_ORDER_FRAMES       40
+#define CONF_TX_RING            (COMM_SEND_QUEUE_LEN + 2)      // 零拷贝发送的缓冲轮换，同 comm_rpc.c
+#define CONF_BAD_TYPES          8
+#define CONF_MAX_MESSAGES       32
+
+enum
+{
+    CONF_BAD_HEAD = 1,
+    CONF_BAD_SUM = 2,
+    CONF_BAD_LEN = 3,
+    CONF_BAD_ACK = 4,
+};
+
+typedef struct
+{
+    const char *key;
+    double value;
+    const char *help;
+} ConfParam_t;
+
+static ConfParam_t kParams[] = {
+    {"bps", 115200, "连线速率（须大于0）"},
+    {"tput_s", 2, "每项吞吐测试时长"},
+    {"esp32", 1, "测试 ESP32 构建"},
+    {"stm32", 1, "测试 STM32 构建"},
+};
+
+// 每个协议栈的接收记录
+typedef struct
+{
+    volatile uint32_t count;
+    volatile uint32_t bytes;
+    uint16_t size;
+    uint8_t data[256];
+} ConfRx_t;
+
+typedef struct
+{
+    const char *name;
+    uint8_t link;
+    const SimStack_t *ref;
+    const SimStack_t *dut;
+    uint8_t ref_idx;
+    uint8_t dut_idx;
+} ConfPair_t;
+
+typedef struct
+{
+    double nak_goodput[2];      // 按方向：0 参考->被测，1 被测->参考（B/s）
+    double nak_efficiency[2];   // 有效吞吐 / 连线速率
+    uint32_t nak_lost[2];
+    double ack_rate[2];         // 停等ACK每秒完成的包数
+    uint32_t ack_failed[2];
+} ConfTput_t;
+
+static volatile uint32_t kBad[4][CONF_BAD_TYPES];
+static ConfRx_t kRx[4][3];              // [协议栈][CONF_CMD_DATA/ORDER/TPUT]
+static char kOrderLog[64];
+static volatile uint32_t kOrderNum;
+static uint32_t kOrderSeq[CONF_ORDER_FRAMES];
+static volatile uint32_t kOrderSeqNum;
+static uint32_t kInjectId = 0x7E000000;  // 注入帧的包ID，避开协议栈自己的ID（去重按ID判断）
+
+static uint8_t kTestFailed;
+static char kMessages[CONF_MAX_MESSAGES][160];
+static uint32_t kMessageNum;
+static uint32_t kPassed;
+static uint32_t kFailed;
+static ConfTput_t kTput[2];
+
+static double param(const char *key)
+{
+    for (size_t i = 0; i < sizeof(kParams) / sizeof(kParams[0]); i++)
+        if (strcmp(kParams[i].key, key) == 0)
+            return kParams[i].value;
+    return 0;
+}
+
+// linux 目标的 app_main 拿不到 argc/argv，直接读 /proc/self/cmdline（同 comm_sim）
+static void parse_args(void)
+{
+    static char buf[4096];
+    FILE *fp = fopen("/proc/self/cmdline", "rb");
+    if (!fp)
+        return;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = 0;
+
+    char *arg = buf + strlen(buf) + 1; // 跳过程序名
+    while (arg < buf + n)
+    {
+        char *eq = strchr(arg, '=');
+        uint8_t matched = 0;
+        if (eq)
+        {
+            *eq = 0;
+            for (size_t i = 0; i < sizeof(kParams) / sizeof(kParams[0]); i++)
+            {
+                if (strcmp(kParams[i].key, arg) == 0)
+                {
+                    kParams[i].value = atof(eq + 1);
+                    matched = 1;
+                }
+            }
+        }
+        if (!matched)
+        {
+            printf("未知参数: %s\n可用参数:\n", arg);
+            for (size_t i = 0; i < sizeof(kParams) / sizeof(kParams[0]); i++)
+                printf("  %-16s %-10g %s\n", kParams[i].key, kParams[i].value, kParams[i].help);
+            exit(1);
+        }
+        arg += strlen(arg) + 1;
+        if (eq)
+            arg += strlen(eq + 1) + 1;
+    }
+}
+
+/* -------------------- 回调 -------------------- */
+#define CONF_BAD_CB(idx)                        \
+    static void bad_cb_##idx(uint32_t type)     \
+    {                                           \
+        if (type < CONF_BAD_TYPES)              \
+            kBad[idx][type]++;                  \
+    }
+CONF_BAD_CB(0)
+CONF_BAD_CB(1)
+CONF_BAD_CB(2)
+CONF_BAD_CB(3)
+
+static void rx_cb(uint8_t *src, uint16_t size, void *user_data)
+{
+    ConfRx_t *rx = user_data;
+    if (size <= sizeof(rx->data))
+    {
+        memcpy(rx->data, src, size);
+        rx->size = size;
+    }
+    rx->bytes += size;
+    rx->count++;
+}
+
+static void order_cb(uint8_t *src, uint16_t size, void *user_data)
+{
+    if (kOrderNum < sizeof(kOrderLog) - 1)
+        kOrderLog[kOrderNum] = (char)(uintptr_t)user_data;
+    kOrderNum++;
+}
+
+static void order_seq_cb(uint8_t *src, uint16_t size, void *user_data)
+{
+    if (size == sizeof(uint32_t) && kOrderSeqNum < CONF_ORDER_FRAMES)
+        memcpy(&kOrderSeq[kOrderSeqNum], src, sizeof(uint32_t));
+    kOrderSeqNum++;
+}
+
+/* -------------------- 工具 -------------------- */
+static void check(uint8_t ok, const char *fmt, ...)
+{
+    if (ok)
+        return;
+    kTestFailed = 1;
+    if (kMessageNum >= CONF_MAX_MESSAGES)
+        return;
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(kMessages[kMessageNum++], sizeof(kMessages[0]), fmt, ap);
+    va_end(ap);
+}
+
+static uint8_t wait_for(volatile uint32_t *value, uint32_t target, uint32_t timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (*value < target)
+    {
+        if (xTaskGetTickCount() - start >= pdMS_TO_TICKS(timeout_ms))
+            return 0;
+        vTaskDelay(1);
+    }
+    return 1;
+}
+
+static uint32_t bad_total(uint8_t idx)
+{
+    uint32_t sum = 0;
+    for (int i = 0; i < CONF_BAD_TYPES; i++)
+        sum += kBad[idx][i];
+    return sum;
+}
+
+// 按协议说明独立构帧（不经过被测代码）
+static uint16_t build_frame(uint8_t *buf, uint8_t cmd, uint32_t id, const uint8_t *data, uint8_t size)
+{
+    buf[0] = 0x5A;
+    buf[1] = (uint8_t)(size + CONF_FRAME_OVERHEAD);
+    buf[2] = cmd;
+    memcpy(buf + 3, &id, 4);
+    memcpy(buf + 7, data, size);
+    uint8_t sum = 0;
+    for (int i = 0; i < size + 7; i++)
+        sum += buf[i];
+    buf[size + 7] = sum;
+    return (uint16_t)(size + CONF_FRAME_OVERHEAD);
+}
+
+// 检查一帧是否符合帧格式，返回包ID
+static uint8_t check_frame(const char *who, const uint8_t *frame, uint16_t len, uint8_t cmd,
+                           const uint8_t *data, uint16_t size, uint32_t *id)
+{
+    uint8_t ok = len == size + CONF_FRAME_OVERHEAD && frame[0] == 0x5A && frame[1] == len && frame[2] == cmd;
+    if (ok)
+    {
+        uint8_t sum = 0;
+        for (int i = 0; i < len - 1; i++)
+            sum += frame[i];
+        ok = sum == frame[len - 1] && memcmp(frame + 7, data, size) == 0;
+    }
+    check(ok, "%s: 发出的帧不符合帧格式（len %u cmd 0x%02X）", who, len, len > 2 ? frame[2] : 0);
+    if (ok && id)
+        memcpy(id, frame + 3, 4);
+    return ok;
+}
+
+static void fill_pattern(uint8_t *buf, uint16_t size, uint8_t seed)
+{
+    for (uint16_t i = 0; i < size; i++)
+        buf[i] = (uint8_t)(seed + i * 7);
+}
+
+/* -------------------- 测试项 -------------------- */
+// 两个方向的各种长度：接收内容一致，发出的字节符合帧格式；可接收参考构帧，包头前的噪声被跳过
+static void test_framing(const ConfPair_t *p)
+{
+    static uint8_t buf[2][256];
+    static const uint16_t kSizes[] = {1, 7, 64, 200, CONF_MAX_PAYLOAD};
+    for (uint8_t dir = 0; dir < 2; dir++)
+    {
+        const SimStack_t *tx = dir == CONF_DIR_TO_DUT ? p->ref : p->dut;
+        ConfRx_t *rx = &kRx[dir == CONF_DIR_TO_DUT ? p->dut_idx : p->ref_idx][0];
+        const char *who = dir == CONF_DIR_TO_DUT ? "参考->被测" : "被测->参考";
+        for (size_t i = 0; i < sizeof(kSizes) / sizeof(kSizes[0]); i++)
+        {
+            uint16_t size = kSizes[i];
+            uint8_t *data = buf[i & 1];
+            fill_pattern(data, size, (uint8_t)(size + dir));
+            uint32_t before = rx->count;
+            check(tx->send_nak(data, CONF_CMD_DATA, size), "%s: %u字节入队失败", who, size);
+            uint8_t got = wait_for(&rx->count, before + 1, 200 + conf_wire_airtime_ms(p->link, size));
+            check(got && rx->size == size && memcmp(rx->data, data, size) == 0, "%s: %u字节未收到或内容不一致", who, size);
+            uint8_t frame[CONF_WIRE_MAX_FRAME];
+            uint16_t len = conf_wire_last_frame(p->link, dir, frame);
+            check_frame(who, frame, len, CONF_CMD_DATA, data, size, NULL);
+        }
+
+        // 超长数据不发送（不会被截断成错误的帧）
+        ConfWireStats_t ws_before, ws_after;
+        conf_wire_get_stats(p->link, dir, &ws_before);
+        tx->send_nak(buf[0], CONF_CMD_DATA, CONF_MAX_PAYLOAD + 1);
+        vTaskDelay(pdMS_TO_TICKS(50));
+        conf_wire_get_stats(p->link, dir, &ws_after);
+        check(ws_after.frames == ws_before.frames, "%s: 超长数据被发出", who);
+    }
+
+    // 参考构帧 + 包头前的噪声
+    static const uint8_t kNoise[] = {0x00, 0x13, 0x37};
+    uint8_t data[16], frame[32];
+    fill_pattern(data, sizeof(data), 0x42);
+    uint16_t len = build_frame(frame, CONF_CMD_DATA, kInjectId++, data, sizeof(data));
+    ConfRx_t *rx = &kRx[p->dut_idx][0];
+    uint32_t before = rx->count;
+    uint32_t bad_head = kBad[p->dut_idx][CONF_BAD_HEAD];
+    conf_wire_inject(p->link, CONF_DIR_TO_DUT, kNoise, sizeof(kNoise));
+    conf_wire_inject(p->link, CONF_DIR_TO_DUT, frame, len);
+    uint8_t got = wait_for(&rx->count, before + 1, 200);
+    check(got && rx->size == sizeof(data) && memcmp(rx->data, data, sizeof(data)) == 0, "被测端: 未收到参考构帧");
+    check(kBad[p->dut_idx][CONF_BAD_HEAD] - bad_head == sizeof(kNoise), "被测端: 噪声字节报告 %lu 次包头错误，应为 %u",
+          (unsigned long)(kBad[p->dut_idx][CONF_BAD_HEAD] - bad_head), (unsigned)sizeof(kNoise));
+}
+
+// 需要ACK的包：两个方向都一次成功，ACK帧格式正确且包ID与数据帧一致
+static void test_ack(const ConfPair_t *p)
+{
+    static uint8_t data[32];
+    fill_pattern(data, sizeof(data), 0x11);
+    for (uint8_t dir = 0; dir < 2; dir++)
+    {
+        const SimStack_t *tx = dir == CONF_DIR_TO_DUT ? p->ref : p->dut;
+        const SimStack_t *rx_stack = dir == CONF_DIR_TO_DUT ? p->dut : p->ref;
+        ConfRx_t *rx = &kRx[dir == CONF_DIR_TO_DUT ? p->dut_idx : p->ref_idx][0];
+        const char *who = dir == CONF_DIR_TO_DUT ? "参考->被测" : "被测->参考";
+
+        CommStats_t tx_before, tx_after, rx_before, rx_after;
+        tx->get_stats(&tx_before);
+        rx_stack->get_stats(&rx_before);
+        uint32_t before = rx->count;
+        uint32_t ok = tx->send_ack(data, CONF_CMD_DATA, sizeof(data), 100, 0);
+        tx->get_stats(&tx_after);
+        rx_stack->get_stats(&rx_after);
+        check(ok, "%s: 没有收到ACK", who);
+        check(rx->count == before + 1, "%s: 接收端分发 %lu 次，应为1次", who, (unsigned long)(rx->count - before));
+        check(tx_after.rx_acks - tx_before.rx_acks == 1 && rx_after.tx_acks - rx_before.tx_acks == 1,
+              "%s: ACK计数不符（发 %lu 收 %lu）", who, (unsigned long)(rx_after.tx_acks - rx_before.tx_acks),
+              (unsigned long)(tx_after.rx_acks - tx_before.rx_acks));
+
+        uint8_t frame[CONF_WIRE_MAX_FRAME], ack[CONF_WIRE_MAX_FRAME];
+        uint32_t id = 0;
+        uint16_t len = conf_wire_last_frame(p->link, dir, frame);
+        check_frame(who, frame, len, CONF_CMD_DATA | CONF_NEED_ACK, data, sizeof(data), &id);
+        uint16_t ack_len = conf_wire_last_frame(p->link, dir ^ 1, ack);
+        check(ack_len == 5 && ack[0] == 0xAA && memcmp(ack + 1, &id, 4) == 0, "%s: ACK帧格式或包ID不符", who);
+    }
+}
+
+// 超时重发、重试耗尽、ACK丢失后的去重（两个方向）
+static void test_retry(const ConfPair_t *p)
+{
+    static uint8_t data[48];
+    fill_pattern(data, sizeof(data), 0x23);
+    for (uint8_t dir = 0; dir < 2; dir++)
+    {
+        const SimStack_t *tx = dir == CONF_DIR_TO_DUT ? p->ref : p->dut;
+        const SimStack_t *rx_stack = dir == CONF_DIR_TO_DUT ? p->dut : p->ref;
+        ConfRx_t *rx = &kRx[dir == CONF_DIR_TO_DUT ? p->dut_idx : p->ref_idx][0];
+        const char *who = dir == CONF_DIR_TO_DUT ? "参考->被测" : "被测->参考";
+        CommStats_t tx_before, tx_after, rx_before, rx_after;
+
+        // 数据帧丢两次，第三次成功
+        tx->get_stats(&tx_before);
+        uint32_t before = rx->count;
+        conf_wire_drop_next(p->link, dir, 2);
+        uint32_t ok = tx->send_ack(data, CONF_CMD_DATA, sizeof(data), 100, 3);
+        tx->get_stats(&tx_after);
+        check(ok && rx->count == before + 1, "%s: 丢两帧后重发未成功", who);
+        check(tx_after.retransmits - tx_before.retransmits == 2, "%s: 重发 %lu 次，应为2次", who,
+              (unsigned long)(tx_after.retransmits - tx_before.retransmits));
+
+        // 重试耗尽
+        tx->get_stats(&tx_before);
+        before = rx->count;
+        conf_wire_drop_next(p->link, dir, 3);
+        ok = tx->send_ack(data, CONF_CMD_DATA, sizeof(data), 50, 2);
+        tx->get_stats(&tx_after);
+        check(!ok && rx->count == before, "%s: 全部丢失时应返回失败", who);
+        check(tx_after.send_failed - tx_before.send_failed == 1, "%s: send_failed 未计数", who);
+
+        // ACK 丢失：发送端重发，接收端回复ACK但不重复分发
+        tx->get_stats(&tx_before);
+        rx_stack->get_stats(&rx_before);
+        before = rx->count;
+        conf_wire_drop_next(p->link, dir ^ 1, 1);
+        ok = tx->send_ack(data, CONF_CMD_DATA, sizeof(data), 100, 3);
+        vTaskDelay(pdMS_TO_TICKS(20));
+        tx->get_stats(&tx_after);
+        rx_stack->get_stats(&rx_after);
+        check(ok, "%s: ACK丢失后重发未成功", who);
+        check(rx->count == before + 1 && rx_after.rx_duplicates - rx_before.rx_duplicates == 1,
+              "%s: ACK丢失后分发 %lu 次、重复包 %lu 个，应为1/1", who, (unsigned long)(rx->count - before),
+              (unsigned long)(rx_after.rx_duplicates - rx_before.rx_duplicates));
+    }
+}
+
+// 错误长度：过短、截断的数据帧和截断的ACK都按长度错误丢弃，之后的正常帧照常接收
+static void test_bad_length(const ConfPair_t *p)
+{
+    static const struct
+    {
+        const char *name;
+        uint8_t bytes[16];
+        uint8_t size;
+        uint8_t type;
+    } kCases[] = {
+        {"长度字段过短", {0x5A, 3}, 2, CONF_BAD_LEN},
+        {"长度字段为0", {0x5A, 0}, 2, CONF_BAD_LEN},
+        {"数据帧截断", {0x5A, 40, CONF_CMD_DATA, 1, 2, 3, 4, 9, 9, 9, 9, 9, 9, 9, 9, 9}, 16, CONF_BAD_LEN},
+        {"ACK帧截断", {0xAA, 1, 2}, 3, CONF_BAD_ACK},
+    };
+    uint8_t data[24], frame[40];
+    fill_pattern(data, sizeof(data), 0x37);
+    ConfRx_t *rx = &kRx[p->dut_idx][0];
+    for (size_t i = 0; i < sizeof(kCases) / sizeof(kCases[0]); i++)
+    {
+        uint32_t bad_before = bad_total(p->dut_idx);
+        uint32_t type_before = kBad[p->dut_idx][kCases[i].type];
+        uint32_t before = rx->count;
+        conf_wire_inject(p->link, CONF_DIR_TO_DUT, kCases[i].bytes, kCases[i].size);
+        vTaskDelay(pdMS_TO_TICKS(100)); // 等被测端读超时放弃这一帧
+        uint16_t len = build_frame(frame, CONF_CMD_DATA, kInjectId++, data, sizeof(data));
+        conf_wire_inject(p->link, CONF_DIR_TO_DUT, frame, len);
+        uint8_t got = wait_for(&rx->count, before + 1, 200);
+        vTaskDelay(pdMS_TO_TICKS(20));
+        check(got && rx->count == before + 1 && rx->size == sizeof(data), "%s: 之后的正常帧未收到", kCases[i].name);
+        check(kBad[p->dut_idx][kCases[i].type] - type_before == 1 && bad_total(p->dut_idx) - bad_before == 1,
+              "%s: 报告 %lu 个错误（类型%u %lu 个），应为1个", kCases[i].name,
+              (unsigned long)(bad_total(p->dut_idx) - bad_before), kCases[i].type,
+              (unsigned long)(kBad[p->dut_idx][kCases[i].type] - type_before));
+    }
+}
+
+// 和校验错误：不分发、不回复ACK；传输中损坏的帧由重发恢复；损坏的ACK被忽略
+static void test_checksum(const ConfPair_t *p)
+{
+    static uint8_t data[40];
+    fill_pattern(data, sizeof(data), 0x51);
+    ConfRx_t *rx = &kRx[p->dut_idx][0];
+    CommStats_t dut_before, dut_after, ref_before, ref_after;
+
+    // 参考构帧，和校验取反
+    uint8_t frame[64];
+    uint16_t len = build_frame(frame, CONF_CMD_DATA | CONF_NEED_ACK, kInjectId++, data, sizeof(data));
+    frame[len - 1] ^= 0xFF;
+    p->dut->get_stats(&dut_before);
+    uint32_t before = rx->count;
+    uint32_t bad_sum = kBad[p->dut_idx][CONF_BAD_SUM];
+    conf_wire_inject(p->link, CONF_DIR_TO_DUT, frame, len);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    p->dut->get_stats(&dut_after);
+    check(kBad[p->dut_idx][CONF_BAD_SUM] - bad_sum == 1, "被测端: 和校验错误未报告");
+    check(rx->count == before && dut_after.tx_acks == dut_before.tx_acks, "被测端: 和校验错误的帧被分发或回复了ACK");
+
+    // 参考端发出的帧在连线上损坏
+    p->dut->get_stats(&dut_before);
+    p->ref->get_stats(&ref_before);
+    before = rx->count;
+    bad_sum = kBad[p->dut_idx][CONF_BAD_SUM];
+    conf_wire_corrupt_next(p->link, CONF_DIR_TO_DUT, 1);
+    uint32_t ok = p->ref->send_ack(data, CONF_CMD_DATA, sizeof(data), 100, 2);
+    p->ref->get_stats(&ref_after);
+    check(ok && rx->count == before + 1, "参考->被测: 损坏后重发未成功");
+    check(kBad[p->dut_idx][CONF_BAD_SUM] - bad_sum == 1, "被测端: 损坏的帧未按和校验错误报告");
+    check(ref_after.retransmits - ref_before.retransmits == 1, "参考->被测: 重发 %lu 次，应为1次",
+          (unsigned long)(ref_after.retransmits - ref_before.retransmits));
+
+    // 被测端回复的ACK在连线上损坏（包ID不符）：参考端重发，被测端去重
+    p->dut->get_stats(&dut_before);
+    before = rx->count;
+    conf_wire_corrupt_next(p->link, CONF_DIR_TO_REF, 1);
+    ok = p->ref->send_ack(data, CONF_CMD_DATA, sizeof(data), 100, 2);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    p->dut->get_stats(&dut_after);
+    check(ok && rx->count == before + 1, "参考->被测: ACK损坏后分发 %lu 次，应为1次", (unsigned long)(rx->count - before));
+    check(dut_after.rx_duplicates - dut_before.rx_duplicates == 1, "被测端: 重发的包未按重复包处理");
+}
+
+// 同一命令的多个回调按注册顺序执行，取消注册后其余顺序不变；连续的包按发送顺序分发（两个方向）
+static void test_callback_order(const ConfPair_t *p)
+{
+    static uint8_t data[4];
+    uint32_t id_a = p->dut->register_recv_cb(order_cb, CONF_CMD_ORDER, (void *)(uintptr_t)'A');
+    uint32_t id_b = p->dut->register_recv_cb(order_cb, CONF_CMD_ORDER, (void *)(uintptr_t)'B');
+    uint32_t id_c = p->dut->register_recv_cb(order_cb, CONF_CMD_ORDER, (void *)(uintptr_t)'C');
+
+    memset(kOrderLog, 0, sizeof(kOrderLog));
+    kOrderNum = 0;
+    p->ref->send_nak(data, CONF_CMD_ORDER, sizeof(data));
+    wait_for(&kOrderNum, 3, 200);
+    check(kOrderNum == 3 && memcmp(kOrderLog, "ABC", 3) == 0, "回调顺序为 \"%s\"，应为 \"ABC\"", kOrderLog);
+
+    p->dut->unregister_recv_cb(id_b);
+    memset(kOrderLog, 0, sizeof(kOrderLog));
+    kOrderNum = 0;
+    p->ref->send_nak(data, CONF_CMD_ORDER, sizeof(data));
+    wait_for(&kOrderNum, 2, 200);
+    vTaskDelay(pdMS_TO_TICKS(20));
+    check(kOrderNum == 2 && memcmp(kOrderLog, "AC", 2) == 0, "取消注册后回调顺序为 \"%s\"，应为 \"AC\"", kOrderLog);
+    p->dut->unregister_recv_cb(id_a);
+    p->dut->unregister_recv_cb(id_c);
+
+    static uint32_t seq[CONF_ORDER_FRAMES];
+    for (uint8_t dir = 0; dir < 2; dir++)
+    {
+        const SimStack_t *tx = dir == CONF_DIR_TO_DUT ? p->ref : p->dut;
+        const SimStack_t *rx_stack = dir == CONF_DIR_TO_DUT ? p->dut : p->ref;
+        const char *who = dir == CONF_DIR_TO_DUT ? "参考->被测" : "被测->参考";
+        uint32_t id = rx_stack->register_recv_cb(order_seq_cb, CONF_CMD_ORDER, NULL);
+        kOrderSeqNum = 0;
+        for (uint32_t i = 0; i < CONF_ORDER_FRAMES; i++)
+        {
+            seq[i] = i;
+            while (!tx->send_nak((uint8_t *)&seq[i], CONF_CMD_ORDER, sizeof(uint32_t)))
+                vTaskDelay(1);
+        }
+        wait_for(&kOrderSeqNum, CONF_ORDER_FRAMES, 1000);
+        vTaskDelay(pdMS_TO_TICKS(20));
+        uint32_t in_order = 1;
+        for (uint32_t i = 0; i < CONF_ORDER_FRAMES && i < kOrderSeqNum; i++)
+            in_order &= kOrderSeq[i] == i;
+        check(kOrderSeqNum == CONF_ORDER_FRAMES && in_order, "%s: 连续发送 %u 包，收到 %lu 包%s", who,
+              CONF_ORDER_FRAMES, (unsigned long)kOrderSeqNum, in_order ? "" : "且顺序错乱");
+        rx_stack->unregister_recv_cb(id);
+    }
+}
+
+// 吞吐：两个方向分别测不确认的连续发送和停等ACK
+static void test_throughput(const ConfPair_t *p)
+{
+    static uint8_t ring[CONF_TX_RING][200];
+    static uint8_t ack_data[64];
+    ConfTput_t *t = &kTput[p->link];
+    uint32_t duration_ms = (uint32_t)(param("tput_s") * 1000);
+    double wire_bytes = param("bps") / 10.0;
+    uint32_t frame_ms = conf_wire_airtime_ms(p->link, sizeof(ring[0]) + CONF_FRAME_OVERHEAD);
+    uint32_t ack_timeout_ms = 3 * (conf_wire_airtime_ms(p->link, sizeof(ack_data) + CONF_FRAME_OVERHEAD) +
+                                   conf_wire_airtime_ms(p->link, 5)) + 30;
+    for (uint8_t dir = 0; dir < 2; dir++)
+    {
+        const SimStack_t *tx = dir == CONF_DIR_TO_DUT ? p->ref : p->dut;
+        ConfRx_t *rx = &kRx[dir == CONF_DIR_TO_DUT ? p->dut_idx : p->ref_idx][2];
+        const char *who = dir == CONF_DIR_TO_DUT ? "参考->被测" : "被测->参考";
+
+        // 不确认：发送队列满就等1ms
+        uint32_t sent = 0;
+        uint32_t before = rx->count, bytes_before = rx->bytes;
+        TickType_t start = xTaskGetTickCount();
+        while (xTaskGetTickCount() - start < pdMS_TO_TICKS(duration_ms))
+        {
+            uint8_t *buf = ring[sent % CONF_TX_RING];
+            fill_pattern(buf, sizeof(ring[0]), (uint8_t)sent);
+            if (tx->send_nak(buf, CONF_CMD_TPUT, sizeof(ring[0])))
+                sent++;
+            else
+                vTaskDelay(1);
+        }
+        // 停止发送时两端队列里还有若干帧（comm.c 发送队列 + 适配层发送队列），等它们发完
+        wait_for(&rx->count, before + sent, (COMM_SEND_QUEUE_LEN + 12) * frame_ms + 500);
+        double seconds = (xTaskGetTickCount() - start) / (double)configTICK_RATE_HZ;
+        uint32_t recv = rx->count - before;
+        t->nak_lost[dir] = sent > recv ? sent - recv : 0;
+        t->nak_goodput[dir] = (rx->bytes - bytes_before) / seconds;
+        t->nak_efficiency[dir] = t->nak_goodput[dir] / wire_bytes;
+        check(t->nak_lost[dir] == 0, "%s: 不确认连续发送丢失 %lu/%lu 包", who, (unsigned long)t->nak_lost[dir],
+              (unsigned long)sent);
+
+        // 停等ACK，超时按数据帧+ACK的发送时间留足余量
+        uint32_t ok = 0, failed = 0;
+        start = xTaskGetTickCount();
+        while (xTaskGetTickCount() - start < pdMS_TO_TICKS(duration_ms))
+        {
+            if (tx->send_ack(ack_data, CONF_CMD_TPUT, sizeof(ack_data), ack_timeout_ms, 0))
+                ok++;
+            else
+                failed++;
+        }
+        seconds = (xTaskGetTickCount() - start) / (double)configTICK_RATE_HZ;
+        t->ack_rate[dir] = ok / seconds;
+        t->ack_failed[dir] = failed;
+        check(failed == 0, "%s: 停等ACK失败 %lu 次", who, (unsigned long)failed);
+    }
+}
+
+/* -------------------- 运行与报告 -------------------- */
+typedef struct
+{
+    const char *name;
+    void (*run)(const ConfPair_t *p);
+} ConfTest_t;
+
+static const ConfTest_t kTests[] = {
+    {"framing", test_framing},
+    {"ack", test_ack},
+    {"retry", test_retry},
+    {"bad_length", test_bad_length},
+    {"checksum", test_checksum},
+    {"callback_order", test_callback_order},
+    {"throughput", test_throughput},
+};
+
+static void run_pair(const ConfPair_t *p)
+{
+    for (size_t i = 0; i < sizeof(kTests) / sizeof(kTests[0]); i++)
+    {
+        kTestFailed = 0;
+        kMessageNum = 0;
+        kTests[i].run(p);
+        conf_wire_drop_next(p->link, CONF_DIR_TO_DUT, 0);
+        conf_wire_drop_next(p->link, CONF_DIR_TO_REF, 0);
+        vTaskDelay(pdMS_TO_TICKS(50));  // 等残留的帧投递完，不影响下一项
+        printf("[%s] %-16s %s\n", p->name, kTests[i].name, kTestFailed ? "FAIL" : "PASS");
+        for (uint32_t m = 0; m < kMessageNum; m++)
+            printf("        - %s\n", kMessages[m]);
+        if (kTestFailed)
+            kFailed++;
+        else
+            kPassed++;
+    }
+}
+
+static void print_throughput(const ConfPair_t *p)
+{
+    const ConfTput_t *t = &kTput[p->link];
+    for (uint8_t dir = 0; dir < 2; dir++)
+    {
+        printf("%-6s %-12s nak %8.1f B/s (%5.1f%%, lost %lu)   ack %6.1f pack/s (failed %lu)\n", p->name,
+               dir == CONF_DIR_TO_DUT ? "ref->dut" : "dut->ref", t->nak_goodput[dir], t->nak_efficiency[dir] * 100,
+               (unsigned long)t->nak_lost[dir], t->ack_rate[dir], (unsigned long)t->ack_failed[dir]);
+    }
+}
+
+static void register_receivers(const SimStack_t *stack, uint8_t idx)
+{
+    stack->register_recv_cb(rx_cb, CONF_CMD_DATA, &kRx[idx][0]);
+    stack->register_recv_cb(rx_cb, CONF_CMD_TPUT, &kRx[idx][2]);
+}
+
+void app_main(void)
+{
+    parse_args();
+    if (param("bps") <= 0)
+    {
+        // 不限速时发送端可以无限快，接收缓冲必然溢出，吞吐和丢包都没有意义
+        printf("bps 必须大于0\n");
+        exit(1);
+    }
+
+    static const ConfPair_t kPairs[] = {
+        {"esp32", CONF_LINK_ESP32, &conf_ref_esp32, &conf_dut_esp32, 0, 1},
+        {"stm32", CONF_LINK_STM32, &conf_ref_stm32, &conf_dut_stm32, 2, 3},
+    };
+    static const BadDataPackCb_t kBadCb[4] = {bad_cb_0, bad_cb_1, bad_cb_2, bad_cb_3};
+    uint8_t enabled[2] = {(uint8_t)param("esp32"), (uint8_t)param("stm32")};
+
+    for (int i = 0; i < 2; i++)
+    {
+        const ConfPair_t *p = &kPairs[i];
+        if (!enabled[i])
+            continue;
+        conf_wire_init(p->link, (uint32_t)param("bps"));
+        p->ref->init(kBadCb[p->ref_idx], conf_wire_ref_port(p->link));
+        if (p->link == CONF_LINK_ESP32)
+            RemoteCommInit(kBadCb[p->dut_idx]);
+        else
+            p->dut->init(kBadCb[p->dut_idx], conf_stm32_port());
+        register_receivers(p->ref, p->ref_idx);
+        register_receivers(p->dut, p->dut_idx);
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+
+    printf("\n========== comm_conformance ==========\n");
+    for (size_t i = 0; i < sizeof(kParams) / sizeof(kParams[0]); i++)
+        printf("%s=%g ", kParams[i].key, kParams[i].value);
+    printf("\n\n");
+
+    for (int i = 0; i < 2; i++)
+    {
+        if (enabled[i])
+            run_pair(&kPairs[i]);
+    }
+
+    printf("\nthroughput (bps=%g, payload 200B nak / 64B ack)\n", param("bps"));
+    for (int i = 0; i < 2; i++)
+    {
+        if (enabled[i])
+            print_throughput(&kPairs[i]);
+    }
+    if (enabled[1] && conf_stm32_rx_overrun())
+        printf("stm32 HAL rx overrun %lu bytes\n", (unsigned long)conf_stm32_rx_overrun());
+
+    printf("\n%lu passed, %lu failed\n", (unsigned long)kPassed, (unsigned long)kFailed);
+    fflush(stdout);
+    exit(kFailed ? 1 : 0);
+}
@@ -0,0 +1,6 @@
+#define SIM_STACK_PREFIX dute_
+#define SIM_STACK_NAME conf_dut_esp32
+#include "sim_stack_impl.h"
+
+// 与遥控器固件相同，经 comm_port_uart.c 使用串口驱动（RemoteCommInit 只有这一份）
+#include "comm_port_uart.c"
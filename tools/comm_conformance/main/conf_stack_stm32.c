@@ -0,0 +1,3 @@
+#define SIM_STACK_PREFIX duts_
+#define SIM_STACK_NAME conf_dut_stm32
+#include "sim_stack_impl.h"
@@ -0,0 +1,33 @@
+/*
+ * STM32 构建的应用层接线（同 stm32_port/example_usage.c）：HAL 中断回调转给适配层，
+ * 适配层的链路端口交给被测协议栈。
+ */
+#include "comm_stm32_hal_middle.h"
+#include "conf_dut.h"
+#include "conf_wire.h"
+
+static UART_HandleTypeDef kHuart;
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (g_comm_handle != NULL)
+        Comm_UART_TxCplt_IRQ_Handle(g_comm_handle, huart);
+}
+
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (g_comm_handle != NULL)
+        Comm_UART_IRQ_Handle(g_comm_handle, huart, g_comm_handle->dma_temp_buffer, Size);
+}
+
+const CommPort_t *conf_stm32_port(void)
+{
+    conf_hal_uart_init(&kHuart, CONF_LINK_STM32);
+    CommHandle_t *handle = Comm_Init(&kHuart);
+    return handle ? Comm_GetPort(handle) : NULL;
+}
+
+uint32_t conf_stm32_rx_overrun(void)
+{
+    return kHuart.rx_overrun;
+}
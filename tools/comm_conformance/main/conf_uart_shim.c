@@ -0,0 +1,44 @@
+#include "driver/uart.h"
+#include "conf_wire.h"
+
+// ESP32 构建的被测端固定接在连线 0
+static StreamBufferHandle_t kUartRx;
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t *uart_queue, int intr_alloc_flags)
+{
+    if (uart_num != UART_NUM_1 || kUartRx)
+        return ESP_FAIL;
+    // 与真实驱动一样，接收缓冲满后新到的数据被丢弃
+    kUartRx = xStreamBufferCreate(rx_buffer_size, 1);
+    if (uart_queue)
+        *uart_queue = xQueueCreate(queue_size ? queue_size : 1, sizeof(uint32_t));
+    conf_wire_set_sink(CONF_LINK_ESP32, CONF_DIR_TO_DUT, conf_wire_stream_sink, kUartRx);
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    if (!kUartRx)
+        return -1;
+    uint32_t timeout_ms = (ticks_to_wait == portMAX_DELAY) ? portMAX_DELAY : ticks_to_wait * portTICK_PERIOD_MS;
+    return conf_wire_stream_read(kUartRx, buf, (uint16_t)length, timeout_ms);
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size)
+{
+    if (!kUartRx)
+        return -1;
+    conf_wire_write(CONF_LINK_ESP32, CONF_DIR_TO_REF, src, (uint16_t)size);
+    return (int)size;
+}
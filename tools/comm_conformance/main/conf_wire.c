@@ -0,0 +1,263 @@
+#include "conf_wire.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+#define CONF_WIRE_PENDING       32
+#define CONF_REF_RX_SIZE        2048
+
+typedef struct
+{
+    uint8_t used;
+    uint8_t dir;
+    uint16_t size;
+    int64_t deliver_ms;
+    uint8_t data[CONF_WIRE_MAX_FRAME];
+} ConfFrame_t;
+
+typedef struct
+{
+    uint32_t bps;
+    SemaphoreHandle_t mutex;
+    ConfFrame_t pending[CONF_WIRE_PENDING];
+    int64_t busy_until[2];
+    uint32_t drop_next[2];
+    uint32_t corrupt_next[2];
+    ConfWireSink_t sink[2];
+    void *sink_ctx[2];
+    uint16_t last_size[2];
+    uint8_t last[2][CONF_WIRE_MAX_FRAME];
+    ConfWireStats_t stats[2];
+    StreamBufferHandle_t ref_rx;
+    CommPort_t ref_port;
+} ConfLink_t;
+
+static ConfLink_t kLinks[CONF_WIRE_LINKS];
+static uint8_t kDeliverTaskStarted;
+
+static int64_t max64(int64_t a, int64_t b)
+{
+    return a > b ? a : b;
+}
+
+uint32_t conf_wire_airtime_ms(uint8_t link, uint32_t size)
+{
+    uint32_t bps = kLinks[link].bps;
+    return bps ? (size * 10u * 1000u + bps - 1) / bps : 0;
+}
+
+// 排入一帧并阻塞到它开始发送，fault 为0时不做故障注入
+static void wire_send(uint8_t link, uint8_t dir, const uint8_t *data, uint16_t size, uint8_t fault)
+{
+    ConfLink_t *l = &kLinks[link];
+    if (size > CONF_WIRE_MAX_FRAME)
+        size = CONF_WIRE_MAX_FRAME;
+
+    xSemaphoreTake(l->mutex, portMAX_DELAY);
+    int64_t now = comm_get_time_ms();
+    int64_t start = max64(now, l->busy_until[dir]);
+    l->busy_until[dir] = start + conf_wire_airtime_ms(link, size);
+
+    ConfFrame_t *f = NULL;
+    for (int i = 0; i < CONF_WIRE_PENDING && !f; i++)
+    {
+        if (!l->pending[i].used)
+            f = &l->pending[i];
+    }
+
+    uint8_t lost = 0;
+    if (fault)
+    {
+        l->stats[dir].frames++;
+        memcpy(l->last[dir], data, size);
+        l->last_size[dir] = size;
+        if (l->drop_next[dir])
+        {
+            l->drop_next[dir]--;
+            l->stats[dir].dropped++;
+            lost = 1;
+        }
+    }
+    if (!lost && !f)
+    {
+        l->stats[dir].overflow++;
+        lost = 1;
+    }
+    if (!lost)
+    {
+        f->used = 1;
+        f->dir = dir;
+        f->size = size;
+        f->deliver_ms = l->busy_until[dir];
+        memcpy(f->data, data, size);
+        if (fault && l->corrupt_next[dir])
+        {
+            l->corrupt_next[dir]--;
+            l->stats[dir].corrupted++;
+            f->data[size - 1] ^= 0x80;
+        }
+    }
+    xSemaphoreGive(l->mutex);
+
+    int64_t wait = start - comm_get_time_ms();
+    if (wait > 0)
+        vTaskDelay(pdMS_TO_TICKS((uint32_t)wait));
+}
+
+static void ConfWireTask(void *param)
+{
+    while (1)
+    {
+        vTaskDelay(1);
+        int64_t now = comm_get_time_ms();
+        for (int n = 0; n < CONF_WIRE_LINKS; n++)
+        {
+            ConfLink_t *l = &kLinks[n];
+            if (!l->mutex)
+                continue;
+            while (1)
+            {
+                // 按发送结束时间先后投递；投递时不持有锁，接收函数里可以再写连线
+                ConfFrame_t frame;
+                xSemaphoreTake(l->mutex, portMAX_DELAY);
+                ConfFrame_t *due = NULL;
+                for (int i = 0; i < CONF_WIRE_PENDING; i++)
+                {
+                    ConfFrame_t *f = &l->pending[i];
+                    if (f->used && f->deliver_ms <= now && (!due || f->deliver_ms < due->deliver_ms))
+                        due = f;
+                }
+                if (due)
+                {
+                    frame = *due;
+                    due->used = 0;
+                    l->stats[frame.dir].bytes += frame.size;
+                }
+                ConfWireSink_t sink = due ? l->sink[frame.dir] : NULL;
+                void *ctx = due ? l->sink_ctx[frame.dir] : NULL;
+                xSemaphoreGive(l->mutex);
+                if (!due)
+                    break;
+                if (sink)
+                    sink(ctx, frame.data, frame.size);
+            }
+        }
+    }
+}
+
+void conf_wire_stream_sink(void *ctx, const uint8_t *data, uint16_t size)
+{
+    xStreamBufferSend((StreamBufferHandle_t)ctx, data, size, 0);
+}
+
+int conf_wire_stream_read(StreamBufferHandle_t rx, uint8_t *dst, uint16_t size, uint32_t timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    uint16_t got = 0;
+    while (got < size)
+    {
+        TickType_t wait = portMAX_DELAY;
+        if (timeout_ms != portMAX_DELAY)
+        {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= pdMS_TO_TICKS(timeout_ms))
+                break;
+            wait = pdMS_TO_TICKS(timeout_ms) - elapsed;
+        }
+        size_t n = xStreamBufferReceive(rx, dst + got, size - got, wait);
+        if (n == 0 && timeout_ms != portMAX_DELAY)
+            break;
+        got += n;
+    }
+    return got;
+}
+
+static int ref_port_read(void *port_data, uint8_t *dst, uint16_t size, uint32_t timeout_ms)
+{
+    ConfLink_t *l = port_data;
+    return conf_wire_stream_read(l->ref_rx, dst, size, timeout_ms);
+}
+
+static int ref_port_write(void *port_data, const uint8_t *src, uint16_t size)
+{
+    ConfLink_t *l = port_data;
+    conf_wire_write((uint8_t)(l - kLinks), CONF_DIR_TO_DUT, src, size);
+    return size;
+}
+
+void conf_wire_init(uint8_t link, uint32_t bps)
+{
+    ConfLink_t *l = &kLinks[link];
+    memset(l, 0, sizeof(*l));
+    l->bps = bps;
+    l->mutex = xSemaphoreCreateMutex();
+    l->ref_rx = xStreamBufferCreate(CONF_REF_RX_SIZE, 1);
+    l->ref_port.read = ref_port_read;
+    l->ref_port.write = ref_port_write;
+    l->ref_port.port_data = l;
+    l->sink[CONF_DIR_TO_REF] = conf_wire_stream_sink;
+    l->sink_ctx[CONF_DIR_TO_REF] = l->ref_rx;
+    if (!kDeliverTaskStarted)
+    {
+        kDeliverTaskStarted = 1;
+        xTaskCreate(ConfWireTask, "confWire", 4096, NULL, 10, NULL);
+    }
+}
+
+void conf_wire_set_sink(uint8_t link, uint8_t dir, ConfWireSink_t sink, void *ctx)
+{
+    ConfLink_t *l = &kLinks[link];
+    xSemaphoreTake(l->mutex, portMAX_DELAY);
+    l->sink[dir] = sink;
+    l->sink_ctx[dir] = ctx;
+    xSemaphoreGive(l->mutex);
+}
+
+void conf_wire_write(uint8_t link, uint8_t dir, const uint8_t *data, uint16_t size)
+{
+    wire_send(link, dir, data, size, 1);
+}
+
+void conf_wire_inject(uint8_t link, uint8_t dir, const uint8_t *data, uint16_t size)
+{
+    wire_send(link, dir, data, size, 0);
+}
+
+void conf_wire_drop_next(uint8_t link, uint8_t dir, uint32_t num)
+{
+    ConfLink_t *l = &kLinks[link];
+    xSemaphoreTake(l->mutex, portMAX_DELAY);
+    l->drop_next[dir] = num;
+    xSemaphoreGive(l->mutex);
+}
+
+void conf_wire_corrupt_next(uint8_t link, uint8_t dir, uint32_t num)
+{
+    ConfLink_t *l = &kLinks[link];
+    xSemaphoreTake(l->mutex, portMAX_DELAY);
+    l->corrupt_next[dir] = num;
+    xSemaphoreGive(l->mutex);
+}
+
+uint16_t conf_wire_last_frame(uint8_t link, uint8_t dir, uint8_t *buf)
+{
+    ConfLink_t *l = &kLinks[link];
+    xSemaphoreTake(l->mutex, portMAX_DELAY);
+    uint16_t size = l->last_size[dir];
+    memcpy(buf, l->last[dir], size);
+    xSemaphoreGive(l->mutex);
+    return size;
+}
+
+void conf_wire_get_stats(uint8_t link, uint8_t dir, ConfWireStats_t *stats)
+{
+    ConfLink_t *l = &kLinks[link];
+    xSemaphoreTake(l->mutex, portMAX_DELAY);
+    *stats = l->stats[dir];
+    xSemaphoreGive(l->mutex);
+}
+
+const CommPort_t *conf_wire_ref_port(uint8_t link)
+{
+    return &kLinks[link].ref_port;
+}
@@ -0,0 +1,101 @@
+#ifndef __CONF_WIRE_H__
+#define __CONF_WIRE_H__
+
+#include <stdint.h>
+#include "comm_port.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+
+/*
+ * 一致性测试用的串口连线：每条连线一端是参考协议栈（ESP32 构建，直接用 CommPort_t），
+ * 另一端是被测协议栈（经 ESP32 串口驱动 / STM32 HAL 适配层收发）。
+ * 每次写入视为一帧，按 bps 串行发送（每字节10bit，全双工，两个方向互不影响），发送结束时交给对端的接收函数。
+ * 测试可以对某个方向的后续若干帧注入故障（整帧丢弃、破坏和校验），也可以绕过故障注入直接写入原始字节。
+ */
+
+#define CONF_WIRE_LINKS         2
+#define CONF_LINK_ESP32         0       // 参考端 <-> ESP32 构建（comm_port_uart.c + 串口驱动替身）
+#define CONF_LINK_STM32         1       // 参考端 <-> STM32 构建（comm_stm32_hal_middle.c + HAL 替身）
+#define CONF_WIRE_MAX_FRAME     260
+
+typedef enum
+{
+    CONF_DIR_TO_DUT = 0,    // 参考端 -> 被测端
+    CONF_DIR_TO_REF = 1,    // 被测端 -> 参考端
+} ConfWireDir_t;
+
+/**
+ * @brief 接收函数，在连线的投递任务中执行
+ */
+typedef void (*ConfWireSink_t)(void *ctx, const uint8_t *data, uint16_t size);
+
+typedef struct
+{
+    uint32_t frames;        // 写入的帧数（不含直接注入）
+    uint32_t bytes;         // 送达的字节数
+    uint32_t dropped;       // 故障注入丢弃的帧
+    uint32_t corrupted;     // 故障注入破坏的帧
+    uint32_t overflow;      // 在途帧过多而丢弃的帧
+} ConfWireStats_t;
+
+/**
+ * @brief 初始化连线
+ * @param bps 速率（bit/s），0表示不限速
+ */
+void conf_wire_init(uint8_t link, uint32_t bps);
+
+/**
+ * @brief 设置某个方向的接收函数（收端）
+ */
+void conf_wire_set_sink(uint8_t link, uint8_t dir, ConfWireSink_t sink, void *ctx);
+
+/**
+ * @brief 写入一帧，等前面的帧发完、本帧开始发送后返回（相当于只有一帧发送缓冲的串口）
+ */
+void conf_wire_write(uint8_t link, uint8_t dir, const uint8_t *data, uint16_t size);
+
+/**
+ * @brief 直接写入原始字节，不经过故障注入、不计入帧数和抓包
+ */
+void conf_wire_inject(uint8_t link, uint8_t dir, const uint8_t *data, uint16_t size);
+
+/**
+ * @brief 丢弃该方向接下来写入的 num 帧
+ */
+void conf_wire_drop_next(uint8_t link, uint8_t dir, uint32_t num);
+
+/**
+ * @brief 破坏该方向接下来写入的 num 帧（翻转最后一个字节，即和校验/ACK包ID的最高字节）
+ */
+void conf_wire_corrupt_next(uint8_t link, uint8_t dir, uint32_t num);
+
+/**
+ * @brief 取该方向最近写入的一帧（故障注入之前的内容）
+ * @return 帧长度，0 表示还没有写入过
+ */
+uint16_t conf_wire_last_frame(uint8_t link, uint8_t dir, uint8_t *buf);
+
+void conf_wire_get_stats(uint8_t link, uint8_t dir, ConfWireStats_t *stats);
+
+/**
+ * @brief 串行发送 size 字节所需的时间
+ */
+uint32_t conf_wire_airtime_ms(uint8_t link, uint32_t size);
+
+/**
+ * @brief 取参考端的链路端口（收：dir CONF_DIR_TO_REF；发：dir CONF_DIR_TO_DUT）
+ */
+const CommPort_t *conf_wire_ref_port(uint8_t link);
+
+/**
+ * @brief 接收函数：把数据放入 ctx 指向的流缓冲（StreamBufferHandle_t），缓冲满时丢弃
+ */
+void conf_wire_stream_sink(void *ctx, const uint8_t *data, uint16_t size);
+
+/**
+ * @brief 从流缓冲读取 size 个字节，直到读满或超时（与 ESP-IDF uart_read_bytes 行为一致）
+ * @return 实际读取的字节数
+ */
+int conf_wire_stream_read(StreamBufferHandle_t rx, uint8_t *dst, uint16_t size, uint32_t timeout_ms);
+
+#endif
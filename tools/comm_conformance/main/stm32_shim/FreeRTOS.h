@@ -0,0 +1,31 @@
+#ifndef __CONF_STM32_FREERTOS_SHIM_H__
+#define __CONF_STM32_FREERTOS_SHIM_H__
+
+/*
+ * STM32 工程按原版 FreeRTOS 的方式包含头文件（"FreeRTOS.h"、"task.h"...），这里转到 ESP-IDF 的 FreeRTOS。
+ * 两者有差异的地方按 STM32 单核语义替换：
+ * - 临界区不带参数，用挂起调度器实现（HAL 替身的“中断”也是任务，同样被挡住）
+ * - *FromISR 接口在替身的“中断”任务中调用，换成任务版本
+ */
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+#undef taskENTER_CRITICAL
+#undef taskEXIT_CRITICAL
+#undef taskENTER_CRITICAL_FROM_ISR
+#undef taskEXIT_CRITICAL_FROM_ISR
+#undef portYIELD_FROM_ISR
+#undef xSemaphoreGiveFromISR
+#undef vTaskNotifyGiveFromISR
+
+#define taskENTER_CRITICAL()                vTaskSuspendAll()
+#define taskEXIT_CRITICAL()                 ((void)xTaskResumeAll())
+#define taskENTER_CRITICAL_FROM_ISR()       (vTaskSuspendAll(), (UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)       ((void)(x), (void)xTaskResumeAll())
+#define portYIELD_FROM_ISR(x)               ((void)(x))
+#define xSemaphoreGiveFromISR(sem, woken)   ((void)(woken), xSemaphoreGive(sem))
+#define vTaskNotifyGiveFromISR(task, woken) ((void)(woken), (void)xTaskNotifyGive(task))
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef __CONF_STM32_HAL_SHIM_H__
+#define __CONF_STM32_HAL_SHIM_H__
+
+/*
+ * 主机端的 STM32 HAL 替身（只实现 comm_stm32_hal_middle.c 用到的串口 DMA 接口），串口接到一致性测试连线 1 的被测端：
+ * - HAL_UART_Transmit_DMA：拷贝数据写入连线，发送完成后调用 HAL_UART_TxCpltCallback
+ * - HAL_UARTEx_ReceiveToIdle_DMA：登记接收缓冲，收满或线路空闲后调用 HAL_UARTEx_RxEventCallback，之后需要重新启动接收
+ * 回调在替身的“中断”任务中执行，与真实硬件一样不可重入。
+ */
+#include <stdint.h>
+
+typedef enum
+{
+    HAL_OK = 0x00,
+    HAL_ERROR = 0x01,
+    HAL_BUSY = 0x02,
+    HAL_TIMEOUT = 0x03,
+} HAL_StatusTypeDef;
+
+typedef struct
+{
+    uint32_t it_disabled;           // __HAL_DMA_DISABLE_IT 关闭的中断
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    DMA_HandleTypeDef *hdmarx;
+    uint8_t link;                   // 接到的一致性测试连线
+    volatile uint8_t tx_busy;
+    uint8_t *rx_buf;                // ReceiveToIdle 登记的接收缓冲，NULL 表示接收未启动
+    uint16_t rx_size;
+    uint32_t rx_overrun;            // 接收未启动期间到达而丢失的字节
+} UART_HandleTypeDef;
+
+#define DMA_IT_HT                   (0x00000004U)
+#define __HAL_DMA_DISABLE_IT(__HANDLE__, __INTERRUPT__) ((__HANDLE__)->it_disabled |= (__INTERRUPT__))
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+void HAL_Delay(uint32_t Delay);
+
+// 由应用层实现（同真实工程）
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+
+/**
+ * @brief 初始化替身串口（创建模拟 DMA 收发的任务），在 Comm_Init 之前调用
+ */
+void conf_hal_uart_init(UART_HandleTypeDef *huart, uint8_t link);
+
+#endif
@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "dataFrame.h"
+#include "comm_loopback.h"
+#include "sim_stack.h"
+
+/*
+ * 回环链路测试（components/core/comm_loopback.h）：
+ * 1. 链路本身：半双工时两端先后发送的帧原样到达对端，发送时间重叠的两帧都被丢弃并计入冲突；全双工时同时发送互不影响。
+ * 2. TDMA：遥控器（主机）和机器人（从机）两份协议栈经半双工回环链路对接，遥控器周期发送控制帧，
+ *    机器人持续发送带ACK的反馈帧，两端都在自己的时隙内发送，整个过程不应发生冲突，
+ *    控制帧全部送达、反馈帧没有发送失败。
+ * 协议栈复用 comm_sim 的 sim_stack_remote.c / sim_stack_robot.c，一个进程只能初始化一次，
+ * 因此没有TDMA时的冲突只在第1项中用裸端口检查。全部通过时返回0，否则返回1。
+ */
+
+#define LB_AIR_BPS          115200
+#define LB_RAW_BPS          9600        // 第1项使用的低速率，单帧空口时间约10ms，保证两端的发送重叠
+#define LB_RAW_FRAME        12
+#define LB_TDMA_SECONDS     3
+#define LB_CTRL_PERIOD_MS   20
+#define LB_CTRL_RING        (COMM_SEND_QUEUE_LEN + 2)  // 零拷贝发送的缓冲轮换，同 comm_rpc.c
+#define LB_BULK_SIZE        64
+#define LB_BULK_TIMEOUT_MS  200
+#define LB_BULK_RETRY       3
+#define LB_DOWN_MS          40
+#define LB_UP_MS            60
+#define LB_GUARD_MS         5
+
+static uint32_t kPassed;
+static uint32_t kFailed;
+
+static void check(uint32_t ok, const char *name, const char *fmt, ...)
+{
+    va_list ap;
+    printf("[%s] %-40s ", ok ? "PASS" : "FAIL", name);
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+    printf("\n");
+    if (ok)
+        kPassed++;
+    else
+        kFailed++;
+}
+
+/* -------------------- 1. 链路本身 -------------------- */
+typedef struct
+{
+    const CommPort_t *port;
+    uint8_t frame[LB_RAW_FRAME];
+    TaskHandle_t waiter;
+} RawWriter_t;
+
+static void RawWriterTask(void *param)
+{
+    RawWriter_t *w = (RawWriter_t *)param;
+    w->port->write(w->port->port_data, w->frame, sizeof(w->frame));
+    xTaskNotifyGive(w->waiter);
+    vTaskDelete(NULL);
+}
+
+// 两端在同一个tick开始发送，等待两次写入都完成
+static void raw_write_both(RawWriter_t w[2])
+{
+    for (int i = 0; i < 2; i++)
+    {
+        w[i].waiter = xTaskGetCurrentTaskHandle();
+        xTaskCreate(RawWriterTask, "lbWrite", 2048, &w[i], 5, NULL);
+    }
+    for (int i = 0; i < 2; i++)
+        ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+}
+
+static int raw_read(const CommPort_t *port, uint8_t *buf)
+{
+    return port->read(port->port_data, buf, LB_RAW_FRAME, 50);
+}
+
+static void test_raw(void)
+{
+    static CommLoopback_t half, full;
+    CommLoopbackConfig_t cfg = {.air_bps = LB_RAW_BPS, .half_duplex = 1};
+    comm_loopback_create(&half, &cfg);
+    cfg.half_duplex = 0;
+    comm_loopback_create(&full, &cfg);
+
+    RawWriter_t w[2];
+    uint8_t buf[LB_RAW_FRAME];
+    for (int i = 0; i < 2; i++)
+    {
+        for (int k = 0; k < LB_RAW_FRAME; k++)
+            w[i].frame[k] = (uint8_t)(i * 0x40 + k);
+    }
+
+    // 先后发送：各自原样到达对端
+    uint32_t ok = 1;
+    for (int i = 0; i < 2; i++)
+    {
+        const CommPort_t *tx = comm_loopback_port(&half, i);
+        tx->write(tx->port_data, w[i].frame, LB_RAW_FRAME);
+        ok &= raw_read(comm_loopback_port(&half, i ^ 1), buf) == LB_RAW_FRAME && !memcmp(buf, w[i].frame, LB_RAW_FRAME);
+    }
+    CommLoopbackStats_t s;
+    comm_loopback_get_stats(&half, &s);
+    check(ok && s.collisions == 0, "half duplex, one end at a time", "tx %lu/%lu collisions %lu",
+          (unsigned long)s.tx_frames[0], (unsigned long)s.tx_frames[1], (unsigned long)s.collisions);
+
+    // 同时发送：两帧都丢弃
+    for (int i = 0; i < 2; i++)
+        w[i].port = comm_loopback_port(&half, i);
+    raw_write_both(w);
+    int got0 = raw_read(comm_loopback_port(&half, 0), buf);
+    int got1 = raw_read(comm_loopback_port(&half, 1), buf);
+    comm_loopback_get_stats(&half, &s);
+    check(s.collisions == 2 && got0 == 0 && got1 == 0, "half duplex, both ends at once", "collisions %lu received %d/%d",
+          (unsigned long)s.collisions, got1, got0);
+
+    // 全双工同时发送：互不影响
+    for (int i = 0; i < 2; i++)
+        w[i].port = comm_loopback_port(&full, i);
+    raw_write_both(w);
+    ok = 1;
+    for (int i = 0; i < 2; i++)
+        ok &= raw_read(comm_loopback_port(&full, i ^ 1), buf) == LB_RAW_FRAME && !memcmp(buf, w[i].frame, LB_RAW_FRAME);
+    comm_loopback_get_stats(&full, &s);
+    check(ok && s.collisions == 0, "full duplex, both ends at once", "collisions %lu", (unsigned long)s.collisions);
+}
+
+/* -------------------- 2. TDMA -------------------- */
+static volatile uint8_t kRunning = 1;
+static volatile uint32_t kCtrlSent;
+static volatile uint32_t kCtrlRecv;
+static volatile uint32_t kCtrlLastSeq;
+static volatile uint32_t kBulkOk;
+static volatile uint32_t kBulkFail;
+
+static void RemoteCtrlTask(void *param)
+{
+    static PackControl_t ring[LB_CTRL_RING];
+    TickType_t last = xTaskGetTickCount();
+    while (kRunning)
+    {
+        PackControl_t *pack = &ring[kCtrlSent % LB_CTRL_RING];
+        memset(pack, 0, sizeof(*pack));
+        pack->Key = kCtrlSent + 1;
+        if (sim_stack_remote.send_nak((uint8_t *)pack, PACK_CONTROL_CMD, sizeof(*pack)))
+            kCtrlSent++;
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(LB_CTRL_PERIOD_MS));
+    }
+    vTaskDelete(NULL);
+}
+
+static void robot_ctrl_recv_cb(uint8_t *src, uint16_t size, void *user_data)
+{
+    PackControl_t pack;
+    if (size < sizeof(pack))
+        return;
+    memcpy(&pack, src, sizeof(pack));
+    kCtrlRecv++;
+    kCtrlLastSeq = pack.Key;
+}
+
+static void RobotBulkTask(void *param)
+{
+    static uint8_t buf[LB_BULK_SIZE];
+    for (int i = 0; i < LB_BULK_SIZE; i++)
+        buf[i] = (uint8_t)i;
+    while (kRunning)
+    {
+        if (sim_stack_robot.send_ack(buf, PACK_STR_FEEDBACK_CMD, LB_BULK_SIZE, LB_BULK_TIMEOUT_MS, LB_BULK_RETRY))
+            kBulkOk++;
+        else
+            kBulkFail++;
+    }
+    vTaskDelete(NULL);
+}
+
+static void test_tdma(void)
+{
+    static CommLoopback_t lb;
+    CommLoopbackConfig_t cfg = {.air_bps = LB_AIR_BPS, .half_duplex = 1};
+    comm_loopback_create(&lb, &cfg);
+    sim_stack_remote.init(NULL, comm_loopback_port(&lb, 0));
+    sim_stack_robot.init(NULL, comm_loopback_port(&lb, 1));
+
+    CommTdmaConfig_t master = {
+        .role = COMM_TDMA_MASTER,
+        .downlink_ms = LB_DOWN_MS,
+        .uplink_ms = LB_UP_MS,
+        .guard_ms = LB_GUARD_MS,
+        .air_bps = LB_AIR_BPS,
+    };
+    CommTdmaConfig_t slave = {.role = COMM_TDMA_SLAVE, .air_bps = LB_AIR_BPS};
+    sim_stack_remote.tdma_config(&master);
+    sim_stack_robot.tdma_config(&slave);
+    sim_stack_robot.register_recv_cb(robot_ctrl_recv_cb, PACK_CONTROL_CMD, NULL);
+
+    xTaskCreate(RemoteCtrlTask, "lbCtrl", 4096, NULL, 6, NULL);
+    xTaskCreate(RobotBulkTask, "lbBulk", 4096, NULL, 4, NULL);
+    vTaskDelay(pdMS_TO_TICKS(LB_TDMA_SECONDS * 1000));
+    kRunning = 0;
+    // 停止产生新帧，等排队的帧在之后的时隙中发完、最后一个反馈帧的ACK超时结束
+    vTaskDelay(pdMS_TO_TICKS((LB_DOWN_MS + LB_UP_MS) * 4 + LB_BULK_TIMEOUT_MS * (LB_BULK_RETRY + 1)));
+
+    CommLoopbackStats_t s;
+    CommStats_t remote, robot;
+    comm_loopback_get_stats(&lb, &s);
+    sim_stack_remote.get_stats(&remote);
+    sim_stack_robot.get_stats(&robot);
+    printf("  loopback tx %lu/%lu collisions %lu, remote tx %lu, robot tx %lu rx_acks %lu retransmits %lu\n",
+           (unsigned long)s.tx_frames[0], (unsigned long)s.tx_frames[1], (unsigned long)s.collisions,
+           (unsigned long)remote.tx_frames, (unsigned long)robot.tx_frames, (unsigned long)robot.rx_acks,
+           (unsigned long)robot.retransmits);
+
+    check(s.tx_frames[0] && s.tx_frames[1] && s.collisions == 0, "tdma, no collisions", "collisions %lu",
+          (unsigned long)s.collisions);
+    check(kCtrlSent > 0 && kCtrlRecv == kCtrlSent && kCtrlLastSeq == kCtrlSent, "tdma, control frames delivered",
+          "sent %lu recv %lu", (unsigned long)kCtrlSent, (unsigned long)kCtrlRecv);
+    check(kBulkOk > 0 && kBulkFail == 0, "tdma, acked frames in the uplink slot", "ok %lu failed %lu",
+          (unsigned long)kBulkOk, (unsigned long)kBulkFail);
+}
+
+void app_main(void)
+{
+    printf("\n========== comm_loopback_test ==========\n");
+    test_raw();
+    test_tdma();
+    printf("\n%lu passed, %lu failed\n", (unsigned long)kPassed, (unsigned long)kFailed);
+    fflush(stdout);
+    exit(kFailed ? 1 : 0);
+}
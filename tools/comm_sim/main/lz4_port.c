@@ -0,0 +1,23 @@
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * LVGL自带的LZ4通过 lv_memcpy/lv_memmove/lv_memset 访问内存，主机端只编译 lz4.c 而不编译整个LVGL，
+ * 这里用C库实现这三个函数。
+ */
+
+void *lv_memcpy(void *dst, const void *src, size_t len)
+{
+    return memcpy(dst, src, len);
+}
+
+void *lv_memmove(void *dst, const void *src, size_t len)
+{
+    return memmove(dst, src, len);
+}
+
+void lv_memset(void *dst, uint8_t v, size_t len)
+{
+    memset(dst, v, len);
+}
@@ -0,0 +1,274 @@
+#include "sim_channel.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/stream_buffer.h"
+#include <string.h>
+
+#define SIM_MAX_FRAME       260
+#define SIM_MAX_PENDING     64
+#define SIM_RX_BUFFER_SIZE  2048
+
+typedef struct
+{
+    uint8_t used;
+    uint8_t from;
+    uint8_t lost;
+    uint16_t size;
+    int64_t tx_start;
+    int64_t tx_end;
+    int64_t deliver_ms;
+    uint8_t data[SIM_MAX_FRAME];
+} SimFrame_t;
+
+static SimChannelConfig_t kCfg;
+static SimChannelStats_t kStats;
+static SimFrame_t kPending[SIM_MAX_PENDING];
+static SemaphoreHandle_t kMutex;
+static StreamBufferHandle_t kRx[2];
+static int64_t kTxBusyUntil[2];     // 该端上一帧发送结束的时间
+static int64_t kRxEnd[2];           // 该端最近一帧已投递帧的接收结束时间（用于收发切换）
+static uint8_t kBurstBad;           // Gilbert-Elliott 当前状态
+static uint8_t kOutage;             // 链路中断
+static uint64_t kRng;
+static CommPort_t kPorts[2];
+
+static double sim_rand(void)
+{
+    // xorshift64*
+    kRng ^= kRng >> 12;
+    kRng ^= kRng << 25;
+    kRng ^= kRng >> 27;
+    return (double)((kRng * 2685821657736338717ULL) >> 11) / (double)(1ULL << 53);
+}
+
+static int64_t max64(int64_t a, int64_t b)
+{
+    return a > b ? a : b;
+}
+
+static uint32_t sim_airtime_ms(uint16_t bytes)
+{
+    if (!kCfg.bps)
+        return 0;
+    return ((uint32_t)bytes * 10u * 1000u + kCfg.bps - 1) / kCfg.bps;
+}
+
+static int sim_read(void *port_data, uint8_t *dst, uint16_t size, uint32_t timeout_ms)
+{
+    StreamBufferHandle_t rx = kRx[(uintptr_t)port_data];
+    TickType_t start = xTaskGetTickCount();
+    uint16_t got = 0;
+    while (got < size)
+    {
+        TickType_t wait = portMAX_DELAY;
+        if (timeout_ms != portMAX_DELAY)
+        {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= pdMS_TO_TICKS(timeout_ms))
+                break;
+            wait = pdMS_TO_TICKS(timeout_ms) - elapsed;
+        }
+        size_t n = xStreamBufferReceive(rx, dst + got, size - got, wait);
+        if (n == 0 && timeout_ms != portMAX_DELAY)
+            break;
+        got += n;
+    }
+    return got;
+}
+
+static int sim_write(void *port_data, const uint8_t *src, uint16_t size)
+{
+    uint8_t self = (uint8_t)(uintptr_t)port_data;
+    uint8_t peer = self ^ 1;
+    if (size > SIM_MAX_FRAME)
+        size = SIM_MAX_FRAME;
+
+    // 发送缓冲满时阻塞，等排队的数据发出去（同 uart_write_bytes）
+    while (kCfg.tx_buffer && kTxBusyUntil[self] - comm_get_time_ms() > (int64_t)sim_airtime_ms(kCfg.tx_buffer))
+        vTaskDelay(1);
+
+    xSemaphoreTake(kMutex, portMAX_DELAY);
+    kStats.frames[self]++;
+
+    int64_t now = comm_get_time_ms();
+    int64_t start = max64(now, kTxBusyUntil[self]);
+    if (kCfg.half_duplex)
+    {
+        // 模块只能感知已经上空的对端帧（载波），对端排队中尚未发出的帧感知不到，重叠即冲突
+        int64_t rx_end = kRxEnd[self];
+        for (int i = 0; i < SIM_MAX_PENDING; i++)
+        {
+            SimFrame_t *o = &kPending[i];
+            if (o->used && o->from == peer && o->tx_start <= now)
+                rx_end = max64(rx_end, o->deliver_ms);
+        }
+        start = max64(start, rx_end + kCfg.turnaround_ms);
+    }
+    int64_t end = start + sim_airtime_ms(size);
+    kTxBusyUntil[self] = end;
+
+    SimFrame_t *f = NULL;
+    for (int i = 0; i < SIM_MAX_PENDING; i++)
+    {
+        if (!kPending[i].used)
+        {
+            f = &kPending[i];
+            break;
+        }
+    }
+    if (!f)
+    {
+        kStats.overflow++;
+        xSemaphoreGive(kMutex);
+        return size;
+    }
+
+    memset(f, 0, sizeof(*f));
+    f->used = 1;
+    f->from = self;
+    f->size = size;
+    f->tx_start = start;
+    f->tx_end = end;
+    memcpy(f->data, src, size);
+
+    // 突发丢包
+    if (kBurstBad)
+        kBurstBad = sim_rand() >= kCfg.p_bad_to_good;
+    else
+        kBurstBad = sim_rand() < kCfg.p_good_to_bad;
+    if (sim_rand() < (kBurstBad ? kCfg.loss_bad : kCfg.loss_good))
+    {
+        f->lost = 1;
+        kStats.lost_burst++;
+    }
+    else if (kOutage)
+    {
+        f->lost = 1;
+        kStats.lost_outage++;
+    }
+
+    // 半双工冲突：与对端尚在空中的帧时间重叠
+    if (kCfg.half_duplex)
+    {
+        for (int i = 0; i < SIM_MAX_PENDING; i++)
+        {
+            SimFrame_t *o = &kPending[i];
+            if (!o->used || o->from != peer)
+                continue;
+            if (o->tx_start < end && start < o->tx_end)
+            {
+                if (!o->lost)
+                    kStats.collisions++;
+                if (!f->lost)
+                    kStats.collisions++;
+                o->lost = 1;
+                f->lost = 1;
+            }
+        }
+    }
+
+    // 误码
+    if (kCfg.ber > 0 && !f->lost)
+    {
+        uint8_t corrupted = 0;
+        for (uint16_t i = 0; i < size; i++)
+        {
+            for (uint8_t b = 0; b < 8; b++)
+            {
+                if (sim_rand() < kCfg.ber)
+                {
+                    f->data[i] ^= (uint8_t)(1u << b);
+                    corrupted = 1;
+                }
+            }
+        }
+        kStats.corrupted += corrupted;
+    }
+
+    f->deliver_ms = end + kCfg.prop_delay_ms;
+    if (kCfg.reorder_prob > 0 && sim_rand() < kCfg.reorder_prob)
+    {
+        f->deliver_ms += kCfg.reorder_delay_ms;
+        kStats.reordered++;
+    }
+
+    xSemaphoreGive(kMutex);
+
+    // 无线模块只能缓存一帧：等前面的帧发完、本帧开始上空后才返回，否则空口积压会无限增长
+    int64_t wait = start - comm_get_time_ms();
+    if (wait > 0)
+        vTaskDelay(pdMS_TO_TICKS((uint32_t)wait));
+    return size;
+}
+
+static void SimChannelTask(void *param)
+{
+    while (1)
+    {
+        vTaskDelay(1);
+        int64_t now = comm_get_time_ms();
+        xSemaphoreTake(kMutex, portMAX_DELAY);
+        while (1)
+        {
+            // 按到达时间先后投递
+            SimFrame_t *due = NULL;
+            for (int i = 0; i < SIM_MAX_PENDING; i++)
+            {
+                SimFrame_t *f = &kPending[i];
+                if (f->used && f->deliver_ms <= now && (!due || f->deliver_ms < due->deliver_ms))
+                    due = f;
+            }
+            if (!due)
+                break;
+            kRxEnd[due->from ^ 1] = max64(kRxEnd[due->from ^ 1], due->deliver_ms);
+            if (!due->lost)
+            {
+                if (xStreamBufferSend(kRx[due->from ^ 1], due->data, due->size, 0) == due->size)
+                    kStats.delivered[due->from]++;
+                else
+                    kStats.overflow++;
+            }
+            due->used = 0;
+        }
+        xSemaphoreGive(kMutex);
+    }
+}
+
+void sim_channel_init(const SimChannelConfig_t *cfg)
+{
+    kCfg = *cfg;
+    memset(&kStats, 0, sizeof(kStats));
+    memset(kPending, 0, sizeof(kPending));
+    kRng = cfg->seed ? cfg->seed : 1;
+    kMutex = xSemaphoreCreateMutex();
+    for (uintptr_t i = 0; i < 2; i++)
+    {
+        kRx[i] = xStreamBufferCreate(SIM_RX_BUFFER_SIZE, 1);
+        kPorts[i].read = sim_read;
+        kPorts[i].write = sim_write;
+        kPorts[i].port_data = (void *)i;
+        kTxBusyUntil[i] = 0;
+        kRxEnd[i] = 0;
+    }
+    xTaskCreate(SimChannelTask, "simChannel", 4096, NULL, 10, NULL);
+}
+
+const CommPort_t *sim_channel_port(uint8_t end)
+{
+    return &kPorts[end & 1];
+}
+
+void sim_channel_get_stats(SimChannelStats_t *stats)
+{
+    xSemaphoreTake(kMutex, portMAX_DELAY);
+    *stats = kStats;
+    xSemaphoreGive(kMutex);
+}
+
+void sim_channel_set_outage(uint8_t on)
+{
+    xSemaphoreTake(kMutex, portMAX_DELAY);
+    kOutage = on;
+    xSemaphoreGive(kMutex);
+}
@@ -0,0 +1,54 @@
+#ifndef __SIM_CHANNEL_H__
+#define __SIM_CHANNEL_H__
+
+#include <stdint.h>
+#include "comm_port.h"
+
+/*
+ * 无线信道模型：两端（0 遥控器 / 1 机器人）每次 write 视为一帧，按以下模型决定何时、以何种内容到达对端：
+ * - 带宽：帧按 bps 串行占用信道（每字节10bit），同一端的帧排队依次发出；排队超过 tx_buffer 字节时写入阻塞（同串口驱动的发送缓冲）
+ * - 传播延迟：发送结束后再经过 prop_delay_ms 到达
+ * - 半双工：两端的发送时间重叠则两帧都丢失；模块只避让已上空的对端帧，收完一帧后需要 turnaround_ms 才能开始发送
+ * - 误码：每bit按 ber 概率翻转（由接收端的和校验发现）
+ * - 突发丢包：Gilbert-Elliott 两状态模型，每帧按当前状态的丢包率丢弃
+ * - 乱序：每帧按 reorder_prob 概率额外延迟 reorder_delay_ms
+ */
+typedef struct
+{
+    uint32_t bps;               // 空口速率（bit/s），0表示不限速
+    uint32_t prop_delay_ms;     // 传播延迟
+    uint8_t half_duplex;        // 1：半双工
+    uint32_t turnaround_ms;     // 半双工收发切换时间
+    double ber;                 // 误码率
+    double p_good_to_bad;       // 每帧由好状态进入坏状态的概率
+    double p_bad_to_good;       // 每帧由坏状态回到好状态的概率
+    double loss_good;           // 好状态丢帧率
+    double loss_bad;            // 坏状态丢帧率
+    double reorder_prob;        // 乱序概率
+    uint32_t reorder_delay_ms;  // 乱序帧的额外延迟
+    uint32_t seed;              // 随机数种子（相同种子+相同配置可复现）
+    uint32_t tx_buffer;         // 每端发送缓冲（字节），0表示不限制
+} SimChannelConfig_t;
+
+typedef struct
+{
+    uint32_t frames[2];         // 各端写入的帧数
+    uint32_t delivered[2];      // 各端发出并送达对端的帧数
+    uint32_t lost_burst;        // 突发丢包模型丢弃的帧
+    uint32_t collisions;        // 半双工冲突丢弃的帧
+    uint32_t corrupted;         // 发生误码的帧
+    uint32_t reordered;         // 被额外延迟的帧
+    uint32_t overflow;          // 接收缓冲溢出丢弃的帧
+    uint32_t lost_outage;       // 中断期间丢弃的帧
+} SimChannelStats_t;
+
+void sim_channel_init(const SimChannelConfig_t *cfg);
+const CommPort_t *sim_channel_port(uint8_t end);
+void sim_channel_get_stats(SimChannelStats_t *stats);
+
+/**
+ * @brief 模拟链路中断（例如机器人跑出通信范围）：中断期间两个方向的帧全部丢失
+ */
+void sim_channel_set_outage(uint8_t on);
+
+#endif
@@ -0,0 +1,505 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "dataFrame.h"
+#include "input_record.h"
+#include "send_scheduler.h"
+#include "sim_channel.h"
+#include "sim_ota.h"
+#include "sim_stack.h"
+
+/*
+ * 信道仿真：遥控器协议栈 <-> 信道模型 <-> 机器人协议栈
+ * 负载：遥控器周期发送控制帧（NAK），机器人持续发送带ACK的反馈帧（窗口 = 并发发送任务数）
+ * 输出：控制帧时延分位数、丢失率，反馈帧有效吞吐，两端重发/错误计数与信道统计
+ *
+ * 参数以 key=value 形式在命令行给出，例如：
+ *   ./build/comm_sim.elf bps=9600 half_duplex=1 ber=1e-5 duration_s=30 tdma=1
+ * 给出 input=录制文件（遥控器录制的输入，见 components/core/input_record.h）时，控制帧改为按录制的输入逐扫描周期
+ * 经发送调度产生，与遥控器上回放同一文件时的发送时机相同。
+ */
+
+#define SIM_MAX_LATENCY_SAMPLES     65536
+#define SIM_CTRL_RING               16
+#define SIM_MAX_BULK_TASKS          8
+#define SIM_FAILSAFE_KEY            0xFFFFFFFFu     // 断线保护控制帧的按键字段，用于和正常控制帧区分
+#define SIM_OTA_PART_FILE           "comm_sim_ota_part.bin"
+#define SIM_OTA_PART_SIZE           0x140000        // 同 partitions.csv 中 ota_0/ota_1 的大小
+
+typedef struct
+{
+    const char *key;
+    double value;
+    const char *help;
+} SimParam_t;
+
+static SimParam_t kParams[] = {
+    {"duration_s", 10, "仿真时长"},
+    {"bps", 115200, "空口速率"},
+    {"delay_ms", 2, "传播延迟"},
+    {"half_duplex", 1, "半双工"},
+    {"turnaround_ms", 3, "收发切换时间"},
+    {"ber", 0, "误码率"},
+    {"ge_p_gb", 0, "突发丢包：好->坏概率"},
+    {"ge_p_bg", 0.3, "突发丢包：坏->好概率"},
+    {"loss_good", 0, "好状态丢帧率"},
+    {"loss_bad", 0.5, "坏状态丢帧率"},
+    {"reorder", 0, "乱序概率"},
+    {"reorder_ms", 30, "乱序额外延迟"},
+    {"seed", 1, "随机数种子"},
+    {"tx_buf", 256, "发送缓冲（字节），0 不限制"},
+    {"ctrl_period_ms", 20, "控制帧周期"},
+    {"bulk_size", 64, "反馈帧数据长度"},
+    {"bulk_window", 1, "反馈帧并发数"},
+    {"timeout_ms", 200, "ACK超时"},
+    {"retry", 3, "最大重发次数"},
+    {"tdma", 0, "开启时隙模式"},
+    {"down_ms", 40, "下行窗口"},
+    {"up_ms", 60, "上行窗口"},
+    {"guard_ms", 5, "保护间隔"},
+    {"compress", 0, "反馈帧使用文本数据并开启压缩"},
+    {"addressing", 0, "开启多机寻址（遥控器节点0，机器人节点1）"},
+    {"heartbeat_ms", 0, "心跳周期，0 不开启"},
+    {"miss", 3, "心跳丢失阈值"},
+    {"outage_at_s", 0, "链路中断开始时间，0 不中断"},
+    {"outage_s", 1, "链路中断时长"},
+    {"ota_kb", 0, "遥控器向机器人发送的OTA镜像大小（KB），0 不发送"},
+    {"ota_at_s", 0.5, "OTA开始时间"},
+};
+
+static const char *kInputPath;  // input=，字符串参数单独处理
+
+static double param(const char *key)
+{
+    for (size_t i = 0; i < sizeof(kParams) / sizeof(kParams[0]); i++)
+        if (strcmp(kParams[i].key, key) == 0)
+            return kParams[i].value;
+    return 0;
+}
+
+// linux 目标的 app_main 拿不到 argc/argv，直接读 /proc/self/cmdline
+static void parse_args(void)
+{
+    static char buf[4096];
+    FILE *fp = fopen("/proc/self/cmdline", "rb");
+    if (!fp)
+        return;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, fp);
+    fclose(fp);
+    buf[n] = 0;
+
+    char *arg = buf + strlen(buf) + 1; // 跳过程序名
+    while (arg < buf + n)
+    {
+        char *eq = strchr(arg, '=');
+        uint8_t matched = 0;
+        if (eq)
+        {
+            *eq = 0;
+            if (strcmp(arg, "input") == 0)
+            {
+                kInputPath = eq + 1;
+                matched = 1;
+            }
+            for (size_t i = 0; i < sizeof(kParams) / sizeof(kParams[0]); i++)
+            {
+                if (strcmp(kParams[i].key, arg) == 0)
+                {
+                    kParams[i].value = atof(eq + 1);
+                    matched = 1;
+                }
+            }
+        }
+        if (!matched)
+        {
+            printf("未知参数: %s\n可用参数:\n", arg);
+            for (size_t i = 0; i < sizeof(kParams) / sizeof(kParams[0]); i++)
+                printf("  %-16s %-10g %s\n", kParams[i].key, kParams[i].value, kParams[i].help);
+            printf("  %-16s %-10s %s\n", "input", "-", "录制的输入文件，按录制的输入经发送调度产生控制帧");
+            exit(1);
+        }
+        arg += strlen(arg) + 1;
+        if (eq)
+            arg += strlen(eq + 1) + 1;
+    }
+}
+
+static int64_t sim_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* -------------------- 控制帧（下行） -------------------- */
+static int64_t *kCtrlSendTime;          // 按序号记录发送时间
+static uint32_t kCtrlSent;
+static uint32_t kCtrlRecv;
+static uint32_t *kLatencyUs;
+static uint32_t kLatencyNum;
+static uint32_t kFailsafeRecv;
+
+static void RemoteCtrlTask(void *param_)
+{
+    static PackControl_t ring[SIM_CTRL_RING];   // 零拷贝发送，缓冲轮换使用
+    TickType_t period = pdMS_TO_TICKS((uint32_t)param("ctrl_period_ms"));
+    TickType_t last = xTaskGetTickCount();
+    while (1)
+    {
+        if (kCtrlSent < SIM_MAX_LATENCY_SAMPLES)
+        {
+            PackControl_t *pack = &ring[kCtrlSent % SIM_CTRL_RING];
+            memset(pack, 0, sizeof(*pack));
+            pack->Key = kCtrlSent;
+            kCtrlSendTime[kCtrlSent] = sim_now_us();
+            if (sim_stack_remote.send_nak((uint8_t *)pack, PACK_CONTROL_CMD, sizeof(*pack)))
+                kCtrlSent++;
+        }
+        vTaskDelayUntil(&last, period);
+    }
+}
+
+/* -------------------- 录制输入回放（下行） -------------------- */
+static SendSchedulerStats_t kInputStats;
+static uint32_t kInputSamples;
+static uint32_t kInputScans;
+static volatile uint8_t kInputDone;
+
+// 没有遥控器的校准数据，按12位ADC中心2048线性换算
+static int16_t sim_raw_to_q15(uint16_t raw)
+{
+    int32_t v = ((int32_t)raw - 2048) * 16;
+    return (int16_t)(v > 32767 ? 32767 : (v < -32767 ? -32767 : v));
+}
+
+// 与遥控器扫描任务相同：每个扫描周期取序号不超过本周期的样本，由发送调度决定是否发送控制帧
+static void RemoteInputTask(void *param_)
+{
+    static PackControl_t ring[SIM_CTRL_RING];
+    InputRecordHeader_t header;
+    FILE *fp = fopen(kInputPath, "rb");
+    if (!fp || !input_record_read_header(fp, &header) || !header.period_us || header.period_us % 1000)
+    {
+        printf("input: %s 不是录制文件或扫描周期不是整数毫秒\n", kInputPath);
+        if (fp)
+            fclose(fp);
+        kInputDone = 1;
+        vTaskDelete(NULL);
+        return;
+    }
+    SendScheduler_t sched;
+    send_scheduler_init(&sched, NULL);
+    InputRecordSample_t cur = {.raw = {2048, 2048, 2048, 2048}};
+    InputRecordSample_t next;
+    uint32_t has_next = input_record_read_sample(fp, &next);
+    TickType_t period = pdMS_TO_TICKS(header.period_us / 1000);
+    TickType_t last = xTaskGetTickCount();
+    for (uint32_t scan = 0; has_next; scan++)
+    {
+        while (has_next && next.scan <= scan)
+        {
+            cur = next;
+            has_next = input_record_read_sample(fp, &next);
+            kInputSamples++;
+        }
+        int16_t sticks[4];
+        for (int i = 0; i < 4; i++)
+            sticks[i] = sim_raw_to_q15(cur.raw[i]);
+        if (send_scheduler_poll(&sched, sticks, cur.keys, (int64_t)scan * header.period_us) &&
+            kCtrlSent < SIM_MAX_LATENCY_SAMPLES)
+        {
+            PackControl_t *pack = &ring[kCtrlSent % SIM_CTRL_RING];
+            for (int i = 0; i < 4; i++)
+                pack->rocker[i] = sticks[i] / 32767.0f;
+            pack->Key = kCtrlSent;  // 序号，用于计算时延；按键只参与发送调度
+            kCtrlSendTime[kCtrlSent] = sim_now_us();
+            if (sim_stack_remote.send_nak((uint8_t *)pack, PACK_CONTROL_CMD, sizeof(*pack)))
+                kCtrlSent++;
+            else
+                send_scheduler_cancel(&sched);      // 与固件相同，入队失败时撤销
+        }
+        kInputScans = scan + 1;
+        vTaskDelayUntil(&last, period);
+    }
+    kInputStats = sched.stats;
+    kInputDone = 1;
+    fclose(fp);
+    vTaskDelete(NULL);
+}
+
+static void robot_ctrl_recv_cb(uint8_t *src, uint16_t size, void *user_data)
+{
+    if (size < sizeof(PackControl_t))
+        return;
+    PackControl_t pack;
+    memcpy(&pack, src, sizeof(pack));
+    if (pack.Key == SIM_FAILSAFE_KEY)
+    {
+        kFailsafeRecv++;
+        return;
+    }
+    if (pack.Key >= kCtrlSent)
+        return;
+    kCtrlRecv++;
+    if (kLatencyNum < SIM_MAX_LATENCY_SAMPLES)
+        kLatencyUs[kLatencyNum++] = (uint32_t)(sim_now_us() - kCtrlSendTime[pack.Key]);
+}
+
+/* -------------------- 反馈帧（上行，带ACK） -------------------- */
+static uint32_t kBulkOk;
+static uint32_t kBulkFail;
+static uint32_t kBulkRecv;
+
+static void RobotBulkTask(void *param_)
+{
+    uint8_t buf[256];
+    uint16_t size = (uint16_t)param("bulk_size");
+    static const char kLogLine[] = "[I][chassis] v=1.25 w=0.00 x=3.412 y=1.087 yaw=90.0 bat=24.6V ";
+    for (uint16_t i = 0; i < size; i++)
+        buf[i] = param("compress") ? (uint8_t)kLogLine[i % (sizeof(kLogLine) - 1)] : (uint8_t)i;
+    while (1)
+    {
+        uint32_t ok = sim_stack_robot.send_ack(buf, PACK_STR_FEEDBACK_CMD, size,
+                                               (uint32_t)param("timeout_ms"), (uint8_t)param("retry"));
+        if (ok)
+            kBulkOk++;
+        else
+            kBulkFail++;
+    }
+}
+
+static void remote_bulk_recv_cb(uint8_t *src, uint16_t size, void *user_data)
+{
+    kBulkRecv++;
+}
+
+/* -------------------- OTA（下行） -------------------- */
+static volatile uint8_t kOtaFinished;
+static uint32_t kOtaError;
+
+static void ota_done_cb(uint32_t error, void *user_data)
+{
+    kOtaError = error;
+    kOtaFinished = 1;
+    printf("[%8.3fs] ota finished, error %lu\n", xTaskGetTickCount() / 1000.0, (unsigned long)error);
+}
+
+static void OtaStartTask(void *param_)
+{
+    uint32_t size = (uint32_t)(param("ota_kb") * 1024);
+    const CommOtaSource_t *source = sim_ota_source(size, (uint32_t)param("seed"));
+    vTaskDelay(pdMS_TO_TICKS((uint32_t)(param("ota_at_s") * 1000)));
+    sim_stack_remote.ota_send(COMM_OTA_TARGET_APP, source, size, ota_done_cb, NULL);
+    vTaskDelete(NULL);
+}
+
+/* -------------------- 链路中断 -------------------- */
+static void OutageTask(void *param_)
+{
+    vTaskDelay(pdMS_TO_TICKS((uint32_t)(param("outage_at_s") * 1000)));
+    sim_channel_set_outage(1);
+    vTaskDelay(pdMS_TO_TICKS((uint32_t)(param("outage_s") * 1000)));
+    sim_channel_set_outage(0);
+    vTaskDelete(NULL);
+}
+
+static const char *const kLinkStateName[] = {"off", "waiting", "up", "lost"};
+
+static void link_state_cb(uint32_t state, void *user_data)
+{
+    printf("[%8.3fs] %s link %s\n", xTaskGetTickCount() / 1000.0, (const char *)user_data,
+           state < 4 ? kLinkStateName[state] : "?");
+}
+
+/* -------------------- 报告 -------------------- */
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_ms(uint32_t p)
+{
+    if (!kLatencyNum)
+        return 0;
+    uint32_t idx = (uint32_t)((uint64_t)(kLatencyNum - 1) * p / 100);
+    return kLatencyUs[idx] / 1000.0;
+}
+
+static void print_stack_stats(const SimStack_t *stack)
+{
+    CommStats_t s;
+    stack->get_stats(&s);
+    printf("%-17s tx %lu ack_tx %lu rx %lu ack_rx %lu retransmit %lu failed %lu bad %lu dup %lu compressed %lu saved %luB\n",
+           stack->name, (unsigned long)s.tx_frames, (unsigned long)s.tx_acks, (unsigned long)s.rx_frames,
+           (unsigned long)s.rx_acks, (unsigned long)s.retransmits, (unsigned long)s.send_failed,
+           (unsigned long)s.bad_frames, (unsigned long)s.rx_duplicates, (unsigned long)s.tx_compressed,
+           (unsigned long)s.tx_saved_bytes);
+    if (!param("heartbeat_ms"))
+        return;
+    CommLinkStats_t l;
+    stack->link_get_stats(&l);
+    printf("%-17s link %s loss %lu detect last %lums max %lums bound %lums hb_tx %lu hb_rx %lu\n", "",
+           l.state < 4 ? kLinkStateName[l.state] : "?", (unsigned long)l.loss_count,
+           (unsigned long)l.last_detect_ms, (unsigned long)l.max_detect_ms, (unsigned long)l.detect_bound_ms,
+           (unsigned long)l.hb_tx, (unsigned long)l.hb_rx);
+}
+
+static void print_ota_stats(void)
+{
+    static const char *const kOtaStateName[] = {"idle", "running", "done", "failed"};
+    CommOtaTxStats_t t;
+    CommOtaRxStats_t r;
+    sim_stack_remote.ota_get_tx_stats(&t);
+    sim_stack_robot.ota_get_rx_stats(&r);
+    int64_t end_ms = t.end_ms ? t.end_ms : xTaskGetTickCount();
+    double seconds = (end_ms - t.start_ms) / 1000.0;
+    double goodput = seconds > 0 ? t.acked / seconds : 0;
+    double wire = param("bps") / 10.0;
+    printf("ota      %s error %lu acked %lu/%lu in %.2fs goodput %.1f B/s (%.1f%% of link) verify %s\n",
+           t.state < 4 ? kOtaStateName[t.state] : "?", (unsigned long)t.error, (unsigned long)t.acked,
+           (unsigned long)t.image_size, seconds, goodput, wire > 0 ? 100.0 * goodput / wire : 0,
+           kOtaFinished && !kOtaError ? (sim_ota_verify(SIM_OTA_PART_FILE, t.image_size) ? "ok" : "MISMATCH") : "-");
+    printf("ota_tx   chunks %lu resent %lu gaps %lu timeouts %lu resumes %lu window %lu max %lu rto %lums\n",
+           (unsigned long)t.chunks_sent, (unsigned long)t.chunks_resent, (unsigned long)t.gaps,
+           (unsigned long)t.timeouts, (unsigned long)t.resumes, (unsigned long)t.window, (unsigned long)t.max_window,
+           (unsigned long)t.rto_ms);
+    printf("ota_rx   %s written %lu chunks %lu bad_crc %lu out_of_order %lu resumes %lu\n",
+           r.state < 4 ? kOtaStateName[r.state] : "?", (unsigned long)r.written, (unsigned long)r.chunks_ok,
+           (unsigned long)r.chunks_bad_crc, (unsigned long)r.chunks_out_of_order, (unsigned long)r.resumes);
+}
+
+static void print_report(double seconds)
+{
+    qsort(kLatencyUs, kLatencyNum, sizeof(uint32_t), cmp_u32);
+
+    printf("\n========== comm_sim ==========\n");
+    for (size_t i = 0; i < sizeof(kParams) / sizeof(kParams[0]); i++)
+        printf("%s=%g ", kParams[i].key, kParams[i].value);
+    printf("\n\n");
+
+    double loss = kCtrlSent ? 100.0 * (kCtrlSent - kCtrlRecv) / kCtrlSent : 0;
+    printf("control  sent %lu recv %lu loss %.2f%% failsafe %lu\n", (unsigned long)kCtrlSent, (unsigned long)kCtrlRecv,
+           loss, (unsigned long)kFailsafeRecv);
+    printf("latency  p50 %.1fms p90 %.1fms p99 %.1fms max %.1fms\n",
+           percentile_ms(50), percentile_ms(90), percentile_ms(99), percentile_ms(100));
+    if (kInputPath)
+        printf("input    %s samples %lu scans %lu%s sched sent %lu period %lu stick %lu key %lu deferred %lu canceled %lu\n",
+               kInputPath, (unsigned long)kInputSamples, (unsigned long)kInputScans, kInputDone ? "" : " (unfinished)",
+               (unsigned long)kInputStats.sent, (unsigned long)kInputStats.by_period,
+               (unsigned long)kInputStats.by_stick, (unsigned long)kInputStats.by_key,
+               (unsigned long)kInputStats.deferred, (unsigned long)kInputStats.canceled);
+
+    double goodput = kBulkOk * param("bulk_size") / seconds;
+    printf("bulk     ok %lu fail %lu recv %lu goodput %.1f B/s\n",
+           (unsigned long)kBulkOk, (unsigned long)kBulkFail, (unsigned long)kBulkRecv, goodput);
+
+    if (param("ota_kb"))
+        print_ota_stats();
+
+    print_stack_stats(&sim_stack_remote);
+    print_stack_stats(&sim_stack_robot);
+
+    SimChannelStats_t cs;
+    sim_channel_get_stats(&cs);
+    printf("channel  frames %lu/%lu delivered %lu/%lu burst_lost %lu collisions %lu corrupted %lu reordered %lu overflow %lu outage %lu\n",
+           (unsigned long)cs.frames[0], (unsigned long)cs.frames[1], (unsigned long)cs.delivered[0],
+           (unsigned long)cs.delivered[1], (unsigned long)cs.lost_burst, (unsigned long)cs.collisions,
+           (unsigned long)cs.corrupted, (unsigned long)cs.reordered, (unsigned long)cs.overflow,
+           (unsigned long)cs.lost_outage);
+}
+
+void app_main(void)
+{
+    parse_args();
+
+    kCtrlSendTime = calloc(SIM_MAX_LATENCY_SAMPLES, sizeof(int64_t));
+    kLatencyUs = calloc(SIM_MAX_LATENCY_SAMPLES, sizeof(uint32_t));
+
+    SimChannelConfig_t ch = {
+        .bps = (uint32_t)param("bps"),
+        .prop_delay_ms = (uint32_t)param("delay_ms"),
+        .half_duplex = (uint8_t)param("half_duplex"),
+        .turnaround_ms = (uint32_t)param("turnaround_ms"),
+        .ber = param("ber"),
+        .p_good_to_bad = param("ge_p_gb"),
+        .p_bad_to_good = param("ge_p_bg"),
+        .loss_good = param("loss_good"),
+        .loss_bad = param("loss_bad"),
+        .reorder_prob = param("reorder"),
+        .reorder_delay_ms = (uint32_t)param("reorder_ms"),
+        .seed = (uint32_t)param("seed"),
+        .tx_buffer = (uint32_t)param("tx_buf"),
+    };
+    sim_channel_init(&ch);
+
+    sim_stack_remote.init(NULL, sim_channel_port(0));
+    sim_stack_robot.init(NULL, sim_channel_port(1));
+
+    if (param("tdma"))
+    {
+        CommTdmaConfig_t master = {
+            .role = COMM_TDMA_MASTER,
+            .downlink_ms = (uint16_t)param("down_ms"),
+            .uplink_ms = (uint16_t)param("up_ms"),
+            .guard_ms = (uint16_t)param("guard_ms"),
+            .air_bps = ch.bps,
+        };
+        CommTdmaConfig_t slave = {.role = COMM_TDMA_SLAVE, .air_bps = ch.bps};
+        sim_stack_remote.tdma_config(&master);
+        sim_stack_robot.tdma_config(&slave);
+    }
+
+    if (param("compress"))
+        sim_stack_robot.set_compress_cmd(PACK_STR_FEEDBACK_CMD, 1);
+    if (param("addressing"))
+    {
+        sim_stack_remote.set_node_id(0);
+        sim_stack_remote.set_default_dst(COMM_NODE_MASK(1));
+        sim_stack_robot.set_node_id(1);
+        sim_stack_robot.set_default_dst(COMM_NODE_MASK(0));
+    }
+
+    if (param("heartbeat_ms"))
+    {
+        CommLinkConfig_t link = {.period_ms = (uint16_t)param("heartbeat_ms"), .miss_threshold = (uint8_t)param("miss")};
+        static const PackControl_t failsafe = {.Key = SIM_FAILSAFE_KEY};
+        sim_stack_remote.link_config(&link);
+        sim_stack_robot.link_config(&link);
+        sim_stack_robot.link_set_failsafe(PACK_CONTROL_CMD, &failsafe, sizeof(failsafe));
+        sim_stack_remote.link_set_state_cb(link_state_cb, "remote");
+        sim_stack_robot.link_set_state_cb(link_state_cb, "robot");
+    }
+
+    sim_stack_robot.register_recv_cb(robot_ctrl_recv_cb, PACK_CONTROL_CMD, NULL);
+    sim_stack_remote.register_recv_cb(remote_bulk_recv_cb, PACK_STR_FEEDBACK_CMD, NULL);
+
+    if (param("ota_kb"))
+        sim_stack_robot.ota_register_sink(COMM_OTA_TARGET_APP, sim_ota_file_sink(SIM_OTA_PART_FILE, SIM_OTA_PART_SIZE));
+
+    int64_t start = sim_now_us();
+    if (kInputPath)
+        xTaskCreate(RemoteInputTask, "simInput", 4096, NULL, 6, NULL);
+    else
+        xTaskCreate(RemoteCtrlTask, "simCtrl", 4096, NULL, 6, NULL);
+    int window = (int)param("bulk_window");
+    if (window > SIM_MAX_BULK_TASKS)
+        window = SIM_MAX_BULK_TASKS;
+    for (int i = 0; i < window; i++)
+        xTaskCreate(RobotBulkTask, "simBulk", 4096, NULL, 4, NULL);
+    if (param("ota_kb"))
+        xTaskCreate(OtaStartTask, "simOta", 4096, NULL, 5, NULL);
+    if (param("outage_at_s"))
+        xTaskCreate(OutageTask, "simOutage", 2048, NULL, 7, NULL);
+
+    vTaskDelay(pdMS_TO_TICKS((uint32_t)(param("duration_s") * 1000)));
+
+    print_report((sim_now_us() - start) / 1e6);
+    fflush(stdout);
+    exit(0);
+}
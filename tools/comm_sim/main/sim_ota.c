@@ -0,0 +1,88 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_ota.h"
+
+static uint8_t *kImage;
+static uint32_t kImageSize;
+static FILE *kPartFile;
+static uint32_t kPartSize;
+
+static uint32_t source_read(void *ctx, uint32_t offset, uint8_t *buf, uint16_t size)
+{
+    if (offset + size > kImageSize)
+        return 0;
+    memcpy(buf, kImage + offset, size);
+    return 1;
+}
+
+const CommOtaSource_t *sim_ota_source(uint32_t image_size, uint32_t seed)
+{
+    static const CommOtaSource_t source = {.read = source_read};
+    free(kImage);
+    kImage = malloc(image_size);
+    kImageSize = image_size;
+    uint32_t x = seed ? seed : 1;
+    for (uint32_t i = 0; i < image_size; i++)
+    {
+        x ^= x << 13;   // xorshift32
+        x ^= x >> 17;
+        x ^= x << 5;
+        kImage[i] = (uint8_t)x;
+    }
+    return &source;
+}
+
+static uint32_t sink_begin(void *ctx, uint32_t image_size)
+{
+    if (image_size > kPartSize)
+        return 0;
+    if (kPartFile)
+        fclose(kPartFile);
+    kPartFile = fopen((const char *)ctx, "wb+");
+    if (!kPartFile)
+        return 0;
+    static uint8_t erased[4096];
+    memset(erased, 0xFF, sizeof(erased));
+    for (uint32_t off = 0; off < kPartSize; off += sizeof(erased))
+        fwrite(erased, 1, kPartSize - off < sizeof(erased) ? kPartSize - off : sizeof(erased), kPartFile);
+    return 1;
+}
+
+static uint32_t sink_write(void *ctx, uint32_t offset, const uint8_t *data, uint16_t size)
+{
+    return kPartFile && fseek(kPartFile, offset, SEEK_SET) == 0 && fwrite(data, 1, size, kPartFile) == size;
+}
+
+static uint32_t sink_finish(void *ctx)
+{
+    return kPartFile && fflush(kPartFile) == 0;
+}
+
+const CommOtaSink_t *sim_ota_file_sink(const char *path, uint32_t part_size)
+{
+    static CommOtaSink_t sink = {
+        .begin = sink_begin,
+        .write = sink_write,
+        .finish = sink_finish,
+    };
+    sink.ctx = (void *)path;
+    kPartSize = part_size;
+    return &sink;
+}
+
+uint32_t sim_ota_verify(const char *path, uint32_t image_size)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp || !kImage || image_size > kImageSize)
+    {
+        if (fp)
+            fclose(fp);
+        return 0;
+    }
+    uint8_t *buf = malloc(image_size);
+    uint32_t ok = fread(buf, 1, image_size, fp) == image_size && memcmp(buf, kImage, image_size) == 0;
+    free(buf);
+    fclose(fp);
+    return ok;
+}
@@ -0,0 +1,31 @@
+#ifndef __SIM_OTA_H__
+#define __SIM_OTA_H__
+
+#include <stdint.h>
+#include "comm_ota.h"
+
+/*
+ * OTA 仿真用的镜像来源和写入目标：
+ * - 来源为内存中按种子生成的伪随机镜像（固件不可压缩，用随机数据代表）
+ * - 写入目标为主机上的分区文件，开始时按分区大小填充 0xFF（相当于擦除后的flash），之后按偏移写入
+ */
+
+/**
+ * @brief 生成镜像并返回来源
+ */
+const CommOtaSource_t *sim_ota_source(uint32_t image_size, uint32_t seed);
+
+/**
+ * @brief 分区文件写入目标
+ * @param path 分区文件路径
+ * @param part_size 分区大小，镜像超过时 begin 失败
+ */
+const CommOtaSink_t *sim_ota_file_sink(const char *path, uint32_t part_size);
+
+/**
+ * @brief 比较分区文件开头与来源镜像
+ * @return 1 一致；0 不一致或读取失败
+ */
+uint32_t sim_ota_verify(const char *path, uint32_t image_size);
+
+#endif
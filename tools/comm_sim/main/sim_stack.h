@@ -0,0 +1,40 @@
+#ifndef __SIM_STACK_H__
+#define __SIM_STACK_H__
+
+#include "comm.h"
+#include "comm_tdma.h"
+#include "comm_link.h"
+#include "comm_ota.h"
+
+/*
+ * comm.c 是单实例模块（全部状态都是文件内静态变量），仿真需要遥控器和机器人两个协议栈，
+ * 因此 sim_stack_remote.c / sim_stack_robot.c 各自把 comm.c 编译一遍，并用 sim_stack_rename.h
+ * 给对外符号加上前缀。两个协议栈通过下面的函数表访问。
+ */
+typedef struct
+{
+    const char *name;
+    void (*init)(BadDataPackCb_t callback, const CommPort_t *port);
+    uint32_t (*register_recv_cb)(CommPackRecv_Cb callback, uint8_t cmd, void *user_data);
+    uint32_t (*unregister_recv_cb)(uint32_t cb_id);
+    uint32_t (*send_nak)(uint8_t *src, uint8_t cmd, uint16_t size);
+    uint32_t (*send_ack)(uint8_t *src, uint8_t cmd, uint16_t size, uint32_t time_out_ms, uint8_t max_retry_num);
+    uint32_t (*tdma_config)(const CommTdmaConfig_t *cfg);
+    void (*get_stats)(CommStats_t *stats);
+    uint32_t (*set_compress_cmd)(uint8_t cmd, uint8_t enable);
+    uint32_t (*set_node_id)(uint8_t node_id);
+    void (*set_default_dst)(uint8_t dst_mask);
+    uint32_t (*link_config)(const CommLinkConfig_t *cfg);
+    void (*link_set_state_cb)(CommLinkStateCb_t callback, void *user_data);
+    uint32_t (*link_set_failsafe)(uint8_t cmd, const void *frame, uint16_t size);
+    void (*link_get_stats)(CommLinkStats_t *stats);
+    uint32_t (*ota_register_sink)(uint8_t target, const CommOtaSink_t *sink);
+    uint32_t (*ota_send)(uint8_t target, const CommOtaSource_t *source, uint32_t image_size, CommOtaDone_Cb done, void *user_data);
+    void (*ota_get_tx_stats)(CommOtaTxStats_t *stats);
+    void (*ota_get_rx_stats)(CommOtaRxStats_t *stats);
+} SimStack_t;
+
+extern const SimStack_t sim_stack_remote;
+extern const SimStack_t sim_stack_robot;
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * 协议栈实例模板，由 sim_stack_remote.c / sim_stack_robot.c 包含，不要单独使用。
+ * 使用前需定义 SIM_STACK_PREFIX（符号前缀）和 SIM_STACK_NAME（函数表变量名）。
+ */
+#include "sim_stack_rename.h"
+
+#include "comm.c"
+#include "comm_tdma.c"
+#include "comm_flow.c"
+#include "comm_rpc.c"
+#include "comm_link.c"
+#include "comm_ota.c"
+
+#include "sim_stack.h"
+
+#define SIM_STR_(x) #x
+#define SIM_STR(x) SIM_STR_(x)
+
+// 与遥控器固件相同，通信模块初始化之后初始化OTA层
+static void sim_stack_init(BadDataPackCb_t callback, const CommPort_t *port)
+{
+    RemoteCommInitWithPort(callback, port);
+    comm_ota_init();
+}
+
+const SimStack_t SIM_STACK_NAME = {
+    .name = SIM_STR(SIM_STACK_NAME),
+    .init = sim_stack_init,
+    .register_recv_cb = register_comm_recv_cb,
+    .unregister_recv_cb = unregister_comm_recv_cb,
+    .send_nak = asyn_comm_send_pack_nak,
+    .send_ack = comm_send_pack_ack,
+    .tdma_config = comm_tdma_config,
+    .get_stats = comm_get_stats,
+    .set_compress_cmd = comm_set_compress_cmd,
+    .set_node_id = comm_set_node_id,
+    .set_default_dst = comm_set_default_dst,
+    .link_config = comm_link_config,
+    .link_set_state_cb = comm_link_set_state_cb,
+    .link_set_failsafe = comm_link_set_failsafe,
+    .link_get_stats = comm_link_get_stats,
+    .ota_register_sink = comm_ota_register_sink,
+    .ota_send = comm_ota_send,
+    .ota_get_tx_stats = comm_ota_get_tx_stats,
+    .ota_get_rx_stats = comm_ota_get_rx_stats,
+};
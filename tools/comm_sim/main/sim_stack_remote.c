@@ -0,0 +1,3 @@
+#define SIM_STACK_PREFIX remote_
+#define SIM_STACK_NAME sim_stack_remote
+#include "sim_stack_impl.h"
@@ -0,0 +1,110 @@
+#ifndef __SIM_STACK_RENAME_H__
+#define __SIM_STACK_RENAME_H__
+
+/*
+ * 给 comm.c / comm_tdma.c / comm_flow.c / comm_rpc.c / comm_link.c / comm_ota.c 的全部对外符号加上 SIM_STACK_PREFIX 前缀。
+ * comm.c 新增对外函数时需要同步加到这里，否则链接时两个协议栈会出现重复定义。
+ */
+#ifndef SIM_STACK_PREFIX
+#error "SIM_STACK_PREFIX must be defined before including sim_stack_rename.h"
+#endif
+
+#define SIM_CAT_(a, b) a##b
+#define SIM_CAT(a, b) SIM_CAT_(a, b)
+#define SIM_NS(x) SIM_CAT(SIM_STACK_PREFIX, x)
+
+// comm.c
+#define RemoteCommInitWithPort      SIM_NS(RemoteCommInitWithPort)
+#define register_comm_recv_cb       SIM_NS(register_comm_recv_cb)
+#define unregister_comm_recv_cb     SIM_NS(unregister_comm_recv_cb)
+#define asyn_comm_send_pack_nak     SIM_NS(asyn_comm_send_pack_nak)
+#define comm_send_pack_ack          SIM_NS(comm_send_pack_ack)
+#define asyn_comm_send_pack_ack     SIM_NS(asyn_comm_send_pack_ack)
+#define comm_get_stats              SIM_NS(comm_get_stats)
+#define comm_reset_stats            SIM_NS(comm_reset_stats)
+#define asyn_comm_send_pack_nak_timeout SIM_NS(asyn_comm_send_pack_nak_timeout)
+#define asyn_comm_send_pack_ack_timeout SIM_NS(asyn_comm_send_pack_ack_timeout)
+#define comm_send_queue_depth       SIM_NS(comm_send_queue_depth)
+#define comm_send_queue_free        SIM_NS(comm_send_queue_free)
+#define comm_set_queue_watermark    SIM_NS(comm_set_queue_watermark)
+#define comm_set_tx_trace           SIM_NS(comm_set_tx_trace)
+#define comm_set_rx_hook            SIM_NS(comm_set_rx_hook)
+#define comm_ack_pending            SIM_NS(comm_ack_pending)
+#define comm_set_compress_cmd       SIM_NS(comm_set_compress_cmd)
+#define register_comm_recv_cb_from  SIM_NS(register_comm_recv_cb_from)
+#define asyn_comm_send_pack_nak_to  SIM_NS(asyn_comm_send_pack_nak_to)
+#define asyn_comm_send_pack_ack_to  SIM_NS(asyn_comm_send_pack_ack_to)
+#define comm_set_node_id            SIM_NS(comm_set_node_id)
+#define comm_get_node_id            SIM_NS(comm_get_node_id)
+#define comm_set_default_dst        SIM_NS(comm_set_default_dst)
+#define comm_get_default_dst        SIM_NS(comm_get_default_dst)
+#define comm_recv_src_node          SIM_NS(comm_recv_src_node)
+#define comm_get_node_stats         SIM_NS(comm_get_node_stats)
+#define register_comm_recv_queue    SIM_NS(register_comm_recv_queue)
+#define comm_rx_frame_retain        SIM_NS(comm_rx_frame_retain)
+#define comm_rx_frame_release       SIM_NS(comm_rx_frame_release)
+#define comm_rx_pool_free           SIM_NS(comm_rx_pool_free)
+#define SendDataPackTask            SIM_NS(SendDataPackTask)
+#define ReceiveDataPackTask         SIM_NS(ReceiveDataPackTask)
+#define ACKTimeoutCheckTask         SIM_NS(ACKTimeoutCheckTask)
+
+// comm_tdma.c
+#define comm_tdma_config            SIM_NS(comm_tdma_config)
+#define comm_tdma_is_synced         SIM_NS(comm_tdma_is_synced)
+#define tdma_init                   SIM_NS(tdma_init)
+#define tdma_enabled                SIM_NS(tdma_enabled)
+#define tdma_role                   SIM_NS(tdma_role)
+#define tdma_airtime_ms             SIM_NS(tdma_airtime_ms)
+#define tdma_wait_window            SIM_NS(tdma_wait_window)
+#define tdma_build_beacon           SIM_NS(tdma_build_beacon)
+#define tdma_on_beacon              SIM_NS(tdma_on_beacon)
+
+// comm_flow.c
+#define comm_flow_set_bulk_cmd      SIM_NS(comm_flow_set_bulk_cmd)
+#define comm_flow_set_rx_window     SIM_NS(comm_flow_set_rx_window)
+#define comm_flow_stop_rx           SIM_NS(comm_flow_stop_rx)
+#define comm_flow_tx_credits        SIM_NS(comm_flow_tx_credits)
+#define flow_init                   SIM_NS(flow_init)
+#define flow_take_credit            SIM_NS(flow_take_credit)
+#define flow_return_credit          SIM_NS(flow_return_credit)
+#define flow_build_advert           SIM_NS(flow_build_advert)
+#define flow_advert_sent            SIM_NS(flow_advert_sent)
+#define flow_on_data_received       SIM_NS(flow_on_data_received)
+#define flow_on_credit              SIM_NS(flow_on_credit)
+
+// comm_rpc.c
+#define comm_rpc_init               SIM_NS(comm_rpc_init)
+#define comm_rpc_register_method    SIM_NS(comm_rpc_register_method)
+#define comm_rpc_call               SIM_NS(comm_rpc_call)
+#define comm_rpc_cancel             SIM_NS(comm_rpc_cancel)
+#define comm_rpc_cancel_by_user     SIM_NS(comm_rpc_cancel_by_user)
+#define comm_rpc_poll               SIM_NS(comm_rpc_poll)
+#define comm_rpc_in_flight          SIM_NS(comm_rpc_in_flight)
+
+// comm_link.c
+#define comm_link_config            SIM_NS(comm_link_config)
+#define comm_link_set_state_cb      SIM_NS(comm_link_set_state_cb)
+#define comm_link_set_failsafe      SIM_NS(comm_link_set_failsafe)
+#define comm_link_state             SIM_NS(comm_link_state)
+#define comm_link_get_stats         SIM_NS(comm_link_get_stats)
+#define link_init                   SIM_NS(link_init)
+#define link_on_rx                  SIM_NS(link_on_rx)
+#define link_on_heartbeat           SIM_NS(link_on_heartbeat)
+#define link_on_tx                  SIM_NS(link_on_tx)
+#define link_build_heartbeat        SIM_NS(link_build_heartbeat)
+#define link_heartbeat_sent         SIM_NS(link_heartbeat_sent)
+#define link_check                  SIM_NS(link_check)
+#define link_notify                 SIM_NS(link_notify)
+#define link_get_failsafe           SIM_NS(link_get_failsafe)
+
+// comm_ota.c
+#define comm_ota_init               SIM_NS(comm_ota_init)
+#define comm_ota_register_sink      SIM_NS(comm_ota_register_sink)
+#define comm_ota_send               SIM_NS(comm_ota_send)
+#define comm_ota_abort              SIM_NS(comm_ota_abort)
+#define comm_ota_get_tx_stats       SIM_NS(comm_ota_get_tx_stats)
+#define comm_ota_get_rx_stats       SIM_NS(comm_ota_get_rx_stats)
+#define comm_ota_busy               SIM_NS(comm_ota_busy)
+#define OtaTask                     SIM_NS(OtaTask)
+
+#endif
@@ -0,0 +1,3 @@
+#define SIM_STACK_PREFIX robot_
+#define SIM_STACK_NAME sim_stack_robot
+#include "sim_stack_impl.h"
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "key_event.c"      // 需要直接设置队列序号 kHead 和各按键的状态
+
+/*
+ * key_event 的功能测试，按固件的1kHz扫描周期送入按键状态，检查产生的事件序列：
+ * 1. 消抖：按下/松开时的抖动只产生一个事件，时间戳是第一次变化的扫描时刻；锁定期内完成的短按，松开在锁定结束时报告。
+ * 2. 长按与重复：KEY_EVENT_LONG_PRESS_US 后产生长按，之后每 KEY_EVENT_REPEAT_US 一次重复，序号从1开始。
+ * 3. 双击：KEY_EVENT_DOUBLE_CLICK_US 内再次按下产生双击；长按和双击第二次的松开不作为下一次双击的开始。
+ * 4. 队列溢出：读者落后超过 KEY_EVENT_QUEUE_SIZE 个事件时读到最新的一整队事件，其余计入 lost，不同读者互不影响。
+ * 5. 序号回绕：32位事件序号回绕前后读取不丢事件、不重复，溢出计数同样正确。
+ * 单线程运行，不测试并发；有错误时主机上返回值为1。
+ */
+
+#define TEST_SCAN_US        (1000000 / 1000)    // 与 CORE_SCAN_HZ 相同
+#define TEST_MAX_EVENTS     (KEY_EVENT_QUEUE_SIZE * 2)
+
+static uint32_t kFailed;
+static int64_t kNow;
+
+#define CHECK(cond, ...)                                             \
+    do                                                               \
+    {                                                                \
+        if (!(cond))                                                 \
+        {                                                            \
+            printf("  FAIL %s:%d: ", __func__, __LINE__);            \
+            printf(__VA_ARGS__);                                     \
+            printf("\n");                                            \
+            kFailed++;                                               \
+        }                                                            \
+    } while (0)
+
+// 各按键回到松开状态，时间前进足够久，不影响下一项测试
+static void test_reset(void)
+{
+    memset(kKeys, 0, sizeof(kKeys));
+    kStable = 0;
+    kNow += 10000000;
+}
+
+// 从当前时刻起每个扫描周期送入一次 keys，持续 us 微秒
+static void feed(uint16_t keys, int64_t us)
+{
+    for (int64_t end = kNow + us; kNow < end; kNow += TEST_SCAN_US)
+        key_event_process(keys, kNow);
+}
+
+static int drain(KeyEventReader_t *reader, KeyEvent_t *events)
+{
+    int n = 0;
+    KeyEvent_t event;
+    while (key_event_read(reader, &event))
+    {
+        if (n < TEST_MAX_EVENTS)
+            events[n] = event;
+        n++;
+    }
+    return n;
+}
+
+static void check_event(const KeyEvent_t *e, uint8_t key, uint8_t type, int64_t time_us, const char *what)
+{
+    CHECK(e->key == key && e->type == type && e->time_us == time_us, "%s: got key%u %s at %+lld us, want key%u %s",
+          what, e->key, key_event_type_name(e->type), (long long)(e->time_us - time_us), key, key_event_type_name(type));
+}
+
+static void test_debounce(void)
+{
+    KeyEventReader_t reader;
+    KeyEvent_t ev[TEST_MAX_EVENTS];
+    test_reset();
+    key_event_reader_init(&reader);
+
+    // 按下时抖动4ms，之后稳定按住
+    int64_t press_us = kNow;
+    for (int i = 0; i < 4; i++)
+        feed(i % 2 ? 0 : 0x0004, TEST_SCAN_US);
+    feed(0x0004, 100000);
+    int n = drain(&reader, ev);
+    CHECK(n == 1, "bouncy press produced %d events, want 1", n);
+    if (n >= 1)
+    {
+        check_event(&ev[0], 2, KEY_EVENT_PRESS, press_us, "bouncy press");
+        CHECK(ev[0].keys == 0x0004, "press keys 0x%X, want 0x4", ev[0].keys);
+    }
+    CHECK(key_event_get_keys() == 0x0004, "stable keys 0x%X, want 0x4", key_event_get_keys());
+
+    // 松开时抖动，另一个键在锁定期内按下不受影响
+    int64_t release_us = kNow;
+    feed(0x0000, TEST_SCAN_US);
+    feed(0x0004, TEST_SCAN_US);
+    int64_t other_us = kNow;
+    feed(0x0010, TEST_SCAN_US);
+    feed(0x0000, 100000);
+    n = drain(&reader, ev);
+    CHECK(n == 3, "bouncy release produced %d events, want 3", n);
+    if (n >= 3)
+    {
+        check_event(&ev[0], 2, KEY_EVENT_RELEASE, release_us, "bouncy release");
+        check_event(&ev[1], 4, KEY_EVENT_PRESS, other_us, "other key press");
+        check_event(&ev[2], 4, KEY_EVENT_RELEASE, other_us + KEY_EVENT_DEBOUNCE_US, "other key release");
+        CHECK(ev[1].keys == 0x0010 && ev[2].keys == 0x0000, "keys 0x%X 0x%X, want 0x10 0x0", ev[1].keys, ev[2].keys);
+    }
+
+    // 锁定期内完成的短按：按下立即报告，松开在锁定结束的那次扫描报告
+    press_us = kNow;
+    feed(0x0001, 3 * TEST_SCAN_US);
+    feed(0x0000, 100000);
+    n = drain(&reader, ev);
+    CHECK(n == 2, "short tap produced %d events, want 2", n);
+    if (n >= 2)
+    {
+        check_event(&ev[0], 0, KEY_EVENT_PRESS, press_us, "short tap press");
+        check_event(&ev[1], 0, KEY_EVENT_RELEASE, press_us + KEY_EVENT_DEBOUNCE_US, "short tap release");
+    }
+    CHECK(reader.lost == 0, "lost %lu", (unsigned long)reader.lost);
+}
+
+static void test_long_press(void)
+{
+    KeyEventReader_t reader;
+    KeyEvent_t ev[TEST_MAX_EVENTS];
+    test_reset();
+    key_event_reader_init(&reader);
+
+    int64_t press_us = kNow;
+    int64_t hold_us = KEY_EVENT_LONG_PRESS_US + 2 * KEY_EVENT_REPEAT_US + KEY_EVENT_REPEAT_US / 2;
+    feed(0x8000, hold_us);
+    int64_t release_us = kNow;
+    feed(0x0000, 100000);
+    // 长按的松开之后马上再按，不算双击
+    feed(0x8000, 50000);
+    feed(0x0000, 50000);
+    int n = drain(&reader, ev);
+    CHECK(n == 7, "long press produced %d events, want 7", n);
+    if (n >= 7)
+    {
+        check_event(&ev[0], 15, KEY_EVENT_PRESS, press_us, "press");
+        check_event(&ev[1], 15, KEY_EVENT_LONG_PRESS, press_us + KEY_EVENT_LONG_PRESS_US, "long press");
+        check_event(&ev[2], 15, KEY_EVENT_REPEAT, press_us + KEY_EVENT_LONG_PRESS_US + KEY_EVENT_REPEAT_US, "repeat 1");
+        check_event(&ev[3], 15, KEY_EVENT_REPEAT, press_us + KEY_EVENT_LONG_PRESS_US + 2 * KEY_EVENT_REPEAT_US, "repeat 2");
+        CHECK(ev[2].count == 1 && ev[3].count == 2, "repeat count %u %u, want 1 2", ev[2].count, ev[3].count);
+        check_event(&ev[4], 15, KEY_EVENT_RELEASE, release_us, "release");
+        CHECK(ev[5].type == KEY_EVENT_PRESS && ev[6].type == KEY_EVENT_RELEASE, "press after long press: %s %s",
+              key_event_type_name(ev[5].type), key_event_type_name(ev[6].type));
+    }
+}
+
+static void test_double_click(void)
+{
+    KeyEventReader_t reader;
+    KeyEvent_t ev[TEST_MAX_EVENTS];
+    test_reset();
+    key_event_reader_init(&reader);
+
+    // 两次短按间隔100ms是双击，紧接着的第三次不是
+    feed(0x0002, 50000);
+    feed(0x0000, 100000);
+    int64_t second_us = kNow;
+    feed(0x0002, 50000);
+    feed(0x0000, 100000);
+    feed(0x0002, 50000);
+    feed(0x0000, KEY_EVENT_DOUBLE_CLICK_US + 100000);
+    // 间隔超过 KEY_EVENT_DOUBLE_CLICK_US 不是双击
+    feed(0x0002, 50000);
+    feed(0x0000, 50000);
+    int n = drain(&reader, ev);
+    CHECK(n == 9, "double click produced %d events, want 9", n);
+    if (n >= 9)
+    {
+        static const uint8_t kWant[] = {KEY_EVENT_PRESS, KEY_EVENT_RELEASE, KEY_EVENT_PRESS, KEY_EVENT_DOUBLE_CLICK,
+                                        KEY_EVENT_RELEASE, KEY_EVENT_PRESS, KEY_EVENT_RELEASE, KEY_EVENT_PRESS,
+                                        KEY_EVENT_RELEASE};
+        for (int i = 0; i < 9; i++)
+            CHECK(ev[i].type == kWant[i] && ev[i].key == 1, "event %d: key%u %s, want key1 %s", i, ev[i].key,
+                  key_event_type_name(ev[i].type), key_event_type_name(kWant[i]));
+        check_event(&ev[3], 1, KEY_EVENT_DOUBLE_CLICK, second_us, "double click");
+    }
+}
+
+// 第 i 个测试事件：按键 (i/2)%16 按下（i为偶数）或松开，每个持续20ms。
+// 同一个键隔 16×40ms 才再次按下，不会产生双击
+#define TEST_EVENT_US       20000
+
+static uint16_t event_keys(int i)
+{
+    return i % 2 ? 0x0000 : (uint16_t)(1u << ((i / 2) % KEY_EVENT_KEYS));
+}
+
+static int64_t make_events(int count)
+{
+    int64_t first_us = kNow;
+    for (int i = 0; i < count; i++)
+        feed(event_keys(i), TEST_EVENT_US);
+    return first_us;
+}
+
+// 读者落后 count 个事件，应读到最后 KEY_EVENT_QUEUE_SIZE 个（按时间顺序），其余计入 lost
+static void check_overflow(KeyEventReader_t *reader, int count, int64_t first_us, const char *what)
+{
+    KeyEvent_t ev[TEST_MAX_EVENTS];
+    int want = count < KEY_EVENT_QUEUE_SIZE ? count : KEY_EVENT_QUEUE_SIZE;
+    int skipped = count - want;
+    int n = drain(reader, ev);
+    CHECK(n == want, "%s: read %d events, want %d", what, n, want);
+    CHECK(reader->lost == (uint32_t)skipped, "%s: lost %lu, want %d", what, (unsigned long)reader->lost, skipped);
+    for (int i = 0; i < n && i < want; i++)
+    {
+        int k = skipped + i;
+        uint8_t type = k % 2 ? KEY_EVENT_RELEASE : KEY_EVENT_PRESS;
+        if (ev[i].time_us != first_us + k * TEST_EVENT_US || ev[i].type != type || ev[i].key != (k / 2) % KEY_EVENT_KEYS)
+        {
+            CHECK(0, "%s: event %d is key%u %s at %+lld us, want event %d", what, i, ev[i].key,
+                  key_event_type_name(ev[i].type), (long long)(ev[i].time_us - first_us), k);
+            break;
+        }
+    }
+}
+
+static void test_overflow(void)
+{
+    KeyEventReader_t slow, fast, late;
+    KeyEvent_t ev[TEST_MAX_EVENTS];
+    test_reset();
+    key_event_reader_init(&slow);
+    key_event_reader_init(&fast);
+
+    // 快的读者每个事件都读，慢的读者最后才读
+    int count = KEY_EVENT_QUEUE_SIZE + 36;
+    int64_t first_us = kNow;
+    int fast_n = 0;
+    for (int i = 0; i < count; i++)
+    {
+        feed(event_keys(i), TEST_EVENT_US);
+        fast_n += drain(&fast, ev);
+    }
+    CHECK(fast_n == count && fast.lost == 0, "fast reader read %d lost %lu, want %d 0", fast_n, (unsigned long)fast.lost,
+          count);
+    check_overflow(&slow, count, first_us, "slow reader");
+
+    // 刚好写满一队不丢
+    test_reset();
+    key_event_reader_init(&slow);
+    first_us = make_events(KEY_EVENT_QUEUE_SIZE);
+    check_overflow(&slow, KEY_EVENT_QUEUE_SIZE, first_us, "full queue");
+
+    // 初始化之后没有新事件
+    key_event_reader_init(&late);
+    CHECK(drain(&late, ev) == 0, "new reader saw old events");
+}
+
+static void test_wraparound(void)
+{
+    KeyEventReader_t reader, slow;
+    KeyEvent_t ev[TEST_MAX_EVENTS];
+    test_reset();
+    // 序号从回绕前20个开始（环形队列中的旧内容不影响从此开始的读者）
+    atomic_store(&kHead, (uint32_t)(UINT32_MAX - 20));
+    key_event_reader_init(&reader);
+    key_event_reader_init(&slow);
+
+    int count = 2 * KEY_EVENT_QUEUE_SIZE;
+    int64_t first_us = kNow;
+    int n = 0;
+    for (int i = 0; i < count; i++)
+    {
+        feed(event_keys(i), TEST_EVENT_US);
+        int got = drain(&reader, ev);
+        if (got != 1 || ev[0].time_us != first_us + i * TEST_EVENT_US)
+            CHECK(0, "event %d (seq 0x%08lX): read %d events", i, (unsigned long)(uint32_t)(UINT32_MAX - 20 + i), got);
+        n += got;
+    }
+    CHECK(n == count && reader.lost == 0, "across wrap: read %d lost %lu, want %d 0", n, (unsigned long)reader.lost, count);
+    CHECK((uint32_t)atomic_load(&kHead) < (uint32_t)count, "head did not wrap");
+    check_overflow(&slow, count, first_us, "slow reader across wrap");
+}
+
+void app_main(void)
+{
+    struct
+    {
+        const char *name;
+        void (*run)(void);
+    } tests[] = {
+        {"debounce", test_debounce},
+        {"long press / repeat", test_long_press},
+        {"double click", test_double_click},
+        {"queue overflow", test_overflow},
+        {"sequence wraparound", test_wraparound},
+    };
+    kNow = 1000000;
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++)
+    {
+        uint32_t before = kFailed;
+        tests[i].run();
+        printf("%-24s %s\n", tests[i].name, kFailed == before ? "ok" : "FAILED");
+    }
+    printf("\n%s\n", kFailed ? "FAILED" : "ok");
+
+    fflush(stdout);
+#if CONFIG_IDF_TARGET_LINUX
+    exit(kFailed ? 1 : 0);
+#else
+    while (1)
+        vTaskDelay(portMAX_DELAY);
+#endif
+}
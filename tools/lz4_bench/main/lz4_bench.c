@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "lvgl/src/libs/lz4/lz4.h"
+
+/*
+ * 按通信协议的方式（每帧独立压缩，输出上限为原长-1，加速因子1）压缩几类典型负载，
+ * 输出每类负载的压缩率、压缩帧占比以及单帧压缩/解压耗时，用于判断哪些命令值得开启 comm_set_compress_cmd。
+ *
+ * 负载由固定格式+变化的数值生成，接近实际运行时的数据；长度不超过单帧数据域上限 BENCH_FRAME_MAX。
+ */
+
+#define BENCH_FRAME_MAX     247         // 帧长度字段为1字节：255 - 8字节帧开销
+#define BENCH_FRAMES        512         // 每类负载生成的帧数
+#define BENCH_REPEAT        200         // 每帧重复压缩/解压的次数（取平均）
+
+typedef uint16_t (*BenchGen_t)(uint8_t *buf, uint32_t seq);
+
+typedef struct
+{
+    const char *name;
+    BenchGen_t gen;
+} BenchCase_t;
+
+static int64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static float jitter(uint32_t seq, float amp)
+{
+    return amp * (float)((seq * 2654435761u) >> 16 & 0xFFFF) / 65535.0f;
+}
+
+/* -------------------- 典型负载 -------------------- */
+// 机器人日志：ESP_LOG 格式，一帧放尽量多的整行
+static uint16_t gen_robot_log(uint8_t *buf, uint32_t seq)
+{
+    static const char *const kTags[] = {"chassis", "gimbal", "shooter", "imu", "comm"};
+    uint16_t len = 0;
+    for (uint32_t line = 0;; line++)
+    {
+        char tmp[96];
+        uint32_t s = seq * 8 + line;
+        int n = snprintf(tmp, sizeof(tmp), "I (%lu) %s: target=%.2f actual=%.2f out=%d\n",
+                         (unsigned long)(100000 + s * 13), kTags[s % 5], 1.0f + jitter(s, 2.0f),
+                         1.0f + jitter(s + 7, 2.0f), (int)(jitter(s + 3, 16000.0f)) - 8000);
+        if (len + n > BENCH_FRAME_MAX)
+            break;
+        memcpy(buf + len, tmp, (size_t)n);
+        len += (uint16_t)n;
+    }
+    return len;
+}
+
+// 字符串反馈（PACK_STR_FEEDBACK_CMD）：键值对状态文本
+static uint16_t gen_feedback(uint8_t *buf, uint32_t seq)
+{
+    int n = snprintf((char *)buf, BENCH_FRAME_MAX + 1,
+                     "pos x=%.3f y=%.3f yaw=%.1f | vel vx=%.2f vy=%.2f w=%.2f | bat=%.1fV | "
+                     "motor0=%d motor1=%d motor2=%d motor3=%d | state=RUNNING err=0",
+                     jitter(seq, 8.0f), jitter(seq + 1, 8.0f), jitter(seq + 2, 360.0f),
+                     jitter(seq + 3, 3.0f), jitter(seq + 4, 3.0f), jitter(seq + 5, 6.0f),
+                     22.0f + jitter(seq + 6, 3.0f), (int)jitter(seq + 7, 9000.0f),
+                     (int)jitter(seq + 8, 9000.0f), (int)jitter(seq + 9, 9000.0f), (int)jitter(seq + 10, 9000.0f));
+    return (uint16_t)(n > BENCH_FRAME_MAX ? BENCH_FRAME_MAX : n);
+}
+
+// 短反馈：单条提示信息
+static uint16_t gen_short_msg(uint8_t *buf, uint32_t seq)
+{
+    return (uint16_t)snprintf((char *)buf, BENCH_FRAME_MAX + 1, "shooter ready, ammo=%d", (int)jitter(seq, 40.0f));
+}
+
+// 对照：控制帧（PackControl_t，4个float+按键），二进制数据基本不可压缩
+static uint16_t gen_control(uint8_t *buf, uint32_t seq)
+{
+    float rocker[4];
+    for (int i = 0; i < 4; i++)
+        rocker[i] = jitter(seq + (uint32_t)i, 2.0f) - 1.0f;
+    uint32_t key = seq & 0x3;
+    memcpy(buf, rocker, sizeof(rocker));
+    memcpy(buf + sizeof(rocker), &key, sizeof(key));
+    return sizeof(rocker) + sizeof(key);
+}
+
+static const BenchCase_t kCases[] = {
+    {"robot_log", gen_robot_log},
+    {"feedback", gen_feedback},
+    {"short_msg", gen_short_msg},
+    {"control", gen_control},
+};
+
+/* -------------------- 测试 -------------------- */
+static void run_case(const BenchCase_t *c, void *state)
+{
+    static uint8_t src[BENCH_FRAMES][BENCH_FRAME_MAX];
+    static uint16_t src_len[BENCH_FRAMES];
+    uint8_t packed[BENCH_FRAME_MAX];
+    uint8_t plain[BENCH_FRAME_MAX];
+
+    uint64_t raw_bytes = 0, wire_bytes = 0;
+    uint32_t compressed = 0;
+    int64_t comp_ns = 0, decomp_ns = 0;
+
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+        src_len[i] = c->gen(src[i], i);
+
+    for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+    {
+        uint16_t size = src_len[i];
+        int n = 0;
+        int64_t t0 = now_ns();
+        for (int r = 0; r < BENCH_REPEAT; r++)
+            n = LZ4_compress_fast_extState(state, (const char *)src[i], (char *)packed, size, size - 1, 1);
+        comp_ns += now_ns() - t0;
+
+        raw_bytes += size;
+        if (n <= 0)
+        {
+            wire_bytes += size;     // 压缩不划算，原样发送
+            continue;
+        }
+        compressed++;
+        wire_bytes += (uint32_t)n;
+
+        int m = 0;
+        t0 = now_ns();
+        for (int r = 0; r < BENCH_REPEAT; r++)
+            m = LZ4_decompress_safe((const char *)packed, (char *)plain, n, sizeof(plain));
+        decomp_ns += now_ns() - t0;
+        if (m != size || memcmp(plain, src[i], size) != 0)
+        {
+            printf("%s: frame %lu round trip mismatch\n", c->name, (unsigned long)i);
+            exit(1);
+        }
+    }
+
+    printf("%-10s %8.1f %8.3f %7.1f%% %10.2f %10.2f\n", c->name, (double)raw_bytes / BENCH_FRAMES,
+           (double)wire_bytes / (double)raw_bytes, 100.0 * compressed / BENCH_FRAMES,
+           comp_ns / 1000.0 / BENCH_FRAMES / BENCH_REPEAT,
+           compressed ? decomp_ns / 1000.0 / compressed / BENCH_REPEAT : 0.0);
+}
+
+void app_main(void)
+{
+    void *state = malloc((size_t)LZ4_sizeofState());
+    if (!state)
+    {
+        printf("no memory for LZ4 state\n");
+        exit(1);
+    }
+
+    printf("LZ4 state %d bytes, %d frames x %d repeats per case\n\n", LZ4_sizeofState(), BENCH_FRAMES, BENCH_REPEAT);
+    printf("%-10s %8s %8s %8s %10s %10s\n", "case", "avg_len", "ratio", "packed", "comp_us", "decomp_us");
+    for (size_t i = 0; i < sizeof(kCases) / sizeof(kCases[0]); i++)
+        run_case(&kCases[i], state);
+    printf("\nratio = 发送字节/原始字节（不可压缩的帧按原样计入）；packed = 以压缩形式发送的帧占比\n");
+
+    free(state);
+    fflush(stdout);
+    exit(0);
+}
@@ -0,0 +1,474 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mixer.h"
+#include "virtual_item.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_timer.h"
+#endif
+
+/*
+ * 1. 解析：格式错误的文本返回0并给出出错的行号，注释、空行、CRLF、十六进制掩码可以正常解析。
+ * 2. 编译：检查操作表的结构——条件相同的连续行共用一个 SKIP（跳过的操作数正确），永远不生效的行被去掉；
+ *    ch 源在使用处用 CH 读取；同一源和曲线只计算一次，只经过曲线使用的源在原寄存器上做曲线。
+ * 3. 执行：随机摇杆/按键/虚拟控件输入下，mixer_eval 的输出与按模型直接用浮点计算的参考结果比较，
+ *    覆盖 add/replace/mul、偏移、曲线、按键条件、ch 级联、微调、反向和上下限，并统计每次执行的耗时。
+ * 芯片上不使用NVS（只调用 mixer_parse/mixer_compile/mixer_eval），结果从串口输出；有错误时主机上返回值为1。
+ */
+
+#define BENCH_SAMPLES       200000      // 每个模型的随机输入组数
+#define BENCH_EVALS         100000      // 计时的执行次数
+#define BENCH_LINEAR_TOL    4           // 不带曲线的模型允许的最大误差（LSB，定点截断）
+// 带曲线的模型允许的最大误差（LSB，1%）：曲线编译成33点查找表，点数-1不整除32的点曲线（例如7点）拐点落在表格点之间，
+// 拐点附近的误差约为 斜率变化 × 表格步长/4 × 权重
+#define BENCH_CURVE_TOL     328
+
+typedef struct
+{
+    const char *text;
+    int err_line;           // 0：应当解析成功
+} ParseCase_t;
+
+typedef struct
+{
+    const char *name;
+    const char *text;
+    int32_t tol;
+} EvalCase_t;
+
+static const ParseCase_t kParseCases[] = {
+    {"# comment\r\n\r\nmode 0 0x400 0x400\r\nmix 0 stick1 100 mode 0 # tail\r\nout 0 trim -5 reverse\r\n", 0},
+    {"mix 0 stick1 100\nmix 8 stick0 100\n", 2},                // 通道超出范围
+    {"mix 0 stick4 100\n", 1},                                  // 源超出范围
+    {"mix 0 foo 100", 1},                                       // 未知的源，最后一行没有换行
+    {"mix 0 stick0 201\n", 1},                                  // 权重超出范围
+    {"mix 0 stick0 100 offset\n", 1},                           // 选项缺少参数
+    {"mix 0 stick0 100 when 0x10\n", 1},
+    {"mode 0 0x400 0x400\n\nmix 0 stick0 100 mode 1\n", 3},     // 模式没有定义，空行也计入行号
+    {"# c\ncurve 0 expo 150\n", 2},
+    {"curve 1 points 0\n", 1},                                  // 点曲线至少2个点
+    {"curve 8 expo 10\n", 1},
+    {"out 0 min 50 max -50\n", 1},
+    {"mix 0 stick0 100 bogus\n", 1},
+    {"bogus\n", 1},
+};
+
+// 条件分组：第3~5行共用一个 SKIP（c=3），第6~7行另一个（c=2），最后一行与前面隔着无条件行（c=1）；第8、9行被去掉
+static const char kGroupModel[] =
+    "mode 0 0x400 0x400\n"
+    "mix 0 stick1 100\n"
+    "mix 0 stick0 50 mode 0\n"
+    "mix 1 stick0 -50 mode 0\n"
+    "mix 2 stick2 100 when 0x400 0x400\n"
+    "mix 0 stick0 100 when 0x400 0\n"
+    "mix 1 stick0 -100 when 0x400 0\n"
+    "mix 3 stick3 100 when 0x1 0x2\n"
+    "mix 3 stick3 0\n"
+    "mix 3 stick2 100\n"
+    "mix 2 max 20 mode 0\n";
+static const uint8_t kGroupSkips[] = {3, 2, 1};
+
+// ch 源：通道0超过100%，作为源时限幅；之后再修改通道0不影响已经读取的值
+static const char kChModel[] =
+    "curve 0 expo 30\n"
+    "mix 0 stick0 200\n"
+    "mix 1 ch0 50 curve 0\n"
+    "mix 3 ch0 50\n"
+    "mix 2 stick2 100\n"
+    "mix 2 ch1 100 mul offset 20\n"
+    "mix 0 stick1 100\n";
+
+// 曲线寄存器：stick0 只经过曲线使用（原寄存器），stick1 同时需要原值（新寄存器），
+// stick2 经过两条曲线（第一条新寄存器，最后一条原寄存器）；stick0/曲线0 只计算一次
+static const char kCurveModel[] =
+    "curve 0 expo 40\n"
+    "curve 1 points -100 -20 0 20 100\n"
+    "mix 0 stick0 100 curve 0\n"
+    "mix 1 stick0 50 curve 0\n"
+    "mix 2 stick1 100\n"
+    "mix 2 stick1 30 curve 0\n"
+    "mix 3 stick2 100 curve 0\n"
+    "mix 3 stick2 -100 curve 1 add\n";
+
+// 完整模型：差速底盘加各种混控方式和输出设置
+static const char kFullModel[] =
+    "curve 0 expo 50\n"
+    "curve 1 points -100 -60 -30 0 30 60 100\n"
+    "mode 0 0x400 0x400\n"
+    "mode 1 0x400 0\n"
+    "mix 0 stick1 100\n"
+    "mix 0 stick0 50 curve 0 mode 0\n"
+    "mix 0 stick0 100 curve 0 mode 1\n"
+    "mix 1 stick1 100\n"
+    "mix 1 stick0 -50 curve 0 mode 0\n"
+    "mix 1 stick0 -100 curve 0 mode 1\n"
+    "mix 2 stick2 80 offset 10 curve 1\n"
+    "mix 2 virt0 150 offset 20 mul\n"
+    "mix 3 key0 100 replace\n"
+    "mix 3 key1 -100\n"
+    "mix 4 max 30 offset -10\n"
+    "mix 4 stick3 -120 curve 1\n"
+    "mix 5 stick3 100\n"
+    "mix 5 ch2 50 offset 50 mul\n"
+    "mix 6 ch0 50\n"
+    "mix 6 ch1 50 when 0x3 0x1\n"
+    "mix 7 virt1 200 replace\n"
+    "out 0 trim 5\n"
+    "out 1 reverse\n"
+    "out 2 min -50 max 80\n"
+    "out 4 trim -20 reverse min -90 max 60\n"
+    "out 6 max 40\n"
+    "out 7 trim 10\n";
+
+static const EvalCase_t kEvalCases[] = {
+    {"group", kGroupModel, BENCH_LINEAR_TOL},
+    {"ch", kChModel, BENCH_CURVE_TOL},
+    {"curve", kCurveModel, BENCH_CURVE_TOL},
+    {"full", kFullModel, BENCH_CURVE_TOL},
+};
+
+static MixerModel_t kModel;
+static MixerProgram_t kProgram;
+static int16_t kVirt[MIXER_VIRT_NUM];
+
+// 只编译 mixer.c，mixer_run 中使用的虚拟控件值由这里提供
+const volatile int16_t *virtual_item_values(void)
+{
+    return kVirt;
+}
+
+static int64_t bench_now_us(void)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static uint32_t bench_rand(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed >> 8;
+}
+
+/* -------------------- 浮点参考 -------------------- */
+
+static double ref_clamp(double v, double lo, double hi)
+{
+    return v > hi ? hi : (v < lo ? lo : v);
+}
+
+static double ref_curve(const MixerCurve_t *c, double x)
+{
+    x = ref_clamp(x, -1.0, 1.0);
+    if (c->type == MIXER_CURVE_EXPO)
+    {
+        double k = c->expo / 100.0;
+        if (k >= 0)
+            return k * x * x * x + (1 - k) * x;
+        double u = 1 - fabs(x);
+        double y = 1 - (-k * u * u * u + (1 + k) * u);
+        return x < 0 ? -y : y;
+    }
+    double pos = (x + 1.0) * 0.5 * (c->n_points - 1);
+    int j = (int)pos;
+    if (j >= c->n_points - 1)
+        j = c->n_points - 2;
+    return (c->points[j] + (c->points[j + 1] - c->points[j]) * (pos - j)) / 100.0;
+}
+
+// 按模型逐行计算，单位与定点相同（32768 为 100%）
+static void ref_eval(const MixerModel_t *model, const int16_t sticks[4], uint16_t keys, const int16_t virt[MIXER_VIRT_NUM],
+                     int16_t channels[MIXER_CHANNELS])
+{
+    const double one = 32767.0;
+    double ch[MIXER_CHANNELS] = {0};
+    for (int i = 0; i < model->n_lines; i++)
+    {
+        const MixerLine_t *l = &model->lines[i];
+        if ((keys & l->when_mask) != l->when_value)
+            continue;
+        double x;
+        if (l->src < MIXER_SRC_KEY(0))
+            x = ref_clamp(sticks[l->src], -one, one);
+        else if (l->src < MIXER_SRC_MAX)
+            x = (keys >> (l->src - MIXER_SRC_KEY(0))) & 1 ? one : 0;
+        else if (l->src == MIXER_SRC_MAX)
+            x = one;
+        else if (l->src < MIXER_SRC_VIRT(0))
+            x = ref_clamp(ch[l->src - MIXER_SRC_CH(0)], -one, one);
+        else
+            x = ref_clamp(virt[l->src - MIXER_SRC_VIRT(0)], -one, one);
+        if (l->curve != MIXER_CURVE_NONE)
+            x = ref_curve(&model->curves[l->curve], x / 32768.0) * one;
+        double v = x * l->weight / 100.0 + l->offset * 32768.0 / 100.0;
+        if (l->multiplex == MIXER_MULTIPLEX_MUL)
+            ch[l->ch] = ch[l->ch] * v / 32768.0;
+        else if (l->multiplex == MIXER_MULTIPLEX_REPLACE)
+            ch[l->ch] = v;
+        else
+            ch[l->ch] += v;
+    }
+    for (int c = 0; c < MIXER_CHANNELS; c++)
+    {
+        const MixerOutput_t *o = &model->outputs[c];
+        double v = (o->reverse ? -ch[c] : ch[c]) + o->trim * 32768.0 / 100.0;
+        double lo = ref_clamp(o->min * 32768.0 / 100.0, -one, one);
+        double hi = ref_clamp(o->max * 32768.0 / 100.0, -one, one);
+        channels[c] = (int16_t)lrint(ref_clamp(v, lo, hi));
+    }
+}
+
+/* -------------------- 检查 -------------------- */
+
+static uint32_t count_ops(const MixerProgram_t *p, uint8_t code)
+{
+    uint32_t n = 0;
+    for (int i = 0; i < p->n_ops; i++)
+        n += p->ops[i].code == code;
+    return n;
+}
+
+static uint32_t load_model(const char *name, const char *text)
+{
+    int err_line = 0;
+    if (!mixer_parse(text, &kModel, &err_line))
+    {
+        printf("  %s: syntax error at line %d\n", name, err_line);
+        return 0;
+    }
+    if (!mixer_compile(&kModel, &kProgram))
+    {
+        printf("  %s: compile failed\n", name);
+        return 0;
+    }
+    return 1;
+}
+
+// 返回出错的用例数
+static uint32_t check_parse(void)
+{
+    uint32_t bad = 0;
+    for (size_t i = 0; i < sizeof(kParseCases) / sizeof(kParseCases[0]); i++)
+    {
+        const ParseCase_t *c = &kParseCases[i];
+        int err_line = -1;
+        uint32_t ok = mixer_parse(c->text, &kModel, &err_line);
+        if (c->err_line ? (ok || err_line != c->err_line) : !ok)
+        {
+            printf("  parse case %u: expected %s line %d, got %s line %d\n", (unsigned)i, c->err_line ? "error at" : "ok,",
+                   c->err_line, ok ? "ok," : "error at", ok ? 0 : err_line);
+            bad++;
+        }
+    }
+    // 超过一行最大长度
+    char text[256];
+    memset(text, 'x', sizeof(text) - 1);
+    text[0] = '#';
+    text[sizeof(text) - 1] = 0;
+    int err_line = -1;
+    if (mixer_parse(text, &kModel, &err_line) || err_line != 1)
+    {
+        printf("  parse: long line not rejected\n");
+        bad++;
+    }
+    // 超过 MIXER_MAX_LINES 行
+    static char many[(MIXER_MAX_LINES + 1) * 16 + 1];
+    size_t len = 0;
+    for (int i = 0; i <= MIXER_MAX_LINES; i++)
+        len += (size_t)snprintf(many + len, sizeof(many) - len, "mix 0 stick0 1\n");
+    if (mixer_parse(many, &kModel, &err_line) || err_line != MIXER_MAX_LINES + 1)
+    {
+        printf("  parse: line %d beyond MIXER_MAX_LINES not rejected\n", MIXER_MAX_LINES + 1);
+        bad++;
+    }
+    return bad;
+}
+
+static uint32_t check_group(void)
+{
+    uint32_t bad = 0;
+    if (!load_model("group", kGroupModel))
+        return 1;
+    uint32_t n = 0;
+    for (int i = 0; i < kProgram.n_ops; i++)
+    {
+        const MixerOp_t *op = &kProgram.ops[i];
+        if (op->code != MIXER_OP_SKIP)
+            continue;
+        if (n < sizeof(kGroupSkips) && op->c != kGroupSkips[n])
+        {
+            printf("  group: skip %u covers %u ops, expected %u\n", (unsigned)n, op->c, kGroupSkips[n]);
+            bad++;
+        }
+        n++;
+    }
+    if (n != sizeof(kGroupSkips))
+    {
+        printf("  group: %u skips, expected %u\n", (unsigned)n, (unsigned)sizeof(kGroupSkips));
+        bad++;
+    }
+    // stick3 只出现在去掉的行中，不读取
+    if (count_ops(&kProgram, MIXER_OP_SRC) != 4)
+    {
+        printf("  group: %u sources, expected 4\n", (unsigned)count_ops(&kProgram, MIXER_OP_SRC));
+        bad++;
+    }
+    return bad;
+}
+
+static uint32_t check_ch(void)
+{
+    uint32_t bad = 0;
+    if (!load_model("ch", kChModel))
+        return 1;
+    uint8_t scratch = kProgram.n_regs - 1;
+    uint32_t n = 0;
+    for (int i = 0; i < kProgram.n_ops; i++)
+    {
+        const MixerOp_t *op = &kProgram.ops[i];
+        if (op->code == MIXER_OP_SRC && op->b >= MIXER_SRC_CH(0) && op->b < MIXER_SRC_CH(MIXER_CHANNELS))
+        {
+            printf("  ch: channel source read at the top of the program\n");
+            bad++;
+        }
+        if (op->code != MIXER_OP_CH)
+            continue;
+        n++;
+        if (op->a != scratch)
+        {
+            printf("  ch: CH writes reg %u, expected scratch reg %u\n", op->a, scratch);
+            bad++;
+        }
+        // 带曲线的 ch 源（第一个）紧接着在同一寄存器上做曲线
+        if (n == 1 && (i + 1 >= kProgram.n_ops || kProgram.ops[i + 1].code != MIXER_OP_CURVE ||
+                           kProgram.ops[i + 1].a != scratch || kProgram.ops[i + 1].b != scratch))
+        {
+            printf("  ch: curve on ch0 not applied in place after CH\n");
+            bad++;
+        }
+    }
+    if (n != 3)
+    {
+        printf("  ch: %u CH ops, expected 3\n", (unsigned)n);
+        bad++;
+    }
+    return bad;
+}
+
+static uint32_t check_curve(void)
+{
+    uint32_t bad = 0;
+    if (!load_model("curve", kCurveModel))
+        return 1;
+    uint32_t in_place = 0;
+    for (int i = 0; i < kProgram.n_ops; i++)
+        in_place += kProgram.ops[i].code == MIXER_OP_CURVE && kProgram.ops[i].a == kProgram.ops[i].b;
+    uint32_t src = count_ops(&kProgram, MIXER_OP_SRC);
+    uint32_t curve = count_ops(&kProgram, MIXER_OP_CURVE);
+    // 寄存器：stick0 1个，stick1 2个，stick2 2个，ch 源临时寄存器1个
+    if (src != 3 || curve != 4 || in_place != 2 || kProgram.n_regs != 6)
+    {
+        printf("  curve: %u sources, %u curves (%u in place), %u regs; expected 3, 4 (2), 6\n", (unsigned)src,
+               (unsigned)curve, (unsigned)in_place, kProgram.n_regs);
+        bad++;
+    }
+    return bad;
+}
+
+// 返回最大误差（LSB），模型无法加载时返回 INT32_MAX
+static int32_t check_eval(const EvalCase_t *c, double *ns_per_eval)
+{
+    if (!load_model(c->name, c->text))
+        return INT32_MAX;
+    uint32_t seed = 12345;
+    int32_t max_err = 0;
+    int16_t sticks[4];
+    int16_t got[MIXER_CHANNELS];
+    int16_t expect[MIXER_CHANNELS];
+    for (int n = 0; n < BENCH_SAMPLES; n++)
+    {
+        for (int i = 0; i < 4; i++)
+            sticks[i] = (int16_t)bench_rand(&seed);         // 包含 -32768，检查源限幅
+        // 每隔一段使用满量程和中位，覆盖曲线和限幅的端点
+        if (n % 64 == 0)
+            for (int i = 0; i < 4; i++)
+                sticks[i] = (int16_t)((n / 64) % 3 == 0 ? 32767 : ((n / 64) % 3 == 1 ? -32768 : 0));
+        uint16_t keys = (uint16_t)bench_rand(&seed);
+        for (int i = 0; i < MIXER_VIRT_NUM; i++)
+            kVirt[i] = (int16_t)bench_rand(&seed);
+        memset(got, 0, sizeof(got));
+        mixer_eval(&kProgram, sticks, keys, kVirt, got);
+        ref_eval(&kModel, sticks, keys, kVirt, expect);
+        for (int ch = 0; ch < MIXER_CHANNELS; ch++)
+        {
+            int32_t err = abs(got[ch] - expect[ch]);
+            if (err > max_err)
+                max_err = err;
+        }
+    }
+
+    int64_t t0 = bench_now_us();
+    for (int n = 0; n < BENCH_EVALS; n++)
+    {
+        sticks[n & 3] = (int16_t)n;
+        mixer_eval(&kProgram, sticks, (uint16_t)n, kVirt, got);
+    }
+    int64_t t = bench_now_us() - t0;
+    *ns_per_eval = t * 1000.0 / BENCH_EVALS;
+    return max_err;
+}
+
+void app_main(void)
+{
+    uint32_t failed = 0;
+    uint32_t bad = check_parse();
+    printf("%-8s %s\n", "parse", bad ? "FAIL" : "ok");
+    failed += bad;
+    bad = check_group();
+    printf("%-8s %s\n", "group", bad ? "FAIL" : "ok");
+    failed += bad;
+    bad = check_ch();
+    printf("%-8s %s\n", "ch", bad ? "FAIL" : "ok");
+    failed += bad;
+    bad = check_curve();
+    printf("%-8s %s\n", "curve", bad ? "FAIL" : "ok");
+    failed += bad;
+
+    printf("\n%d random inputs per model, max error vs float reference (LSB, 32767 = 100%%)\n", BENCH_SAMPLES);
+    printf("%-8s %6s %6s %5s %8s %6s %10s\n", "model", "lines", "ops", "regs", "max err", "limit", "ns/eval");
+    for (size_t i = 0; i < sizeof(kEvalCases) / sizeof(kEvalCases[0]); i++)
+    {
+        const EvalCase_t *c = &kEvalCases[i];
+        double ns = 0;
+        int32_t err = check_eval(c, &ns);
+        if (err == INT32_MAX)
+        {
+            failed++;
+            continue;
+        }
+        printf("%-8s %6u %6u %5u %8ld %6ld %10.1f%s\n", c->name, kModel.n_lines, kProgram.n_ops, kProgram.n_regs, (long)err,
+               (long)c->tol, ns, err > c->tol ? "  FAIL" : "");
+        if (err > c->tol)
+            failed++;
+    }
+    printf("\n%s\n", failed ? "FAILED" : "ok");
+
+    fflush(stdout);
+#if CONFIG_IDF_TARGET_LINUX
+    exit(failed ? 1 : 0);
+#else
+    while (1)
+        vTaskDelay(portMAX_DELAY);
+#endif
+}
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "remote_state.h"
+
+/*
+ * remote_state 的并发测试：
+ * - 发布者按序号 k 发布 STRESS_PUBLISH 份快照，快照中每个字段都由 k 算出；
+ * - STRESS_READERS 个读者不停 remote_state_read，检查快照的各字段属于同一个 k（没有撕裂），序号不后退；
+ * - 订阅者反复注册/注销（其它任务中注销，以及在回调中注销自己），检查注销返回后回调不再被调用，
+ *   回调收到的快照同样检查一致性。
+ * 芯片上发布者在实时核，读者和订阅管理分布在两个核；主机上每个任务是一个线程（IDF linux 目标）。
+ * 有错误时主机上返回值为1。
+ */
+
+#define STRESS_PUBLISH      3000000
+#define STRESS_READERS      3
+#define STRESS_CHURN_SLOTS  4           // 由管理任务反复注册/注销的订阅者
+#define STRESS_SELF_DECIM   97          // 在回调中注销自己的订阅者的降频系数
+#define STRESS_YIELD_EVERY  4096        // 每多少次循环让出一次CPU（芯片上让空闲任务喂看门狗）
+
+typedef struct
+{
+    atomic_uint closed;                 // 注销已经返回
+    atomic_uint calls;
+} StressSub_t;
+
+static atomic_uint kDone;
+static atomic_uint kTorn;               // 读到撕裂的快照
+static atomic_uint kBackwards;          // 读者看到的序号后退
+static atomic_uint kLate;               // 注销之后回调仍被调用
+static atomic_uint kReads;
+static atomic_uint kCycles;             // 注册/注销次数
+static atomic_uint kFinished;           // 结束的任务数
+
+static StressSub_t kChurn[STRESS_CHURN_SLOTS];
+static StressSub_t kSelf;
+static atomic_uint kSelfHandle;
+
+static void stress_fill(RemoteState_t *s, uint32_t k)
+{
+    s->time_us = k;
+    for (int i = 0; i < 4; i++)
+    {
+        s->raw[i] = (int)(k + i);
+        s->stick[i] = (int16_t)(k * 3 + i);
+    }
+    for (int i = 0; i < MIXER_CHANNELS; i++)
+        s->channel[i] = (int16_t)(k + i * 7);
+    s->keys = (uint16_t)(k ^ 0x5a5a);
+}
+
+static uint32_t stress_consistent(const RemoteState_t *s)
+{
+    uint32_t k = (uint32_t)s->time_us;
+    if (s->seq != k)
+        return 0;
+    for (int i = 0; i < 4; i++)
+        if (s->raw[i] != (int)(k + i) || s->stick[i] != (int16_t)(k * 3 + i))
+            return 0;
+    for (int i = 0; i < MIXER_CHANNELS; i++)
+        if (s->channel[i] != (int16_t)(k + i * 7))
+            return 0;
+    return s->keys == (uint16_t)(k ^ 0x5a5a);
+}
+
+static void stress_sub_cb(const RemoteState_t *state, void *user_data)
+{
+    StressSub_t *sub = user_data;
+    if (atomic_load(&sub->closed))
+        atomic_fetch_add(&kLate, 1);
+    if (!stress_consistent(state))
+        atomic_fetch_add(&kTorn, 1);
+    atomic_fetch_add(&sub->calls, 1);
+}
+
+// 被调用一次后在回调中注销自己
+static void stress_self_cb(const RemoteState_t *state, void *user_data)
+{
+    stress_sub_cb(state, user_data);
+    uint32_t handle = atomic_exchange(&kSelfHandle, 0);
+    if (!handle)
+        return;     // 管理任务还没有保存注册返回的句柄，下一次再注销
+    remote_state_unsubscribe(handle);
+    atomic_store(&kSelf.closed, 1);
+}
+
+static void stress_publisher_task(void *param)
+{
+    RemoteState_t s;
+    for (uint32_t k = 1; k <= STRESS_PUBLISH; k++)
+    {
+        stress_fill(&s, k);
+        remote_state_publish(&s);
+        if (k % STRESS_YIELD_EVERY == 0)
+            vTaskDelay(1);
+    }
+    atomic_store(&kDone, 1);
+    atomic_fetch_add(&kFinished, 1);
+    vTaskDelete(NULL);
+}
+
+static void stress_reader_task(void *param)
+{
+    RemoteState_t s;
+    uint32_t last = 0;
+    uint32_t n = 0;
+    while (!atomic_load(&kDone))
+    {
+        if (remote_state_read(&s))
+        {
+            if (!stress_consistent(&s))
+                atomic_fetch_add(&kTorn, 1);
+            if (s.seq < last)
+                atomic_fetch_add(&kBackwards, 1);
+            last = s.seq;
+            n++;
+        }
+        if (n % STRESS_YIELD_EVERY == 0)
+            vTaskDelay(1);
+    }
+    atomic_fetch_add(&kReads, n);
+    atomic_fetch_add(&kFinished, 1);
+    vTaskDelete(NULL);
+}
+
+static void stress_churn_task(void *param)
+{
+    uint32_t handles[STRESS_CHURN_SLOTS] = {0};
+    uint32_t seed = 1;
+    while (!atomic_load(&kDone))
+    {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t i = (seed >> 16) % STRESS_CHURN_SLOTS;
+        StressSub_t *sub = &kChurn[i];
+        if (handles[i])
+        {
+            remote_state_unsubscribe(handles[i]);
+            atomic_store(&sub->closed, 1);
+            handles[i] = 0;
+        }
+        else
+        {
+            atomic_store(&sub->closed, 0);
+            handles[i] = remote_state_subscribe(stress_sub_cb, sub, 1 + (seed >> 8) % 5);
+        }
+        // 自注销的订阅者注销后重新注册
+        if (atomic_load(&kSelf.closed) && !atomic_load(&kSelfHandle))
+        {
+            atomic_store(&kSelf.closed, 0);
+            atomic_store(&kSelfHandle, remote_state_subscribe(stress_self_cb, &kSelf, STRESS_SELF_DECIM));
+        }
+        atomic_fetch_add(&kCycles, 1);
+        vTaskDelay(1);
+    }
+    for (int i = 0; i < STRESS_CHURN_SLOTS; i++)
+        remote_state_unsubscribe(handles[i]);
+    atomic_fetch_add(&kFinished, 1);
+    vTaskDelete(NULL);
+}
+
+void app_main(void)
+{
+    printf("%d publishes, %d readers, %d churn subscribers + 1 self-unsubscribing\n", STRESS_PUBLISH, STRESS_READERS,
+           STRESS_CHURN_SLOTS);
+    remote_state_init();                // 与固件相同，在创建任务之前
+    atomic_store(&kSelf.closed, 1);     // 由管理任务第一次注册
+    // 与固件相同：发布者在实时核（核0），读者分布在两个核
+    xTaskCreatePinnedToCore(stress_churn_task, "stressChurn", 4096, NULL, 4, NULL, 1);
+    for (int i = 0; i < STRESS_READERS; i++)
+        xTaskCreatePinnedToCore(stress_reader_task, "stressRead", 4096, NULL, 3, NULL, i % 2 ? 0 : 1);
+    xTaskCreatePinnedToCore(stress_publisher_task, "stressPub", 4096, NULL, 5, NULL, 0);
+
+    while (atomic_load(&kFinished) < STRESS_READERS + 2)
+        vTaskDelay(100);
+
+    uint32_t calls = atomic_load(&kSelf.calls);
+    for (int i = 0; i < STRESS_CHURN_SLOTS; i++)
+        calls += atomic_load(&kChurn[i].calls);
+    printf("reads %u, callbacks %u, subscribe/unsubscribe %u\n", atomic_load(&kReads), calls, atomic_load(&kCycles));
+    printf("torn %u, seq backwards %u, callbacks after unsubscribe %u\n", atomic_load(&kTorn),
+           atomic_load(&kBackwards), atomic_load(&kLate));
+    uint32_t failed = atomic_load(&kTorn) || atomic_load(&kBackwards) || atomic_load(&kLate) || !calls;
+    printf("\n%s\n", failed ? "FAILED" : "ok");
+
+    fflush(stdout);
+#if CONFIG_IDF_TARGET_LINUX
+    exit(failed ? 1 : 0);
+#else
+    while (1)
+        vTaskDelay(portMAX_DELAY);
+#endif
+}
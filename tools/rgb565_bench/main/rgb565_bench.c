@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "rgb565_swap.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_timer.h"
+#endif
+
+/*
+ * 1. 一致性：每个实现对不同起始地址（0~15个像素的偏移，lvgl_builtin 只测32位对齐的偏移）和长度（0~BENCH_CHECK_MAX_PX）的缓冲就地转换，
+ *    结果与逐像素参考实现逐字节比较，并检查缓冲前后的保护区没有被改写。
+ * 2. 吞吐量：对一个渲染缓冲大小（lvgl_port_disp.c，320*240/6 像素）的缓冲连续转换 BENCH_BATCH 次计时，
+ *    重复 BENCH_REPEAT 次取最快一次换算为 MB/s；
+ *    分别测 16 字节对齐和错开一个像素两种起始地址。
+ * lvgl_builtin 为 LVGL 9.2 lv_draw_sw_rgb565_swap 自带的实现（没有自定义加速时使用），作为对照。
+ */
+
+#define BENCH_PX            (320 * 240 / 6)
+#define BENCH_REPEAT        50
+#define BENCH_BATCH         20      // 每次计时连续转换的次数，主机上单次转换只有几微秒
+#define BENCH_CHECK_MAX_PX  100
+#define BENCH_GUARD_PX      16
+
+typedef void (*SwapFn_t)(void *buf, uint32_t px);
+
+typedef struct
+{
+    const char *name;
+    SwapFn_t fn;
+    uint8_t align_px;       // 起始地址要求的像素对齐，LVGL自带实现按32位访问，芯片上非对齐访问会异常
+} BenchCase_t;
+
+// LVGL 9.2 src/draw/sw/lv_draw_sw.c 中的默认实现
+static void lvgl_builtin(void *buf, uint32_t buf_size_px)
+{
+    uint32_t u32_cnt = buf_size_px / 2;
+    uint16_t *buf16 = buf;
+    uint32_t *buf32 = buf;
+
+    while (u32_cnt >= 8)
+    {
+        for (int i = 0; i < 8; i++)
+            buf32[i] = ((buf32[i] & 0xff00ff00) >> 8) | ((buf32[i] & 0x00ff00ff) << 8);
+        buf32 += 8;
+        u32_cnt -= 8;
+    }
+    while (u32_cnt)
+    {
+        *buf32 = ((*buf32 & 0xff00ff00) >> 8) | ((*buf32 & 0x00ff00ff) << 8);
+        buf32++;
+        u32_cnt--;
+    }
+    if (buf_size_px & 0x1)
+    {
+        uint32_t e = buf_size_px - 1;
+        buf16[e] = ((buf16[e] & 0xff00) >> 8) | ((buf16[e] & 0x00ff) << 8);
+    }
+}
+
+static const BenchCase_t kCases[] = {
+    {"ref", rgb565_swap_ref, 1},
+    {"lvgl_builtin", lvgl_builtin, 2},
+    {"swar32", rgb565_swap_swar32, 1},
+    {"swar64", rgb565_swap_swar64, 1},
+    {"rgb565_swap", rgb565_swap, 1},
+};
+
+static uint16_t kBuf[BENCH_PX + 2 * BENCH_GUARD_PX] __attribute__((aligned(16)));
+static uint16_t kExpect[BENCH_PX + 2 * BENCH_GUARD_PX] __attribute__((aligned(16)));
+
+static int64_t bench_now_us(void)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    return esp_timer_get_time();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+static void fill_random(uint16_t *buf, uint32_t px, uint32_t seed)
+{
+    for (uint32_t i = 0; i < px; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        buf[i] = (uint16_t)(seed >> 16);
+    }
+}
+
+// 返回不一致的用例数
+static uint32_t check_case(const BenchCase_t *c, uint32_t max_px)
+{
+    uint32_t bad = 0;
+    for (uint32_t offset = 0; offset < BENCH_GUARD_PX; offset += c->align_px)
+    {
+        for (uint32_t px = 0; px <= max_px; px++)
+        {
+            uint32_t total = BENCH_GUARD_PX + px + BENCH_GUARD_PX;
+            fill_random(kBuf, total, offset * 1000 + px + 1);
+            memcpy(kExpect, kBuf, total * sizeof(uint16_t));
+            rgb565_swap_ref(kExpect + offset, px);
+            c->fn(kBuf + offset, px);
+            if (memcmp(kBuf, kExpect, total * sizeof(uint16_t)) != 0)
+            {
+                if (!bad)
+                    printf("  %s: mismatch at offset %lu, %lu px\n", c->name, (unsigned long)offset, (unsigned long)px);
+                bad++;
+            }
+        }
+    }
+    return bad;
+}
+
+static double bench_case(const BenchCase_t *c, uint16_t *buf)
+{
+    c->fn(buf, BENCH_PX);   // 预热缓存
+    int64_t best = INT64_MAX;
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        int64_t t0 = bench_now_us();
+        for (int i = 0; i < BENCH_BATCH; i++)
+            c->fn(buf, BENCH_PX);
+        int64_t t = bench_now_us() - t0;
+        if (t < best)
+            best = t;
+    }
+    if (best < 1)
+        best = 1;
+    return (double)BENCH_PX * sizeof(uint16_t) * BENCH_BATCH / best;     // 字节/微秒 = MB/s
+}
+
+void app_main(void)
+{
+    uint32_t failed = 0;
+    printf("check: offsets 0~%d px, lengths 0~%d px, plus %d px\n", BENCH_GUARD_PX - 1, BENCH_CHECK_MAX_PX, BENCH_PX);
+    for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); c++)
+    {
+        uint32_t bad = check_case(&kCases[c], BENCH_CHECK_MAX_PX);
+        // 完整渲染缓冲大小
+        fill_random(kBuf, BENCH_PX, 7);
+        memcpy(kExpect, kBuf, BENCH_PX * sizeof(uint16_t));
+        rgb565_swap_ref(kExpect, BENCH_PX);
+        kCases[c].fn(kBuf, BENCH_PX);
+        if (memcmp(kBuf, kExpect, BENCH_PX * sizeof(uint16_t)) != 0)
+            bad++;
+        printf("  %-14s %s\n", kCases[c].name, bad ? "FAIL" : "ok");
+        if (bad)
+            failed++;
+    }
+
+    printf("\n%d px (%d bytes) x %d x %d repeats, MB/s\n", BENCH_PX, (int)(BENCH_PX * sizeof(uint16_t)), BENCH_BATCH,
+           BENCH_REPEAT);
+    printf("%-14s %10s %10s\n", "variant", "aligned", "offset+1");
+    for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); c++)
+    {
+        double aligned = bench_case(&kCases[c], kBuf);
+        if (kCases[c].align_px > 1)
+        {
+            printf("%-14s %10.1f %10s\n", kCases[c].name, aligned, "-");
+            continue;
+        }
+        double offset = bench_case(&kCases[c], kBuf + 1);
+        printf("%-14s %10.1f %10.1f\n", kCases[c].name, aligned, offset);
+    }
+    printf("\n%s\n", failed ? "FAILED" : "all variants match the reference");
+
+    fflush(stdout);
+#if CONFIG_IDF_TARGET_LINUX
+    exit(failed ? 1 : 0);
+#else
+    while (1)
+        vTaskDelay(portMAX_DELAY);
+#endif
+}
@@ -0,0 +1,295 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "stick_filter.h"
+#include "core_config.h"
+
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_cpu.h"
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * 每个处理级单独组成一条编译期滤波链，对同一段模拟摇杆输入（慢速摆动+快速推杆+噪声+偶发尖峰）测量每个采样的平均周期数，
+ * 另外测量遥控器默认滤波链（core_config.h：扫描频率、处理级和参数与固件相同，归一化和死区由查找表完成）、
+ * 运行时组合（全部处理级）以及原来的浮点实现作为对照。
+ * 芯片上用CPU周期计数器；主机上x86用TSC（按TSC频率计，不一定等于CPU主频），其它架构输出纳秒。
+ *
+ * 同时给出定点结果与浮点参考实现的最大误差（Q15 LSB），用于确认定点换算没有损失精度：
+ * deadzone+iir 链，以及默认滤波链与按相同参数计算的浮点 One Euro。
+ */
+
+#define BENCH_SAMPLES       4096
+#define BENCH_REPEAT        50
+#define BENCH_SAMPLE_HZ     ((float)CORE_SCAN_HZ)
+#define BENCH_DEADZONE      80          // 模拟校准查找表的中心和边缘死区（ADC原始值单位）
+
+static int16_t kInput[BENCH_SAMPLES];
+
+static uint64_t bench_now(void)
+{
+#if !CONFIG_IDF_TARGET_LINUX
+    return esp_cpu_get_cycle_count();
+#elif defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+#if !CONFIG_IDF_TARGET_LINUX || defined(__x86_64__) || defined(__i386__)
+#define BENCH_UNIT  "cycles"
+#else
+#define BENCH_UNIT  "ns"
+#endif
+
+static void gen_input(void)
+{
+    uint32_t seed = 1;
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        float t = i / BENCH_SAMPLE_HZ;
+        float v = 2047 + 1200 * sinf(2 * 3.14159265f * 0.3f * t);      // 慢速摆动
+        if ((i / 256) % 4 == 3)
+            v = (i / 64) % 2 ? 4095 : 0;                                // 快速推到底
+        v += (float)((seed >> 16) % 41) - 20;                           // ADC噪声 ±20
+        if ((seed >> 8) % 200 == 0)
+            v += 600;                                                   // 偶发尖峰
+        kInput[i] = (int16_t)(v < 0 ? 0 : (v > 4095 ? 4095 : v));
+    }
+}
+
+/* -------------------- 被测滤波链 -------------------- */
+#define CHAIN_CENTER(S)
+#define CHAIN_DEADZONE(S)   S(deadzone)
+#define CHAIN_EXPO(S)       S(expo)
+#define CHAIN_IIR(S)        S(iir)
+#define CHAIN_EURO(S)       S(euro)
+#define CHAIN_RATE(S)       S(rate)
+#define CHAIN_ALL(S)        S(deadzone) S(expo) S(iir) S(euro) S(rate)
+
+STICK_FILTER_DEFINE_CHAIN(chain_center, CHAIN_CENTER)
+STICK_FILTER_DEFINE_CHAIN(chain_deadzone, CHAIN_DEADZONE)
+STICK_FILTER_DEFINE_CHAIN(chain_expo, CHAIN_EXPO)
+STICK_FILTER_DEFINE_CHAIN(chain_iir, CHAIN_IIR)
+STICK_FILTER_DEFINE_CHAIN(chain_euro, CHAIN_EURO)
+STICK_FILTER_DEFINE_CHAIN(chain_rate, CHAIN_RATE)
+STICK_FILTER_DEFINE_Q15_CHAIN(chain_core, CORE_STICK_CHAIN)
+
+// 遥控器上ADC原始值经校准查找表（stick_calib_lut）得到Q15，这里用 center+deadzone 生成同样作用的表
+static int16_t kLut[4096];
+
+static inline int16_t chain_default(StickFilter_t *f, int raw)
+{
+    return chain_core(f, kLut[raw]);
+}
+STICK_FILTER_DEFINE_CHAIN(chain_all, CHAIN_ALL)
+
+// 每条链包成一个不内联的循环，测量时只有循环本身的开销
+#define BENCH_LOOP(name, fn)                                                        \
+    static __attribute__((noinline)) int32_t name(StickFilter_t *f, int16_t *out)    \
+    {                                                                               \
+        int32_t sum = 0;                                                            \
+        for (int i = 0; i < BENCH_SAMPLES; i++)                                     \
+        {                                                                           \
+            out[i] = fn(f, kInput[i]);                                              \
+            sum += out[i];                                                          \
+        }                                                                           \
+        return sum;                                                                 \
+    }
+
+BENCH_LOOP(loop_center, chain_center)
+BENCH_LOOP(loop_deadzone, chain_deadzone)
+BENCH_LOOP(loop_expo, chain_expo)
+BENCH_LOOP(loop_iir, chain_iir)
+BENCH_LOOP(loop_euro, chain_euro)
+BENCH_LOOP(loop_rate, chain_rate)
+BENCH_LOOP(loop_default, chain_default)
+BENCH_LOOP(loop_all, chain_all)
+BENCH_LOOP(loop_runtime, stick_filter_run)
+
+/* -------------------- 浮点参考实现 -------------------- */
+// 原 core.c 的 NormalizationRocker
+static float ref_normalize(int adc_value, int dead_zone, int offset)
+{
+    int v = adc_value + offset;
+    int center = 0x7FF;
+    if (v < center + dead_zone && v > center - dead_zone)
+        return 0.0f;
+    float k = 1.0f / (0x7FF - 2 * dead_zone);
+    float out = v > center ? (v - center - dead_zone) * k : (v - center + dead_zone) * k;
+    return out > 1.0f ? 1.0f : (out < -1.0f ? -1.0f : out);
+}
+
+static float kRefIir;
+static float ref_deadzone_iir(int raw, float alpha)
+{
+    kRefIir += alpha * (ref_normalize(raw, BENCH_DEADZONE, 0) - kRefIir);
+    return kRefIir;
+}
+
+// 浮点 One Euro，参数含义同 StickFilterConfig_t，速度按满量程/秒计
+typedef struct
+{
+    float prev;
+    float dx;
+    float y;
+} RefEuro_t;
+
+static float ref_euro(RefEuro_t *e, const StickFilterConfig_t *cfg, float x)
+{
+    float fs = cfg->sample_hz;
+    float wd = 2 * 3.14159265f * cfg->euro_d_hz / fs;
+    float d = x - e->prev;
+    d = d > 1.0f ? 1.0f : (d < -1.0f ? -1.0f : d);     // 与定点实现相同，每采样变化量限制在满量程
+    e->dx += wd / (1 + wd) * (d - e->dx);
+    e->prev = x;
+    float fc = cfg->euro_min_hz + cfg->euro_beta * fabsf(e->dx) * fs;
+    float w = 2 * 3.14159265f * fc / fs;
+    e->y += w / (1 + w) * (x - e->y);
+    return e->y;
+}
+
+static __attribute__((noinline)) float loop_float(float alpha, float *out)
+{
+    float sum = 0;
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        out[i] = ref_deadzone_iir(kInput[i], alpha);
+        sum += out[i];
+    }
+    return sum;
+}
+
+/* -------------------- 测量 -------------------- */
+typedef int32_t (*BenchLoop_t)(StickFilter_t *f, int16_t *out);
+
+typedef struct
+{
+    const char *name;
+    BenchLoop_t loop;
+    const StickFilterConfig_t *cfg;
+} BenchCase_t;
+
+static const StickFilterConfig_t kConfig = {
+    .stages = STICK_STAGE_DEADZONE | STICK_STAGE_EXPO | STICK_STAGE_IIR | STICK_STAGE_EURO | STICK_STAGE_RATE,
+    .sample_hz = BENCH_SAMPLE_HZ,
+    .deadzone = BENCH_DEADZONE,
+    .outer_deadzone = BENCH_DEADZONE,
+    .expo = 0.3f,
+    .lowpass_hz = 5.0f,
+    .euro_min_hz = 2.0f,
+    .euro_beta = 5.0f,
+    .euro_d_hz = 1.0f,
+    .rate_limit = 8.0f,
+};
+
+static const StickFilterConfig_t kCoreConfig = CORE_STICK_FILTER_CONFIG;
+
+static const BenchCase_t kCases[] = {
+    {"center", loop_center, &kConfig},
+    {"deadzone", loop_deadzone, &kConfig},
+    {"expo", loop_expo, &kConfig},
+    {"iir", loop_iir, &kConfig},
+    {"euro", loop_euro, &kConfig},
+    {"rate", loop_rate, &kConfig},
+    {"default", loop_default, &kCoreConfig},
+    {"all", loop_all, &kConfig},
+    {"runtime_all", loop_runtime, &kConfig},
+};
+
+static int16_t kOut[BENCH_SAMPLES];
+static float kOutFloat[BENCH_SAMPLES];
+
+void app_main(void)
+{
+    gen_input();
+    StickFilter_t f;
+    stick_filter_init(&f, &kConfig);
+    for (int raw = 0; raw < 4096; raw++)
+        kLut[raw] = (int16_t)stick_stage_deadzone(&f, stick_stage_center(&f, raw));
+
+    printf("%d samples at %.0f Hz x %d repeats, unit: %s per sample\n\n", BENCH_SAMPLES, BENCH_SAMPLE_HZ, BENCH_REPEAT,
+           BENCH_UNIT);
+    printf("%-12s %10s\n", "chain", BENCH_UNIT);
+
+    volatile int32_t sink = 0;
+    for (size_t c = 0; c < sizeof(kCases) / sizeof(kCases[0]); c++)
+    {
+        stick_filter_init(&f, kCases[c].cfg);
+        kCases[c].loop(&f, kOut);   // 预热缓存
+        uint64_t best = UINT64_MAX;
+        for (int r = 0; r < BENCH_REPEAT; r++)
+        {
+            uint64_t t0 = bench_now();
+            sink += kCases[c].loop(&f, kOut);
+            uint64_t t = bench_now() - t0;
+            if (t < best)
+                best = t;
+        }
+        printf("%-12s %10.1f\n", kCases[c].name, (double)best / BENCH_SAMPLES);
+    }
+
+    float alpha = 2 * 3.14159265f * kConfig.lowpass_hz / BENCH_SAMPLE_HZ;
+    alpha = alpha / (1 + alpha);
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        kRefIir = 0;
+        uint64_t t0 = bench_now();
+        sink += (int32_t)loop_float(alpha, kOutFloat);
+        uint64_t t = bench_now() - t0;
+        if (t < best)
+            best = t;
+    }
+    printf("%-12s %10.1f\n", "float_ref", (double)best / BENCH_SAMPLES);
+
+    // 精度：deadzone+iir 定点链与浮点参考实现比较
+    StickFilterConfig_t cfg = kConfig;
+    cfg.stages = STICK_STAGE_DEADZONE | STICK_STAGE_IIR;
+    stick_filter_init(&f, &cfg);
+    kRefIir = 0;
+    loop_float(alpha, kOutFloat);
+    int32_t max_err = 0;
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int32_t ref = (int32_t)lroundf(kOutFloat[i] * STICK_Q15_ONE);
+        int32_t err = abs(stick_filter_run(&f, kInput[i]) - ref);
+        if (err > max_err)
+            max_err = err;
+    }
+    printf("\ndeadzone+iir vs float reference: max error %ld LSB (%.5f of full scale)\n",
+           (long)max_err, (double)max_err / STICK_Q15_ONE);
+
+    // 精度：默认滤波链与浮点 One Euro 比较（输入为同一个查找表的结果）
+    stick_filter_init(&f, &kCoreConfig);
+    RefEuro_t euro = {0};
+    max_err = 0;
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int16_t x = kLut[kInput[i]];
+        int32_t ref = (int32_t)lroundf(ref_euro(&euro, &kCoreConfig, stick_q15_to_float(x)) * STICK_Q15_ONE);
+        int32_t err = abs(chain_default(&f, kInput[i]) - ref);
+        if (err > max_err)
+            max_err = err;
+    }
+    printf("default vs float one euro: max error %ld LSB (%.5f of full scale)\n",
+           (long)max_err, (double)max_err / STICK_Q15_ONE);
+
+    fflush(stdout);
+#if CONFIG_IDF_TARGET_LINUX
+    exit(0);
+#else
+    while (1)
+        vTaskDelay(portMAX_DELAY);
+#endif
+}